@@ -0,0 +1,66 @@
+// Benchmark the startup cost of each wasm build: the size of its .wasm file, how long it takes to
+// compile and instantiate, and how long its first call takes. Build whichever builds you want to
+// compare first (see build-wasm.sh); missing builds are skipped. The multithreaded builds need
+// Node 21+ (for navigator.hardwareConcurrency), and are skipped on older versions.
+//
+// Usage: node bench-wasm-startup.mjs [runs]
+
+import { statSync } from "node:fs";
+import { performance } from "node:perf_hooks";
+
+const WASM_DIR = "./scripts/components/wasm/";
+const RUNS = Number(process.argv[2] ?? 10);
+const BUILDS = ["libdamage", "libdamage-lean", "libdamage-mt", "libdamage-mt-lean"];
+
+function median(times) {
+    times.sort((a, b) => a - b);
+    return times[Math.floor(times.length / 2)];
+}
+
+async function bench(build) {
+    let wasmBytes;
+    try {
+        wasmBytes = statSync(new URL(WASM_DIR + build + ".wasm", import.meta.url)).size;
+    } catch {
+        return null;
+    }
+    if (build.includes("-mt") && typeof navigator === "undefined") {
+        return null;
+    }
+    const createWasmModule = (await import(WASM_DIR + build + ".js")).default;
+    const instantiateTimes = [];
+    const firstCallTimes = [];
+    // Each module instance compiles and instantiates the .wasm file from scratch
+    for (let i = 0; i < RUNS; i++) {
+        let start = performance.now();
+        const damagecalc = await createWasmModule({
+            print: () => {},
+            printErr: (text) => console.warn(text),
+        });
+        instantiateTimes.push(performance.now() - start);
+        // Something that every build has, and which goes through the name tables
+        start = performance.now();
+        damagecalc.getMoves();
+        firstCallTimes.push(performance.now() - start);
+    }
+    return {
+        wasmBytes,
+        instantiateMs: median(instantiateTimes),
+        firstCallMs: median(firstCallTimes),
+    };
+}
+
+for (const build of BUILDS) {
+    const r = await bench(build);
+    if (r === null) {
+        console.log(`${build}: skipped`);
+        continue;
+    }
+    console.log(
+        `${build}: ${(r.wasmBytes / 1024).toFixed(1)} KiB .wasm, ` +
+            `instantiated in ${r.instantiateMs.toFixed(1)} ms, ` +
+            `first call in ${r.firstCallMs.toFixed(2)} ms`
+    );
+}
+// The multithreaded builds' worker pools keep Node running
+process.exit(0);
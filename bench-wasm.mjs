@@ -0,0 +1,86 @@
+// Benchmark the single-threaded and multithreaded wasm builds against each other, and check that
+// they give the same results. Build both first (./build-wasm.sh && ./build-wasm.sh --threads).
+// Node runs the multithreaded build's worker pool on worker threads, and needs to be version 21+
+// (for navigator.hardwareConcurrency).
+//
+// Usage: node bench-wasm.mjs [runs]
+
+import { performance } from "node:perf_hooks";
+
+const WASM_DIR = "./scripts/components/wasm/";
+const RUNS = Number(process.argv[2] ?? 5);
+
+// A matchup table: every defender species at every few attacker levels, for a couple moves
+const SWEEP_SPEC = JSON.stringify({
+    attacker: { species: "charmander", level: { range: [1, 100, 4] }, sp_atk: 60 },
+    defender: { species: "*", level: 50 },
+    move: { id: ["ember", "flamethrower"] },
+});
+const CONFIG = JSON.stringify({
+    attacker: { species: "charmander", level: 50, sp_atk: 60 },
+    defender: { species: "bulbasaur", level: 50 },
+    move: { id: "ember" },
+});
+const N_REQUESTS = 50000;
+
+async function load(file) {
+    const createWasmModule = (await import(WASM_DIR + file)).default;
+    return await createWasmModule({ print: () => {}, printErr: (text) => console.warn(text) });
+}
+
+// Median time of a few runs of f, after a warmup run. Returns the time and f's last result.
+function time(f) {
+    let result = f();
+    const times = [];
+    for (let i = 0; i < RUNS; i++) {
+        const start = performance.now();
+        result = f();
+        times.push(performance.now() - start);
+    }
+    times.sort((a, b) => a - b);
+    return [times[Math.floor(times.length / 2)], result];
+}
+
+function bench(damagecalc) {
+    // Results are views into wasm memory, so copy them before the next call
+    const [sweepMs, sweep] = time(() => damagecalc.calcSweep(SWEEP_SPEC).results.slice());
+
+    const requests = damagecalc.getRequestBuffer(N_REQUESTS * damagecalc.REQUEST_SIZE);
+    damagecalc.encodeRequest(CONFIG, 0, 0);
+    const record = requests.slice(0, damagecalc.REQUEST_SIZE);
+    for (let i = 1; i < N_REQUESTS; i++) {
+        requests.set(record, i * damagecalc.REQUEST_SIZE);
+    }
+    const [requestsMs, results] = time(() => damagecalc.calcRequests(N_REQUESTS).slice());
+    return { sweepMs, sweep, requestsMs, results, stride: damagecalc.RESULT_STRIDE };
+}
+
+function report(name, r) {
+    const points = r.sweep.length / r.stride;
+    console.log(
+        `${name}: sweep of ${points} points in ${r.sweepMs.toFixed(1)} ms ` +
+            `(${Math.round((points / r.sweepMs) * 1000)}/s), ` +
+            `${N_REQUESTS} requests in ${r.requestsMs.toFixed(1)} ms ` +
+            `(${Math.round((N_REQUESTS / r.requestsMs) * 1000)}/s)`
+    );
+}
+
+function equal(a, b) {
+    return a.length === b.length && a.every((x, i) => x === b[i]);
+}
+
+const single = bench(await load("libdamage.js"));
+report("single-threaded", single);
+const threaded = bench(await load("libdamage-mt.js"));
+report(`multithreaded (${navigator.hardwareConcurrency} threads)`, threaded);
+console.log(
+    `speedup: sweep ${(single.sweepMs / threaded.sweepMs).toFixed(2)}x, ` +
+        `requests ${(single.requestsMs / threaded.requestsMs).toFixed(2)}x`
+);
+
+if (!equal(single.sweep, threaded.sweep) || !equal(single.results, threaded.results)) {
+    console.error("the builds gave different results");
+    process.exit(1);
+}
+// The worker pool keeps Node running
+process.exit(0);
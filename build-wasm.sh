@@ -2,33 +2,67 @@
 
 set -ex
 
+# --debug: debug build
+# --threads: multithreaded build with pthreads and SIMD (libdamage-mt.js), which the web app uses
+#   instead of libdamage.js when the page is cross-origin isolated
+# --lean: build without the APIs that take JSON configs (calcDamage, encodeRequest, calcSweep, base
+#   configs), for callers that only use the binary APIs (libdamage-lean.js, or libdamage-mt-lean.js
+#   with --threads). It's smaller and starts faster, since the JSON parser is left out.
 BUILD_TYPE='Release'
-if [ "$#" -ge 1 ]; then
-    if [ "$1" = "--debug" ]; then
-        BUILD_TYPE='Debug'
-    fi
-fi
+THREADS=0
+LEAN=0
+for arg in "$@"; do
+    case "$arg" in
+        --debug) BUILD_TYPE='Debug' ;;
+        --threads) THREADS=1 ;;
+        --lean) LEAN=1 ;;
+    esac
+done
 
 OLD_PWD="$PWD"
 REPO_ROOT=$(git rev-parse --show-toplevel)
 cd $REPO_ROOT
 
-mkdir -p build-wasm
-cd build-wasm
+BUILD_DIR='build-wasm'
+OUTPUT='libdamage'
+THREAD_FLAGS=''
+if [ "${THREADS}" = 1 ]; then
+    BUILD_DIR="${BUILD_DIR}-mt"
+    OUTPUT="${OUTPUT}-mt"
+    # The worker pool is started with the module, since threads can't be started while the main
+    # browser thread is blocked waiting for them
+    THREAD_FLAGS='-pthread -msimd128 -sPTHREAD_POOL_SIZE=navigator.hardwareConcurrency'
+fi
+if [ "${LEAN}" = 1 ]; then
+    BUILD_DIR="${BUILD_DIR}-lean"
+    OUTPUT="${OUTPUT}-lean"
+fi
 
-emcmake cmake .. -DCMAKE_BUILD_TYPE="${BUILD_TYPE}"
+mkdir -p "${BUILD_DIR}"
+cd "${BUILD_DIR}"
+# Don't copy a worker script left over from a build with an older Emscripten (see below)
+rm -f "${OUTPUT}.worker.js"
+
+emcmake cmake .. -DCMAKE_BUILD_TYPE="${BUILD_TYPE}" -DDAMAGECALC_WASM_THREADS="${THREADS}" \
+    -DDAMAGECALC_WASM_LEAN="${LEAN}"
 emmake cmake --build . --target damage.wasm
 if [ "${BUILD_TYPE}" = 'Debug' ]; then
-    emcc -lembind -o libdamage.js \
+    emcc -lembind -o "${OUTPUT}.js" ${THREAD_FLAGS} \
         -Wl,--whole-archive src/libdamage.wasm.a -Wl,--no-whole-archive \
         -s EXPORT_NAME='createWasmModule' -s MODULARIZE=1 -s EXPORT_ES6=1 \
         -s NO_DISABLE_EXCEPTION_CATCHING
 else
-    emcc -O3 -DNDEBUG -lembind -o libdamage.js \
+    emcc -O3 -DNDEBUG -lembind -o "${OUTPUT}.js" ${THREAD_FLAGS} \
         -Wl,--whole-archive src/libdamage.wasm.a -Wl,--no-whole-archive \
         -s EXPORT_NAME='createWasmModule' -s MODULARIZE=1 -s EXPORT_ES6=1
 fi
 
-cp libdamage.js libdamage.wasm "${REPO_ROOT}/scripts/components/wasm"
+OUTPUT_FILES="${OUTPUT}.js ${OUTPUT}.wasm"
+if [ -f "${OUTPUT}.worker.js" ]; then
+    # Emscripten before 3.1.58 puts the pthread worker in a separate script. Later versions build
+    # it into the main script, and don't emit this file.
+    OUTPUT_FILES="${OUTPUT_FILES} ${OUTPUT}.worker.js"
+fi
+cp ${OUTPUT_FILES} "${REPO_ROOT}/scripts/components/wasm"
 
-cd "$OLD_PWD"
\ No newline at end of file
+cd "$OLD_PWD"
@@ -1,8 +1,24 @@
 // Convenience wrapper to synchronously import libdamage
-import createWasmModule from "./libdamage.js"
 
+// The multithreaded build (see build-wasm.sh) needs SharedArrayBuffer, which browsers only allow
+// on cross-origin isolated pages, so fall back to the single-threaded build everywhere else (or if
+// the multithreaded build is missing)
+async function importWasmModule() {
+    if (globalThis.crossOriginIsolated) {
+        try {
+            return [(await import("./libdamage-mt.js")).default, true];
+        } catch (e) {
+            console.warn("[libdamage] Multithreaded build unavailable: " + e);
+        }
+    }
+    return [(await import("./libdamage.js")).default, false];
+}
+
+const [createWasmModule, isThreaded] = await importWasmModule();
 const damagecalc = await createWasmModule({
     print: function(text) { console.log("[libdamage] " + text) },
     printErr: function(text) { console.warn("[libdamage] " + text) },
 });
 export default damagecalc;
+// Whether batches and sweeps are split across a pool of Web Workers
+export const threaded = isThreaded;
@@ -0,0 +1,125 @@
+#include "api.hpp"
+
+#include <exception>
+#include <utility>
+#include <string>
+#include <vector>
+#include "batch.hpp"
+#include "calcresult.hpp"
+#include "sweep.hpp"
+
+using nlohmann::json;
+
+namespace api {
+namespace {
+http::Response ok(const json& body) { return {200, body.dump()}; }
+} // namespace
+
+http::Response Handler::calc(const std::string& body) {
+    tape.clear();
+    auto inputs = bases.parse(tape.parse(body), tape);
+    return ok(calcresult::to_json(calcresult::calc_damage(inputs)));
+}
+
+http::Response Handler::calc_batch(const std::string& body) {
+    tape.clear();
+    auto cfgs = tape.parse(body);
+    if (!cfgs.is_array()) {
+        return http::error_response(400, "batch must be an array of configs");
+    }
+    json results = json::array();
+    for (auto cfg : cfgs) {
+        json result;
+        try {
+            result = calcresult::to_json(calcresult::calc_damage(bases.parse(cfg, tape)));
+        } catch (const std::exception& e) {
+            result = {{"error", e.what()}};
+        }
+        if (cfg.contains("id")) {
+            result["id"] = cfg.at("id").to_json();
+        }
+        results.push_back(std::move(result));
+    }
+    return ok(results);
+}
+
+http::Response Handler::distribution(const std::string& body) {
+    tape.clear();
+    auto inputs = bases.parse(tape.parse(body), tape);
+    return ok(calcresult::to_json(calcresult::damage_distribution(inputs)));
+}
+
+http::Response Handler::versions(const std::string& body) {
+    tape.clear();
+    auto inputs = bases.parse(tape.parse(body), tape);
+    return ok(batch::diff_versions(inputs));
+}
+
+http::Response Handler::matrix(const std::string& body) {
+    sweep::Sweep s(json::parse(body));
+    std::size_t size = s.size();
+    if (size > max_matrix_size) {
+        return http::error_response(400, "matrix has more than the maximum of " +
+                                             std::to_string(max_matrix_size) + " points");
+    }
+    const auto& axes = s.axes();
+    json axes_out = json::array();
+    for (const auto& axis : axes) {
+        json values = json::array();
+        for (const auto& value : axis.values) {
+            values.push_back(value.to_json());
+        }
+        axes_out.push_back({{"path", axis.path}, {"values", values}});
+    }
+
+    // Points come in order with the innermost axis changing fastest, so nest them by grouping
+    // consecutive results, from the innermost axis outwards
+    std::vector<json> results;
+    results.reserve(size);
+    s.run([&](const sweep::Point& point) {
+        results.push_back(point.run ? batch::summarize(*point.run) : json{{"error", point.error}});
+    });
+    for (std::size_t i = axes.size(); i-- > 1;) {
+        std::size_t n = axes[i].values.size();
+        std::vector<json> grouped;
+        grouped.reserve(results.size() / n);
+        for (std::size_t j = 0; j < results.size(); j += n) {
+            json group = json::array();
+            for (std::size_t k = j; k < j + n; k++) {
+                group.push_back(std::move(results[k]));
+            }
+            grouped.push_back(std::move(group));
+        }
+        results = std::move(grouped);
+    }
+    json results_out = axes.empty() ? std::move(results.front()) : json(std::move(results));
+    return ok({{"axes", axes_out}, {"results", results_out}});
+}
+
+http::Response Handler::operator()(const http::Request& request) {
+    using Endpoint = http::Response (Handler::*)(const std::string&);
+    Endpoint endpoint = nullptr;
+    if (request.path == "/calc") {
+        endpoint = &Handler::calc;
+    } else if (request.path == "/calc/batch") {
+        endpoint = &Handler::calc_batch;
+    } else if (request.path == "/distribution") {
+        endpoint = &Handler::distribution;
+    } else if (request.path == "/versions") {
+        endpoint = &Handler::versions;
+    } else if (request.path == "/matrix") {
+        endpoint = &Handler::matrix;
+    } else {
+        return http::error_response(404, "no endpoint at '" + request.path + "'");
+    }
+    if (request.method != "POST") {
+        return http::error_response(405, request.path + " only accepts POST");
+    }
+    try {
+        return (this->*endpoint)(request.body);
+    } catch (const std::exception& e) {
+        // Errors from parsing the request or config, or calculating it, are the client's fault
+        return http::error_response(400, e.what());
+    }
+}
+} // namespace api
@@ -0,0 +1,48 @@
+// Damage calc HTTP API, served by damagecalc_server
+
+#ifndef API_HPP_
+#define API_HPP_
+
+#include <cstddef>
+#include "cfgtape.hpp"
+#include "http.hpp"
+#include "overlay.hpp"
+
+// Every endpoint takes a JSON request body and returns a JSON response. Configs are like
+// sample-config.json, or overlays on a base config (see overlay::BaseConfigs::parse()).
+// - POST /calc: calc one config. The result has the same fields as the web app's calcDamage()
+//   (see calcresult::to_json()).
+// - POST /calc/batch: calc an array of configs, giving an array of results like /calc. Configs
+//   that fail give an {"error": ...} object instead, and any "id" field is copied into the result.
+// - POST /distribution: the exact damage distribution of a config over every damage roll (see
+//   calcresult::damage_distribution()).
+// - POST /versions: how a config's results change in every other game version and with the other
+//   move power table (see batch::diff_versions()).
+// - POST /matrix: run a sweep spec (see sweep.hpp). The result has the "path" and "values" of each
+//   axis in "axes", and "results" nested one array deep per axis, from outermost to innermost.
+//   Each result is a compact calc summary (see batch::summarize()) or an {"error": ...} object.
+// Malformed requests and configs give a 400 response with an "error" field.
+namespace api {
+// Handles API requests with its own scratch state, so each worker thread needs its own.
+class Handler {
+    const overlay::BaseConfigs& bases;
+    std::size_t max_matrix_size;
+    cfgparse::ConfigTape tape;
+
+    http::Response calc(const std::string& body);
+    http::Response calc_batch(const std::string& body);
+    http::Response distribution(const std::string& body);
+    http::Response versions(const std::string& body);
+    http::Response matrix(const std::string& body);
+
+  public:
+    // bases must not be modified while the handler is in use. Sweeps with more than
+    // max_matrix_size points are rejected.
+    Handler(const overlay::BaseConfigs& bases, std::size_t max_matrix_size)
+        : bases(bases), max_matrix_size(max_matrix_size) {}
+
+    http::Response operator()(const http::Request& request);
+};
+} // namespace api
+
+#endif
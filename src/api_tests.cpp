@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+#include "api.hpp"
+#include "batch.hpp"
+#include "calcresult.hpp"
+#include "test_configs.hpp"
+
+using nlohmann::json;
+using test_configs::make_cfg;
+
+namespace {
+http::Request post(const std::string& path, const json& body) {
+    return {"POST", path, body.dump(), true, false};
+}
+} // namespace
+
+TEST_CASE("API endpoints work", "[api]") {
+    overlay::BaseConfigs bases;
+    bases.add("base", std::make_unique<const overlay::BaseConfig>(make_cfg()));
+    api::Handler handler(bases, 100);
+    auto expected = calcresult::to_json(calcresult::calc_damage(parse_cfg(make_cfg())));
+
+    SECTION("/calc") {
+        auto response = handler(post("/calc", make_cfg()));
+        REQUIRE(response.status == 200);
+        REQUIRE(json::parse(response.body) == expected);
+        // Overlays work too
+        response = handler(post("/calc", {{"base", "base"}}));
+        REQUIRE(json::parse(response.body) == expected);
+
+        response = handler(post("/calc", {{"attacker", {{"species", "charmander"}}}}));
+        REQUIRE(response.status == 400);
+        REQUIRE(json::parse(response.body).contains("error"));
+        response = handler({"POST", "/calc", "{", true, false});
+        REQUIRE(response.status == 400);
+    }
+    SECTION("/calc/batch") {
+        json batch = {make_cfg(), {{"base", "nope"}, {"id", 2}}, {{"base", "base"}, {"id", "x"}}};
+        auto response = handler(post("/calc/batch", batch));
+        REQUIRE(response.status == 200);
+        auto results = json::parse(response.body);
+        REQUIRE(results.size() == 3);
+        REQUIRE(results[0] == expected);
+        REQUIRE(results[1] == json{{"error", "unknown base config 'nope'"}, {"id", 2}});
+        auto with_id = expected;
+        with_id["id"] = "x";
+        REQUIRE(results[2] == with_id);
+
+        REQUIRE(handler(post("/calc/batch", make_cfg())).status == 400);
+    }
+    SECTION("/distribution") {
+        auto response = handler(post("/distribution", make_cfg()));
+        REQUIRE(response.status == 200);
+        auto dist = json::parse(response.body);
+        REQUIRE(dist["rolls"] == calcresult::N_DAMAGE_ROLLS);
+        int32_t total = 0;
+        for (const auto& count : dist["distribution"]) {
+            total += count["count"].get<int32_t>();
+        }
+        REQUIRE(total == calcresult::N_DAMAGE_ROLLS);
+        REQUIRE(dist["distribution"].front()["damage"] == expected["minDamage"]);
+        REQUIRE(dist["distribution"].back()["damage"] == expected["maxDamage"]);
+    }
+    SECTION("/versions") {
+        auto response = handler(post("/versions", {{"base", "base"}}));
+        REQUIRE(response.status == 200);
+        REQUIRE(json::parse(response.body) == batch::diff_versions(parse_cfg(make_cfg())));
+
+        response = handler(post("/versions", {{"base", "nope"}}));
+        REQUIRE(response.status == 400);
+    }
+    SECTION("/matrix") {
+        json spec = make_cfg();
+        spec["attacker.level"] = {10, 20, 30};
+        spec["defender.species"] = {"bulbasaur", "squirtle"};
+        auto response = handler(post("/matrix", spec));
+        REQUIRE(response.status == 200);
+        auto matrix = json::parse(response.body);
+        REQUIRE(matrix["axes"] == json{{{"path", "attacker.level"}, {"values", {10, 20, 30}}},
+                                       {{"path", "defender.species"},
+                                        {"values", {"bulbasaur", "squirtle"}}}});
+        const auto& results = matrix["results"];
+        REQUIRE(results.size() == 3);
+        for (std::size_t i = 0; i < 3; i++) {
+            REQUIRE(results[i].size() == 2);
+            for (std::size_t j = 0; j < 2; j++) {
+                json cfg = make_cfg();
+                cfg["attacker"]["level"] = matrix["axes"][0]["values"][i];
+                cfg["defender"]["species"] = matrix["axes"][1]["values"][j];
+                REQUIRE(results[i][j] == batch::summarize(batch::run_calc(cfg)));
+            }
+        }
+
+        // No axes gives a single result
+        response = handler(post("/matrix", make_cfg()));
+        REQUIRE(json::parse(response.body)["results"] ==
+                batch::summarize(batch::run_calc(make_cfg())));
+
+        spec["defender.species"] = "*";
+        response = handler(post("/matrix", spec));
+        REQUIRE(response.status == 400);
+        REQUIRE(json::parse(response.body)["error"] ==
+                "matrix has more than the maximum of 100 points");
+    }
+    SECTION("Unknown endpoints and methods") {
+        REQUIRE(handler(post("/nope", make_cfg())).status == 404);
+        REQUIRE(handler({"GET", "/calc", "", true, false}).status == 405);
+    }
+}
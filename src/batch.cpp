@@ -0,0 +1,658 @@
+#include "batch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "calcresult.hpp"
+#include "cfgparse.hpp"
+#include "idmap.hpp"
+#include "wire.hpp"
+
+using nlohmann::json;
+
+namespace batch {
+bool CalcRun::guaranteed_miss() const {
+    return dungeon.damage_calc.two_turn_move_forced_miss ||
+           dungeon.damage_calc.soundproof_activated || dungeon.damage_calc.first_hit_check_failed ||
+           dungeon.damage_calc.dream_eater_failed || dungeon.damage_calc.last_resort_failed;
+}
+
+CalcRun run_calc(const CalcInputs& inputs) {
+    auto& [dungeon, attacker, defender, move, attack_power] = inputs;
+
+    // Copy for a second damage calc since the inputs can be modified by the simulation
+    CalcRun run = {dungeon, attacker, defender, move, dungeon, {}, {}, 0, 0};
+    MonsterEntity attacker_max = attacker;
+    MonsterEntity defender_max = defender;
+    Move move_max = move;
+
+    run.dungeon.rng.variance_dial = 0;     // minimum damage roll
+    run.dungeon_max.rng.variance_dial = 1; // maximum damage roll
+
+    if (move.id == eos::MOVE_PROJECTILE) {
+        run.damage = simulate_damage_calc_projectile(run.details, run.dungeon, run.attacker,
+                                                     run.defender, attack_power);
+        run.damage_max_var = simulate_damage_calc_projectile(
+            run.details_max_var, run.dungeon_max, attacker_max, defender_max, attack_power);
+    } else {
+        run.damage = simulate_damage_calc(run.details, run.dungeon, run.attacker, run.defender,
+                                          run.move);
+        run.damage_max_var = simulate_damage_calc(run.details_max_var, run.dungeon_max,
+                                                  attacker_max, defender_max, move_max);
+    }
+    return run;
+}
+CalcRun run_calc(const json& cfg) { return run_calc(parse_cfg(cfg)); }
+CalcRun run_calc(const cfgparse::ConfigTape::Node& cfg) { return run_calc(parse_cfg(cfg)); }
+
+json summarize(const CalcRun& run) {
+    json result;
+    if (run.details.healed) {
+        result["healed"] = {run.details.damage, run.details_max_var.damage};
+    } else {
+        result["damage"] = {run.damage, run.damage_max_var};
+    }
+    if (run.guaranteed_miss()) {
+        result["guaranteed_miss"] = true;
+    } else {
+        result["hit_chance"] = run.dungeon.rng.get_combined_hit_percentage();
+        result["crit_chance"] = run.dungeon.rng.get_computed_crit_chance();
+    }
+    return result;
+}
+
+json summarize_branches(const CalcInputs& inputs) {
+    json results = json::array();
+    for (const auto& branch : calcresult::damage_branches(inputs)) {
+        results.push_back({
+            {"huge_pure_power", branch.huge_pure_power},
+            {"critical_hit", branch.critical_hit},
+            {"chance", branch.chance},
+            {branch.healed ? "healed" : "damage", {branch.min_damage, branch.max_damage}},
+        });
+    }
+    return results;
+}
+
+json calc_result(const cfgparse::ConfigTape::Node& cfg, cfgparse::ConfigTape& tape,
+                 const overlay::BaseConfigs& bases) {
+    json result;
+    try {
+        CalcInputs inputs = bases.parse(cfg, tape);
+        result = summarize(run_calc(inputs));
+        if (cfg.value("branches", false)) {
+            result["branches"] = summarize_branches(inputs);
+        }
+        if (cfg.value("versions", false)) {
+            result["versions"] = diff_versions(inputs);
+        }
+    } catch (const std::exception& e) {
+        result = {{"error", e.what()}};
+    }
+    if (cfg.contains("id")) {
+        result["id"] = cfg.at("id").to_json();
+    }
+    return result;
+}
+
+namespace {
+// A value in a result column, or null
+using Value = std::variant<std::monostate, int32_t, double, bool, std::string_view>;
+
+struct ResultField {
+    const char* name;
+    columns::Type type;
+    Value (*get)(const CalcRun& run);
+};
+
+// Result columns other than the DamageCalcDiag flags, which are in DIAG_FLAGS
+const ResultField RESULT_FIELDS[] = {
+    {"attacker", columns::Type::STRING,
+     [](const CalcRun& r) -> Value { return ids::MONSTER[r.attacker.monster.apparent_id]; }},
+    {"attacker_level", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.attacker.monster.level); }},
+    {"defender", columns::Type::STRING,
+     [](const CalcRun& r) -> Value { return ids::MONSTER[r.defender.monster.apparent_id]; }},
+    {"defender_level", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.defender.monster.level); }},
+    {"move", columns::Type::STRING, [](const CalcRun& r) -> Value { return ids::MOVE[r.move.id]; }},
+    {"min_damage", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return r.details.healed ? r.details.damage : r.damage; }},
+    {"max_damage", columns::Type::INT32,
+     [](const CalcRun& r) -> Value {
+         return r.details.healed ? r.details_max_var.damage : r.damage_max_var;
+     }},
+    {"healed", columns::Type::BOOL, [](const CalcRun& r) -> Value { return r.details.healed; }},
+    {"guaranteed_miss", columns::Type::BOOL,
+     [](const CalcRun& r) -> Value { return r.guaranteed_miss(); }},
+    {"hit_chance", columns::Type::FLOAT64,
+     [](const CalcRun& r) -> Value {
+         if (r.guaranteed_miss()) {
+             return std::monostate();
+         }
+         return double(r.dungeon.rng.get_combined_hit_percentage());
+     }},
+    {"crit_chance", columns::Type::INT32,
+     [](const CalcRun& r) -> Value {
+         if (r.guaranteed_miss()) {
+             return std::monostate();
+         }
+         return int32_t(r.dungeon.rng.get_computed_crit_chance());
+     }},
+    {"damage_message", columns::Type::STRING,
+     [](const CalcRun& r) -> Value { return ids::DAMAGE_MESSAGE[r.details.damage_message]; }},
+    {"type_matchup", columns::Type::STRING,
+     [](const CalcRun& r) -> Value { return ids::TYPE_MATCHUP[r.details.type_matchup]; }},
+    {"critical_hit", columns::Type::BOOL,
+     [](const CalcRun& r) -> Value { return r.details.critical_hit; }},
+    {"full_type_immunity", columns::Type::BOOL,
+     [](const CalcRun& r) -> Value { return r.details.full_type_immunity; }},
+    {"no_damage", columns::Type::BOOL,
+     [](const CalcRun& r) -> Value { return r.details.no_damage; }},
+    // DamageCalcDiag, except for attacker_level, which is already a column
+    {"move_type", columns::Type::STRING,
+     [](const CalcRun& r) -> Value { return ids::TYPE[r.dungeon.damage_calc.move_type]; }},
+    {"move_category", columns::Type::STRING,
+     [](const CalcRun& r) -> Value {
+         return ids::MOVE_CATEGORY[r.dungeon.damage_calc.move_category];
+     }},
+    {"move_indiv_type_matchup1", columns::Type::STRING,
+     [](const CalcRun& r) -> Value {
+         return ids::TYPE_MATCHUP[r.dungeon.damage_calc.move_indiv_type_matchups[0]];
+     }},
+    {"move_indiv_type_matchup2", columns::Type::STRING,
+     [](const CalcRun& r) -> Value {
+         return ids::TYPE_MATCHUP[r.dungeon.damage_calc.move_indiv_type_matchups[1]];
+     }},
+    {"offensive_stat_stage", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.offensive_stat_stage); }},
+    {"defensive_stat_stage", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.defensive_stat_stage); }},
+    {"offensive_stat", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.offensive_stat); }},
+    {"defensive_stat", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.defensive_stat); }},
+    {"flash_fire_boost", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.flash_fire_boost); }},
+    {"offense_calc", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.offense_calc); }},
+    {"defense_calc", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.defense_calc); }},
+    {"damage_calc_at", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.damage_calc_at); }},
+    {"damage_calc_def", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.damage_calc_def); }},
+    {"damage_calc_flv", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.damage_calc_flv); }},
+    {"damage_calc", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return r.dungeon.damage_calc.damage_calc; }},
+    {"damage_calc_base", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return r.dungeon.damage_calc.damage_calc_base; }},
+    // damage_calc_random_mult_pct, for both damage rolls
+    {"min_random_mult_pct", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return r.dungeon.damage_calc.damage_calc_random_mult_pct; }},
+    {"max_random_mult_pct", columns::Type::INT32,
+     [](const CalcRun& r) -> Value {
+         return r.dungeon_max.damage_calc.damage_calc_random_mult_pct;
+     }},
+    {"static_damage_mult", columns::Type::FLOAT64,
+     [](const CalcRun& r) -> Value { return r.dungeon.damage_calc.static_damage_mult.val(); }},
+    {"item_atk_modifier", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.item_atk_modifier); }},
+    {"item_sp_atk_modifier", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.item_sp_atk_modifier); }},
+    {"ability_offense_modifier", columns::Type::INT32,
+     [](const CalcRun& r) -> Value {
+         return int32_t(r.dungeon.damage_calc.ability_offense_modifier);
+     }},
+    {"ability_defense_modifier", columns::Type::INT32,
+     [](const CalcRun& r) -> Value {
+         return int32_t(r.dungeon.damage_calc.ability_defense_modifier);
+     }},
+    {"iq_skill_offense_modifier", columns::Type::INT32,
+     [](const CalcRun& r) -> Value {
+         return int32_t(r.dungeon.damage_calc.iq_skill_offense_modifier);
+     }},
+    {"iq_skill_defense_modifier", columns::Type::INT32,
+     [](const CalcRun& r) -> Value {
+         return int32_t(r.dungeon.damage_calc.iq_skill_defense_modifier);
+     }},
+    {"item_def_modifier", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.item_def_modifier); }},
+    {"item_sp_def_modifier", columns::Type::INT32,
+     [](const CalcRun& r) -> Value { return int32_t(r.dungeon.damage_calc.item_sp_def_modifier); }},
+};
+
+// DamageCalcDiag flags, as bool columns
+const std::pair<const char*, bool DamageCalcDiag::*> DIAG_FLAGS[] = {
+    {"scope_lens_or_sharpshooter_activated",
+     &DamageCalcDiag::scope_lens_or_sharpshooter_activated},
+    {"patsy_band_activated", &DamageCalcDiag::patsy_band_activated},
+    {"half_physical_damage_activated", &DamageCalcDiag::half_physical_damage_activated},
+    {"half_special_damage_activated", &DamageCalcDiag::half_special_damage_activated},
+    {"focus_energy_activated", &DamageCalcDiag::focus_energy_activated},
+    {"type_advantage_master_activated", &DamageCalcDiag::type_advantage_master_activated},
+    {"cloudy_drop_activated", &DamageCalcDiag::cloudy_drop_activated},
+    {"rain_multiplier_activated", &DamageCalcDiag::rain_multiplier_activated},
+    {"sunny_multiplier_activated", &DamageCalcDiag::sunny_multiplier_activated},
+    {"fire_move_ability_drop_activated", &DamageCalcDiag::fire_move_ability_drop_activated},
+    {"flash_fire_activated", &DamageCalcDiag::flash_fire_activated},
+    {"levitate_activated", &DamageCalcDiag::levitate_activated},
+    {"torrent_boost_activated", &DamageCalcDiag::torrent_boost_activated},
+    {"overgrow_boost_activated", &DamageCalcDiag::overgrow_boost_activated},
+    {"swarm_boost_activated", &DamageCalcDiag::swarm_boost_activated},
+    {"fire_move_ability_boost_activated", &DamageCalcDiag::fire_move_ability_boost_activated},
+    {"scrappy_activated", &DamageCalcDiag::scrappy_activated},
+    {"super_luck_activated", &DamageCalcDiag::super_luck_activated},
+    {"sniper_activated", &DamageCalcDiag::sniper_activated},
+    {"stab_boost_activated", &DamageCalcDiag::stab_boost_activated},
+    {"electric_move_dampened", &DamageCalcDiag::electric_move_dampened},
+    {"water_sport_drop_activated", &DamageCalcDiag::water_sport_drop_activated},
+    {"charge_boost_activated", &DamageCalcDiag::charge_boost_activated},
+    {"ghost_immunity_activated", &DamageCalcDiag::ghost_immunity_activated},
+    {"skull_bash_defense_boost_activated", &DamageCalcDiag::skull_bash_defense_boost_activated},
+    {"two_turn_move_forced_miss", &DamageCalcDiag::two_turn_move_forced_miss},
+    {"soundproof_activated", &DamageCalcDiag::soundproof_activated},
+    {"first_hit_check_failed", &DamageCalcDiag::first_hit_check_failed},
+    {"lightningrod_activated", &DamageCalcDiag::lightningrod_activated},
+    {"storm_drain_activated", &DamageCalcDiag::storm_drain_activated},
+    {"dream_eater_failed", &DamageCalcDiag::dream_eater_failed},
+    {"last_resort_failed", &DamageCalcDiag::last_resort_failed},
+};
+
+void push_value(columns::Table& table, std::size_t col, const Value& value) {
+    if (auto i = std::get_if<int32_t>(&value)) {
+        table.push_int(col, *i);
+    } else if (auto d = std::get_if<double>(&value)) {
+        table.push_double(col, *d);
+    } else if (auto b = std::get_if<bool>(&value)) {
+        table.push_bool(col, *b);
+    } else if (auto str = std::get_if<std::string_view>(&value)) {
+        table.push_string(col, *str);
+    } else {
+        table.push_null(col);
+    }
+}
+} // namespace
+
+const std::vector<columns::Column>& result_columns() {
+    static const std::vector<columns::Column> cols = [] {
+        std::vector<columns::Column> cols;
+        for (const auto& field : RESULT_FIELDS) {
+            cols.push_back({field.name, field.type});
+        }
+        for (const auto& [name, flag] : DIAG_FLAGS) {
+            cols.push_back({name, columns::Type::BOOL});
+        }
+        cols.push_back({"error", columns::Type::STRING});
+        return cols;
+    }();
+    return cols;
+}
+
+void push_result(columns::Table& table, std::size_t first, const CalcRun* run,
+                 std::string_view error) {
+    std::size_t col = first;
+    for (const auto& field : RESULT_FIELDS) {
+        push_value(table, col++, run ? field.get(*run) : Value());
+    }
+    for (const auto& [name, flag] : DIAG_FLAGS) {
+        if (run) {
+            table.push_bool(col++, run->dungeon.damage_calc.*flag);
+        } else {
+            table.push_null(col++);
+        }
+    }
+    if (run) {
+        table.push_null(col);
+    } else {
+        table.push_string(col, error);
+    }
+}
+
+namespace {
+json to_json(const Value& value) {
+    return std::visit(
+        [](const auto& v) -> json {
+            if constexpr (std::is_same_v<std::decay_t<decltype(v)>, std::monostate>) {
+                return nullptr;
+            } else {
+                return v;
+            }
+        },
+        value);
+}
+
+// The result columns (see result_columns()) where run differs from base
+json diff_runs(const CalcRun& base, const CalcRun& run) {
+    json diff = json::object();
+    for (const auto& field : RESULT_FIELDS) {
+        Value value = field.get(run);
+        if (value != field.get(base)) {
+            diff[field.name] = to_json(value);
+        }
+    }
+    for (const auto& [name, flag] : DIAG_FLAGS) {
+        if (run.dungeon.damage_calc.*flag != base.dungeon.damage_calc.*flag) {
+            diff[name] = run.dungeon.damage_calc.*flag;
+        }
+    }
+    return diff;
+}
+
+// The inputs with a different game version and move power table
+CalcInputs with_version(const CalcInputs& inputs, versions::eos_version version,
+                        bool time_darkness) {
+    CalcInputs variant = inputs;
+    auto& [dungeon, attacker, defender, move, attack_power] = variant;
+    dungeon.version = version;
+    move.time_darkness = time_darkness;
+    if (move.id != eos::MOVE_PROJECTILE) {
+        attack_power = mechanics::get_move_base_power(move.id, time_darkness);
+    }
+    return variant;
+}
+} // namespace
+
+json diff_versions(const CalcInputs& inputs) {
+    const auto& [dungeon, attacker, defender, move, attack_power] = inputs;
+    // Most configs give the same results in every version and with both power tables, so only
+    // calc the variants that can differ. The version only matters through JP's Giratina bug, and
+    // the power table only matters for moves with a different power in Time/Darkness.
+    bool versions_differ = version_affects_calc(attacker, defender);
+    bool tables_differ =
+        move.id != eos::MOVE_PROJECTILE && mechanics::get_move_base_power(move.id, true) !=
+                                               mechanics::get_move_base_power(move.id, false);
+    bool base_jp = dungeon.version == versions::JP;
+
+    // Runs indexed by [JP][Time/Darkness], with the config's own in base
+    CalcRun base = run_calc(inputs);
+    std::optional<CalcRun> runs[2][2];
+    auto get_run = [&](versions::eos_version version, bool time_darkness) -> const CalcRun& {
+        bool jp = versions_differ ? version == versions::JP : base_jp;
+        if (!tables_differ) {
+            time_darkness = move.time_darkness;
+        }
+        if (jp == base_jp && time_darkness == move.time_darkness) {
+            return base;
+        }
+        auto& run = runs[jp][time_darkness];
+        if (!run) {
+            run = run_calc(with_version(inputs, version, time_darkness));
+        }
+        return *run;
+    };
+
+    json diffs = json::array();
+    for (const auto& name : ids::VERSION.all_except()) {
+        versions::eos_version version = ids::VERSION[name];
+        for (bool time_darkness : {false, true}) {
+            if (version == dungeon.version && time_darkness == move.time_darkness) {
+                continue;
+            }
+            diffs.push_back({{"version", name},
+                             {"time_darkness", time_darkness},
+                             {"diff", diff_runs(base, get_run(version, time_darkness))}});
+        }
+    }
+    return diffs;
+}
+
+namespace {
+// Number of items handed to the workers at a time
+const std::size_t BLOCK_SIZE = 1024;
+// Minimum number of rows written at a time in columnar formats
+const std::size_t TABLE_ROWS = 65536;
+
+// State that each worker thread keeps between items
+struct WorkerState {
+    cfgparse::ConfigTape tape; // Reused for parsing
+    const overlay::BaseConfigs& bases;
+};
+
+// How to read and calculate the items (lines or records) in a batch, with results of type R
+template <typename R> struct Format {
+    // Read the next item into buf, returning false at the end of the input
+    bool (*read)(std::istream& in, std::string& buf);
+    // Calculate an item, replacing result with the output
+    void (*calc)(const std::string& item, R& result, WorkerState& state);
+};
+
+// Item buffers are kept between blocks so their storage can be reused
+template <typename R> struct Block {
+    std::vector<std::string> items;
+    std::vector<R> results;
+    std::size_t size = 0;
+};
+
+template <typename R> void read_block(std::istream& in, const Format<R>& format, Block<R>& block) {
+    block.size = 0;
+    while (block.size < BLOCK_SIZE) {
+        if (block.items.size() == block.size) {
+            block.items.emplace_back();
+            block.results.emplace_back();
+        }
+        if (!format.read(in, block.items[block.size])) {
+            break;
+        }
+        block.size++;
+    }
+}
+
+bool read_line(std::istream& in, std::string& buf) {
+    auto is_space = [](unsigned char c) { return std::isspace(c); };
+    while (std::getline(in, buf)) {
+        if (!std::all_of(buf.begin(), buf.end(), is_space)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void calc_line(const std::string& line, std::string& output, WorkerState& state) {
+    json result;
+    state.tape.clear();
+    try {
+        result = calc_result(state.tape.parse(line), state.tape, state.bases);
+    } catch (const std::exception& e) {
+        result = {{"error", e.what()}};
+    }
+    output = result.dump();
+    output += '\n';
+}
+
+void calc_record(const std::string& record, std::string& output, WorkerState&) {
+    output.clear();
+    auto data = reinterpret_cast<const uint8_t*>(record.data());
+    wire::calc_request(wire::RecordView(data, record.size()), output);
+}
+
+// Result of a config as a table row
+struct RowResult {
+    std::optional<CalcRun> run;
+    std::string error;
+    std::optional<std::string> id;
+};
+
+void calc_row(const std::string& line, RowResult& row, WorkerState& state) {
+    row.run.reset();
+    row.id.reset();
+    state.tape.clear();
+    try {
+        const auto& cfg = state.tape.parse(line);
+        if (cfg.contains("id")) {
+            const auto& id = cfg.at("id");
+            row.id = id.is_string() ? std::string(id.get_string()) : id.to_json().dump();
+        }
+        row.run = run_calc(state.bases.parse(cfg, state.tape));
+    } catch (const std::exception& e) {
+        row.error = e.what();
+    }
+}
+
+const Format<std::string> JSON_LINES = {read_line, calc_line};
+const Format<std::string> BINARY = {wire::read_record, calc_record};
+const Format<RowResult> JSON_ROWS = {read_line, calc_row};
+
+// Fixed set of worker threads that calculate one block at a time
+template <typename R> class WorkerPool {
+    const Format<R>& format;
+    const overlay::BaseConfigs& bases;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    Block<R>* block = nullptr;
+    uint64_t generation = 0;
+    std::size_t n_busy = 0;
+    bool stopping = false;
+    std::atomic<std::size_t> next_item{0};
+    BaseDamageMemoStats memo_stats_;
+
+    void work() {
+        WorkerState state = {{}, bases};
+        uint64_t seen_generation = 0;
+        while (true) {
+            Block<R>* current;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start_cv.wait(lock, [&] { return stopping || generation != seen_generation; });
+                if (stopping) {
+                    return;
+                }
+                seen_generation = generation;
+                current = block;
+            }
+            for (std::size_t i = next_item++; i < current->size; i = next_item++) {
+                format.calc(current->items[i], current->results[i], state);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            memo_stats_ += base_damage_memo_stats();
+            reset_base_damage_memo_stats();
+            if (--n_busy == 0) {
+                done_cv.notify_one();
+            }
+        }
+    }
+
+  public:
+    WorkerPool(const Format<R>& format_, const overlay::BaseConfigs& bases_, unsigned n_threads)
+        : format(format_), bases(bases_) {
+        for (unsigned i = 0; i < n_threads; i++) {
+            threads.emplace_back(&WorkerPool::work, this);
+        }
+    }
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        start_cv.notify_all();
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+    void start(Block<R>& b) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            block = &b;
+            next_item = 0;
+            n_busy = threads.size();
+            generation++;
+        }
+        start_cv.notify_all();
+    }
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [&] { return n_busy == 0; });
+    }
+    // Base damage memo counts of every worker, added up after each block
+    BaseDamageMemoStats memo_stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return memo_stats_;
+    }
+};
+
+// Calculate every item in the input, passing each finished block to write_block in order.
+// Returns the workers' base damage memo counts.
+template <typename R, typename F>
+BaseDamageMemoStats run_blocks(std::istream& in, const Format<R>& format, unsigned n_threads,
+                const overlay::BaseConfigs& bases, F write_block) {
+    // Declared before the pool so the workers are stopped first if reading throws
+    Block<R> blocks[2];
+    WorkerPool<R> pool(format, bases, std::max(n_threads, 1u));
+    std::size_t cur = 0;
+    read_block(in, format, blocks[cur]);
+    while (blocks[cur].size > 0) {
+        pool.start(blocks[cur]);
+        // Read ahead while the workers are busy
+        read_block(in, format, blocks[1 - cur]);
+        pool.wait();
+        write_block(blocks[cur]);
+        cur = 1 - cur;
+    }
+    return pool.memo_stats();
+}
+
+BaseDamageMemoStats run_blocks(std::istream& in, std::ostream& out,
+                               const Format<std::string>& format, unsigned n_threads,
+                               const overlay::BaseConfigs& bases) {
+    return run_blocks(in, format, n_threads, bases, [&](const Block<std::string>& block) {
+        for (std::size_t i = 0; i < block.size; i++) {
+            out << block.results[i];
+        }
+        out.flush();
+    });
+}
+} // namespace
+
+BaseDamageMemoStats run_batch(std::istream& in, std::ostream& out, unsigned n_threads) {
+    return run_batch(in, out, n_threads, overlay::BaseConfigs());
+}
+BaseDamageMemoStats run_batch(std::istream& in, std::ostream& out, unsigned n_threads,
+                              const overlay::BaseConfigs& bases) {
+    return run_blocks(in, out, JSON_LINES, n_threads, bases);
+}
+BaseDamageMemoStats run_batch(std::istream& in, std::ostream& out, unsigned n_threads,
+                              const overlay::BaseConfigs& bases, std::string_view format) {
+    std::vector<columns::Column> schema = {{"id", columns::Type::STRING}};
+    const auto& results = result_columns();
+    schema.insert(schema.end(), results.begin(), results.end());
+    auto writer = columns::make_writer(format, out, schema);
+    columns::Table table(schema);
+    auto write_block = [&](const Block<RowResult>& block) {
+        for (std::size_t i = 0; i < block.size; i++) {
+            const RowResult& row = block.results[i];
+            if (row.id) {
+                table.push_string(0, *row.id);
+            } else {
+                table.push_null(0);
+            }
+            push_result(table, 1, row.run ? &*row.run : nullptr, row.error);
+            table.end_row();
+        }
+        if (table.n_rows() >= TABLE_ROWS) {
+            writer->write(table);
+            table.clear();
+        }
+    };
+    auto memo_stats = run_blocks(in, JSON_ROWS, n_threads, bases, write_block);
+    if (table.n_rows() > 0) {
+        writer->write(table);
+    }
+    writer->finish();
+    return memo_stats;
+}
+BaseDamageMemoStats run_binary_batch(std::istream& in, std::ostream& out, unsigned n_threads) {
+    return run_blocks(in, out, BINARY, n_threads, overlay::BaseConfigs());
+}
+} // namespace batch
@@ -0,0 +1,93 @@
+// Running damage calcs on configs, either singly or in batches of newline-delimited JSON
+
+#ifndef BATCH_HPP_
+#define BATCH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "cfgtape.hpp"
+#include "columns.hpp"
+#include "damage.hpp"
+#include "overlay.hpp"
+
+namespace batch {
+// Calc inputs, as returned by parse_cfg(): dungeon, attacker, defender, move, and move base power
+using CalcInputs = std::tuple<DungeonState, MonsterEntity, MonsterEntity, Move, int32_t>;
+
+// Results of a damage calc with both the minimum and maximum damage rolls. The inputs are the
+// states after the minimum-roll simulation, since simulating can modify them.
+struct CalcRun {
+    DungeonState dungeon;
+    MonsterEntity attacker;
+    MonsterEntity defender;
+    Move move;
+    DungeonState dungeon_max; // After the maximum-roll simulation
+    DamageData details;
+    DamageData details_max_var;
+    int32_t damage;
+    int32_t damage_max_var;
+
+    bool guaranteed_miss() const;
+};
+CalcRun run_calc(const CalcInputs& inputs);
+CalcRun run_calc(const nlohmann::json& cfg);
+CalcRun run_calc(const cfgparse::ConfigTape::Node& cfg);
+
+// Compact summary of a calc: damage (or healing) range, and hit and crit chances
+nlohmann::json summarize(const CalcRun& run);
+// Compact summary of every branch of a calc at the Huge Power/Pure Power and critical hit rolls
+// (see calcresult::damage_branches()): an array with each branch's roll outcomes, its chance as a
+// percentage, and its damage (or healing) range
+nlohmann::json summarize_branches(const CalcInputs& inputs);
+// How a calc's results change in every other game version (in ids::VERSION) and with the other
+// move power table (Sky or Time/Darkness), all from the same parsed inputs: an array with one
+// entry per version and table, each with a "diff" object holding only the result columns (see
+// result_columns()) whose values differ from the calc's own, under the same names. Only the
+// variants that can give different results (see version_affects_calc()) are calculated again.
+nlohmann::json diff_versions(const CalcInputs& inputs);
+// Result of a config in a batch: its summary, or an "error" field if it failed, with the config's
+// "id" field copied in if it has one. Configs with a "base" field are overlays (see
+// overlay::BaseConfigs::parse()), which are merged in tape. Configs with "branches": true also get
+// a "branches" field, with summarize_branches(), and configs with "versions": true get a
+// "versions" field, with diff_versions().
+nlohmann::json calc_result(const cfgparse::ConfigTape::Node& cfg, cfgparse::ConfigTape& tape,
+                           const overlay::BaseConfigs& bases);
+
+// Table columns for calc results: the attacker, defender and move, the damage (or healing) range,
+// hit and crit chances, every DamageCalcDiag field from the minimum-roll simulation, and an
+// "error" column that's only set if the calc failed
+const std::vector<columns::Column>& result_columns();
+// Push the result columns of a row to a table, starting at column first. run is null if the calc
+// failed with error.
+void push_result(columns::Table& table, std::size_t first, const CalcRun* run,
+                 std::string_view error);
+
+// Read one JSON config per line from in, and write one result object per line to out, in the same
+// order. Blank lines are skipped. If a config has an "id" field, it's copied into the result. If a
+// config fails to parse or calculate, the result has an "error" field instead.
+// Configs are parsed and calculated by n_threads worker threads, while the next block of lines is
+// read on the calling thread. Returns the workers' base damage memo counts, added up (see
+// base_damage_memo_stats()).
+BaseDamageMemoStats run_batch(std::istream& in, std::ostream& out, unsigned n_threads);
+// Same as above, but configs with a "base" field are overlays on the named base config (see
+// overlay::BaseConfigs::parse()). bases must not be modified while the batch is running.
+BaseDamageMemoStats run_batch(std::istream& in, std::ostream& out, unsigned n_threads,
+                              const overlay::BaseConfigs& bases);
+// Same as above, but writing a table in a columnar format (see columns::make_writer()) instead of
+// JSON results. The table has an "id" column, with each config's "id" field as a string, followed
+// by result_columns().
+BaseDamageMemoStats run_batch(std::istream& in, std::ostream& out, unsigned n_threads,
+                              const overlay::BaseConfigs& bases, std::string_view format);
+// Same as run_batch(), but with concatenated binary request records as input and result records
+// as output (see wire.hpp). Throws std::invalid_argument if the input isn't a sequence of complete
+// records.
+BaseDamageMemoStats run_binary_batch(std::istream& in, std::ostream& out, unsigned n_threads);
+} // namespace batch
+
+#endif
@@ -0,0 +1,227 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "batch.hpp"
+#include "cfgparse.hpp"
+#include "test_configs.hpp"
+
+using nlohmann::json;
+using test_configs::make_cfg;
+
+namespace {
+std::vector<json> run_lines(const std::string& input, unsigned n_threads) {
+    std::istringstream in(input);
+    std::ostringstream out;
+    batch::run_batch(in, out, n_threads);
+    std::vector<json> results;
+    std::istringstream lines(out.str());
+    for (std::string line; std::getline(lines, line);) {
+        results.push_back(json::parse(line));
+    }
+    return results;
+}
+
+// Split CSV into rows of fields, unquoting quoted fields
+std::vector<std::vector<std::string>> parse_csv(const std::string& csv) {
+    std::vector<std::vector<std::string>> rows(1, std::vector<std::string>(1));
+    bool quoted = false;
+    for (std::size_t i = 0; i < csv.size(); i++) {
+        char c = csv[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < csv.size() && csv[i + 1] == '"') {
+                rows.back().back() += c;
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                rows.back().back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            rows.back().emplace_back();
+        } else if (c == '\n') {
+            rows.emplace_back(1);
+        } else {
+            rows.back().back() += c;
+        }
+    }
+    rows.pop_back(); // After the last newline
+    return rows;
+}
+} // namespace
+
+TEST_CASE("summarize() works", "[batch]") {
+    auto run = batch::run_calc(make_cfg(5));
+    auto summary = batch::summarize(run);
+    REQUIRE(summary["damage"] == json{run.damage, run.damage_max_var});
+    REQUIRE(run.damage <= run.damage_max_var);
+    REQUIRE(summary["hit_chance"] == run.dungeon.rng.get_combined_hit_percentage());
+    REQUIRE(summary["crit_chance"] == run.dungeon.rng.get_computed_crit_chance());
+    REQUIRE(!summary.contains("guaranteed_miss"));
+}
+
+TEST_CASE("diff_versions() matches separate configs", "[batch]") {
+    // The JP version checks the attacker for Giratina's defense stage change, and Surf has a
+    // different power in Time/Darkness
+    json cfg = {
+        {"attacker", {{"species", "giratina"}, {"level", 50}, {"sp_atk", 100}}},
+        {"defender", {{"species", "bulbasaur"}, {"level", 50}}},
+        {"move", {{"id", "surf"}}},
+    };
+    // Versions that can't differ, between two of the same Giratina, and with nothing that differs
+    json same_giratina = cfg;
+    same_giratina["defender"]["species"] = "giratina";
+    json eu_cfg = make_cfg();
+    eu_cfg["misc"]["version"] = "EU";
+    for (const auto& c : {cfg, same_giratina, eu_cfg}) {
+        INFO(c.dump());
+        auto base = batch::run_calc(c);
+        auto diffs = batch::diff_versions(parse_cfg(c));
+        REQUIRE(diffs.size() == 5);
+        for (const auto& entry : diffs) {
+            INFO(entry.dump());
+            json variant = c;
+            variant["misc"]["version"] = entry["version"];
+            variant["move"]["time_darkness"] = entry["time_darkness"];
+            auto run = batch::run_calc(variant);
+            const auto& diff = entry["diff"];
+            REQUIRE(diff.value("min_damage", base.damage) == run.damage);
+            REQUIRE(diff.value("max_damage", base.damage_max_var) == run.damage_max_var);
+            REQUIRE(diff.value("defensive_stat_stage",
+                               int32_t(base.dungeon.damage_calc.defensive_stat_stage)) ==
+                    run.dungeon.damage_calc.defensive_stat_stage);
+            REQUIRE(!diff.contains("attacker"));
+        }
+    }
+
+    auto diffs = batch::diff_versions(parse_cfg(cfg));
+    REQUIRE(diffs[0]["version"] == "NA");
+    REQUIRE(diffs[0]["diff"].contains("max_damage"));
+    REQUIRE(diffs[1]["version"] == "EU");
+    REQUIRE(diffs[1]["diff"].empty());
+    REQUIRE(diffs[3]["version"] == "JP");
+    REQUIRE(diffs[3]["diff"].contains("defensive_stat_stage"));
+    for (const auto& entry : batch::diff_versions(parse_cfg(same_giratina))) {
+        REQUIRE(!entry["diff"].contains("defensive_stat_stage"));
+    }
+    for (const auto& entry : batch::diff_versions(parse_cfg(eu_cfg))) {
+        REQUIRE(entry["diff"].empty());
+    }
+}
+
+TEST_CASE("run_batch() works", "[batch]") {
+    SECTION("Results are in input order") {
+        // Enough lines to span multiple blocks
+        const int n_lines = 2500;
+        std::string input;
+        for (int i = 0; i < n_lines; i++) {
+            json cfg = make_cfg(1 + i % 100);
+            cfg["id"] = i;
+            input += cfg.dump() + "\n";
+        }
+        auto results = run_lines(input, 4);
+        REQUIRE(results.size() == n_lines);
+        for (int i = 0; i < n_lines; i++) {
+            REQUIRE(results[i]["id"] == i);
+            auto expected = batch::summarize(batch::run_calc(make_cfg(1 + i % 100)));
+            REQUIRE(results[i]["damage"] == expected["damage"]);
+        }
+    }
+    SECTION("Blank lines are skipped") {
+        std::string input = make_cfg(5).dump() + "\n\n  \n" + make_cfg(10).dump();
+        auto results = run_lines(input, 1);
+        REQUIRE(results.size() == 2);
+    }
+    SECTION("Errors are reported per line") {
+        json bad_species = make_cfg(5);
+        bad_species["attacker"]["species"] = "missingno";
+        bad_species["id"] = "bad";
+        std::string input = "not json\n" + bad_species.dump() + "\n" + make_cfg(5).dump() + "\n";
+        auto results = run_lines(input, 2);
+        REQUIRE(results.size() == 3);
+        REQUIRE(results[0].contains("error"));
+        REQUIRE(results[1].contains("error"));
+        REQUIRE(results[1]["id"] == "bad");
+        REQUIRE(results[2].contains("damage"));
+    }
+    SECTION("Empty input gives empty output") { REQUIRE(run_lines("", 2).empty()); }
+    SECTION("The workers' base damage memo counts are added up") {
+        // The same config over and over only misses the memo once per worker
+        const int n_lines = 500;
+        std::string input;
+        for (int i = 0; i < n_lines; i++) {
+            input += make_cfg(5).dump() + "\n";
+        }
+        std::istringstream in(input);
+        std::ostringstream out;
+        auto stats = batch::run_batch(in, out, 4);
+        REQUIRE(stats.hits + stats.misses >= n_lines);
+        REQUIRE(stats.misses <= 4);
+        REQUIRE(stats.hit_rate() > 0.99);
+    }
+    SECTION("Configs can ask for the crit branches") {
+        json cfg = make_cfg(50);
+        cfg["branches"] = true;
+        auto results = run_lines(make_cfg(50).dump() + "\n" + cfg.dump() + "\n", 1);
+        REQUIRE(!results[0].contains("branches"));
+        REQUIRE(results[1]["branches"] == batch::summarize_branches(parse_cfg(make_cfg(50))));
+        REQUIRE(results[1]["branches"].size() == 2);
+        REQUIRE(results[1]["branches"][1]["critical_hit"] == true);
+        REQUIRE(results[1]["branches"][1]["chance"] == results[1]["crit_chance"]);
+    }
+}
+
+TEST_CASE("run_batch() can write tables", "[batch]") {
+    json bad_species = make_cfg(5);
+    bad_species["attacker"]["species"] = "missingno";
+    json with_id = make_cfg(10);
+    with_id["id"] = 3;
+    std::string input = bad_species.dump() + "\n" + with_id.dump() + "\n";
+    std::istringstream in(input);
+    std::ostringstream out;
+    batch::run_batch(in, out, 2, overlay::BaseConfigs(), "csv");
+    auto rows = parse_csv(out.str());
+    REQUIRE(rows.size() == 3);
+
+    const auto& header = rows[0];
+    REQUIRE(header.size() == 1 + batch::result_columns().size());
+    REQUIRE(header[0] == "id");
+    auto col = [&](const std::string& name) {
+        for (std::size_t i = 0; i < header.size(); i++) {
+            if (header[i] == name) {
+                return i;
+            }
+        }
+        FAIL("no column " << name);
+        return std::size_t(0);
+    };
+    for (const auto& row : rows) {
+        REQUIRE(row.size() == header.size());
+    }
+
+    // Failed calcs only have an error
+    REQUIRE(rows[1][col("id")] == "");
+    REQUIRE(rows[1][col("min_damage")] == "");
+    REQUIRE(!rows[1][col("error")].empty());
+
+    auto run = batch::run_calc(make_cfg(10));
+    const auto& row = rows[2];
+    REQUIRE(row[col("id")] == "3");
+    REQUIRE(row[col("attacker")] == "Charmander");
+    REQUIRE(row[col("attacker_level")] == "10");
+    REQUIRE(row[col("move")] == "Ember");
+    REQUIRE(row[col("min_damage")] == std::to_string(run.damage));
+    REQUIRE(row[col("max_damage")] == std::to_string(run.damage_max_var));
+    REQUIRE(row[col("healed")] == "false");
+    REQUIRE(row[col("crit_chance")] ==
+            std::to_string(run.dungeon.rng.get_computed_crit_chance()));
+    REQUIRE(row[col("move_type")] == "Fire");
+    REQUIRE(row[col("offensive_stat")] == std::to_string(run.dungeon.damage_calc.offensive_stat));
+    REQUIRE(row[col("stab_boost_activated")] == "true");
+    REQUIRE(row[col("error")] == "");
+
+    REQUIRE_THROWS_AS(batch::run_batch(in, out, 1, overlay::BaseConfigs(), "xml"),
+                      std::invalid_argument);
+}
@@ -0,0 +1,292 @@
+#include "calcresult.hpp"
+
+#include "idmap.hpp"
+#include "pmdsky.hpp"
+
+using nlohmann::json;
+
+namespace calcresult {
+namespace {
+// Simulate with a copy of the inputs, since simulating can modify them. Returns the damage, or
+// the healing if details.healed is set.
+int32_t simulate(const CalcInputs& inputs, double variance_dial, DungeonState& dungeon,
+                 DamageData& details) {
+    auto [dungeon_in, attacker, defender, move, attack_power] = inputs;
+    dungeon = dungeon_in;
+    dungeon.rng.variance_dial = variance_dial;
+    int32_t damage = 0;
+    if (move.id == eos::MOVE_PROJECTILE) {
+        damage = simulate_damage_calc_projectile(details, dungeon, attacker, defender, attack_power);
+    } else {
+        damage = simulate_damage_calc(details, dungeon, attacker, defender, move);
+    }
+    return details.healed ? details.damage : damage;
+}
+
+// Simulate every branch of a calc (see simulate_damage_branches()) with the average damage roll
+DamageBranches simulate_branches(const CalcInputs& inputs) {
+    auto [dungeon, attacker, defender, move, attack_power] = inputs;
+    dungeon.rng.variance_dial = 0.5;
+    if (move.id == eos::MOVE_PROJECTILE) {
+        return simulate_damage_branches_projectile(dungeon, attacker, defender, attack_power);
+    }
+    return simulate_damage_branches(dungeon, attacker, defender, move);
+}
+// The damage (or the healing if details.healed is set) on a branch, given its details.damage with
+// some damage roll
+int32_t branch_damage(const DamageBranch& branch, int32_t details_damage) {
+    return branch.details.no_damage && !branch.details.healed ? 0 : details_damage;
+}
+
+bool is_guaranteed_miss(const DungeonState& dungeon) {
+    return dungeon.damage_calc.two_turn_move_forced_miss ||
+           dungeon.damage_calc.soundproof_activated || dungeon.damage_calc.first_hit_check_failed ||
+           dungeon.damage_calc.dream_eater_failed || dungeon.damage_calc.last_resort_failed;
+}
+} // namespace
+
+CalcDamageResult calc_damage(const CalcInputs& inputs) {
+    DungeonState dungeon, dungeon_min, dungeon_max;
+    DamageData details = {};
+    DamageData details_min_var = {};
+    DamageData details_max_var = {};
+
+    CalcDamageResult result = {};
+    result.avg_damage = simulate(inputs, 0.5, dungeon, details);            // average damage roll
+    result.min_damage = simulate(inputs, 0, dungeon_min, details_min_var); // minimum damage roll
+    result.max_damage = simulate(inputs, 1, dungeon_max, details_max_var); // maximum damage roll
+    result.healed = details.healed;
+    if (is_guaranteed_miss(dungeon)) {
+        result.guaranteed_miss = true;
+        return result;
+    }
+    result.hit_chance = dungeon.rng.get_combined_hit_percentage();
+    result.crit_chance = dungeon.rng.get_computed_crit_chance();
+
+    const auto& calc = dungeon.damage_calc;
+    auto& res_details = result.details;
+    res_details.damage_message = ids::DAMAGE_MESSAGE[details.damage_message];
+    res_details.type_matchup = ids::TYPE_MATCHUP[details.type_matchup];
+    res_details.indiv_type_matchup1 = ids::TYPE_MATCHUP[calc.move_indiv_type_matchups[0]];
+    res_details.indiv_type_matchup2 = ids::TYPE_MATCHUP[calc.move_indiv_type_matchups[1]];
+    res_details.move_type = ids::TYPE[details.type];
+    res_details.move_category = ids::MOVE_CATEGORY[details.category];
+    res_details.critical_hit = details.critical_hit;
+    res_details.full_type_immunity = details.full_type_immunity;
+    res_details.no_damage = details.no_damage;
+
+    auto& calc_details = res_details.calc;
+    calc_details.offensive_stat_stage = calc.offensive_stat_stage;
+    calc_details.defensive_stat_stage = calc.defensive_stat_stage;
+    calc_details.offensive_stat = calc.offensive_stat;
+    calc_details.defensive_stat = calc.defensive_stat;
+    calc_details.offense_calc = calc.offense_calc;
+    calc_details.defense_calc = calc.defense_calc;
+    calc_details.damage_calc_at = calc.damage_calc_at;
+    calc_details.damage_calc_def = calc.damage_calc_def;
+    calc_details.damage_calc_flv = calc.damage_calc_flv;
+    calc_details.damage_calc_base = calc.damage_calc_base;
+    calc_details.static_damage_mult = calc.static_damage_mult.val();
+    calc_details.damage_calc = calc.damage_calc;
+    calc_details.avg_random_damage_mult_pct = calc.damage_calc_random_mult_pct;
+    calc_details.min_random_damage_mult_pct = dungeon_min.damage_calc.damage_calc_random_mult_pct;
+    calc_details.max_random_damage_mult_pct = dungeon_max.damage_calc.damage_calc_random_mult_pct;
+
+    auto& mod_details = calc_details.modifiers;
+    mod_details.item_atk = calc.item_atk_modifier;
+    mod_details.item_spatk = calc.item_sp_atk_modifier;
+    mod_details.item_def = calc.item_def_modifier;
+    mod_details.item_spdef = calc.item_sp_def_modifier;
+    mod_details.ability_offense = calc.ability_offense_modifier;
+    mod_details.ability_defense = calc.ability_defense_modifier;
+    mod_details.iq_skill_offense = calc.iq_skill_offense_modifier;
+    mod_details.iq_skill_defense = calc.iq_skill_defense_modifier;
+    mod_details.scope_lens_or_sharpshooter = calc.scope_lens_or_sharpshooter_activated;
+    mod_details.patsy_band = calc.patsy_band_activated;
+    mod_details.half_physical_damage = calc.half_physical_damage_activated;
+    mod_details.half_special_damage = calc.half_special_damage_activated;
+    mod_details.focus_energy = calc.focus_energy_activated;
+    mod_details.type_advantage_master = calc.type_advantage_master_activated;
+    mod_details.cloudy_drop = calc.cloudy_drop_activated;
+    mod_details.rain_multiplier = calc.rain_multiplier_activated;
+    mod_details.sunny_multiplier = calc.sunny_multiplier_activated;
+    mod_details.thick_fat_heatproof = calc.fire_move_ability_drop_activated;
+    mod_details.flash_fire = calc.flash_fire_activated;
+    mod_details.levitate = calc.levitate_activated;
+    mod_details.overgrow = calc.overgrow_boost_activated;
+    mod_details.swarm = calc.swarm_boost_activated;
+    mod_details.blaze_dry_skin = calc.fire_move_ability_boost_activated;
+    mod_details.scrappy = calc.scrappy_activated;
+    mod_details.super_luck = calc.super_luck_activated;
+    mod_details.sniper = calc.sniper_activated;
+    mod_details.stab = calc.stab_boost_activated;
+    mod_details.mud_sport_fog = calc.electric_move_dampened;
+    mod_details.water_sport = calc.water_sport_drop_activated;
+    mod_details.charge = calc.charge_boost_activated;
+    mod_details.ghost_immunity = calc.ghost_immunity_activated;
+    mod_details.skull_bash = calc.skull_bash_defense_boost_activated;
+
+    return result;
+}
+
+json to_json(const CalcDamageResult& result) {
+    const auto& details = result.details;
+    const auto& calc = details.calc;
+    const auto& mods = calc.modifiers;
+    return {
+        {"avgDamage", result.avg_damage},
+        {"minDamage", result.min_damage},
+        {"maxDamage", result.max_damage},
+        {"healed", result.healed},
+        {"hitChance", result.hit_chance},
+        {"guaranteedMiss", result.guaranteed_miss},
+        {"critChance", result.crit_chance},
+        {"details",
+         {
+             {"damageMessage", details.damage_message},
+             {"typeMatchup", details.type_matchup},
+             {"indivTypeMatchup1", details.indiv_type_matchup1},
+             {"indivTypeMatchup2", details.indiv_type_matchup2},
+             {"moveType", details.move_type},
+             {"moveCategory", details.move_category},
+             {"criticalHit", details.critical_hit},
+             {"fullTypeImmunity", details.full_type_immunity},
+             {"noDamage", details.no_damage},
+             {"calc",
+              {
+                  {"offensiveStatStage", calc.offensive_stat_stage},
+                  {"defensiveStatStage", calc.defensive_stat_stage},
+                  {"offensiveStat", calc.offensive_stat},
+                  {"defensiveStat", calc.defensive_stat},
+                  {"offenseCalc", calc.offense_calc},
+                  {"defenseCalc", calc.defense_calc},
+                  {"damageCalcAt", calc.damage_calc_at},
+                  {"damageCalcDef", calc.damage_calc_def},
+                  {"damageCalcFlv", calc.damage_calc_flv},
+                  {"damageCalcBase", calc.damage_calc_base},
+                  {"staticDamageMult", calc.static_damage_mult},
+                  {"damageCalc", calc.damage_calc},
+                  {"avgRandomDamageMultPct", calc.avg_random_damage_mult_pct},
+                  {"minRandomDamageMultPct", calc.min_random_damage_mult_pct},
+                  {"maxRandomDamageMultPct", calc.max_random_damage_mult_pct},
+                  {"modifiers",
+                   {
+                       {"itemAtk", mods.item_atk},
+                       {"itemSpAtk", mods.item_spatk},
+                       {"itemDef", mods.item_def},
+                       {"itemSpDef", mods.item_spdef},
+                       {"abilityOffense", mods.ability_offense},
+                       {"abilityDefense", mods.ability_defense},
+                       {"iqSkillOffense", mods.iq_skill_offense},
+                       {"iqSkillDefense", mods.iq_skill_defense},
+                       {"scopeLensOrSharpshooter", mods.scope_lens_or_sharpshooter},
+                       {"patsyBand", mods.patsy_band},
+                       {"halfPhysicalDamage", mods.half_physical_damage},
+                       {"halfSpecialDamage", mods.half_special_damage},
+                       {"focusEnergy", mods.focus_energy},
+                       {"typeAdvantageMaster", mods.type_advantage_master},
+                       {"cloudyDrop", mods.cloudy_drop},
+                       {"rainMultiplier", mods.rain_multiplier},
+                       {"sunnyMultiplier", mods.sunny_multiplier},
+                       {"thickFatHeatproof", mods.thick_fat_heatproof},
+                       {"flashFire", mods.flash_fire},
+                       {"levitate", mods.levitate},
+                       {"overgrow", mods.overgrow},
+                       {"swarm", mods.swarm},
+                       {"blazeDrySkin", mods.blaze_dry_skin},
+                       {"scrappy", mods.scrappy},
+                       {"superLuck", mods.super_luck},
+                       {"sniper", mods.sniper},
+                       {"stab", mods.stab},
+                       {"mudSportFog", mods.mud_sport_fog},
+                       {"waterSport", mods.water_sport},
+                       {"charge", mods.charge},
+                       {"ghostImmunity", mods.ghost_immunity},
+                       {"skullBash", mods.skull_bash},
+                   }},
+              }},
+         }},
+    };
+}
+
+DamageDistribution damage_distribution(const CalcInputs& inputs) {
+    DamageDistribution dist;
+    DungeonState dungeon;
+    DamageData details;
+    auto damage_at = [&](int32_t roll) {
+        details = {};
+        return simulate(inputs, roll / double(N_DAMAGE_ROLLS - 1), dungeon, details);
+    };
+
+    int32_t roll = 0;
+    int32_t damage = damage_at(roll);
+    dist.healed = details.healed;
+    dist.guaranteed_miss = is_guaranteed_miss(dungeon);
+    while (roll < N_DAMAGE_ROLLS) {
+        // Damage is non-decreasing in the damage roll, so the first roll that does more damage
+        // than this one can be found by bisection, rather than by simulating every roll
+        int32_t lo = roll + 1;
+        int32_t hi = N_DAMAGE_ROLLS;
+        while (lo < hi) {
+            int32_t mid = lo + (hi - lo) / 2;
+            if (damage_at(mid) > damage) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        dist.counts.push_back({damage, lo - roll});
+        roll = lo;
+        if (roll < N_DAMAGE_ROLLS) {
+            damage = damage_at(roll);
+        }
+    }
+    return dist;
+}
+
+json to_json(const DamageDistribution& dist) {
+    json counts = json::array();
+    for (const auto& c : dist.counts) {
+        counts.push_back({{"damage", c.damage},
+                          {"count", c.count},
+                          {"probability", c.count / double(N_DAMAGE_ROLLS)}});
+    }
+    return {
+        {"healed", dist.healed},
+        {"guaranteedMiss", dist.guaranteed_miss},
+        {"rolls", N_DAMAGE_ROLLS},
+        {"distribution", counts},
+    };
+}
+std::vector<DamageBranchResult> damage_branches(const CalcInputs& inputs) {
+    std::vector<DamageBranchResult> results;
+    for (const auto& branch : simulate_branches(inputs)) {
+        DamageBranchResult result;
+        result.huge_pure_power = branch.huge_pure_power;
+        result.critical_hit = branch.critical_hit;
+        result.chance = branch.chance / 100.0;
+        result.avg_damage = branch_damage(branch, branch.details.damage);
+        result.min_damage = branch_damage(branch, branch.min_roll_damage);
+        result.max_damage = branch_damage(branch, branch.max_roll_damage);
+        result.healed = branch.details.healed;
+        results.push_back(result);
+    }
+    return results;
+}
+
+json to_json(const std::vector<DamageBranchResult>& branches) {
+    json results = json::array();
+    for (const auto& b : branches) {
+        results.push_back({
+            {"hugePurePower", b.huge_pure_power},
+            {"criticalHit", b.critical_hit},
+            {"chance", b.chance},
+            {"avgDamage", b.avg_damage},
+            {"minDamage", b.min_damage},
+            {"maxDamage", b.max_damage},
+            {"healed", b.healed},
+        });
+    }
+    return results;
+}
+} // namespace calcresult
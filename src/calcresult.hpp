@@ -0,0 +1,135 @@
+// Full damage calc results, as returned by the web app's calcDamage()
+
+#ifndef CALCRESULT_HPP_
+#define CALCRESULT_HPP_
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "damage.hpp"
+
+namespace calcresult {
+// Calc inputs, as returned by parse_cfg() (same as batch::CalcInputs)
+using CalcInputs = std::tuple<DungeonState, MonsterEntity, MonsterEntity, Move, int32_t>;
+
+struct ModifierDetails {
+    int item_atk = 0;
+    int item_spatk = 0;
+    int item_def = 0;
+    int item_spdef = 0;
+    int ability_offense = 0;
+    int ability_defense = 0;
+    int iq_skill_offense = 0;
+    int iq_skill_defense = 0;
+    bool scope_lens_or_sharpshooter = false;
+    bool patsy_band = false;
+    bool half_physical_damage = false;
+    bool half_special_damage = false;
+    bool focus_energy = false;
+    bool type_advantage_master = false;
+    bool cloudy_drop = false;
+    bool rain_multiplier = false;
+    bool sunny_multiplier = false;
+    bool thick_fat_heatproof = false;
+    bool flash_fire = false;
+    bool levitate = false;
+    bool overgrow = false;
+    bool swarm = false;
+    bool blaze_dry_skin = false;
+    bool scrappy = false;
+    bool super_luck = false;
+    bool sniper = false;
+    bool stab = false;
+    bool mud_sport_fog = false;
+    bool water_sport = false;
+    bool charge = false;
+    bool ghost_immunity = false;
+    bool skull_bash = false;
+};
+struct CalcDetails {
+    int offensive_stat_stage = 0;
+    int defensive_stat_stage = 0;
+    int offensive_stat = 0;
+    int defensive_stat = 0;
+    int offense_calc = 0;
+    int defense_calc = 0;
+    int damage_calc_at = 0;
+    int damage_calc_def = 0;
+    int damage_calc_flv = 0;
+    int damage_calc_base = 0;
+    double static_damage_mult = 0;
+    int damage_calc = 0;
+    int avg_random_damage_mult_pct = 0;
+    int min_random_damage_mult_pct = 0;
+    int max_random_damage_mult_pct = 0;
+    ModifierDetails modifiers = {};
+};
+struct ResultDetails {
+    std::string damage_message = "";
+    std::string type_matchup = "";
+    std::string indiv_type_matchup1 = "";
+    std::string indiv_type_matchup2 = "";
+    std::string move_type = "";
+    std::string move_category = "";
+    bool critical_hit = false;
+    bool full_type_immunity = false;
+    bool no_damage = false;
+    CalcDetails calc = {};
+};
+struct CalcDamageResult {
+    int avg_damage = 0;
+    int min_damage = 0;
+    int max_damage = 0;
+    bool healed = false;
+    double hit_chance = 0;
+    bool guaranteed_miss = false;
+    int crit_chance = 0;
+    ResultDetails details = {};
+};
+
+// Calculate damage with the average, minimum and maximum damage rolls. If the move is a
+// guaranteed miss, only the damage and healed fields are filled in.
+CalcDamageResult calc_damage(const CalcInputs& inputs);
+
+// The same fields as the web app's CalcDamageResult object, with the same (camelCase) names
+nlohmann::json to_json(const CalcDamageResult& result);
+
+// Number of equally likely damage rolls in-game
+const int32_t N_DAMAGE_ROLLS = 0x4000;
+
+// How many of the damage rolls give a particular amount of damage (or healing)
+struct DamageCount {
+    int32_t damage;
+    int32_t count;
+};
+struct DamageDistribution {
+    bool healed = false;
+    bool guaranteed_miss = false;
+    // Sorted by damage, with counts summing to N_DAMAGE_ROLLS
+    std::vector<DamageCount> counts;
+};
+// Exact distribution of damage over every damage roll, given the rest of the config (including
+// whether it's a critical hit)
+DamageDistribution damage_distribution(const CalcInputs& inputs);
+nlohmann::json to_json(const DamageDistribution& dist);
+
+// Damage with the average, minimum and maximum damage rolls on one branch of a calc at the Huge
+// Power/Pure Power and critical hit rolls (see simulate_damage_branches())
+struct DamageBranchResult {
+    bool huge_pure_power = false;
+    bool critical_hit = false;
+    double chance = 0; // As a percentage
+    int avg_damage = 0;
+    int min_damage = 0;
+    int max_damage = 0;
+    bool healed = false;
+};
+// Every branch of a calc at the Huge Power/Pure Power and critical hit rolls, whatever the config
+// says about them, with chances summing to 100%
+std::vector<DamageBranchResult> damage_branches(const CalcInputs& inputs);
+nlohmann::json to_json(const std::vector<DamageBranchResult>& branches);
+} // namespace calcresult
+
+#endif
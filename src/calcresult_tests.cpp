@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <map>
+#include <vector>
+#include "batch.hpp"
+#include "calcresult.hpp"
+
+using nlohmann::json;
+
+namespace {
+std::vector<json> test_configs() {
+    json ember = {
+        {"attacker", {{"species", "charmander"}, {"level", 50}, {"sp_atk", 120}}},
+        {"defender", {{"species", "bulbasaur"}, {"level", 40}}},
+        {"move", {{"id", "ember"}}},
+    };
+    json crit = ember;
+    crit["rng"] = {{"critical_hit", true}};
+    json heal = {
+        {"attacker", {{"species", "squirtle"}, {"level", 60}, {"sp_atk", 150}}},
+        {"defender", {{"species", "lapras"}, {"ability1", "water absorb"}}},
+        {"move", {{"id", "water gun"}}},
+    };
+    json projectile = {
+        {"attacker", {{"species", "pikachu"}, {"level", 99}, {"atk", 200}}},
+        {"defender", {{"species", "onix"}}},
+        {"move", {{"id", "gold fang"}}},
+    };
+    json immune = {
+        {"attacker", {{"species", "pikachu"}}},
+        {"defender", {{"species", "onix"}}},
+        {"move", {{"id", "thundershock"}}},
+    };
+    return {ember, crit, heal, projectile, immune};
+}
+} // namespace
+
+TEST_CASE("calc_damage matches run_calc", "[calcresult]") {
+    for (const auto& cfg : test_configs()) {
+        INFO(cfg.dump());
+        auto inputs = parse_cfg(cfg);
+        auto result = calcresult::calc_damage(inputs);
+        auto run = batch::run_calc(inputs);
+        REQUIRE(result.healed == run.details.healed);
+        REQUIRE(result.min_damage == (run.details.healed ? run.details.damage : run.damage));
+        REQUIRE(result.max_damage ==
+                (run.details.healed ? run.details_max_var.damage : run.damage_max_var));
+        REQUIRE(result.min_damage <= result.avg_damage);
+        REQUIRE(result.avg_damage <= result.max_damage);
+        REQUIRE(result.guaranteed_miss == run.guaranteed_miss());
+
+        auto result_json = calcresult::to_json(result);
+        REQUIRE(result_json["avgDamage"] == result.avg_damage);
+        REQUIRE(result_json["details"]["moveType"] == result.details.move_type);
+        REQUIRE(result_json["details"]["calc"]["modifiers"]["stab"] ==
+                result.details.calc.modifiers.stab);
+    }
+}
+
+TEST_CASE("Damage distributions are exact", "[calcresult]") {
+    for (const auto& cfg : test_configs()) {
+        INFO(cfg.dump());
+        auto inputs = parse_cfg(cfg);
+        auto dist = calcresult::damage_distribution(inputs);
+
+        // Simulate every damage roll
+        std::map<int32_t, int32_t> expected;
+        for (int32_t roll = 0; roll < calcresult::N_DAMAGE_ROLLS; roll++) {
+            auto [dungeon, attacker, defender, move, attack_power] = inputs;
+            dungeon.rng.variance_dial = roll / double(calcresult::N_DAMAGE_ROLLS - 1);
+            DamageData details = {};
+            int32_t damage =
+                move.id == eos::MOVE_PROJECTILE
+                    ? simulate_damage_calc_projectile(details, dungeon, attacker, defender,
+                                                      attack_power)
+                    : simulate_damage_calc(details, dungeon, attacker, defender, move);
+            REQUIRE(details.healed == dist.healed);
+            expected[details.healed ? details.damage : damage]++;
+        }
+        std::map<int32_t, int32_t> actual;
+        for (const auto& count : dist.counts) {
+            REQUIRE(actual.count(count.damage) == 0);
+            actual[count.damage] = count.count;
+        }
+        REQUIRE(actual == expected);
+
+        auto result = calcresult::calc_damage(inputs);
+        REQUIRE(dist.counts.front().damage == result.min_damage);
+        REQUIRE(dist.counts.back().damage == result.max_damage);
+        auto dist_json = calcresult::to_json(dist);
+        REQUIRE(dist_json["rolls"] == calcresult::N_DAMAGE_ROLLS);
+        REQUIRE(dist_json["distribution"].size() == dist.counts.size());
+    }
+}
+
+TEST_CASE("Damage branches match calcs with the rolls forced", "[calcresult]") {
+    json huge_power = {
+        {"attacker",
+         {{"species", "marill"}, {"level", 60}, {"atk", 120}, {"ability1", "huge power"}}},
+        {"defender", {{"species", "geodude"}, {"level", 30}}},
+        {"move", {{"id", "tackle"}}},
+    };
+    auto configs = test_configs();
+    configs.push_back(huge_power);
+    for (const auto& cfg : configs) {
+        INFO(cfg.dump());
+        auto inputs = parse_cfg(cfg);
+        auto branches = calcresult::damage_branches(inputs);
+        REQUIRE(!branches.empty());
+        long total_chance = 0; // In hundredths of a percent, to add up exactly
+        for (const auto& branch : branches) {
+            total_chance += std::lround(branch.chance * 100);
+            auto forced = inputs;
+            std::get<0>(forced).rng.huge_pure_power = branch.huge_pure_power;
+            std::get<0>(forced).rng.critical_hit = branch.critical_hit;
+            auto result = calcresult::calc_damage(forced);
+            REQUIRE(branch.avg_damage == result.avg_damage);
+            REQUIRE(branch.min_damage == result.min_damage);
+            REQUIRE(branch.max_damage == result.max_damage);
+            REQUIRE(branch.healed == result.healed);
+        }
+        REQUIRE(total_chance == 10000);
+    }
+
+    auto branches = calcresult::damage_branches(parse_cfg(huge_power));
+    REQUIRE(branches.size() == 4);
+    REQUIRE(branches[0].max_damage < branches[1].max_damage); // Crit
+    REQUIRE(branches[0].max_damage < branches[2].max_damage); // Huge Power
+    REQUIRE(branches[2].chance + branches[3].chance == 33);
+    REQUIRE(calcresult::to_json(branches)[3]["hugePurePower"] == true);
+}
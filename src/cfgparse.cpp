@@ -3,10 +3,22 @@
 #include "idmap.hpp"
 
 using nlohmann::json;
+using cfgparse::ConfigTape;
+using Node = cfgparse::ConfigTape::Node;
+
+namespace {
+// Defaults for missing objects and arrays
+const ConfigTape& empty_tape() {
+    static const ConfigTape tape;
+    return tape;
+}
+Node empty_object() { return empty_tape().empty_object(); }
+Node empty_array() { return empty_tape().empty_array(); }
+} // namespace
 
 // See the top-level sample-config.json for example config
 
-Fx32 json_get_fx32(const json& obj, const std::string name, double default_val = 0) {
+Fx32 json_get_fx32(const Node& obj, const std::string name, double default_val = 0) {
     double v = obj.value(name, default_val);
     if (v < -(1 << 23)) {
         throw std::underflow_error(name + ": " + std::to_string(v) + " out of range (min " +
@@ -22,12 +34,17 @@ Fx32 json_get_fx32(const json& obj, const std::string name, double default_val =
     uint8_t fpart = static_cast<uint8_t>((v - ipart) * (1 << 8));
     return Fx32{ipart, fpart};
 }
+Fx32 json_get_fx32(const json& obj, const std::string name, double default_val = 0) {
+    ConfigTape tape;
+    return json_get_fx32(tape.add(obj), name, default_val);
+}
 
-DungeonState parse_dungeon_cfg(const json& dungeon_obj, const json& rng_obj, const json& misc_obj) {
+DungeonState parse_dungeon_cfg(const Node& dungeon_obj, const Node& rng_obj,
+                               const Node& misc_obj) {
     DungeonState dungeon = {};
 
     if (dungeon_obj.contains("weather")) {
-        dungeon.weather = ids::WEATHER[dungeon_obj.at("weather").get<std::string>()];
+        dungeon.weather = ids::WEATHER[dungeon_obj.at("weather").get_string()];
     }
     dungeon.mud_sport_turns = dungeon_obj.value("mud_sport", false) ? 1 : 0;
     dungeon.water_sport_turns = dungeon_obj.value("water_sport", false) ? 1 : 0;
@@ -35,39 +52,46 @@ DungeonState parse_dungeon_cfg(const json& dungeon_obj, const json& rng_obj, con
     dungeon.iq_disabled = dungeon_obj.value("iq_disabled", false);
     dungeon.gen_info.fixed_room_id = eos::fixed_room_id(dungeon_obj.value("fixed_room_id", 0));
 
-    const json& plus = dungeon_obj.value("plus", json({}));
+    Node plus = dungeon_obj.value("plus", empty_object());
     dungeon.plus_is_active[0] = plus.value("enemy", false);
     dungeon.plus_is_active[1] = plus.value("team", false);
-    const json& minus = dungeon_obj.value("minus", json({}));
+    Node minus = dungeon_obj.value("minus", empty_object());
     dungeon.minus_is_active[0] = minus.value("enemy", false);
     dungeon.minus_is_active[1] = minus.value("team", false);
 
-    const json& other_monsters = dungeon_obj.value("other_monsters", json({}));
-    const json& iq_array = other_monsters.value("iq", json::array());
-    for (auto& iq : iq_array) {
-        dungeon.other_monsters.iq_skill_flags[ids::IQ[iq.get<std::string>()]] = true;
+    Node other_monsters = dungeon_obj.value("other_monsters", empty_object());
+    Node iq_array = other_monsters.value("iq", empty_array());
+    for (auto iq : iq_array) {
+        dungeon.other_monsters.iq_skill_flags[ids::IQ[iq.get_string()]] = true;
     }
-    const json& ability_array = other_monsters.value("abilities", json::array());
-    for (auto& ability : ability_array) {
-        dungeon.other_monsters.abilities[ids::ABILITY[ability.get<std::string>()]] = true;
+    Node ability_array = other_monsters.value("abilities", empty_array());
+    for (auto ability : ability_array) {
+        dungeon.other_monsters.abilities[ids::ABILITY[ability.get_string()]] = true;
     }
 
     dungeon.rng.huge_pure_power = rng_obj.value("huge_pure_power", false);
     dungeon.rng.critical_hit = rng_obj.value("critical_hit", false);
 
     if (misc_obj.contains("version")) {
-        dungeon.version = ids::VERSION[misc_obj.at("version").get<std::string>()];
+        dungeon.version = ids::VERSION[misc_obj.at("version").get_string()];
     }
 
     return dungeon;
 }
-MonsterEntity parse_monster_cfg(const json& monster_obj) {
+DungeonState parse_dungeon_cfg(const json& dungeon_obj, const json& rng_obj, const json& misc_obj) {
+    ConfigTape tape;
+    Node dungeon_node = tape.add(dungeon_obj);
+    Node rng_node = tape.add(rng_obj);
+    Node misc_node = tape.add(misc_obj);
+    return parse_dungeon_cfg(dungeon_node, rng_node, misc_node);
+}
+MonsterEntity parse_monster_cfg(const Node& monster_obj) {
     Monster monster = {};
 
-    const json& species = monster_obj.at("species");
+    Node species = monster_obj.at("species");
     eos::monster_id monster_id;
     if (species.is_string()) {
-        monster_id = ids::MONSTER[species.get<std::string>()];
+        monster_id = ids::MONSTER[species.get_string()];
     } else {
         throw std::runtime_error("custom species not implemented");
     }
@@ -79,16 +103,16 @@ MonsterEntity parse_monster_cfg(const json& monster_obj) {
     monster.abilities[1] = mdata.abilities[1];
     // Overrides
     if (monster_obj.contains("type1")) {
-        monster.types[0] = ids::TYPE[monster_obj.at("type1").get<std::string>()];
+        monster.types[0] = ids::TYPE[monster_obj.at("type1").get_string()];
     }
     if (monster_obj.contains("type2")) {
-        monster.types[1] = ids::TYPE[monster_obj.at("type2").get<std::string>()];
+        monster.types[1] = ids::TYPE[monster_obj.at("type2").get_string()];
     }
     if (monster_obj.contains("ability1")) {
-        monster.abilities[0] = ids::ABILITY[monster_obj.at("ability1").get<std::string>()];
+        monster.abilities[0] = ids::ABILITY[monster_obj.at("ability1").get_string()];
     }
     if (monster_obj.contains("ability2")) {
-        monster.abilities[1] = ids::ABILITY[monster_obj.at("ability2").get<std::string>()];
+        monster.abilities[1] = ids::ABILITY[monster_obj.at("ability2").get_string()];
     }
 
     monster.is_not_team_member = !monster_obj.value("is_team_member", false);
@@ -103,8 +127,8 @@ MonsterEntity parse_monster_cfg(const json& monster_obj) {
     monster.iq = json_get_int<int16_t>(monster_obj, "iq");
     monster.belly = DecFx16_16(json_get_int<int16_t>(monster_obj, "belly", 100));
 
-    const json& stat_modifiers = monster_obj.value("stat_modifiers", json({}));
-    const json& stages = stat_modifiers.value("stages", json({}));
+    Node stat_modifiers = monster_obj.value("stat_modifiers", empty_object());
+    Node stages = stat_modifiers.value("stages", empty_object());
     monster.stat_modifiers.offensive_stages[0] = json_get_int<int16_t>(stages, "atk", 10);
     monster.stat_modifiers.offensive_stages[1] = json_get_int<int16_t>(stages, "sp_atk", 10);
     monster.stat_modifiers.defensive_stages[0] = json_get_int<int16_t>(stages, "def", 10);
@@ -113,7 +137,7 @@ MonsterEntity parse_monster_cfg(const json& monster_obj) {
     monster.stat_modifiers.hit_chance_stages[1] = json_get_int<int16_t>(stages, "evasion", 10);
     monster.statuses.speed_stage = json_get_int<int32_t>(stages, "speed", 1);
     monster.statuses.stockpile_stage = json_get_int<uint8_t>(stages, "stockpile");
-    const json& multipliers = stat_modifiers.value("multipliers", json({}));
+    Node multipliers = stat_modifiers.value("multipliers", empty_object());
     monster.stat_modifiers.offensive_multipliers[0] = json_get_fx32(multipliers, "atk", 1);
     monster.stat_modifiers.offensive_multipliers[1] = json_get_fx32(multipliers, "sp_atk", 1);
     monster.stat_modifiers.defensive_multipliers[0] = json_get_fx32(multipliers, "def", 1);
@@ -129,40 +153,40 @@ MonsterEntity parse_monster_cfg(const json& monster_obj) {
         json_get_int<int16_t>(monster_obj, "hidden_power_base_power", 1);
     if (monster_obj.contains("hidden_power_type")) {
         monster.hidden_power_type =
-            ids::TYPE[monster_obj.at("hidden_power_type").get<std::string>()];
+            ids::TYPE[monster_obj.at("hidden_power_type").get_string()];
     }
 
-    const json& held_item = monster_obj.value("held_item", json({}));
+    Node held_item = monster_obj.value("held_item", empty_object());
     if (held_item.contains("id")) {
-        monster.held_item.id = ids::ITEM[held_item.at("id").get<std::string>()];
+        monster.held_item.id = ids::ITEM[held_item.at("id").get_string()];
         if (monster.held_item.id != eos::ITEM_NOTHING) {
             monster.held_item.exists = true;
         }
     }
     monster.held_item.sticky = held_item.value("sticky", false);
 
-    const json& iq_skills = monster_obj.value("iq_skills", json::array());
-    for (auto& iq : iq_skills) {
-        monster.iq_skill_flags[ids::IQ[iq.get<std::string>()]] = true;
+    Node iq_skills = monster_obj.value("iq_skills", empty_array());
+    for (auto iq : iq_skills) {
+        monster.iq_skill_flags[ids::IQ[iq.get_string()]] = true;
     }
 
-    const json& exclusive_items = monster_obj.value("exclusive_items", json({}));
-    const json& effects = exclusive_items.value("effects", json::array());
-    for (auto& eff : effects) {
-        monster.exclusive_item_effect_flags[ids::EXCLUSIVE_ITEM_EFFECT[eff.get<std::string>()]] =
+    Node exclusive_items = monster_obj.value("exclusive_items", empty_object());
+    Node effects = exclusive_items.value("effects", empty_array());
+    for (auto eff : effects) {
+        monster.exclusive_item_effect_flags[ids::EXCLUSIVE_ITEM_EFFECT[eff.get_string()]] =
             true;
     }
-    const json& stat_boosts = exclusive_items.value("stat_boosts", json({}));
+    Node stat_boosts = exclusive_items.value("stat_boosts", empty_object());
     monster.exclusive_item_offense_boosts[0] = json_get_int<uint8_t>(stat_boosts, "atk");
     monster.exclusive_item_offense_boosts[1] = json_get_int<uint8_t>(stat_boosts, "sp_atk");
     monster.exclusive_item_defense_boosts[0] = json_get_int<uint8_t>(stat_boosts, "def");
     monster.exclusive_item_defense_boosts[1] = json_get_int<uint8_t>(stat_boosts, "sp_def");
 
-    const json& statuses = monster_obj.value("statuses", json::array());
-    for (auto& status : statuses) {
+    Node statuses = monster_obj.value("statuses", empty_array());
+    for (auto status : statuses) {
         std::string status_name = status.get<std::string>();
         // special case
-        if (ids::STATUS.normalize(status_name) == "guts/marvel scale") {
+        if (ids::names_equal(status_name, "guts/marvel scale")) {
             monster.statuses.other_negative_status = true;
             continue;
         }
@@ -255,8 +279,25 @@ MonsterEntity parse_monster_cfg(const json& monster_obj) {
 
     return MonsterEntity{monster};
 }
+MonsterEntity parse_monster_cfg(const json& monster_obj) {
+    ConfigTape tape;
+    return parse_monster_cfg(tape.add(monster_obj));
+}
 
 namespace cfgparse {
+Section section_of(std::string_view key) {
+    if (key == "dungeon" || key == "rng" || key == "misc") {
+        return SECTION_DUNGEON;
+    } else if (key == "attacker") {
+        return SECTION_ATTACKER;
+    } else if (key == "defender") {
+        return SECTION_DEFENDER;
+    } else if (key == "move") {
+        return SECTION_MOVE;
+    }
+    return N_SECTIONS;
+}
+
 const std::array<ProjectileItem, 7> PROJECTILE_ITEMS = {{
     {eos::ITEM_STICK, mechanics::STICK_POWER},
     {eos::ITEM_IRON_THORN, mechanics::IRON_THORN_POWER},
@@ -280,8 +321,8 @@ std::optional<ProjectileItem> find_projectile_item(std::string name) {
     return std::nullopt;
 }
 } // namespace cfgparse
-std::pair<Move, int32_t> parse_move_cfg(const json& move_obj) {
-    const json& id = move_obj.at("id");
+std::pair<Move, int32_t> parse_move_cfg(const Node& move_obj) {
+    Node id = move_obj.at("id");
     bool time_darkness = move_obj.value<bool>("time_darkness", false);
     eos::move_id move_id;
 
@@ -304,13 +345,45 @@ std::pair<Move, int32_t> parse_move_cfg(const json& move_obj) {
                  json_get_int<uint8_t>(move_obj, "prior_successive_hits"), time_darkness},
             base_power};
 }
+std::pair<Move, int32_t> parse_move_cfg(const json& move_obj) {
+    ConfigTape tape;
+    return parse_move_cfg(tape.add(move_obj));
+}
 
-std::tuple<DungeonState, MonsterEntity, MonsterEntity, Move, int32_t> parse_cfg(const json& cfg) {
-    DungeonState dungeon = parse_dungeon_cfg(
-        cfg.value("dungeon", json({})), cfg.value("rng", json({})), cfg.value("misc", json({})));
-    MonsterEntity attacker = parse_monster_cfg(cfg.at("attacker"));
-    MonsterEntity defender = parse_monster_cfg(cfg.at("defender"));
-    auto [move, power] = parse_move_cfg(cfg.at("move"));
+namespace cfgparse {
+void parse_cfg_section(
+    const Node& cfg, Section section,
+    std::tuple<DungeonState, MonsterEntity, MonsterEntity, Move, int32_t>& inputs) {
+    switch (section) {
+    case SECTION_DUNGEON:
+        std::get<DungeonState>(inputs) = parse_dungeon_cfg(cfg.value("dungeon", empty_object()),
+                                                           cfg.value("rng", empty_object()),
+                                                           cfg.value("misc", empty_object()));
+        break;
+    case SECTION_ATTACKER:
+        std::get<1>(inputs) = parse_monster_cfg(cfg.at("attacker"));
+        break;
+    case SECTION_DEFENDER:
+        std::get<2>(inputs) = parse_monster_cfg(cfg.at("defender"));
+        break;
+    case SECTION_MOVE:
+        std::tie(std::get<Move>(inputs), std::get<int32_t>(inputs)) =
+            parse_move_cfg(cfg.at("move"));
+        break;
+    default:
+        break;
+    }
+}
+} // namespace cfgparse
 
-    return {dungeon, attacker, defender, move, power};
+std::tuple<DungeonState, MonsterEntity, MonsterEntity, Move, int32_t> parse_cfg(const Node& cfg) {
+    std::tuple<DungeonState, MonsterEntity, MonsterEntity, Move, int32_t> inputs;
+    for (int section = 0; section < cfgparse::N_SECTIONS; section++) {
+        cfgparse::parse_cfg_section(cfg, static_cast<cfgparse::Section>(section), inputs);
+    }
+    return inputs;
+}
+std::tuple<DungeonState, MonsterEntity, MonsterEntity, Move, int32_t> parse_cfg(const json& cfg) {
+    ConfigTape tape;
+    return parse_cfg(tape.add(cfg));
 }
@@ -7,13 +7,16 @@
 #include <cstdint>
 #include <limits>
 #include <stdexcept>
+#include <string_view>
 #include <tuple>
 #include <nlohmann/json.hpp>
+#include "cfgtape.hpp"
 #include "damage.hpp"
 
-template <typename T>
-T json_get_int(const nlohmann::json& obj, const std::string name, T default_val = 0) {
-    std::int64_t v = obj.value<int64_t>(name, default_val);
+// Works with both nlohmann::json and cfgparse::ConfigTape::Node objects
+template <typename T, typename Obj = nlohmann::json>
+T json_get_int(const Obj& obj, const std::string name, T default_val = 0) {
+    std::int64_t v = obj.template value<int64_t>(name, default_val);
     if (v < std::numeric_limits<T>::min()) {
         throw std::underflow_error(name + ": " + std::to_string(v) + " out of range (min " +
                                    std::to_string(std::numeric_limits<T>::min()) + ")");
@@ -27,9 +30,32 @@ T json_get_int(const nlohmann::json& obj, const std::string name, T default_val
 
 std::tuple<DungeonState, MonsterEntity, MonsterEntity, Move, int32_t>
 parse_cfg(const nlohmann::json& cfg);
+// Same as above, but for a config stored in a ConfigTape. Parsing JSON text into a (reused) tape and
+// then calling this is much cheaper than building an nlohmann::json document, and throws exactly
+// the same exceptions.
+std::tuple<DungeonState, MonsterEntity, MonsterEntity, Move, int32_t>
+parse_cfg(const cfgparse::ConfigTape::Node& cfg);
+
+// The parts of parse_cfg(), for callers that only need to reparse part of a config
+DungeonState parse_dungeon_cfg(const cfgparse::ConfigTape::Node& dungeon_obj,
+                               const cfgparse::ConfigTape::Node& rng_obj,
+                               const cfgparse::ConfigTape::Node& misc_obj);
+MonsterEntity parse_monster_cfg(const cfgparse::ConfigTape::Node& monster_obj);
+std::pair<Move, int32_t> parse_move_cfg(const cfgparse::ConfigTape::Node& move_obj);
 
-// Projectile items can be specified as moves
 namespace cfgparse {
+// Parts of a config that parse_cfg() parses independently of each other, in the order it parses
+// them
+enum Section { SECTION_DUNGEON, SECTION_ATTACKER, SECTION_DEFENDER, SECTION_MOVE, N_SECTIONS };
+// The section a top-level config key belongs to, or N_SECTIONS if it isn't part of one
+Section section_of(std::string_view key);
+// Parse one section of a config into the corresponding parts of inputs (in the same order as the
+// return value of parse_cfg())
+void parse_cfg_section(
+    const ConfigTape::Node& cfg, Section section,
+    std::tuple<DungeonState, MonsterEntity, MonsterEntity, Move, int32_t>& inputs);
+
+// Projectile items can be specified as moves
 struct ProjectileItem {
     eos::item_id id;
     int16_t base_power;
@@ -247,3 +247,51 @@ TEST_CASE("Top-level config is parsed correctly") {
     CHECK(dungeon.version == versions::EU);
     CHECK(power == mechanics::get_move_base_power(eos::MOVE_TACKLE));
 }
+TEST_CASE("Top-level config can be parsed from JSON text") {
+    cfgparse::ConfigTape tape;
+    SECTION("Text and JSON documents give the same result") {
+        json cfg = {
+            {"move", {{"id", "ember"}, {"pp", 3}}},
+            {"attacker",
+             {{"species", "charmander"}, {"level", 20}, {"iq_skills", {"type-advantage master"}}}},
+            {"defender", {{"species", "bulbasaur"}, {"type2", "fire"}}},
+            {"dungeon", {{"weather", "sunny"}}},
+        };
+        auto [dungeon, attacker, defender, move, power] = parse_cfg(tape.parse(cfg.dump()));
+        auto [dungeon_j, attacker_j, defender_j, move_j, power_j] = parse_cfg(cfg);
+        CHECK(move.id == move_j.id);
+        CHECK(move.pp == move_j.pp);
+        CHECK(attacker.monster.level == attacker_j.monster.level);
+        CHECK(attacker.monster.offensive_stats[1] == attacker_j.monster.offensive_stats[1]);
+        CHECK(defender.monster.types[1] == defender_j.monster.types[1]);
+        CHECK(dungeon.weather == dungeon_j.weather);
+        CHECK(attacker.monster.iq_skill_flags[eos::IQ_TYPE_ADVANTAGE_MASTER]);
+        CHECK(attacker_j.monster.iq_skill_flags[eos::IQ_TYPE_ADVANTAGE_MASTER]);
+        CHECK(power == power_j);
+    }
+    SECTION("Errors are the same as for JSON documents") {
+        auto error_of = [](auto f) -> std::string {
+            try {
+                f();
+            } catch (const std::exception& e) {
+                return e.what();
+            }
+            return "";
+        };
+        std::vector<std::string> texts = {
+            R"([])",
+            R"({"move": 1})",
+            R"({"move": {"id": 1}})",
+            R"({"move": {"id": "ember"}, "attacker": {"species": "missingno"}})",
+            R"({"move": {"id": "ember"}, "attacker": {"species": "charmander", "level": 1000}})",
+            R"({"move": {"id": "ember"}, "attacker": {"species": "charmander", "level": true}})",
+        };
+        for (const auto& text : texts) {
+            CAPTURE(text);
+            auto expected = error_of([&] { parse_cfg(json::parse(text)); });
+            REQUIRE(!expected.empty());
+            tape.clear();
+            REQUIRE(error_of([&] { parse_cfg(tape.parse(text)); }) == expected);
+        }
+    }
+}
@@ -0,0 +1,351 @@
+#include "cfgtape.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+using nlohmann::json;
+
+namespace cfgparse {
+namespace {
+// Indexes of the default empty containers, which are always at the start of the tape
+const uint32_t EMPTY_OBJECT_IDX = 0;
+const uint32_t EMPTY_ARRAY_IDX = 1;
+} // namespace
+
+// SAX handler that appends the parsed value to a tape
+class ConfigTape::Builder {
+    ConfigTape& tape;
+
+  public:
+    explicit Builder(ConfigTape& tape_) : tape(tape_) {}
+
+    bool null() {
+        tape.push(json::value_t::null);
+        return true;
+    }
+    bool boolean(bool val) {
+        tape.entries[tape.push(json::value_t::boolean)].boolean = val;
+        return true;
+    }
+    bool number_integer(json::number_integer_t val) {
+        tape.entries[tape.push(json::value_t::number_integer)].integer = val;
+        return true;
+    }
+    bool number_unsigned(json::number_unsigned_t val) {
+        tape.entries[tape.push(json::value_t::number_unsigned)].uinteger = val;
+        return true;
+    }
+    bool number_float(json::number_float_t val, const json::string_t&) {
+        tape.entries[tape.push(json::value_t::number_float)].number = val;
+        return true;
+    }
+    bool string(json::string_t& val) {
+        tape.push_string(val);
+        return true;
+    }
+    bool binary(json::binary_t&) {
+        // Not possible in JSON text
+        tape.push(json::value_t::binary);
+        return true;
+    }
+    bool start_object(std::size_t) {
+        tape.stack.push_back(tape.push(json::value_t::object));
+        return true;
+    }
+    bool key(json::string_t& val) {
+        tape.push_key(val);
+        return true;
+    }
+    bool end_object() {
+        tape.close();
+        return true;
+    }
+    bool start_array(std::size_t) {
+        tape.stack.push_back(tape.push(json::value_t::array));
+        return true;
+    }
+    bool end_array() {
+        tape.close();
+        return true;
+    }
+    template <typename Exception>
+    bool parse_error(std::size_t, const std::string&, const Exception& ex) {
+        throw ex;
+    }
+};
+
+uint32_t ConfigTape::push(json::value_t type) {
+    uint32_t idx = entries.size();
+    Entry e;
+    e.type = type;
+    e.key_begin = pending_key_begin;
+    e.key_len = pending_key_len;
+    e.next = idx + 1;
+    e.uinteger = 0;
+    entries.push_back(e);
+    pending_key_begin = 0;
+    pending_key_len = 0;
+    return idx;
+}
+uint32_t ConfigTape::push_string(std::string_view str) {
+    uint32_t idx = push(json::value_t::string);
+    entries[idx].string.begin = strings.size();
+    entries[idx].string.len = str.size();
+    strings.append(str);
+    return idx;
+}
+void ConfigTape::push_key(std::string_view key) {
+    pending_key_begin = strings.size();
+    pending_key_len = key.size();
+    strings.append(key);
+}
+void ConfigTape::close() {
+    entries[stack.back()].next = entries.size();
+    stack.pop_back();
+}
+void ConfigTape::add_json(const json& value) {
+    switch (value.type()) {
+    case json::value_t::object:
+        stack.push_back(push(json::value_t::object));
+        for (auto& [key, val] : value.items()) {
+            push_key(key);
+            add_json(val);
+        }
+        close();
+        break;
+    case json::value_t::array:
+        stack.push_back(push(json::value_t::array));
+        for (auto& val : value) {
+            add_json(val);
+        }
+        close();
+        break;
+    case json::value_t::string:
+        push_string(value.get_ref<const json::string_t&>());
+        break;
+    case json::value_t::boolean:
+        entries[push(json::value_t::boolean)].boolean = value.get<bool>();
+        break;
+    case json::value_t::number_integer:
+        entries[push(json::value_t::number_integer)].integer = value.get<int64_t>();
+        break;
+    case json::value_t::number_unsigned:
+        entries[push(json::value_t::number_unsigned)].uinteger = value.get<uint64_t>();
+        break;
+    case json::value_t::number_float:
+        entries[push(json::value_t::number_float)].number = value.get<double>();
+        break;
+    default:
+        push(value.type());
+        break;
+    }
+}
+void ConfigTape::add_node(const Node& value) {
+    switch (value.type()) {
+    case json::value_t::object:
+    case json::value_t::array: {
+        bool is_object = value.is_object();
+        stack.push_back(push(value.type()));
+        for (uint32_t i = value.idx + 1; i < value.entry().next; i = value.tape->entries[i].next) {
+            Node child(value.tape, i);
+            if (is_object) {
+                push_key(child.key());
+            }
+            add_node(child);
+        }
+        close();
+        break;
+    }
+    case json::value_t::string:
+        push_string(value.get_string());
+        break;
+    default: {
+        // Copy before pushing, since pushing can move the value if it's in this tape
+        Entry e = value.entry();
+        uint32_t idx = push(e.type);
+        std::memcpy(&entries[idx].uinteger, &e.uinteger, sizeof(e.uinteger));
+        break;
+    }
+    }
+}
+void ConfigTape::add_merged(const Node& target, const Node& patch) {
+    if (!patch.is_object()) {
+        add_node(patch);
+        return;
+    }
+    stack.push_back(push(json::value_t::object));
+    if (target.is_object()) {
+        for (uint32_t i = target.idx + 1; i < target.entry().next;
+             i = target.tape->entries[i].next) {
+            Node child(target.tape, i);
+            // Skip keys that are patched, and shadowed duplicates
+            if (!patch.contains(child.key()) && target.find(child.key()) == &child.entry()) {
+                push_key(child.key());
+                add_node(child);
+            }
+        }
+    }
+    for (uint32_t i = patch.idx + 1; i < patch.entry().next; i = patch.tape->entries[i].next) {
+        Node child(patch.tape, i);
+        if (child.is_null() || patch.find(child.key()) != &child.entry()) {
+            continue; // Removed, or shadowed
+        }
+        const Entry* old = target.is_object() ? target.find(child.key()) : nullptr;
+        push_key(child.key());
+        // Anything that isn't an object is treated as an empty object when patching it
+        add_merged(old ? Node(target.tape, old - target.tape->entries.data()) : empty_object(),
+                   child);
+    }
+    close();
+}
+
+void ConfigTape::clear() {
+    entries.clear();
+    strings.clear();
+    stack.clear();
+    push(json::value_t::object); // EMPTY_OBJECT_IDX
+    push(json::value_t::array);  // EMPTY_ARRAY_IDX
+}
+ConfigTape::Node ConfigTape::add(const json& value) {
+    uint32_t idx = entries.size();
+    add_json(value);
+    return Node(this, idx);
+}
+ConfigTape::Node ConfigTape::add(const Node& value) {
+    uint32_t idx = entries.size();
+    add_node(value);
+    return Node(this, idx);
+}
+ConfigTape::Node ConfigTape::merge_patch(const Node& target, const Node& patch) {
+    uint32_t idx = entries.size();
+    add_merged(target, patch);
+    return Node(this, idx);
+}
+ConfigTape::Node ConfigTape::parse(std::string_view text) {
+    uint32_t idx = entries.size();
+    Builder builder(*this);
+    json::sax_parse(text.begin(), text.end(), &builder);
+    return Node(this, idx);
+}
+void ConfigTape::set(const Node& target, const Node& value) {
+    auto is_container = [](const Node& node) { return node.is_object() || node.is_array(); };
+    if (target.tape != this || is_container(target) || is_container(value)) {
+        throw std::invalid_argument("ConfigTape: can only set primitives within the tape");
+    }
+    Entry& e = entries[target.idx];
+    if (value.is_string() && value.tape != this) {
+        std::string_view str = value.get_string();
+        e.string.begin = strings.size();
+        e.string.len = str.size();
+        strings.append(str);
+    } else {
+        // Copy whichever member of the value union is active; none are bigger than 8 bytes
+        std::memcpy(&e.uinteger, &value.entry().uinteger, sizeof(e.uinteger));
+    }
+    e.type = value.type();
+}
+ConfigTape::Node ConfigTape::empty_object() const { return Node(this, EMPTY_OBJECT_IDX); }
+ConfigTape::Node ConfigTape::empty_array() const { return Node(this, EMPTY_ARRAY_IDX); }
+
+json ConfigTape::Node::scalar() const {
+    const Entry& e = entry();
+    switch (e.type) {
+    case json::value_t::boolean:
+        return e.boolean;
+    case json::value_t::number_integer:
+        return e.integer;
+    case json::value_t::number_unsigned:
+        return e.uinteger;
+    case json::value_t::number_float:
+        return e.number;
+    case json::value_t::string:
+        return std::string(get_string());
+    case json::value_t::object:
+        return json::object();
+    case json::value_t::array:
+        return json::array();
+    default:
+        return json(e.type);
+    }
+}
+const ConfigTape::Entry* ConfigTape::Node::find(std::string_view key) const {
+    // Later duplicate keys take precedence, like in nlohmann::json
+    const Entry* found = nullptr;
+    for (uint32_t i = idx + 1; i < entry().next; i = tape->entries[i].next) {
+        const Entry& child = tape->entries[i];
+        if (std::string_view(tape->strings).substr(child.key_begin, child.key_len) == key) {
+            found = &child;
+        }
+    }
+    return found;
+}
+std::string_view ConfigTape::Node::key() const {
+    return std::string_view(tape->strings).substr(entry().key_begin, entry().key_len);
+}
+
+std::string_view ConfigTape::Node::get_string() const {
+    if (!is_string()) {
+        throw json::type_error::create(
+            302, std::string("type must be string, but is ") + type_name(), nullptr);
+    }
+    return std::string_view(tape->strings).substr(entry().string.begin, entry().string.len);
+}
+json ConfigTape::Node::to_json() const {
+    switch (type()) {
+    case json::value_t::object: {
+        json obj = json::object();
+        for (uint32_t i = idx + 1; i < entry().next; i = tape->entries[i].next) {
+            const Entry& child = tape->entries[i];
+            obj[std::string(tape->strings, child.key_begin, child.key_len)] =
+                Node(tape, i).to_json();
+        }
+        return obj;
+    }
+    case json::value_t::array: {
+        json arr = json::array();
+        for (Node elem : *this) {
+            arr.push_back(elem.to_json());
+        }
+        return arr;
+    }
+    default:
+        return scalar();
+    }
+}
+
+ConfigTape::Node ConfigTape::Node::at(std::string_view key) const {
+    if (!is_object()) {
+        throw json::type_error::create(304, std::string("cannot use at() with ") + type_name(),
+                                       nullptr);
+    }
+    const Entry* e = find(key);
+    if (!e) {
+        throw json::out_of_range::create(403, "key '" + std::string(key) + "' not found", nullptr);
+    }
+    return Node(tape, e - tape->entries.data());
+}
+ConfigTape::Node ConfigTape::Node::value(std::string_view key, const Node& default_val) const {
+    if (!is_object()) {
+        throw_value_type_error();
+    }
+    const Entry* e = find(key);
+    return e ? Node(tape, e - tape->entries.data()) : default_val;
+}
+void ConfigTape::Node::throw_value_type_error() const {
+    throw json::type_error::create(306, std::string("cannot use value() with ") + type_name(),
+                                   nullptr);
+}
+
+ConfigTape::Iterator ConfigTape::Node::begin() const {
+    switch (type()) {
+    case json::value_t::object:
+    case json::value_t::array:
+        return Iterator(tape, idx + 1);
+    case json::value_t::null:
+        return end();
+    default:
+        return Iterator(tape, idx);
+    }
+}
+ConfigTape::Iterator ConfigTape::Node::end() const { return Iterator(tape, entry().next); }
+} // namespace cfgparse
@@ -0,0 +1,155 @@
+// Compact, read-only JSON representation used for config parsing, which can be filled straight from
+// JSON text without building an nlohmann::json document
+
+#ifndef CFGTAPE_HPP_
+#define CFGTAPE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace cfgparse {
+// JSON values stored as a flat list of entries in document order, with containers followed by
+// their contents. Strings (including object keys) live in a single buffer. Clearing the tape keeps
+// its storage, so a tape reused across configs doesn't allocate once it has grown big enough.
+//
+// Values are accessed through Nodes, which mimic the subset of the nlohmann::json interface used by
+// the config parser, with the same semantics and exceptions (e.g., value() only works on objects,
+// later duplicate keys shadow earlier ones, iterating over a primitive visits the primitive once).
+class ConfigTape {
+  public:
+    class Node;
+    class Iterator;
+
+  private:
+    struct Entry {
+        nlohmann::json::value_t type;
+        uint32_t key_begin; // Object key, in strings (empty if not in an object)
+        uint32_t key_len;
+        uint32_t next; // Index just past this value, including any contents
+        union {
+            bool boolean;
+            int64_t integer;
+            uint64_t uinteger;
+            double number;
+            struct {
+                uint32_t begin;
+                uint32_t len;
+            } string;
+        };
+    };
+    std::vector<Entry> entries;
+    std::string strings;
+    // Open containers while filling the tape
+    std::vector<uint32_t> stack;
+    // Key for the next value added
+    uint32_t pending_key_begin = 0;
+    uint32_t pending_key_len = 0;
+
+    class Builder;
+
+    uint32_t push(nlohmann::json::value_t type);
+    uint32_t push_string(std::string_view str);
+    void push_key(std::string_view key);
+    void close();
+    void add_json(const nlohmann::json& value);
+    void add_node(const Node& value);
+    void add_merged(const Node& target, const Node& patch);
+
+  public:
+    ConfigTape() { clear(); }
+
+    void clear();
+    // Add a value to the tape
+    Node add(const nlohmann::json& value);
+    // Copy a value, which can be from any tape (including this one), to the end of the tape
+    Node add(const Node& value);
+    // Add the result of applying a JSON merge patch (RFC 7386) to target. Both values can be from
+    // any tape, and are left as they are.
+    Node merge_patch(const Node& target, const Node& patch);
+    // Parse JSON text into the tape. Throws the same exceptions as nlohmann::json::parse().
+    Node parse(std::string_view text);
+    // Empty containers, for use as defaults
+    Node empty_object() const;
+    Node empty_array() const;
+    // Replace a primitive value in the tape with another primitive, which can be from any tape.
+    // Throws std::invalid_argument if either one is an object or array.
+    void set(const Node& target, const Node& value);
+};
+
+class ConfigTape::Node {
+    friend class ConfigTape;
+    friend class ConfigTape::Iterator;
+
+    const ConfigTape* tape;
+    uint32_t idx;
+
+    Node(const ConfigTape* tape_, uint32_t idx_) : tape(tape_), idx(idx_) {}
+    const Entry& entry() const { return tape->entries[idx]; }
+    // Primitives as an nlohmann::json value, so conversions behave exactly like nlohmann's.
+    // Containers come out empty.
+    nlohmann::json scalar() const;
+    const Entry* find(std::string_view key) const;
+
+  public:
+    nlohmann::json::value_t type() const { return entry().type; }
+    const char* type_name() const { return scalar().type_name(); }
+    bool is_null() const { return type() == nlohmann::json::value_t::null; }
+    bool is_object() const { return type() == nlohmann::json::value_t::object; }
+    bool is_array() const { return type() == nlohmann::json::value_t::array; }
+    bool is_string() const { return type() == nlohmann::json::value_t::string; }
+
+    // Convert a primitive, like nlohmann::json::get<T>()
+    template <typename T> T get() const {
+        if constexpr (std::is_same_v<T, std::string>) {
+            return std::string(get_string());
+        } else {
+            return scalar().template get<T>();
+        }
+    }
+    // Like get<std::string>(), but without copying the string
+    std::string_view get_string() const;
+    // Copy into an nlohmann::json value
+    nlohmann::json to_json() const;
+    // Key of an object member, e.g., when iterating over an object (empty otherwise)
+    std::string_view key() const;
+
+    bool contains(std::string_view key) const { return is_object() && find(key) != nullptr; }
+    Node at(std::string_view key) const;
+    // Like nlohmann::json::value()
+    template <typename T> T value(std::string_view key, const T& default_val) const {
+        if (!is_object()) {
+            throw_value_type_error();
+        }
+        const Entry* e = find(key);
+        return e ? Node(tape, e - tape->entries.data()).get<T>() : default_val;
+    }
+    // Like nlohmann::json::value() with a JSON default, but returns the value itself rather than a
+    // copy
+    Node value(std::string_view key, const Node& default_val) const;
+    [[noreturn]] void throw_value_type_error() const;
+
+    // Iterate over object values, array elements, or a primitive itself; null is empty
+    Iterator begin() const;
+    Iterator end() const;
+};
+
+class ConfigTape::Iterator {
+    const ConfigTape* tape;
+    uint32_t idx;
+
+  public:
+    Iterator(const ConfigTape* tape_, uint32_t idx_) : tape(tape_), idx(idx_) {}
+    Node operator*() const { return Node(tape, idx); }
+    Iterator& operator++() {
+        idx = tape->entries[idx].next;
+        return *this;
+    }
+    bool operator==(const Iterator& other) const { return idx == other.idx; }
+    bool operator!=(const Iterator& other) const { return idx != other.idx; }
+};
+} // namespace cfgparse
+
+#endif
@@ -0,0 +1,147 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "cfgtape.hpp"
+
+using nlohmann::json;
+using cfgparse::ConfigTape;
+
+namespace {
+// Exception message from a callable, or an empty string if it doesn't throw
+template <typename F> std::string error_of(F f) {
+    try {
+        f();
+    } catch (const std::exception& e) {
+        return e.what();
+    }
+    return "";
+}
+} // namespace
+
+TEST_CASE("ConfigTape parsing works", "[cfgtape]") {
+    ConfigTape tape;
+    SECTION("Parsed values round-trip") {
+        std::string text =
+            R"({"a": 1, "b": [true, null, -2, 3.5, "x"], "c": {"d": {}, "e": []}, "f": 18446744073709551615})";
+        REQUIRE(tape.parse(text).to_json() == json::parse(text));
+        REQUIRE(tape.add(json::parse(text)).to_json() == json::parse(text));
+    }
+    SECTION("Later duplicate keys take precedence") {
+        auto node = tape.parse(R"({"a": 1, "a": 2})");
+        REQUIRE(node.value("a", 0) == json::parse(R"({"a": 1, "a": 2})").value("a", 0));
+    }
+    SECTION("Parse errors match nlohmann::json::parse()") {
+        for (std::string text : {"", "not json", "{\"a\": }", "[1, 2", "{} extra"}) {
+            REQUIRE(error_of([&] { tape.parse(text); }) ==
+                    error_of([&] { json parsed = json::parse(text); }));
+        }
+    }
+    SECTION("Tapes can be reused after clearing") {
+        tape.parse(R"({"a": "long string value", "b": [1, 2, 3]})");
+        tape.clear();
+        auto node = tape.parse(R"({"c": "d"})");
+        REQUIRE(node.to_json() == json{{"c", "d"}});
+        REQUIRE(tape.empty_object().to_json() == json::object());
+        REQUIRE(tape.empty_array().to_json() == json::array());
+    }
+}
+
+TEST_CASE("ConfigTape nodes behave like nlohmann::json", "[cfgtape]") {
+    ConfigTape tape;
+    std::vector<json> values = {
+        nullptr, true, 5, -5, 5u, 2.5, "str", json::array({1, "two"}), {{"k", 1}, {"s", "v"}},
+    };
+    for (const json& j : values) {
+        auto node = tape.add(j);
+        CAPTURE(j.dump());
+        REQUIRE(node.type() == j.type());
+        REQUIRE(std::string(node.type_name()) == j.type_name());
+
+        // Conversions
+        REQUIRE(error_of([&] { node.get<int>(); }) == error_of([&] { j.get<int>(); }));
+        REQUIRE(error_of([&] { node.get<bool>(); }) == error_of([&] { j.get<bool>(); }));
+        REQUIRE(error_of([&] { node.get<double>(); }) == error_of([&] { j.get<double>(); }));
+        REQUIRE(error_of([&] { node.get<std::string>(); }) ==
+                error_of([&] { j.get<std::string>(); }));
+        if (j.is_number_integer()) {
+            REQUIRE(node.get<int64_t>() == j.get<int64_t>());
+        }
+
+        // Key lookups
+        REQUIRE(node.contains("k") == j.contains("k"));
+        REQUIRE(error_of([&] { node.at("k"); }) == error_of([&] { j.at("k"); }));
+        REQUIRE(error_of([&] { node.at("missing"); }) == error_of([&] { j.at("missing"); }));
+        REQUIRE(error_of([&] { node.value("k", 0); }) == error_of([&] { j.value("k", 0); }));
+        REQUIRE(error_of([&] { node.value("s", 0); }) == error_of([&] { j.value("s", 0); }));
+        if (j.is_object()) {
+            REQUIRE(node.value("k", 0) == j.value("k", 0));
+            REQUIRE(node.value("missing", 0) == j.value("missing", 0));
+            REQUIRE(node.value("missing", tape.empty_array()).is_array());
+        }
+
+        // Iteration
+        std::vector<json> node_elems;
+        for (auto elem : node) {
+            node_elems.push_back(elem.to_json());
+        }
+        std::vector<json> json_elems(j.begin(), j.end());
+        REQUIRE(node_elems == json_elems);
+    }
+}
+
+TEST_CASE("ConfigTape primitives can be replaced", "[cfgtape]") {
+    ConfigTape tape;
+    auto node = tape.parse(R"({"a": 1, "b": [true, "x"]})");
+    tape.set(node.at("a"), tape.add("long string value"));
+    REQUIRE(node.to_json() == json::parse(R"({"a": "long string value", "b": [true, "x"]})"));
+
+    ConfigTape other;
+    tape.set(node.at("a"), other.add(2.5));
+    tape.set(*node.at("b").begin(), other.add("y"));
+    REQUIRE(node.to_json() == json::parse(R"({"a": 2.5, "b": ["y", "x"]})"));
+
+    REQUIRE_THROWS_AS(tape.set(node.at("b"), tape.add(1)), std::invalid_argument);
+    REQUIRE_THROWS_AS(tape.set(node.at("a"), tape.add(json::array())), std::invalid_argument);
+    REQUIRE_THROWS_AS(other.set(node.at("a"), other.add(1)), std::invalid_argument);
+}
+
+TEST_CASE("ConfigTape merge patches match nlohmann::json", "[cfgtape]") {
+    // Cases from RFC 7386, plus nesting
+    std::vector<std::tuple<std::string, std::string>> cases = {
+        {R"({"a": "b"})", R"({"a": "c"})"},
+        {R"({"a": "b"})", R"({"b": "c"})"},
+        {R"({"a": "b"})", R"({"a": null})"},
+        {R"({"a": "b", "b": "c"})", R"({"a": null})"},
+        {R"({"a": ["b"]})", R"({"a": "c"})"},
+        {R"({"a": "c"})", R"({"a": ["b"]})"},
+        {R"({"a": {"b": "c"}})", R"({"a": {"b": "d", "c": null}})"},
+        {R"({"a": [{"b": "c"}]})", R"({"a": [1]})"},
+        {R"(["a", "b"])", R"(["c", "d"])"},
+        {R"({"a": "b"})", R"(["c"])"},
+        {R"({"a": "foo"})", "null"},
+        {R"({"a": "foo"})", R"("bar")"},
+        {R"({"e": null})", R"({"a": 1})"},
+        {R"([1, 2])", R"({"a": "b", "c": null})"},
+        {"{}", R"({"a": {"bb": {"ccc": null}}})"},
+        {R"({"x": {"y": 1, "z": [true]}, "w": 2.5})", R"({"x": {"y": {"deep": -3}}, "v": "s"})"},
+    };
+    for (const auto& [target, patch] : cases) {
+        CAPTURE(target, patch);
+        json expected = json::parse(target);
+        expected.merge_patch(json::parse(patch));
+
+        // From separate tapes
+        ConfigTape target_tape;
+        ConfigTape patch_tape;
+        ConfigTape tape;
+        auto merged = tape.merge_patch(target_tape.parse(target), patch_tape.parse(patch));
+        REQUIRE(merged.to_json() == expected);
+        // All in the same tape
+        auto target_node = tape.parse(target);
+        auto patch_node = tape.parse(patch);
+        REQUIRE(tape.merge_patch(target_node, patch_node).to_json() == expected);
+        REQUIRE(target_node.to_json() == json::parse(target));
+        REQUIRE(tape.add(patch_node).to_json() == json::parse(patch));
+    }
+}
@@ -0,0 +1,418 @@
+#include "columns.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+namespace columns {
+Table::Table(std::vector<Column> schema) : schema_(std::move(schema)), data(schema_.size()) {}
+
+void Table::push_int(std::size_t col, int32_t value) {
+    data[col].ints.push_back(value);
+    data[col].valid.push_back(1);
+}
+void Table::push_double(std::size_t col, double value) {
+    data[col].doubles.push_back(value);
+    data[col].valid.push_back(1);
+}
+void Table::push_bool(std::size_t col, bool value) {
+    data[col].bools.push_back(value);
+    data[col].valid.push_back(1);
+}
+void Table::push_string(std::size_t col, std::string_view value) {
+    data[col].chars += value;
+    data[col].ends.push_back(data[col].chars.size());
+    data[col].valid.push_back(1);
+}
+void Table::push_null(std::size_t col) {
+    auto& column = data[col];
+    switch (schema_[col].type) {
+    case Type::INT32:
+        column.ints.push_back(0);
+        break;
+    case Type::FLOAT64:
+        column.doubles.push_back(0);
+        break;
+    case Type::BOOL:
+        column.bools.push_back(0);
+        break;
+    case Type::STRING:
+        column.ends.push_back(column.chars.size());
+        break;
+    }
+    column.valid.push_back(0);
+    column.n_nulls++;
+}
+void Table::clear() {
+    for (auto& column : data) {
+        column.ints.clear();
+        column.doubles.clear();
+        column.bools.clear();
+        column.ends.clear();
+        column.chars.clear();
+        column.valid.clear();
+        column.n_nulls = 0;
+    }
+    n_rows_ = 0;
+}
+
+namespace {
+// Output is flushed to the stream in chunks of about this size
+const std::size_t BUFFER_SIZE = 1 << 20;
+
+template <typename T> void append_number(std::string& buf, T value) {
+    char chars[32];
+    auto result = std::to_chars(chars, chars + sizeof(chars), value);
+    buf.append(chars, result.ptr);
+}
+
+void append_csv_string(std::string& buf, std::string_view str) {
+    if (!str.empty() && str.find_first_of(",\"\r\n") == std::string_view::npos) {
+        buf += str;
+        return;
+    }
+    // Empty strings are quoted so they're distinct from nulls
+    buf += '"';
+    for (char c : str) {
+        if (c == '"') {
+            buf += '"';
+        }
+        buf += c;
+    }
+    buf += '"';
+}
+} // namespace
+
+CsvWriter::CsvWriter(std::ostream& out, const std::vector<Column>& schema) : out(out) {
+    buffer.reserve(BUFFER_SIZE + BUFFER_SIZE / 4);
+    for (std::size_t col = 0; col < schema.size(); col++) {
+        if (col > 0) {
+            buffer += ',';
+        }
+        append_csv_string(buffer, schema[col].name);
+    }
+    buffer += '\n';
+}
+
+void CsvWriter::flush_if_full() {
+    if (buffer.size() >= BUFFER_SIZE) {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+void CsvWriter::write(const Table& table) {
+    const auto& schema = table.schema();
+    for (std::size_t row = 0; row < table.n_rows(); row++) {
+        for (std::size_t col = 0; col < schema.size(); col++) {
+            if (col > 0) {
+                buffer += ',';
+            }
+            const auto& column = table.column(col);
+            if (!column.valid[row]) {
+                continue;
+            }
+            switch (schema[col].type) {
+            case Type::INT32:
+                append_number(buffer, column.ints[row]);
+                break;
+            case Type::FLOAT64:
+                append_number(buffer, column.doubles[row]);
+                break;
+            case Type::BOOL:
+                buffer += column.bools[row] ? "true" : "false";
+                break;
+            case Type::STRING: {
+                uint32_t start = row > 0 ? column.ends[row - 1] : 0;
+                append_csv_string(buffer, std::string_view(column.chars).substr(
+                                              start, column.ends[row] - start));
+                break;
+            }
+            }
+        }
+        buffer += '\n';
+        flush_if_full();
+    }
+}
+
+void CsvWriter::finish() {
+    out.write(buffer.data(), buffer.size());
+    buffer.clear();
+    out.flush();
+}
+
+namespace {
+// Just enough of a FlatBuffers builder to write Arrow's IPC metadata
+// (https://flatbuffers.dev/flatbuffers_internals.html). Unlike the real builder, which writes
+// back to front, this writes front to back: each table is followed by the objects it refers to,
+// and the offsets to them are patched in once they've been written. Scalars are aligned to their
+// size, relative to the start of the buffer.
+class FlatBuilder {
+  public:
+    std::string buf;
+
+    void pad(std::size_t align) { buf.resize((buf.size() + align - 1) / align * align, '\0'); }
+    template <typename T> std::size_t put(T value) {
+        pad(sizeof(T));
+        std::size_t pos = buf.size();
+        buf.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        return pos;
+    }
+    template <typename T> void patch(std::size_t pos, T value) {
+        std::memcpy(&buf[pos], &value, sizeof(T));
+    }
+    // Point the offset at pos to target, which must come after it
+    void link(std::size_t pos, std::size_t target) { patch<uint32_t>(pos, target - pos); }
+
+    // Start a vector of n elements with the given alignment, returning the position of its length
+    // prefix, which is what offsets to the vector point to. The elements follow.
+    std::size_t start_vector(uint32_t n, std::size_t elem_align) {
+        pad(4);
+        while ((buf.size() + 4) % elem_align != 0) {
+            buf.append(4, '\0');
+        }
+        return put<uint32_t>(n);
+    }
+    std::size_t add_string(std::string_view str) {
+        std::size_t pos = put<uint32_t>(str.size());
+        buf += str;
+        buf += '\0';
+        return pos;
+    }
+};
+
+// A table is written as its vtable followed by its fields, which must be added in order of their
+// IDs. Offset fields are filled in with FlatBuilder::link() after the table is finished.
+class TableBuilder {
+    FlatBuilder& fb;
+    std::size_t vtable;
+    std::size_t start_;
+
+    void set_field(uint16_t id, std::size_t pos) {
+        fb.patch<uint16_t>(vtable + 4 + 2 * id, pos - start_);
+    }
+
+  public:
+    TableBuilder(FlatBuilder& fb, uint16_t n_fields) : fb(fb) {
+        fb.pad(2);
+        vtable = fb.buf.size();
+        fb.buf.append(2 * (2 + n_fields), '\0');
+        fb.patch<uint16_t>(vtable, 2 * (2 + n_fields));
+        start_ = fb.put<int32_t>(0);
+        fb.patch<int32_t>(start_, start_ - vtable);
+    }
+    // Where offsets to the table point
+    std::size_t start() const { return start_; }
+
+    template <typename T> void add(uint16_t id, T value) { set_field(id, fb.put<T>(value)); }
+    // Add an offset field, returning its position to link later
+    std::size_t add_offset(uint16_t id) {
+        std::size_t pos = fb.put<uint32_t>(0);
+        set_field(id, pos);
+        return pos;
+    }
+    void finish() { fb.patch<uint16_t>(vtable + 2, fb.buf.size() - start_); }
+};
+
+// Enum values from Arrow's Schema.fbs and Message.fbs
+const int16_t METADATA_V5 = 4;
+const uint8_t HEADER_SCHEMA = 1;
+const uint8_t HEADER_RECORD_BATCH = 3;
+const uint8_t TYPE_INT = 2;
+const uint8_t TYPE_FLOATING_POINT = 3;
+const uint8_t TYPE_UTF8 = 5;
+const uint8_t TYPE_BOOL = 6;
+const int16_t PRECISION_DOUBLE = 2;
+
+// Start a Message table in an empty builder, returning the position of the header offset
+std::size_t start_message(FlatBuilder& fb, uint8_t header_type, int64_t body_length) {
+    std::size_t root = fb.put<uint32_t>(0);
+    // Fields: version, header_type, header, bodyLength
+    TableBuilder message(fb, 4);
+    fb.link(root, message.start());
+    message.add<int16_t>(0, METADATA_V5);
+    message.add<uint8_t>(1, header_type);
+    std::size_t header = message.add_offset(2);
+    message.add<int64_t>(3, body_length);
+    message.finish();
+    return header;
+}
+
+// Write an encapsulated message: a continuation marker, the metadata size, the metadata padded to
+// 8 bytes, then the body
+void write_message(std::ostream& out, FlatBuilder& fb, const std::string& body) {
+    fb.pad(8);
+    int32_t prefix[2] = {-1, static_cast<int32_t>(fb.buf.size())};
+    out.write(reinterpret_cast<const char*>(prefix), sizeof(prefix));
+    out.write(fb.buf.data(), fb.buf.size());
+    out.write(body.data(), body.size());
+}
+
+// Append a bitmap of the given byte-per-value flags to the body, padded to 8 bytes
+void append_bitmap(std::string& body, const std::vector<uint8_t>& flags) {
+    std::size_t start = body.size();
+    body.append((flags.size() + 7) / 8, '\0');
+    for (std::size_t i = 0; i < flags.size(); i++) {
+        if (flags[i]) {
+            body[start + i / 8] |= static_cast<char>(1 << (i % 8));
+        }
+    }
+}
+template <typename T> void append_values(std::string& body, const std::vector<T>& values) {
+    body.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+} // namespace
+
+ArrowWriter::ArrowWriter(std::ostream& out, const std::vector<Column>& schema)
+    : out(out), schema(schema) {
+    FlatBuilder fb;
+    std::size_t header = start_message(fb, HEADER_SCHEMA, 0);
+    // Fields: endianness (little by default), fields
+    TableBuilder schema_table(fb, 2);
+    fb.link(header, schema_table.start());
+    std::size_t fields_offset = schema_table.add_offset(1);
+    schema_table.finish();
+
+    std::size_t fields = fb.start_vector(schema.size(), 4);
+    fb.link(fields_offset, fields);
+    for (std::size_t i = 0; i < schema.size(); i++) {
+        fb.put<uint32_t>(0);
+    }
+    for (std::size_t i = 0; i < schema.size(); i++) {
+        // Fields: name, nullable, type_type, type, dictionary, children
+        TableBuilder field(fb, 6);
+        fb.link(fields + 4 + 4 * i, field.start());
+        std::size_t name = field.add_offset(0);
+        field.add<uint8_t>(1, true);
+        switch (schema[i].type) {
+        case Type::INT32:
+            field.add<uint8_t>(2, TYPE_INT);
+            break;
+        case Type::FLOAT64:
+            field.add<uint8_t>(2, TYPE_FLOATING_POINT);
+            break;
+        case Type::BOOL:
+            field.add<uint8_t>(2, TYPE_BOOL);
+            break;
+        case Type::STRING:
+            field.add<uint8_t>(2, TYPE_UTF8);
+            break;
+        }
+        std::size_t type = field.add_offset(3);
+        std::size_t children = field.add_offset(5);
+        field.finish();
+
+        fb.link(name, fb.add_string(schema[i].name));
+        if (schema[i].type == Type::INT32) {
+            // Fields: bitWidth, is_signed
+            TableBuilder int_type(fb, 2);
+            fb.link(type, int_type.start());
+            int_type.add<int32_t>(0, 32);
+            int_type.add<uint8_t>(1, true);
+            int_type.finish();
+        } else if (schema[i].type == Type::FLOAT64) {
+            // Fields: precision
+            TableBuilder float_type(fb, 1);
+            fb.link(type, float_type.start());
+            float_type.add<int16_t>(0, PRECISION_DOUBLE);
+            float_type.finish();
+        } else {
+            // Bool and Utf8 have no fields
+            TableBuilder empty_type(fb, 0);
+            fb.link(type, empty_type.start());
+            empty_type.finish();
+        }
+        fb.link(children, fb.start_vector(0, 4));
+    }
+    write_message(out, fb, "");
+}
+
+void ArrowWriter::write(const Table& table) {
+    std::size_t n_rows = table.n_rows();
+    if (n_rows == 0) {
+        return;
+    }
+    // Each column has a validity bitmap (empty if there are no nulls), then the values, which for
+    // strings are 32-bit offsets followed by the characters. Buffers are padded to 8 bytes.
+    struct Buffer {
+        int64_t offset;
+        int64_t length;
+    };
+    std::vector<Buffer> buffers;
+    std::string body;
+    auto add_buffer = [&](auto append) {
+        std::size_t start = body.size();
+        append();
+        buffers.push_back({static_cast<int64_t>(start), static_cast<int64_t>(body.size() - start)});
+        body.resize((body.size() + 7) / 8 * 8, '\0');
+    };
+    for (std::size_t col = 0; col < schema.size(); col++) {
+        const auto& column = table.column(col);
+        add_buffer([&] {
+            if (column.n_nulls > 0) {
+                append_bitmap(body, column.valid);
+            }
+        });
+        switch (schema[col].type) {
+        case Type::INT32:
+            add_buffer([&] { append_values(body, column.ints); });
+            break;
+        case Type::FLOAT64:
+            add_buffer([&] { append_values(body, column.doubles); });
+            break;
+        case Type::BOOL:
+            add_buffer([&] { append_bitmap(body, column.bools); });
+            break;
+        case Type::STRING:
+            add_buffer([&] {
+                int32_t zero = 0;
+                body.append(reinterpret_cast<const char*>(&zero), sizeof(zero));
+                append_values(body, column.ends);
+            });
+            add_buffer([&] { body += column.chars; });
+            break;
+        }
+    }
+
+    FlatBuilder fb;
+    std::size_t header = start_message(fb, HEADER_RECORD_BATCH, body.size());
+    // Fields: length, nodes, buffers
+    TableBuilder batch(fb, 3);
+    fb.link(header, batch.start());
+    batch.add<int64_t>(0, n_rows);
+    std::size_t nodes_offset = batch.add_offset(1);
+    std::size_t buffers_offset = batch.add_offset(2);
+    batch.finish();
+    // FieldNode structs: length, null_count
+    fb.link(nodes_offset, fb.start_vector(schema.size(), 8));
+    for (std::size_t col = 0; col < schema.size(); col++) {
+        fb.put<int64_t>(n_rows);
+        fb.put<int64_t>(table.column(col).n_nulls);
+    }
+    // Buffer structs: offset, length
+    fb.link(buffers_offset, fb.start_vector(buffers.size(), 8));
+    for (const auto& buffer : buffers) {
+        fb.put<int64_t>(buffer.offset);
+        fb.put<int64_t>(buffer.length);
+    }
+    write_message(out, fb, body);
+}
+
+void ArrowWriter::finish() {
+    // End-of-stream marker
+    int32_t eos[2] = {-1, 0};
+    out.write(reinterpret_cast<const char*>(eos), sizeof(eos));
+    out.flush();
+}
+
+std::unique_ptr<Writer> make_writer(std::string_view format, std::ostream& out,
+                                    const std::vector<Column>& schema) {
+    if (format == "csv") {
+        return std::make_unique<CsvWriter>(out, schema);
+    }
+    if (format == "arrow") {
+        return std::make_unique<ArrowWriter>(out, schema);
+    }
+    throw std::invalid_argument("unknown output format '" + std::string(format) + "'");
+}
+} // namespace columns
@@ -0,0 +1,101 @@
+// Columnar tables of results, and writers for CSV and the Arrow IPC streaming format
+
+#ifndef COLUMNS_HPP_
+#define COLUMNS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace columns {
+enum class Type { INT32, FLOAT64, BOOL, STRING };
+
+struct Column {
+    std::string name;
+    Type type;
+};
+
+// Values for one column, in whichever vector matches its type
+struct ColumnData {
+    std::vector<int32_t> ints;
+    std::vector<double> doubles;
+    std::vector<uint8_t> bools;
+    // End of each string in chars
+    std::vector<uint32_t> ends;
+    std::string chars;
+    std::vector<uint8_t> valid; // 0 for nulls
+    std::size_t n_nulls = 0;
+};
+
+// A batch of rows, stored by column. Rows are appended by pushing one value to every column, in
+// any order, then calling end_row(). Every column can be null.
+class Table {
+    std::vector<Column> schema_;
+    std::vector<ColumnData> data;
+    std::size_t n_rows_ = 0;
+
+  public:
+    explicit Table(std::vector<Column> schema);
+
+    const std::vector<Column>& schema() const { return schema_; }
+    const ColumnData& column(std::size_t col) const { return data[col]; }
+    std::size_t n_rows() const { return n_rows_; }
+
+    void push_int(std::size_t col, int32_t value);
+    void push_double(std::size_t col, double value);
+    void push_bool(std::size_t col, bool value);
+    void push_string(std::size_t col, std::string_view value);
+    void push_null(std::size_t col);
+    void end_row() { n_rows_++; }
+    // Remove all rows, keeping the allocated storage
+    void clear();
+};
+
+// Writes tables with a fixed schema to a stream, buffering output in large chunks
+class Writer {
+  public:
+    virtual ~Writer() = default;
+    // Write the rows of a table with the writer's schema
+    virtual void write(const Table& table) = 0;
+    // Write anything that ends the output, and flush it
+    virtual void finish() = 0;
+};
+
+// CSV (RFC 4180) with a header row, and empty fields for nulls. Strings are quoted if needed, and
+// floats are written in their shortest round-trip form.
+class CsvWriter : public Writer {
+    std::ostream& out;
+    std::string buffer;
+
+    void flush_if_full();
+
+  public:
+    CsvWriter(std::ostream& out, const std::vector<Column>& schema);
+    void write(const Table& table) override;
+    void finish() override;
+};
+
+// Arrow IPC streaming format (https://arrow.apache.org/docs/format/Columnar.html), which dataframe
+// libraries can read without parsing. Each table written is one record batch. Written by hand
+// rather than with the Arrow libraries, so it assumes a little-endian platform.
+class ArrowWriter : public Writer {
+    std::ostream& out;
+    std::vector<Column> schema;
+
+  public:
+    ArrowWriter(std::ostream& out, const std::vector<Column>& schema);
+    void write(const Table& table) override;
+    void finish() override;
+};
+
+// Writer for an output format name ("csv" or "arrow"). Throws std::invalid_argument for other
+// names.
+std::unique_ptr<Writer> make_writer(std::string_view format, std::ostream& out,
+                                    const std::vector<Column>& schema);
+} // namespace columns
+
+#endif
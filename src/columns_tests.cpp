@@ -0,0 +1,255 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "columns.hpp"
+
+using columns::Type;
+
+namespace {
+const std::vector<columns::Column> SCHEMA = {
+    {"n", Type::INT32},
+    {"x", Type::FLOAT64},
+    {"flag", Type::BOOL},
+    {"name", Type::STRING},
+};
+
+columns::Table make_table() {
+    columns::Table table(SCHEMA);
+    table.push_int(0, 1);
+    table.push_double(1, 0.5);
+    table.push_bool(2, true);
+    table.push_string(3, "plain");
+    table.end_row();
+    table.push_int(0, -20);
+    table.push_null(1);
+    table.push_bool(2, false);
+    table.push_string(3, "a, \"quoted\" one");
+    table.end_row();
+    table.push_null(0);
+    table.push_double(1, 100);
+    table.push_null(2);
+    table.push_string(3, "");
+    table.end_row();
+    table.push_int(0, 3);
+    table.push_double(1, -1.25);
+    table.push_bool(2, true);
+    table.push_null(3);
+    table.end_row();
+    return table;
+}
+
+template <typename T> T read(const std::string& buf, std::size_t pos) {
+    T value;
+    REQUIRE(pos + sizeof(T) <= buf.size());
+    std::memcpy(&value, &buf[pos], sizeof(T));
+    return value;
+}
+
+// Reads tables from a FlatBuffers buffer, checking alignment along the way
+struct FlatTable {
+    const std::string& buf;
+    std::size_t pos;
+
+    FlatTable(const std::string& buf_, std::size_t pos_) : buf(buf_), pos(pos_) {
+        REQUIRE(pos % 4 == 0);
+    }
+    std::size_t vtable() const { return pos - read<int32_t>(buf, pos); }
+    // Position of a field, or 0 if it's absent
+    std::size_t field(uint16_t id) const {
+        std::size_t vt = vtable();
+        if (4 + 2 * id >= read<uint16_t>(buf, vt)) {
+            return 0;
+        }
+        uint16_t offset = read<uint16_t>(buf, vt + 4 + 2 * id);
+        return offset ? pos + offset : 0;
+    }
+    template <typename T> T get(uint16_t id, T default_val = 0) const {
+        std::size_t f = field(id);
+        if (!f) {
+            return default_val;
+        }
+        REQUIRE(f % sizeof(T) == 0);
+        return read<T>(buf, f);
+    }
+    std::size_t deref(uint16_t id) const {
+        std::size_t f = field(id);
+        REQUIRE(f != 0);
+        return f + read<uint32_t>(buf, f);
+    }
+    FlatTable table(uint16_t id) const { return FlatTable(buf, deref(id)); }
+    std::string string(uint16_t id) const {
+        std::size_t s = deref(id);
+        return buf.substr(s + 4, read<uint32_t>(buf, s));
+    }
+};
+
+struct Message {
+    uint8_t header_type;
+    std::string metadata;
+    std::string body;
+};
+
+// Split an Arrow IPC stream into its messages, checking the framing and end-of-stream marker
+std::vector<Message> read_messages(const std::string& stream) {
+    std::vector<Message> messages;
+    std::size_t pos = 0;
+    while (true) {
+        REQUIRE(read<int32_t>(stream, pos) == -1);
+        auto size = read<int32_t>(stream, pos + 4);
+        pos += 8;
+        if (size == 0) {
+            break;
+        }
+        REQUIRE(size % 8 == 0);
+        std::string metadata = stream.substr(pos, size);
+        pos += size;
+        FlatTable message(metadata, read<uint32_t>(metadata, 0));
+        REQUIRE(message.get<int16_t>(0) == 4); // V5
+        auto body_length = message.get<int64_t>(3);
+        REQUIRE(body_length % 8 == 0);
+        messages.push_back({message.get<uint8_t>(1), metadata, stream.substr(pos, body_length)});
+        pos += body_length;
+    }
+    REQUIRE(pos == stream.size());
+    return messages;
+}
+
+FlatTable header(const Message& message) {
+    FlatTable root(message.metadata, read<uint32_t>(message.metadata, 0));
+    return root.table(2);
+}
+
+bool bit(const std::string& body, std::size_t offset, std::size_t i) {
+    return (body[offset + i / 8] >> (i % 8)) & 1;
+}
+} // namespace
+
+TEST_CASE("Tables are written as CSV", "[columns]") {
+    std::ostringstream out;
+    columns::CsvWriter writer(out, SCHEMA);
+    auto table = make_table();
+    writer.write(table);
+    table.clear();
+    REQUIRE(table.n_rows() == 0);
+    table.push_int(0, 7);
+    table.push_double(1, 0.1);
+    table.push_bool(2, false);
+    table.push_string(3, "line\nbreak");
+    table.end_row();
+    writer.write(table);
+    writer.finish();
+    REQUIRE(out.str() == "n,x,flag,name\n"
+                         "1,0.5,true,plain\n"
+                         "-20,,false,\"a, \"\"quoted\"\" one\"\n"
+                         ",100,,\"\"\n"
+                         "3,-1.25,true,\n"
+                         "7,0.1,false,\"line\nbreak\"\n");
+}
+
+TEST_CASE("Tables are written in the Arrow IPC stream format", "[columns]") {
+    std::ostringstream out;
+    auto writer = columns::make_writer("arrow", out, SCHEMA);
+    writer->write(make_table());
+    writer->write(columns::Table(SCHEMA)); // Empty tables are skipped
+    writer->finish();
+    auto messages = read_messages(out.str());
+    REQUIRE(messages.size() == 2);
+
+    SECTION("Schema") {
+        REQUIRE(messages[0].header_type == 1);
+        REQUIRE(messages[0].body.empty());
+        FlatTable schema = header(messages[0]);
+        std::size_t fields = schema.deref(1);
+        REQUIRE(read<uint32_t>(messages[0].metadata, fields) == SCHEMA.size());
+        const uint8_t type_ids[] = {2, 3, 6, 5}; // Int, FloatingPoint, Bool, Utf8
+        for (std::size_t i = 0; i < SCHEMA.size(); i++) {
+            std::size_t f = fields + 4 + 4 * i;
+            FlatTable field(messages[0].metadata, f + read<uint32_t>(messages[0].metadata, f));
+            REQUIRE(field.string(0) == SCHEMA[i].name);
+            REQUIRE(field.get<uint8_t>(1) == 1);
+            REQUIRE(field.get<uint8_t>(2) == type_ids[i]);
+            FlatTable type = field.table(3);
+            if (SCHEMA[i].type == Type::INT32) {
+                REQUIRE(type.get<int32_t>(0) == 32);
+                REQUIRE(type.get<uint8_t>(1) == 1);
+            } else if (SCHEMA[i].type == Type::FLOAT64) {
+                REQUIRE(type.get<int16_t>(0) == 2);
+            }
+            REQUIRE(read<uint32_t>(messages[0].metadata, field.deref(5)) == 0);
+        }
+    }
+    SECTION("Record batch") {
+        REQUIRE(messages[1].header_type == 3);
+        const std::string& body = messages[1].body;
+        FlatTable batch = header(messages[1]);
+        REQUIRE(batch.get<int64_t>(0) == 4);
+
+        std::size_t nodes = batch.deref(1);
+        REQUIRE(read<uint32_t>(messages[1].metadata, nodes) == SCHEMA.size());
+        REQUIRE((nodes + 4) % 8 == 0);
+        const int64_t null_counts[] = {1, 1, 1, 1};
+        for (std::size_t i = 0; i < SCHEMA.size(); i++) {
+            REQUIRE(read<int64_t>(messages[1].metadata, nodes + 4 + 16 * i) == 4);
+            REQUIRE(read<int64_t>(messages[1].metadata, nodes + 12 + 16 * i) == null_counts[i]);
+        }
+
+        std::size_t buffers = batch.deref(2);
+        REQUIRE(read<uint32_t>(messages[1].metadata, buffers) == 9);
+        std::vector<std::pair<int64_t, int64_t>> bufs;
+        for (std::size_t i = 0; i < 9; i++) {
+            int64_t offset = read<int64_t>(messages[1].metadata, buffers + 4 + 16 * i);
+            int64_t length = read<int64_t>(messages[1].metadata, buffers + 12 + 16 * i);
+            REQUIRE(offset % 8 == 0);
+            REQUIRE(offset + length <= static_cast<int64_t>(body.size()));
+            bufs.push_back({offset, length});
+        }
+        // n
+        REQUIRE(bufs[0].second == 1);
+        REQUIRE(body[bufs[0].first] == 0b1011);
+        REQUIRE(bufs[1].second == 16);
+        REQUIRE(read<int32_t>(body, bufs[1].first) == 1);
+        REQUIRE(read<int32_t>(body, bufs[1].first + 4) == -20);
+        REQUIRE(read<int32_t>(body, bufs[1].first + 12) == 3);
+        // x
+        REQUIRE(body[bufs[2].first] == 0b1101);
+        REQUIRE(bufs[3].second == 32);
+        REQUIRE(read<double>(body, bufs[3].first + 8 * 2) == 100);
+        REQUIRE(read<double>(body, bufs[3].first + 8 * 3) == -1.25);
+        // flag
+        REQUIRE(body[bufs[4].first] == 0b1011);
+        REQUIRE(bufs[5].second == 1);
+        REQUIRE(bit(body, bufs[5].first, 0));
+        REQUIRE(!bit(body, bufs[5].first, 1));
+        REQUIRE(bit(body, bufs[5].first, 3));
+        // name
+        REQUIRE(body[bufs[6].first] == 0b0111);
+        REQUIRE(bufs[7].second == 20);
+        std::vector<int32_t> offsets;
+        for (std::size_t i = 0; i < 5; i++) {
+            offsets.push_back(read<int32_t>(body, bufs[7].first + 4 * i));
+        }
+        REQUIRE(offsets == std::vector<int32_t>{0, 5, 20, 20, 20});
+        REQUIRE(body.substr(bufs[8].first, bufs[8].second) == "plaina, \"quoted\" one");
+    }
+    SECTION("Validity bitmaps are omitted without nulls") {
+        std::ostringstream no_nulls;
+        columns::ArrowWriter w(no_nulls, {{"n", Type::INT32}});
+        columns::Table table({{"n", Type::INT32}});
+        table.push_int(0, 5);
+        table.end_row();
+        w.write(table);
+        w.finish();
+        auto msgs = read_messages(no_nulls.str());
+        REQUIRE(msgs.size() == 2);
+        std::size_t buffers = header(msgs[1]).deref(2);
+        REQUIRE(read<int64_t>(msgs[1].metadata, buffers + 12) == 0);
+        REQUIRE(msgs[1].body.size() == 8);
+    }
+}
+
+TEST_CASE("Unknown formats are rejected", "[columns]") {
+    std::ostringstream out;
+    REQUIRE_THROWS_AS(columns::make_writer("parquet", out, SCHEMA), std::invalid_argument);
+}
@@ -1,3 +1,5 @@
+#include <array>
+#include <iterator>
 #include <limits>
 #include "damage.hpp"
 
@@ -204,6 +206,32 @@ bool MonsterEntity::two_turn_move_forced_miss(eos::move_id move) const {
     return true;
 }
 
+ResolvedMonster::ResolvedMonster(const MonsterEntity& entity, const DungeonState& dungeon)
+    : iq_skill_flags(nullptr), exclusive_item_effect_flags(nullptr),
+      weather(entity.perceived_weather(dungeon)) {
+    for (int i = 0; i < 2; i++) {
+        auto ability = entity.monster.abilities[i];
+        abilities[i] = entity.ability_active(ability) ? ability : eos::ABILITY_UNKNOWN;
+    }
+    // These mirror iq_skill_enabled() and exclusive_item_effect_active()
+    if (entity.monster.is_not_team_member || !dungeon.iq_disabled) {
+        iq_skill_flags = entity.monster.iq_skill_flags;
+    }
+    if (!entity.monster.is_not_team_member) {
+        exclusive_item_effect_flags = entity.monster.exclusive_item_effect_flags;
+    }
+    // item_active() can only be true for the held item
+    if (entity.item_active(entity.monster.held_item.id)) {
+        active_item = entity.monster.held_item.id;
+    }
+}
+
+CombatContext::CombatContext(const MonsterEntity& attacker_, const MonsterEntity& defender_,
+                             const DungeonState& dungeon)
+    : attacker(attacker_, dungeon), defender(defender_, dungeon),
+      mold_breaker(&attacker_ != &defender_ && attacker_.is_monster() &&
+                   attacker.ability_active(eos::ABILITY_MOLD_BREAKER)) {}
+
 // pmdsky-debug: GetTypeMatchup ([NA] 0x230AC58)
 eos::type_matchup get_type_matchup(const DungeonState& dungeon, const MonsterEntity& attacker,
                                    const MonsterEntity& defender, int target_type_idx,
@@ -248,11 +276,32 @@ bool genders_equal_not_genderless(eos::monster_id monster1, eos::monster_id mons
     return gender1 == gender2;
 }
 
+// Whether any of the special cases in the per-type matchup logic of CalcTypeBasedDamageEffects
+// (Ghost immunity, Scrappy, Miracle Eye, Gravity, Magnet Rise) could apply. If not, the individual
+// matchups are just the raw TYPE_MATCHUP_TABLE entries, and can be looked up all at once.
+bool type_matchup_special_case_possible(const DungeonState& dungeon, const MonsterEntity& defender,
+                                        eos::type_id attack_type) {
+    switch (attack_type) {
+    case eos::TYPE_NORMAL:
+    case eos::TYPE_FIGHTING:
+        return defender.is_type(eos::TYPE_GHOST);
+    case eos::TYPE_PSYCHIC:
+        return defender.is_type(eos::TYPE_DARK);
+    case eos::TYPE_GROUND:
+        return (dungeon.gravity && defender.is_type(eos::TYPE_FLYING)) ||
+               defender.has_conditional_ground_immunity(dungeon);
+    default:
+        return false;
+    }
+}
+
 // pmdsky-debug: CalcTypeBasedDamageEffects ([NA] 0x230AD04)
-bool calc_type_based_damage_effects(DungeonState& dungeon, Fx64& damage_mult_out,
-                                    const MonsterEntity& attacker, const MonsterEntity& defender,
-                                    int32_t attack_power, eos::type_id attack_type,
-                                    DamageData& damage_out, bool partial)
+// partial is a template parameter since it's fixed for a given move (see calc_damage())
+template <bool partial>
+bool calc_type_based_damage_effects(DungeonState& dungeon, const CombatContext& ctx,
+                                    Fx64& damage_mult_out, const MonsterEntity& attacker,
+                                    const MonsterEntity& defender, int32_t attack_power,
+                                    eos::type_id attack_type, DamageData& damage_out)
 
 {
     damage_mult_out = Fx64{1};
@@ -263,81 +312,66 @@ bool calc_type_based_damage_effects(DungeonState& dungeon, Fx64& damage_mult_out
     }
 
     damage_out.type_matchup = eos::MATCHUP_NEUTRAL;
-    // TODO: these two values are initialized to some default values...what are they?
-    // It should never affect the output of the function though.
-    eos::type_matchup type_matchups[2] = {};
-    for (int i = 0; i < 2; i++) {
-        Fx64 matchup_multipliers[4];
-        if (!partial && (attacker.iq_skill_enabled(eos::IQ_ERRATIC_PLAYER, dungeon) ||
-                         defender.iq_skill_enabled(eos::IQ_ERRATIC_PLAYER, dungeon))) {
-            matchup_multipliers[0] = Fx64{mechanics::MATCHUP_IMMUNE_MULTIPLIER_ERRATIC_PLAYER};
-            matchup_multipliers[1] =
-                Fx64{mechanics::MATCHUP_NOT_VERY_EFFECTIVE_MULTIPLIER_ERRATIC_PLAYER};
-            matchup_multipliers[2] = Fx64{mechanics::MATCHUP_NEUTRAL_MULTIPLIER_ERRATIC_PLAYER};
-            matchup_multipliers[3] =
-                Fx64{mechanics::MATCHUP_SUPER_EFFECTIVE_MULTIPLIER_ERRATIC_PLAYER};
-        } else {
-            matchup_multipliers[0] = Fx64{mechanics::MATCHUP_IMMUNE_MULTIPLIER};
-            matchup_multipliers[1] = Fx64{mechanics::MATCHUP_NOT_VERY_EFFECTIVE_MULTIPLIER};
-            matchup_multipliers[2] = Fx64{mechanics::MATCHUP_NEUTRAL_MULTIPLIER};
-            matchup_multipliers[3] = Fx64{mechanics::MATCHUP_SUPER_EFFECTIVE_MULTIPLIER};
-        }
-
-        if (damage_mult_out == 0) {
-            break;
-        }
-
-        eos::type_matchup matchup;
-        if (!attacker.scrappy_should_activate(defender, attack_type, dungeon) &&
-            mechanics::type_ineffective_against_ghost(attack_type) &&
-            defender.ghost_immunity_active(attacker, i)) {
-            matchup = eos::MATCHUP_IMMUNE;
-            dungeon.damage_calc.ghost_immunity_activated = true;
-        } else {
-            matchup = get_type_matchup(dungeon, attacker, defender, i, attack_type);
-        }
-        if (attacker.iq_skill_enabled(eos::IQ_ERRATIC_PLAYER, dungeon) ||
-            matchup != eos::MATCHUP_NEUTRAL) {
-            damage_mult_out *= matchup_multipliers[matchup];
+    const mechanics::TypeMatchupCombination* matchups;
+    if (type_matchup_special_case_possible(dungeon, defender, attack_type)) {
+        eos::type_matchup type_matchups[2];
+        for (int i = 0; i < 2; i++) {
+            if (!attacker.scrappy_should_activate(defender, attack_type, dungeon) &&
+                mechanics::type_ineffective_against_ghost(attack_type) &&
+                defender.ghost_immunity_active(attacker, i)) {
+                type_matchups[i] = eos::MATCHUP_IMMUNE;
+                dungeon.damage_calc.ghost_immunity_activated = true;
+            } else {
+                type_matchups[i] = get_type_matchup(dungeon, attacker, defender, i, attack_type);
+            }
         }
-        type_matchups[i] = matchup;
+        matchups = &mechanics::combine_type_matchups(type_matchups[0], type_matchups[1]);
+    } else {
+        matchups = &mechanics::get_dual_type_matchup(attack_type, defender.monster.types[0],
+                                                     defender.monster.types[1]);
     }
+    // The Erratic Player multipliers are used if either side has the IQ skill, but neutral
+    // matchups only factor in if the attacker has it
+    bool erratic_player_multipliers =
+        !partial && (ctx.attacker.iq_skill_enabled(eos::IQ_ERRATIC_PLAYER) ||
+                     ctx.defender.iq_skill_enabled(eos::IQ_ERRATIC_PLAYER));
+    bool apply_neutral_multiplier = ctx.attacker.iq_skill_enabled(eos::IQ_ERRATIC_PLAYER);
+    damage_mult_out = matchups->multipliers[erratic_player_multipliers][apply_neutral_multiplier];
 
-    dungeon.damage_calc.move_indiv_type_matchups[0] = type_matchups[0];
-    dungeon.damage_calc.move_indiv_type_matchups[1] = type_matchups[1];
-    damage_out.type_matchup =
-        mechanics::TYPE_MATCHUP_COMBINATOR_TABLE[type_matchups[0]][type_matchups[1]];
+    dungeon.damage_calc.move_indiv_type_matchups[0] = matchups->indiv[0];
+    dungeon.damage_calc.move_indiv_type_matchups[1] = matchups->indiv[1];
+    damage_out.type_matchup = matchups->combined;
 
     bool super_effective = (damage_out.type_matchup == eos::MATCHUP_SUPER_EFFECTIVE);
     if (!super_effective) {
-        if (defender.ability_active(eos::ABILITY_WONDER_GUARD, attacker, true) &&
+        if (ctx.defender_ability_active(eos::ABILITY_WONDER_GUARD) &&
             attack_type != eos::TYPE_NONE) {
             damage_mult_out = Fx64{0};
         }
     }
 
-    if (attacker.ability_active(eos::ABILITY_TINTED_LENS) &&
+    if (ctx.attacker.ability_active(eos::ABILITY_TINTED_LENS) &&
         damage_out.type_matchup == eos::MATCHUP_NOT_VERY_EFFECTIVE) {
         damage_mult_out *= Fx64{mechanics::TINTED_LENS_MULTIPLIER};
     }
 
-    if ((defender.ability_active(eos::ABILITY_SOLID_ROCK, attacker, true) ||
-         defender.ability_active(eos::ABILITY_FILTER, attacker, true)) &&
+    if ((ctx.defender_ability_active(eos::ABILITY_SOLID_ROCK) ||
+         ctx.defender_ability_active(eos::ABILITY_FILTER)) &&
         (damage_out.type_matchup == eos::MATCHUP_SUPER_EFFECTIVE)) {
         damage_mult_out *= mechanics::SOLID_ROCK_MULTIPLIER;
     }
 
-    if (defender.exclusive_item_effect_active(eos::EXCLUSIVE_EFF_HALVED_DAMAGE)) {
+    if (ctx.defender.exclusive_item_effect_active(eos::EXCLUSIVE_EFF_HALVED_DAMAGE)) {
         damage_mult_out *= Fx64::CONST_0_5;
     }
 
-    if (!partial && attacker.ability_active(eos::ABILITY_TECHNICIAN) &&
+    if (!partial && ctx.attacker.ability_active(eos::ABILITY_TECHNICIAN) &&
         attack_power <= mechanics::TECHNICIAN_MOVE_POWER_THRESHOLD) {
         damage_mult_out *= Fx64::CONST_1_5;
     }
 
     if ((attack_type == eos::TYPE_FIRE || attack_type == eos::TYPE_ICE) &&
-        defender.ability_active(eos::ABILITY_THICK_FAT, attacker, true)) {
+        ctx.defender_ability_active(eos::ABILITY_THICK_FAT)) {
         dungeon.damage_calc.fire_move_ability_drop_activated = true;
         damage_mult_out *= Fx64::CONST_0_5;
     }
@@ -352,14 +386,15 @@ bool calc_type_based_damage_effects(DungeonState& dungeon, Fx64& damage_mult_out
     }
 
     if (attack_type == eos::TYPE_FIRE &&
-        defender.ability_active(eos::ABILITY_HEATPROOF, attacker, true)) {
+        ctx.defender_ability_active(eos::ABILITY_HEATPROOF)) {
         dungeon.damage_calc.fire_move_ability_drop_activated = true;
         damage_mult_out *= Fx64::CONST_0_5;
     }
 
-    if (attack_type == eos::TYPE_GROUND && ((!attacker.ability_active(eos::ABILITY_MOLD_BREAKER) &&
-                                             defender.levitate_active(dungeon)) ||
-                                            defender.has_conditional_ground_immunity(dungeon))) {
+    if (attack_type == eos::TYPE_GROUND &&
+        ((!ctx.attacker.ability_active(eos::ABILITY_MOLD_BREAKER) &&
+          defender.levitate_active(dungeon)) ||
+         defender.has_conditional_ground_immunity(dungeon))) {
         damage_mult_out = Fx64{0};
         super_effective = false;
         damage_out.type_matchup = eos::MATCHUP_IMMUNE;
@@ -367,7 +402,7 @@ bool calc_type_based_damage_effects(DungeonState& dungeon, Fx64& damage_mult_out
         damage_out.full_type_immunity = true;
     }
 
-    if (attack_type == eos::TYPE_WATER && attacker.ability_active(eos::ABILITY_TORRENT)) {
+    if (attack_type == eos::TYPE_WATER && ctx.attacker.ability_active(eos::ABILITY_TORRENT)) {
         int32_t max_hp = attacker.monster.max_hp_stat + attacker.monster.max_hp_boost;
         if (max_hp > mechanics::MAX_HP_CAP) {
             max_hp = mechanics::MAX_HP_CAP;
@@ -377,7 +412,7 @@ bool calc_type_based_damage_effects(DungeonState& dungeon, Fx64& damage_mult_out
             damage_mult_out *= Fx64{2};
         }
     }
-    if (attack_type == eos::TYPE_GRASS && attacker.ability_active(eos::ABILITY_OVERGROW)) {
+    if (attack_type == eos::TYPE_GRASS && ctx.attacker.ability_active(eos::ABILITY_OVERGROW)) {
         int32_t max_hp = attacker.monster.max_hp_stat + attacker.monster.max_hp_boost;
         if (max_hp > mechanics::MAX_HP_CAP) {
             max_hp = mechanics::MAX_HP_CAP;
@@ -387,7 +422,7 @@ bool calc_type_based_damage_effects(DungeonState& dungeon, Fx64& damage_mult_out
             damage_mult_out *= Fx64{2};
         }
     }
-    if (attack_type == eos::TYPE_BUG && attacker.ability_active(eos::ABILITY_SWARM)) {
+    if (attack_type == eos::TYPE_BUG && ctx.attacker.ability_active(eos::ABILITY_SWARM)) {
         int32_t max_hp = attacker.monster.max_hp_stat + attacker.monster.max_hp_boost;
         if (max_hp > mechanics::MAX_HP_CAP) {
             max_hp = mechanics::MAX_HP_CAP;
@@ -398,7 +433,7 @@ bool calc_type_based_damage_effects(DungeonState& dungeon, Fx64& damage_mult_out
         }
     }
     if (attack_type == eos::TYPE_FIRE) {
-        if (attacker.ability_active(eos::ABILITY_BLAZE)) {
+        if (ctx.attacker.ability_active(eos::ABILITY_BLAZE)) {
             int32_t max_hp = attacker.monster.max_hp_stat + attacker.monster.max_hp_boost;
             if (max_hp > mechanics::MAX_HP_CAP) {
                 max_hp = mechanics::MAX_HP_CAP;
@@ -409,7 +444,7 @@ bool calc_type_based_damage_effects(DungeonState& dungeon, Fx64& damage_mult_out
             }
         }
 
-        if (defender.ability_active(eos::ABILITY_DRY_SKIN, attacker, true)) {
+        if (ctx.defender_ability_active(eos::ABILITY_DRY_SKIN)) {
             dungeon.damage_calc.fire_move_ability_boost_activated = true;
             damage_mult_out *= Fx64::CONST_1_5;
         }
@@ -421,14 +456,14 @@ bool calc_type_based_damage_effects(DungeonState& dungeon, Fx64& damage_mult_out
 
     if (damage_mult_out != 0 && attacker.is_type(attack_type)) {
         dungeon.damage_calc.stab_boost_activated = true;
-        if (attacker.ability_active(eos::ABILITY_ADAPTABILITY)) {
+        if (ctx.attacker.ability_active(eos::ABILITY_ADAPTABILITY)) {
             damage_mult_out *= 2;
         } else {
             damage_mult_out *= Fx64::CONST_1_5;
         }
     }
 
-    eos::weather_id weather = attacker.perceived_weather(dungeon);
+    eos::weather_id weather = ctx.attacker.perceived_weather();
     if (weather == eos::WEATHER_SUNNY) {
         if (attack_type == eos::TYPE_FIRE) {
             dungeon.damage_calc.sunny_multiplier_activated = true;
@@ -469,10 +504,222 @@ bool calc_type_based_damage_effects(DungeonState& dungeon, Fx64& damage_mult_out
     return super_effective;
 }
 
+// Whether the calling thread skips the damage calc's shortcuts; see set_reference_mode()
+namespace {
+thread_local bool reference_mode_enabled = false;
+} // namespace
+
+void set_reference_mode(bool enabled) { reference_mode_enabled = enabled; }
+bool reference_mode() { return reference_mode_enabled; }
+
+// The base damage from the attack, defense and level terms of the damage formula, with the enemy
+// divisor and the clamp to 1-999 applied
+static Fx64 calc_base_damage(Fx64 at, int32_t def, Fx64 flv, bool enemy_divisor) {
+    Fx64 at_scaled = at * Fx64{Fx32::CONST_153_DIV_256};
+    Fx64 def_scaled = Fx64{def} * Fx64{Fx32::CONST_NEG0_5};
+    int32_t ln_arg = ((flv + Fx64{Fx32{50}}) * Fx64{Fx32{10}}).round();
+    Fx64 ln = clamped_ln(ln_arg);
+    Fx64 ln_scaled = ln * Fx64{Fx32{50}};
+
+    Fx64 base = ((def_scaled + at_scaled) + ln_scaled) + Fx64{Fx32{-311}};
+
+    if (enemy_divisor) {
+        base = reference_mode_enabled ? base / Fx64::CONST_85_DIV_64
+                                      : div_by_constant<Fx64::CONST_85_DIV_64>(base);
+    }
+    if (Fx64{999} < base) {
+        base = Fx64{999};
+    }
+    if (base < Fx64{1}) {
+        base = Fx64{1};
+    }
+    return base;
+}
+
+// Sweeps and batches tend to revisit the same attack/defense/level combinations over and over, so
+// the base damage is memoized in a small direct-mapped cache. Each thread has its own, so there's
+// no locking, and every entry stores its full key, so a collision only costs a recomputation.
+namespace {
+struct BaseDamageMemoEntry {
+    uint64_t at_raw;
+    uint64_t flv_raw;
+    int32_t def;
+    bool enemy_divisor;
+    bool valid;
+    Fx64 base;
+};
+constexpr std::size_t BASE_DAMAGE_MEMO_SIZE = 1024;
+thread_local std::array<BaseDamageMemoEntry, BASE_DAMAGE_MEMO_SIZE> base_damage_memo{};
+thread_local BaseDamageMemoStats base_damage_memo_counts{};
+} // namespace
+
+static Fx64 memoized_base_damage(Fx64 at, int32_t def, Fx64 flv, bool enemy_divisor) {
+    if (reference_mode_enabled) {
+        return calc_base_damage(at, def, flv, enemy_divisor);
+    }
+    uint64_t at_raw = at.get_raw();
+    uint64_t flv_raw = flv.get_raw();
+    uint64_t hash = (at_raw ^ (flv_raw << 24) ^ (static_cast<uint64_t>(def) << 40) ^
+                     static_cast<uint64_t>(enemy_divisor)) *
+                    0x9E3779B97F4A7C15;
+    auto& entry = base_damage_memo[hash >> 54];
+    if (entry.valid && entry.at_raw == at_raw && entry.flv_raw == flv_raw && entry.def == def &&
+        entry.enemy_divisor == enemy_divisor) {
+        base_damage_memo_counts.hits++;
+        return entry.base;
+    }
+    base_damage_memo_counts.misses++;
+    Fx64 base = calc_base_damage(at, def, flv, enemy_divisor);
+    entry = {at_raw, flv_raw, def, enemy_divisor, true, base};
+    return base;
+}
+
+BaseDamageMemoStats base_damage_memo_stats() { return base_damage_memo_counts; }
+void reset_base_damage_memo_stats() { base_damage_memo_counts = {}; }
+
+// calc_damage()'s state at the Huge Power/Pure Power and critical hit rolls, with both rolls
+// failing (see MockDungeonRNG::roll_state)
+struct DamageRollState {
+    std::optional<CombatContext> ctx; // Set once calc_damage() gets to the rolls
+    // Arguments to stats_to_base_damage()
+    int32_t atk;
+    int32_t def;
+    int32_t atk_mult_int;
+    int32_t atk_div;
+    int32_t def_mult_int;
+    int32_t def_div;
+    Fx64 power;
+    // Whether a successful Huge Power/Pure Power roll boosts the attack
+    bool huge_pure_power_boosts;
+    // Arguments to finish_damage(), before the critical hit roll
+    Fx64 damage_mult_dynamic;
+    Fx32 damage_mult;
+    eos::move_id move_id;
+};
+
+// The parts of calc_damage() after each roll, split out so that simulate_damage_branches() can
+// run them again for the other outcomes of the rolls.
+
+// The Huge Power/Pure Power roll only changes the attack multiplier and divisor, so this takes
+// over from once they're final up to the base damage
+static Fx64 stats_to_base_damage(DungeonState& dungeon, const MonsterEntity& attacker, int32_t atk,
+                                 int32_t def, int32_t atk_mult_int, int32_t atk_div,
+                                 int32_t def_mult_int, int32_t def_div, Fx64 power) {
+    atk *= atk_mult_int;
+    def *= def_mult_int;
+
+    if (atk_div != 1) {
+        atk /= atk_div;
+    }
+    if (def_div != 1) {
+        def /= def_div;
+    }
+
+    dungeon.damage_calc.offense_calc = atk;
+    dungeon.damage_calc.defense_calc = def;
+
+    if (atk < 0) {
+        atk = 0;
+    }
+    if (atk >= mechanics::OFFENSE_STAT_MAX) {
+        atk = mechanics::OFFENSE_STAT_MAX;
+    }
+
+    dungeon.damage_calc.damage_calc_def = def;
+
+    Fx64 flv = Fx64{attacker.monster.level} +
+               (reference_mode_enabled ? Fx64{atk - def} / Fx64::CONST_8
+                                       : div_by_constant<Fx64::CONST_8>(Fx64{atk - def}));
+    Fx64 at = power + Fx64{atk};
+    dungeon.damage_calc.damage_calc_at = at.round();
+    dungeon.damage_calc.attacker_level = attacker.monster.level;
+    dungeon.damage_calc.damage_calc_flv = flv.round();
+
+    bool enemy_divisor = dungeon.gen_info.fixed_room_id != eos::FIXED_SUBSTITUTE_ROOM &&
+                         attacker.monster.is_not_team_member;
+    return memoized_base_damage(at, def, flv, enemy_divisor);
+}
+
+// After a successful critical hit roll
+static void apply_critical_hit(DungeonState& dungeon, const CombatContext& ctx,
+                               Fx64& damage_mult_dynamic, DamageData& damage_out) {
+    if (!ctx.defender.exclusive_item_effect_active(eos::EXCLUSIVE_EFF_NO_CRITICAL_HITS)) {
+        damage_out.critical_hit = true;
+        if (ctx.attacker.ability_active(eos::ABILITY_SNIPER)) {
+            damage_mult_dynamic *= Fx64{2};
+            dungeon.damage_calc.sniper_activated = true;
+        } else {
+            damage_mult_dynamic *= Fx64::CONST_1_5;
+        }
+    }
+}
+
+// From the damage multipliers on, including the damage roll
+template <bool regular_attack_or_projectile>
+static void finish_damage(DungeonState& dungeon, const CombatContext& ctx, MonsterEntity& defender,
+                          Fx64 base, Fx64 damage_mult_dynamic, Fx32 damage_mult,
+                          eos::move_id move_id, DamageData& damage_out) {
+    dungeon.damage_calc.damage_calc_base = base.round();
+    base *= damage_mult_dynamic;
+    dungeon.damage_calc.static_damage_mult = damage_mult;
+    base *= Fx64{damage_mult};
+    dungeon.damage_calc.damage_calc = base.round();
+
+    Fx64 variance = dungeon.rng.roll_damage_variance();
+    base *= variance;
+    dungeon.damage_calc.damage_calc_random_mult_pct = (Fx64{100} * variance).round();
+    damage_out.damage = base.round();
+
+    if (regular_attack_or_projectile && move_id == eos::MOVE_PROJECTILE) {
+        damage_out.damage = (Fx32{damage_out.damage} * Fx32::CONST_0_5).ceil();
+    }
+    if (regular_attack_or_projectile && move_id == eos::MOVE_PROJECTILE &&
+        ctx.attacker.iq_skill_enabled(eos::IQ_POWER_PITCHER)) {
+        damage_out.damage =
+            (Fx32{damage_out.damage} * mechanics::POWER_PITCHER_DAMAGE_MULTIPLIER).ceil();
+    }
+
+    if (damage_out.damage > 0 &&
+        ctx.attacker.exclusive_item_effect_active(eos::EXCLUSIVE_EFF_DAMAGE_BOOST_50_PCT)) {
+        damage_out.damage =
+            (Fx32{damage_out.damage} * mechanics::AIR_BLADE_DAMAGE_MULTIPLIER).ceil();
+    }
+
+    damage_out.damage_message = eos::DAMAGE_MESSAGE_MOVE;
+    if (damage_out.damage == 0) {
+        damage_out.critical_hit = false;
+    }
+    defender.monster.anger_point_flag = damage_out.critical_hit;
+}
+
+// Change to the defensive stage from the defender being Giratina. JP checks the attacker
+// instead (see calc_damage_kernel()).
+static int giratina_def_stage(const MonsterEntity& entity) {
+    switch (entity.monster.apparent_id) {
+    case eos::MONSTER_GIRATINA_ALTERED:
+        return 2;
+    case eos::MONSTER_GIRATINA_ORIGIN:
+        return -2;
+    default:
+        return 0;
+    }
+}
+
+bool version_affects_calc(const MonsterEntity& attacker, const MonsterEntity& defender) {
+    return giratina_def_stage(attacker) != giratina_def_stage(defender);
+}
+
 // pmdsky-debug: CalcDamage ([NA] 0x230BBAC)
-void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEntity& defender,
-                 eos::type_id attack_type, int32_t attack_power, int32_t crit_chance,
-                 DamageData& damage_out, Fx32 damage_mult, eos::move_id move_id, bool full_calc)
+// Specialized on the move properties that the game checks over and over again, but which are
+// fixed for a given move, so that each combination compiles to straight-line code. calc_damage()
+// picks the right one. full_calc is left as a runtime argument like in-game: every caller passes
+// true, so specializing on it would only add dead kernels.
+template <bool not_physical, bool regular_attack_or_projectile>
+void calc_damage_kernel(DungeonState& dungeon, const CombatContext& ctx,
+                        const MonsterEntity& attacker, MonsterEntity& defender,
+                        eos::type_id attack_type, int32_t attack_power, int32_t crit_chance,
+                        DamageData& damage_out, Fx32 damage_mult, eos::move_id move_id,
+                        bool full_calc)
 
 {
     damage_out = DamageData{};
@@ -480,27 +727,26 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
         damage_mult *= mechanics::ME_FIRST_MULTIPLIER;
     }
 
-    if (attacker.ability_active(eos::ABILITY_RECKLESS) && mechanics::is_recoil_move(move_id)) {
+    if (ctx.attacker.ability_active(eos::ABILITY_RECKLESS) && mechanics::is_recoil_move(move_id)) {
         damage_mult = (damage_mult * 3) / 2;
     }
 
-    if (attacker.ability_active(eos::ABILITY_IRON_FIST) && mechanics::is_punch_move(move_id)) {
+    if (ctx.attacker.ability_active(eos::ABILITY_IRON_FIST) && mechanics::is_punch_move(move_id)) {
         damage_mult *= Fx32::CONST_1_5;
     }
 
-    if (attacker.ability_active(eos::ABILITY_NORMALIZE)) {
+    if (ctx.attacker.ability_active(eos::ABILITY_NORMALIZE)) {
         attack_type = eos::TYPE_NORMAL;
     }
     if (move_id == eos::MOVE_JUDGMENT) {
         attack_type = attacker.monster.types[0];
     }
 
-    bool not_physical = mechanics::move_not_physical(move_id);
     dungeon.damage_calc = DamageCalcDiag{};
 
     if ((!attacker.monster.is_team_leader && attacker.monster.belly.ceil() == 0) ||
-        (move_id == eos::MOVE_REGULAR_ATTACK &&
-         defender.ability_active(eos::ABILITY_WONDER_GUARD, attacker, true))) {
+        (regular_attack_or_projectile && move_id == eos::MOVE_REGULAR_ATTACK &&
+         ctx.defender_ability_active(eos::ABILITY_WONDER_GUARD))) {
         damage_out.damage = 1;
         damage_out.damage_message = eos::DAMAGE_MESSAGE_MOVE;
         damage_out.type_matchup = eos::MATCHUP_NEUTRAL;
@@ -518,14 +764,14 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
     int32_t atk_stage_boost = 0;
 
     dungeon.damage_calc.move_type = attack_type;
-    eos::move_category move_category =
+    constexpr eos::move_category move_category =
         (not_physical ? eos::CATEGORY_SPECIAL : eos::CATEGORY_PHYSICAL);
     dungeon.damage_calc.move_category = move_category;
 
     Fx32 atk_stage_mult = attacker.monster.stat_modifiers.offensive_multipliers[move_category];
     int32_t def_stage = 0;
     Fx32 def_stage_mult = defender.monster.stat_modifiers.defensive_multipliers[move_category];
-    if (attacker.ability_active(eos::ABILITY_DOWNLOAD)) {
+    if (ctx.attacker.ability_active(eos::ABILITY_DOWNLOAD)) {
         if (defender.monster.defensive_stats[0] < defender.monster.defensive_stats[1]) {
             bool is_physical = (move_category == eos::CATEGORY_PHYSICAL);
             atk_stage_boost = static_cast<int32_t>(is_physical);
@@ -547,17 +793,17 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
         atk_stage_boost += flash_fire_boost;
     }
 
-    if (attacker.iq_skill_enabled(eos::IQ_AGGRESSOR, dungeon)) {
+    if (ctx.attacker.iq_skill_enabled(eos::IQ_AGGRESSOR)) {
         atk_stage_boost += 1;
         dungeon.damage_calc.iq_skill_offense_modifier += 1;
     }
 
-    if (attacker.iq_skill_enabled(eos::IQ_DEFENDER, dungeon)) {
+    if (ctx.attacker.iq_skill_enabled(eos::IQ_DEFENDER)) {
         atk_stage_boost -= 1;
         dungeon.damage_calc.iq_skill_offense_modifier -= 1;
     }
 
-    if (attacker.iq_skill_enabled(eos::IQ_PRACTICE_SWINGER, dungeon) &&
+    if (ctx.attacker.iq_skill_enabled(eos::IQ_PRACTICE_SWINGER) &&
         attacker.monster.practice_swinger_flag) {
         atk_stage_boost += 1;
         dungeon.damage_calc.iq_skill_offense_modifier += 1;
@@ -567,8 +813,8 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
         atk_stage_boost += 1;
     }
 
-    if (move_category == eos::CATEGORY_PHYSICAL) {
-        if (attacker.ability_active(eos::ABILITY_RIVALRY)) {
+    if constexpr (move_category == eos::CATEGORY_PHYSICAL) {
+        if (ctx.attacker.ability_active(eos::ABILITY_RIVALRY)) {
             if (genders_equal_not_genderless(attacker.monster.apparent_id,
                                              defender.monster.apparent_id)) {
                 atk_stage_boost += 1;
@@ -580,27 +826,27 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
             }
         }
 
-        if (attacker.perceived_weather(dungeon) == eos::WEATHER_SUNNY &&
-            (attacker.ability_active(eos::ABILITY_FLOWER_GIFT) ||
+        if (ctx.attacker.perceived_weather() == eos::WEATHER_SUNNY &&
+            (ctx.attacker.ability_active(eos::ABILITY_FLOWER_GIFT) ||
              attacker.other_monster_ability_active(eos::ABILITY_FLOWER_GIFT, dungeon))) {
             atk_stage_boost += 1;
             dungeon.damage_calc.ability_offense_modifier += 1;
         }
     } else {
-        if (attacker.ability_active(eos::ABILITY_SOLAR_POWER) &&
-            attacker.perceived_weather(dungeon) == eos::WEATHER_SUNNY) {
+        if (ctx.attacker.ability_active(eos::ABILITY_SOLAR_POWER) &&
+            ctx.attacker.perceived_weather() == eos::WEATHER_SUNNY) {
             atk_stage_boost += 2;
             dungeon.damage_calc.ability_offense_modifier += 2;
         }
 
-        if (defender.perceived_weather(dungeon) == eos::WEATHER_SUNNY &&
-            (defender.ability_active(eos::ABILITY_FLOWER_GIFT) ||
+        if (ctx.defender.perceived_weather() == eos::WEATHER_SUNNY &&
+            (ctx.defender.ability_active(eos::ABILITY_FLOWER_GIFT) ||
              defender.other_monster_ability_active(eos::ABILITY_FLOWER_GIFT, dungeon))) {
             def_stage = 1;
             dungeon.damage_calc.ability_defense_modifier += 1;
         }
 
-        if (defender.perceived_weather(dungeon) == eos::WEATHER_SANDSTORM) {
+        if (ctx.defender.perceived_weather() == eos::WEATHER_SANDSTORM) {
             if (defender.monster.types[0] == eos::TYPE_ROCK ||
                 defender.monster.types[1] == eos::TYPE_ROCK) {
                 def_stage += 2;
@@ -625,27 +871,28 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
 
     int32_t atk_stage =
         attacker.monster.stat_modifiers.offensive_stages[move_category] + atk_stage_boost;
-    if (attacker.monster.anger_point_flag && attacker.ability_active(eos::ABILITY_ANGER_POINT)) {
+    if (attacker.monster.anger_point_flag &&
+        ctx.attacker.ability_active(eos::ABILITY_ANGER_POINT)) {
         atk_stage = 20;
     }
 
-    if (move_category == eos::CATEGORY_PHYSICAL) {
+    if constexpr (move_category == eos::CATEGORY_PHYSICAL) {
         if (defender.monster.statuses.skull_bash) {
             dungeon.damage_calc.skull_bash_defense_boost_activated = true;
             def_stage += 1;
         }
 
-        if (defender.iq_skill_enabled(eos::IQ_COUNTER_BASHER, dungeon)) {
+        if (ctx.defender.iq_skill_enabled(eos::IQ_COUNTER_BASHER)) {
             def_stage -= 1;
             dungeon.damage_calc.iq_skill_defense_modifier -= 1;
         }
     }
 
-    if (defender.iq_skill_enabled(eos::IQ_AGGRESSOR, dungeon)) {
+    if (ctx.defender.iq_skill_enabled(eos::IQ_AGGRESSOR)) {
         def_stage -= 1;
         dungeon.damage_calc.iq_skill_defense_modifier -= 1;
     }
-    if (defender.iq_skill_enabled(eos::IQ_DEFENDER, dungeon)) {
+    if (ctx.defender.iq_skill_enabled(eos::IQ_DEFENDER)) {
         def_stage += 1;
         dungeon.damage_calc.iq_skill_defense_modifier += 1;
     }
@@ -662,11 +909,7 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
     // The JP version has a bug where the attacker's identity is checked instead of the defender for
     // the defensive stage modifier
     const auto& entity_check_giratina = (dungeon.version == versions::JP) ? attacker : defender;
-    if (entity_check_giratina.monster.apparent_id == eos::MONSTER_GIRATINA_ALTERED) {
-        def_stage += 2;
-    } else if (entity_check_giratina.monster.apparent_id == eos::MONSTER_GIRATINA_ORIGIN) {
-        def_stage -= 2;
-    }
+    def_stage += giratina_def_stage(entity_check_giratina);
     def_stage += defender.monster.stat_modifiers.defensive_stages[move_category];
 
     if (move_id == eos::MOVE_PUNISHMENT) {
@@ -691,10 +934,10 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
         atk_stage += atk_stage_boost;
     }
 
-    if (attacker.ability_active(eos::ABILITY_UNAWARE)) {
+    if (ctx.attacker.ability_active(eos::ABILITY_UNAWARE)) {
         def_stage = 10;
         def_stage_mult = Fx32{1};
-    } else if (defender.ability_active(eos::ABILITY_UNAWARE)) {
+    } else if (ctx.defender.ability_active(eos::ABILITY_UNAWARE)) {
         atk_stage = 10;
         atk_stage_mult = Fx32{1};
     }
@@ -708,8 +951,16 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
     dungeon.damage_calc.offensive_stat_stage = atk_stage;
     dungeon.damage_calc.offensive_stat = attacker.monster.offensive_stats[move_category];
     Fx32 atk_stat_stage_mult = mechanics::OFFENSIVE_STAT_STAGE_MULTIPLIERS[atk_stage];
-    Fx32 atk_mult = Fx32{attacker.monster.offensive_stats[move_category]} * atk_stat_stage_mult;
-    int32_t atk = (atk_mult * atk_stage_mult).trunc();
+    int32_t atk;
+    if (atk_stage_mult == Fx32{1} && !reference_mode_enabled) {
+        // Multiplying by 1 is exact, so use the precomputed stat after the stage multiplier
+        atk = mechanics::offensive_stat_after_stage(
+            atk_stage, attacker.monster.offensive_stats[move_category]);
+    } else {
+        Fx32 atk_mult =
+            Fx32{attacker.monster.offensive_stats[move_category]} * atk_stat_stage_mult;
+        atk = (atk_mult * atk_stage_mult).trunc();
+    }
 
     if (def_stage < 0) {
         def_stage = 0;
@@ -719,9 +970,15 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
     }
     dungeon.damage_calc.defensive_stat_stage = def_stage;
     dungeon.damage_calc.defensive_stat = defender.monster.defensive_stats[move_category];
-    Fx32 def_mult = Fx32{defender.monster.defensive_stats[move_category]} *
-                    mechanics::DEFENSIVE_STAT_STAGE_MULTIPLIERS[def_stage];
-    int32_t def = (def_mult * def_stage_mult).trunc();
+    int32_t def;
+    if (def_stage_mult == Fx32{1} && !reference_mode_enabled) {
+        def = mechanics::defensive_stat_after_stage(
+            def_stage, defender.monster.defensive_stats[move_category]);
+    } else {
+        Fx32 def_mult = Fx32{defender.monster.defensive_stats[move_category]} *
+                        mechanics::DEFENSIVE_STAT_STAGE_MULTIPLIERS[def_stage];
+        def = (def_mult * def_stage_mult).trunc();
+    }
 
     if (!attacker.monster.is_not_team_member) {
         atk += attacker.exclusive_item_offense_boost(move_category);
@@ -730,54 +987,54 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
         def += defender.exclusive_item_defense_boost(move_category);
     }
 
-    if (move_category == eos::CATEGORY_PHYSICAL) {
-        if (attacker.item_active(eos::ITEM_POWER_BAND)) {
+    if constexpr (move_category == eos::CATEGORY_PHYSICAL) {
+        if (ctx.attacker.item_active(eos::ITEM_POWER_BAND)) {
             atk += mechanics::POWER_BAND_STAT_BOOST;
             dungeon.damage_calc.item_atk_modifier += mechanics::POWER_BAND_STAT_BOOST;
         }
-        if (attacker.item_active(eos::ITEM_MUNCH_BELT)) {
+        if (ctx.attacker.item_active(eos::ITEM_MUNCH_BELT)) {
             atk += mechanics::MUNCH_BELT_STAT_BOOST;
             dungeon.damage_calc.item_atk_modifier += mechanics::MUNCH_BELT_STAT_BOOST;
         }
-        if (attacker.aura_bow_active()) {
+        if (ctx.attacker.aura_bow_active()) {
             atk += mechanics::AURA_BOW_STAT_BOOST;
             // Yes, really
             dungeon.damage_calc.item_sp_atk_modifier += mechanics::AURA_BOW_STAT_BOOST;
         }
 
         if (full_calc) {
-            if (defender.item_active(eos::ITEM_DEF_SCARF)) {
+            if (ctx.defender.item_active(eos::ITEM_DEF_SCARF)) {
                 def += mechanics::DEF_SCARF_STAT_BOOST;
                 dungeon.damage_calc.item_def_modifier += mechanics::DEF_SCARF_STAT_BOOST;
             }
-            if (defender.aura_bow_active()) {
+            if (ctx.defender.aura_bow_active()) {
                 def += mechanics::AURA_BOW_STAT_BOOST;
                 dungeon.damage_calc.item_def_modifier += mechanics::AURA_BOW_STAT_BOOST;
             }
         }
     } else {
         if (full_calc) {
-            if (defender.item_active(eos::ITEM_ZINC_BAND)) {
+            if (ctx.defender.item_active(eos::ITEM_ZINC_BAND)) {
                 def += mechanics::ZINC_BAND_STAT_BOOST;
                 dungeon.damage_calc.item_sp_def_modifier += mechanics::ZINC_BAND_STAT_BOOST;
             }
-            if (defender.aura_bow_active()) {
+            if (ctx.defender.aura_bow_active()) {
                 def += mechanics::AURA_BOW_STAT_BOOST;
                 // Yes, really
                 dungeon.damage_calc.item_def_modifier += mechanics::AURA_BOW_STAT_BOOST;
             }
         }
 
-        if (attacker.item_active(eos::ITEM_SPECIAL_BAND)) {
+        if (ctx.attacker.item_active(eos::ITEM_SPECIAL_BAND)) {
             atk += mechanics::SPECIAL_BAND_STAT_BOOST;
             dungeon.damage_calc.item_sp_atk_modifier += mechanics::SPECIAL_BAND_STAT_BOOST;
         }
-        if (attacker.item_active(eos::ITEM_MUNCH_BELT)) {
+        if (ctx.attacker.item_active(eos::ITEM_MUNCH_BELT)) {
             atk += mechanics::MUNCH_BELT_STAT_BOOST;
             dungeon.damage_calc.item_sp_atk_modifier += mechanics::MUNCH_BELT_STAT_BOOST;
         }
         // Yes, really
-        if (defender.aura_bow_active()) {
+        if (ctx.defender.aura_bow_active()) {
             atk += mechanics::AURA_BOW_STAT_BOOST;
             dungeon.damage_calc.item_sp_atk_modifier += mechanics::AURA_BOW_STAT_BOOST;
         }
@@ -789,123 +1046,94 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
     int32_t atk_div = 1;
     int32_t def_mult_int = 1;
     int32_t def_div = 1;
-    not_physical = mechanics::move_not_physical(move_id);
-    if (!not_physical && attacker.ability_active(eos::ABILITY_GUTS) &&
+    if (!not_physical && ctx.attacker.ability_active(eos::ABILITY_GUTS) &&
         attacker.has_negative_status(true)) {
         atk_mult_int = 2;
     }
 
-    if (attacker.ability_active(eos::ABILITY_HUGE_POWER) ||
-        attacker.ability_active(eos::ABILITY_PURE_POWER)) {
+    if (ctx.attacker.ability_active(eos::ABILITY_HUGE_POWER) ||
+        ctx.attacker.ability_active(eos::ABILITY_PURE_POWER)) {
         if (dungeon.rng.roll_huge_pure_power() && !not_physical) {
             atk_mult_int *= 3;
             atk_div = 2;
         }
     }
 
-    if (attacker.ability_active(eos::ABILITY_HUSTLE) && !not_physical) {
+    if (ctx.attacker.ability_active(eos::ABILITY_HUSTLE) && !not_physical) {
         atk_mult_int *= 3;
         atk_div <<= 1;
     }
 
     int team_idx = attacker.monster.is_not_team_member ? 0 : 1;
-    if (attacker.ability_active(eos::ABILITY_PLUS) && not_physical &&
+    if (ctx.attacker.ability_active(eos::ABILITY_PLUS) && not_physical &&
         dungeon.minus_is_active[team_idx]) {
         atk_div *= 10;
         atk_mult_int *= 15;
     }
-    if (attacker.ability_active(eos::ABILITY_MINUS) && not_physical &&
+    if (ctx.attacker.ability_active(eos::ABILITY_MINUS) && not_physical &&
         dungeon.plus_is_active[team_idx]) {
         atk_div *= 10;
         atk_mult_int *= 15;
     }
 
-    if (defender.ability_active(eos::ABILITY_INTIMIDATE, attacker, true) && !not_physical) {
+    if (ctx.defender_ability_active(eos::ABILITY_INTIMIDATE) && !not_physical) {
         atk_mult_int <<= 2;
         atk_div *= 5;
     }
 
-    if (defender.ability_active(eos::ABILITY_MARVEL_SCALE, attacker, true) && !not_physical) {
+    if (ctx.defender_ability_active(eos::ABILITY_MARVEL_SCALE) && !not_physical) {
         if (defender.has_negative_status(true)) {
             def_mult_int = 3;
             def_div = 2;
         }
     }
 
-    atk *= atk_mult_int;
-    def *= def_mult_int;
-
-    if (atk_div != 1) {
-        atk /= atk_div;
-    }
-    if (def_div != 1) {
-        def /= def_div;
-    }
-
-    dungeon.damage_calc.offense_calc = atk;
-    dungeon.damage_calc.defense_calc = def;
-
-    if (atk < 0) {
-        atk = 0;
-    }
-    if (atk >= mechanics::OFFENSE_STAT_MAX) {
-        atk = mechanics::OFFENSE_STAT_MAX;
-    }
-
-    dungeon.damage_calc.damage_calc_def = def;
-
-    Fx64 def_fx = Fx64{def};
-    Fx64 level = Fx64{attacker.monster.level};
-    Fx64 flv = Fx64{attacker.monster.level} + (Fx64{atk - def} / Fx64{8});
-    Fx64 at = power + Fx64{atk};
-    dungeon.damage_calc.damage_calc_at = at.round();
-    dungeon.damage_calc.attacker_level = attacker.monster.level;
-    dungeon.damage_calc.damage_calc_flv = flv.round();
-
-    Fx64 at_scaled = at * Fx64{Fx32::CONST_153_DIV_256};
-    Fx64 def_scaled = def_fx * Fx64{Fx32::CONST_NEG0_5};
-    int32_t ln_arg = ((flv + Fx64{Fx32{50}}) * Fx64{Fx32{10}}).round();
-    Fx64 ln = clamped_ln(ln_arg);
-    Fx64 ln_scaled = ln * Fx64{Fx32{50}};
-
-    Fx64 base = ((def_scaled + at_scaled) + ln_scaled) + Fx64{Fx32{-311}};
-
-    if (dungeon.gen_info.fixed_room_id != eos::FIXED_SUBSTITUTE_ROOM &&
-        attacker.monster.is_not_team_member) {
-        base /= Fx64{Fx32::CONST_85_DIV_64};
-    }
-    if (Fx64{999} < base) {
-        base = Fx64{999};
-    }
-    if (base < Fx64{1}) {
-        base = Fx64{1};
+    DamageRollState* roll_state = dungeon.rng.roll_state;
+    if (roll_state) {
+        roll_state->ctx.emplace(ctx);
+        roll_state->atk = atk;
+        roll_state->def = def;
+        roll_state->atk_mult_int = atk_mult_int;
+        roll_state->atk_div = atk_div;
+        roll_state->def_mult_int = def_mult_int;
+        roll_state->def_div = def_div;
+        roll_state->power = power;
+        roll_state->huge_pure_power_boosts = !not_physical;
+        roll_state->damage_mult = damage_mult;
+        roll_state->move_id = move_id;
     }
+    Fx64 base = stats_to_base_damage(dungeon, attacker, atk, def, atk_mult_int, atk_div,
+                                     def_mult_int, def_div, power);
 
     Fx64 damage_mult_dynamic;
-    bool super_effective = calc_type_based_damage_effects(
-        dungeon, damage_mult_dynamic, attacker, defender, attack_power, attack_type, damage_out,
-        mechanics::is_regular_attack_or_projectile(move_id));
+    bool super_effective = calc_type_based_damage_effects<regular_attack_or_projectile>(
+        dungeon, ctx, damage_mult_dynamic, attacker, defender, attack_power, attack_type,
+        damage_out);
 
-    if (full_calc &&
-        !attacker.exclusive_item_effect_active(eos::EXCLUSIVE_EFF_BYPASS_REFLECT_LIGHT_SCREEN)) {
+    if (full_calc && !ctx.attacker.exclusive_item_effect_active(
+                         eos::EXCLUSIVE_EFF_BYPASS_REFLECT_LIGHT_SCREEN)) {
         if (move_category == eos::CATEGORY_PHYSICAL &&
             ((move_id != eos::MOVE_BRICK_BREAK && defender.monster.statuses.reflect) ||
-             defender.exclusive_item_effect_active(eos::EXCLUSIVE_EFF_HALVED_PHYSICAL_DAMAGE))) {
+             ctx.defender.exclusive_item_effect_active(
+                 eos::EXCLUSIVE_EFF_HALVED_PHYSICAL_DAMAGE))) {
             damage_mult_dynamic *= Fx64::CONST_0_5;
             dungeon.damage_calc.half_physical_damage_activated = true;
         }
         if (move_category == eos::CATEGORY_SPECIAL &&
             (defender.monster.statuses.light_screen ||
-             defender.exclusive_item_effect_active(eos::EXCLUSIVE_EFF_HALVED_SPECIAL_DAMAGE))) {
+             ctx.defender.exclusive_item_effect_active(eos::EXCLUSIVE_EFF_HALVED_SPECIAL_DAMAGE))) {
             damage_mult_dynamic *= Fx64::CONST_0_5;
             dungeon.damage_calc.half_special_damage_activated = true;
         }
     }
 
+    if (roll_state) {
+        roll_state->damage_mult_dynamic = damage_mult_dynamic;
+    }
     if (!defender.monster.statuses.lucky_chant &&
-        !defender.ability_active(eos::ABILITY_BATTLE_ARMOR, attacker, true) &&
-        !defender.ability_active(eos::ABILITY_SHELL_ARMOR, attacker, true) &&
-        !defender.iq_skill_enabled(eos::IQ_CRITICAL_DODGER, dungeon)) {
+        !ctx.defender_ability_active(eos::ABILITY_BATTLE_ARMOR) &&
+        !ctx.defender_ability_active(eos::ABILITY_SHELL_ARMOR) &&
+        !ctx.defender.iq_skill_enabled(eos::IQ_CRITICAL_DODGER)) {
         if (attacker.gender() != eos::GENDER_FEMALE) {
             crit_chance += crit_chance / 2;
         }
@@ -914,142 +1142,127 @@ void calc_damage(DungeonState& dungeon, const MonsterEntity& attacker, MonsterEn
             dungeon.damage_calc.focus_energy_activated = true;
             crit_chance = mechanics::OFFENSE_STAT_MAX;
         } else {
-            if (attacker.item_active(eos::ITEM_SCOPE_LENS) ||
-                attacker.iq_skill_enabled(eos::IQ_SHARPSHOOTER, dungeon)) {
+            if (ctx.attacker.item_active(eos::ITEM_SCOPE_LENS) ||
+                ctx.attacker.iq_skill_enabled(eos::IQ_SHARPSHOOTER)) {
                 dungeon.damage_calc.scope_lens_or_sharpshooter_activated = true;
                 crit_chance += mechanics::SCOPE_LENS_CRIT_RATE_BOOST;
             }
-            if (attacker.ability_active(eos::ABILITY_SUPER_LUCK)) {
+            if (ctx.attacker.ability_active(eos::ABILITY_SUPER_LUCK)) {
                 dungeon.damage_calc.super_luck_activated = true;
                 crit_chance += mechanics::SUPER_LUCK_CRIT_RATE_BOOST;
             }
-            if (defender.item_active(eos::ITEM_PATSY_BAND)) {
+            if (ctx.defender.item_active(eos::ITEM_PATSY_BAND)) {
                 dungeon.damage_calc.patsy_band_activated = true;
                 // same boost
                 crit_chance += mechanics::SCOPE_LENS_CRIT_RATE_BOOST;
             }
             if (super_effective &&
-                attacker.iq_skill_enabled(eos::IQ_TYPE_ADVANTAGE_MASTER, dungeon)) {
+                ctx.attacker.iq_skill_enabled(eos::IQ_TYPE_ADVANTAGE_MASTER)) {
                 // override, not add
                 crit_chance = mechanics::TYPE_ADVANTAGE_MASTER_CRIT_RATE;
                 dungeon.damage_calc.type_advantage_master_activated = true;
             }
         }
 
-        if (dungeon.rng.roll_critical_hit(crit_chance) &&
-            !defender.exclusive_item_effect_active(eos::EXCLUSIVE_EFF_NO_CRITICAL_HITS)) {
-            damage_out.critical_hit = true;
-            if (attacker.ability_active(eos::ABILITY_SNIPER)) {
-                damage_mult_dynamic *= Fx64{2};
-                dungeon.damage_calc.sniper_activated = true;
-            } else {
-                damage_mult_dynamic *= Fx64::CONST_1_5;
-            }
+        if (dungeon.rng.roll_critical_hit(crit_chance)) {
+            apply_critical_hit(dungeon, ctx, damage_mult_dynamic, damage_out);
         }
     }
 
-    dungeon.damage_calc.damage_calc_base = base.round();
-    base *= damage_mult_dynamic;
-    dungeon.damage_calc.static_damage_mult = damage_mult;
-    base *= Fx64{damage_mult};
-    dungeon.damage_calc.damage_calc = base.round();
-
-    Fx64 variance = dungeon.rng.roll_damage_variance();
-    base *= variance;
-    dungeon.damage_calc.damage_calc_random_mult_pct = (Fx64{100} * variance).round();
-    damage_out.damage = base.round();
-
-    if (move_id == eos::MOVE_PROJECTILE) {
-        damage_out.damage = (Fx32{damage_out.damage} * Fx32::CONST_0_5).ceil();
-    }
-    if (move_id == eos::MOVE_PROJECTILE &&
-        attacker.iq_skill_enabled(eos::IQ_POWER_PITCHER, dungeon)) {
-        damage_out.damage =
-            (Fx32{damage_out.damage} * mechanics::POWER_PITCHER_DAMAGE_MULTIPLIER).ceil();
-    }
-
-    if (damage_out.damage > 0 &&
-        attacker.exclusive_item_effect_active(eos::EXCLUSIVE_EFF_DAMAGE_BOOST_50_PCT)) {
-        damage_out.damage =
-            (Fx32{damage_out.damage} * mechanics::AIR_BLADE_DAMAGE_MULTIPLIER).ceil();
-    }
+    finish_damage<regular_attack_or_projectile>(dungeon, ctx, defender, base, damage_mult_dynamic,
+                                                damage_mult, move_id, damage_out);
+}
 
-    damage_out.damage_message = eos::DAMAGE_MESSAGE_MOVE;
-    if (damage_out.damage == 0) {
-        damage_out.critical_hit = false;
-    }
-    defender.monster.anger_point_flag = damage_out.critical_hit;
+using CalcDamageKernel = void (*)(DungeonState&, const CombatContext&, const MonsterEntity&,
+                                  MonsterEntity&, eos::type_id, int32_t, int32_t, DamageData&,
+                                  Fx32, eos::move_id, bool);
+// Indexed by [not_physical][regular_attack_or_projectile]
+constexpr CalcDamageKernel CALC_DAMAGE_KERNELS[2][2] = {
+    {calc_damage_kernel<false, false>, calc_damage_kernel<false, true>},
+    {calc_damage_kernel<true, false>, calc_damage_kernel<true, true>},
+};
+
+void calc_damage(DungeonState& dungeon, const CombatContext& ctx, const MonsterEntity& attacker,
+                 MonsterEntity& defender, eos::type_id attack_type, int32_t attack_power,
+                 int32_t crit_chance, DamageData& damage_out, Fx32 damage_mult,
+                 eos::move_id move_id, bool full_calc) {
+    auto kernel = CALC_DAMAGE_KERNELS[mechanics::move_not_physical(move_id)]
+                                     [mechanics::is_regular_attack_or_projectile(move_id)];
+    kernel(dungeon, ctx, attacker, defender, attack_type, attack_power, crit_chance, damage_out,
+           damage_mult, move_id, full_calc);
 }
 
-// pmdsky-debug: MoveHitCheck ([NA] 0x2323C48)
-bool move_hit_check(DungeonState& dungeon, const MonsterEntity& attacker,
-                    const MonsterEntity& defender, eos::move_id move_id, bool use_second_accuracy,
-                    bool never_miss_self) {
+// pmdsky-debug: MoveHitCheck ([NA] 0x2323C48), up to the stage calculations
+HitCheck::HitCheck(const CombatContext& ctx, const MonsterEntity& attacker,
+                   const MonsterEntity& defender, eos::move_id move_id, bool use_second_accuracy,
+                   bool never_miss_self) {
     if (never_miss_self && &attacker == &defender) {
-        return true;
+        guaranteed = true;
+        return;
     }
     if (move_id == eos::MOVE_REGULAR_ATTACK &&
-        attacker.iq_skill_enabled(eos::IQ_SURE_HIT_ATTACKER, dungeon)) {
-        return true;
+        ctx.attacker.iq_skill_enabled(eos::IQ_SURE_HIT_ATTACKER)) {
+        guaranteed = true;
+        return;
     }
     if (attacker.monster.statuses.sure_shot) {
-        return true;
+        guaranteed = true;
+        return;
     }
     if (attacker.monster.statuses.whiffer) {
-        return false;
+        guaranteed = false;
+        return;
     }
 
-    int32_t move_accuracy = mechanics::get_move_accuracy(move_id, use_second_accuracy);
+    move_accuracy = mechanics::get_move_accuracy(move_id, use_second_accuracy);
     if (move_accuracy > 100) {
-        return true;
+        guaranteed = true;
+        return;
     }
-    if (defender.item_active(eos::ITEM_DETECT_BAND)) {
+    if (ctx.defender.item_active(eos::ITEM_DETECT_BAND)) {
         move_accuracy -= mechanics::DETECT_BAND_MOVE_ACCURACY_DROP;
     }
-    if (defender.iq_skill_enabled(eos::IQ_QUICK_DODGER, dungeon)) {
+    if (ctx.defender.iq_skill_enabled(eos::IQ_QUICK_DODGER)) {
         move_accuracy -= mechanics::QUICK_DODGER_MOVE_ACCURACY_DROP;
     }
 
-    int32_t accuracy_boost = 0;
-
-    if (attacker.ability_active(eos::ABILITY_COMPOUNDEYES)) {
+    if (ctx.attacker.ability_active(eos::ABILITY_COMPOUNDEYES)) {
         accuracy_boost = 2;
     }
 
     if (move_id == eos::MOVE_THUNDER) {
-        eos::weather_id weather = attacker.perceived_weather(dungeon);
+        eos::weather_id weather = ctx.attacker.perceived_weather();
         if (weather == eos::WEATHER_RAIN) {
-            return true;
+            guaranteed = true;
+            return;
         }
         if (weather == eos::WEATHER_SUNNY) {
             accuracy_boost -= 2;
         }
     }
 
-    if (move_id == eos::MOVE_BLIZZARD && attacker.perceived_weather(dungeon) == eos::WEATHER_HAIL) {
-        return true;
+    if (move_id == eos::MOVE_BLIZZARD && ctx.attacker.perceived_weather() == eos::WEATHER_HAIL) {
+        guaranteed = true;
+        return;
     }
 
-    if (attacker.iq_skill_enabled(eos::IQ_CONCENTRATOR, dungeon)) {
+    if (ctx.attacker.iq_skill_enabled(eos::IQ_CONCENTRATOR)) {
         accuracy_boost += 1;
     }
 
-    int32_t evasion_stage = defender.monster.stat_modifiers.hit_chance_stages[1];
-    if (defender.monster.statuses.exposed) {
-        evasion_stage = 10;
-    }
+    exposed = defender.monster.statuses.exposed;
 
-    int32_t evasion_boost = 0;
-    if (defender.perceived_weather(dungeon) == eos::WEATHER_SANDSTORM &&
-        defender.ability_active(eos::ABILITY_SAND_VEIL, attacker, true)) {
+    if (ctx.defender.perceived_weather() == eos::WEATHER_SANDSTORM &&
+        ctx.defender_ability_active(eos::ABILITY_SAND_VEIL)) {
         evasion_boost = 2;
     }
 
-    if (attacker.ability_active(eos::ABILITY_HUSTLE) && !mechanics::move_not_physical(move_id)) {
+    if (ctx.attacker.ability_active(eos::ABILITY_HUSTLE) &&
+        !mechanics::move_not_physical(move_id)) {
         evasion_boost += 2;
     }
 
-    if (defender.iq_skill_enabled(eos::IQ_CLUTCH_PERFORMER, dungeon)) {
+    if (ctx.defender.iq_skill_enabled(eos::IQ_CLUTCH_PERFORMER)) {
         int32_t max_hp = defender.monster.max_hp_stat + defender.monster.max_hp_boost;
         if (max_hp > mechanics::MAX_HP_CAP) {
             max_hp = mechanics::MAX_HP_CAP;
@@ -1059,33 +1272,48 @@ bool move_hit_check(DungeonState& dungeon, const MonsterEntity& attacker,
         }
     }
 
-    if (defender.iq_skill_enabled(eos::IQ_CONCENTRATOR, dungeon)) {
+    if (ctx.defender.iq_skill_enabled(eos::IQ_CONCENTRATOR)) {
         evasion_boost -= 1;
     }
 
-    if (defender.ability_active(eos::ABILITY_TANGLED_FEET, attacker, true) &&
+    if (ctx.defender_ability_active(eos::ABILITY_TANGLED_FEET) &&
         (defender.monster.statuses.confusion || defender.monster.statuses.cross_eyed)) {
         evasion_boost += 3;
     }
 
-    if (defender.ability_active(eos::ABILITY_SNOW_CLOAK, attacker, true) &&
-        (defender.perceived_weather(dungeon) == eos::WEATHER_HAIL ||
-         defender.perceived_weather(dungeon) == eos::WEATHER_SNOW)) {
+    if (ctx.defender_ability_active(eos::ABILITY_SNOW_CLOAK) &&
+        (ctx.defender.perceived_weather() == eos::WEATHER_HAIL ||
+         ctx.defender.perceived_weather() == eos::WEATHER_SNOW)) {
         evasion_boost += 2;
     }
 
-    eos::weather_id weather = defender.perceived_weather(dungeon);
+    eos::weather_id weather = ctx.defender.perceived_weather();
     if (mechanics::EXCL_ITEM_EFFECTS_EVASION_BOOST[weather] != eos::EXCLUSIVE_EFF_STAT_BOOST &&
-        defender.exclusive_item_effect_active(
+        ctx.defender.exclusive_item_effect_active(
             mechanics::EXCL_ITEM_EFFECTS_EVASION_BOOST[weather])) {
         evasion_boost += 1;
     }
 
+    no_guard = ctx.attacker.ability_active(eos::ABILITY_NO_GUARD) ||
+               ctx.defender_ability_active(eos::ABILITY_NO_GUARD);
+
+    accuracy_multipliers = (attacker.gender() == eos::GENDER_FEMALE)
+                               ? mechanics::FEMALE_ACCURACY_STAGE_MULTIPLIERS
+                               : mechanics::MALE_ACCURACY_STAGE_MULTIPLIERS;
+    evasion_multipliers = (defender.gender() == eos::GENDER_FEMALE)
+                              ? mechanics::FEMALE_EVASION_STAGE_MULTIPLIERS
+                              : mechanics::MALE_EVASION_STAGE_MULTIPLIERS;
+}
+
+// pmdsky-debug: MoveHitCheck ([NA] 0x2323C48), from the stage calculations on
+int32_t HitCheck::hit_chance(int32_t accuracy_stage, int32_t evasion_stage) const {
+    if (exposed) {
+        evasion_stage = 10;
+    }
     evasion_stage += evasion_boost;
-    int32_t accuracy_stage = attacker.monster.stat_modifiers.hit_chance_stages[0] + accuracy_boost;
+    accuracy_stage += accuracy_boost;
 
-    if (attacker.ability_active(eos::ABILITY_NO_GUARD) ||
-        defender.ability_active(eos::ABILITY_NO_GUARD, attacker, true)) {
+    if (no_guard) {
         evasion_stage = 10;
         accuracy_stage = 10;
     }
@@ -1097,10 +1325,7 @@ bool move_hit_check(DungeonState& dungeon, const MonsterEntity& attacker,
         accuracy_stage = 20;
     }
 
-    auto ACCURACY_MULTIPLIERS = (attacker.gender() == eos::GENDER_FEMALE)
-                                    ? mechanics::FEMALE_ACCURACY_STAGE_MULTIPLIERS
-                                    : mechanics::MALE_ACCURACY_STAGE_MULTIPLIERS;
-    Fx32 accuracy = ACCURACY_MULTIPLIERS[accuracy_stage];
+    Fx32 accuracy = accuracy_multipliers[accuracy_stage];
 
     if (evasion_stage < 0) {
         evasion_stage = 0;
@@ -1116,10 +1341,7 @@ bool move_hit_check(DungeonState& dungeon, const MonsterEntity& attacker,
         accuracy = Fx32{100};
     }
 
-    auto EVASION_MULTIPLIERS = (defender.gender() == eos::GENDER_FEMALE)
-                                   ? mechanics::FEMALE_EVASION_STAGE_MULTIPLIERS
-                                   : mechanics::MALE_EVASION_STAGE_MULTIPLIERS;
-    Fx32 evasion = EVASION_MULTIPLIERS[evasion_stage];
+    Fx32 evasion = evasion_multipliers[evasion_stage];
     if (evasion < Fx32{0}) {
         evasion = Fx32{0};
     }
@@ -1127,32 +1349,45 @@ bool move_hit_check(DungeonState& dungeon, const MonsterEntity& attacker,
         evasion = Fx32{100};
     }
 
-    return dungeon.rng.roll_hit_chance(((move_accuracy * accuracy) * evasion).trunc(),
-                                       use_second_accuracy);
+    return ((move_accuracy * accuracy) * evasion).trunc();
+}
+
+// pmdsky-debug: MoveHitCheck ([NA] 0x2323C48)
+bool move_hit_check(DungeonState& dungeon, const CombatContext& ctx, const MonsterEntity& attacker,
+                    const MonsterEntity& defender, eos::move_id move_id, bool use_second_accuracy,
+                    bool never_miss_self) {
+    HitCheck check(ctx, attacker, defender, move_id, use_second_accuracy, never_miss_self);
+    if (check.guaranteed) {
+        return *check.guaranteed;
+    }
+    return dungeon.rng.roll_hit_chance(
+        check.hit_chance(attacker.monster.stat_modifiers.hit_chance_stages[0],
+                         defender.monster.stat_modifiers.hit_chance_stages[1]),
+        use_second_accuracy);
 }
 
 // Based on pmdsky-debug: ApplyDamage ([NA] 0x2308FE0). The only (known) thing that really matters
 // for this damage calculator within this function is negating damage due to abilities and exclusive
 // item effects.
-void apply_ability_and_effect_immunities(const MonsterEntity& attacker,
+void apply_ability_and_effect_immunities(const CombatContext& ctx, const MonsterEntity& attacker,
                                          const MonsterEntity& defender, DamageData& damage_data) {
     if (!defender.is_monster() || !attacker.is_monster()) {
         return;
     }
-    if (defender.ability_active(eos::ABILITY_VOLT_ABSORB, attacker, true) &&
+    if (ctx.defender_ability_active(eos::ABILITY_VOLT_ABSORB) &&
         damage_data.type == eos::TYPE_ELECTRIC) {
         damage_data.no_damage = true;
         damage_data.healed = true;
         return;
     }
-    if ((defender.ability_active(eos::ABILITY_WATER_ABSORB, attacker, true) ||
-         defender.ability_active(eos::ABILITY_DRY_SKIN, attacker, true)) &&
+    if ((ctx.defender_ability_active(eos::ABILITY_WATER_ABSORB) ||
+         ctx.defender_ability_active(eos::ABILITY_DRY_SKIN)) &&
         damage_data.type == eos::TYPE_WATER) {
         damage_data.no_damage = true;
         damage_data.healed = true;
         return;
     }
-    if (defender.ability_active(eos::ABILITY_MOTOR_DRIVE, attacker, true) &&
+    if (ctx.defender_ability_active(eos::ABILITY_MOTOR_DRIVE) &&
         damage_data.type == eos::TYPE_ELECTRIC) {
         damage_data.no_damage = true;
         return;
@@ -1161,7 +1396,7 @@ void apply_ability_and_effect_immunities(const MonsterEntity& attacker,
     for (const auto* entry = &mechanics::TYPE_DAMAGE_NEGATING_EXCLUSIVE_ITEM_EFFECTS[0];
          entry->type != eos::TYPE_NEUTRAL; ++entry) {
         if (entry->type == damage_data.type &&
-            defender.exclusive_item_effect_active(entry->effect)) {
+            ctx.defender.exclusive_item_effect_active(entry->effect)) {
             if (entry->effect < eos::EXCLUSIVE_EFF_ABSORB_FIRE_DAMAGE) {
                 damage_data.no_damage = true;
                 return;
@@ -1177,11 +1412,11 @@ void apply_ability_and_effect_immunities(const MonsterEntity& attacker,
 
 // Based on pmdsky-debug: PerformDamageSequence ([NA] 0x2332D6C), omitting the things that don't
 // matter
-int32_t run_mock_damage_sequence(DungeonState& dungeon, MonsterEntity& attacker,
-                                 const MonsterEntity& defender, eos::move_id move_id,
-                                 DamageData& damage_data) {
-    if (move_hit_check(dungeon, attacker, defender, move_id, true, true)) {
-        apply_ability_and_effect_immunities(attacker, defender, damage_data);
+int32_t run_mock_damage_sequence(DungeonState& dungeon, const CombatContext& ctx,
+                                 MonsterEntity& attacker, const MonsterEntity& defender,
+                                 eos::move_id move_id, DamageData& damage_data) {
+    if (move_hit_check(dungeon, ctx, attacker, defender, move_id, true, true)) {
+        apply_ability_and_effect_immunities(ctx, attacker, defender, damage_data);
         attacker.monster.practice_swinger_flag = false;
         attacker.monster.anger_point_flag = false;
     } else {
@@ -1197,23 +1432,30 @@ int32_t run_mock_damage_sequence(DungeonState& dungeon, MonsterEntity& attacker,
     return damage_data.damage;
 }
 
+// Whether a move can't miss when used on its user, for the first hit check in ExecuteMoveEffect
+bool never_misses_self(eos::move_id move_id) {
+    return move_id != eos::MOVE_ENDURE && move_id != eos::MOVE_DETECT &&
+           move_id != eos::MOVE_PROTECT;
+}
+
 // Loosely based on pmdsky-debug: ExecuteMoveEffect ([NA] 0x232E864)
 // Includes stuff known to happen before calls to DealDamage and friends that affect the damage
 // calculation. This function is likely incomplete and should be considered experimental; still
 // need to get a better understanding of the in-game function works... (TODO)
 // Returns whether or not the move has passed all the hit checks in this function.
-bool execute_move_effect_prechecks(DungeonState& dungeon, MonsterEntity& attacker,
-                                   MonsterEntity& defender, eos::move_id move_id) {
+bool execute_move_effect_prechecks(DungeonState& dungeon, const CombatContext& ctx,
+                                   MonsterEntity& attacker, MonsterEntity& defender,
+                                   eos::move_id move_id) {
     // TODO: actually handle the checks for this flag properly, although it doesn't really matter
     // since we don't care about status moves.
     bool reflected_by_magic_coat_etc = false;
 
     // I don't actually understand how these checks work, so this is just a made-up implementation
     // that probably approximates what the game does.
-    bool lightningrod = (defender.ability_active(eos::ABILITY_LIGHTNINGROD) ||
+    bool lightningrod = (ctx.defender.ability_active(eos::ABILITY_LIGHTNINGROD) ||
                          dungeon.other_monsters.abilities[eos::ABILITY_LIGHTNINGROD]) &&
                         attacker.get_move_type(move_id, dungeon) == eos::TYPE_ELECTRIC;
-    bool storm_drain = (defender.ability_active(eos::ABILITY_STORM_DRAIN) ||
+    bool storm_drain = (ctx.defender.ability_active(eos::ABILITY_STORM_DRAIN) ||
                         dungeon.other_monsters.abilities[eos::ABILITY_STORM_DRAIN]) &&
                        attacker.get_move_type(move_id, dungeon) == eos::TYPE_WATER;
 
@@ -1223,19 +1465,18 @@ bool execute_move_effect_prechecks(DungeonState& dungeon, MonsterEntity& attacke
         // For program reporting purposes; not really in the game
         dungeon.damage_calc.two_turn_move_forced_miss = true;
     }
-    if (hit && defender.ability_active(eos::ABILITY_SOUNDPROOF, attacker, true) &&
+    if (hit && ctx.defender_ability_active(eos::ABILITY_SOUNDPROOF) &&
         mechanics::is_sound_move(move_id)) {
         hit = false;
         dungeon.damage_calc.soundproof_activated =
             true; // For program reporting purposes; not really in the game
     }
-    if (hit && defender.ability_active(eos::ABILITY_FOREWARN, attacker, true) &&
+    if (hit && ctx.defender_ability_active(eos::ABILITY_FOREWARN) &&
         dungeon.rng.roll_forewarn()) {
         hit = false;
     }
-    bool never_miss_self = (move_id != eos::MOVE_ENDURE && move_id != eos::MOVE_DETECT &&
-                            move_id != eos::MOVE_PROTECT && !reflected_by_magic_coat_etc);
-    if (hit && !move_hit_check(dungeon, attacker, defender, move_id, false, never_miss_self)) {
+    bool never_miss_self = never_misses_self(move_id) && !reflected_by_magic_coat_etc;
+    if (hit && !move_hit_check(dungeon, ctx, attacker, defender, move_id, false, never_miss_self)) {
         hit = false;
         dungeon.damage_calc.first_hit_check_failed =
             true; // For program reporting purposes; not really in the game
@@ -1261,26 +1502,26 @@ bool execute_move_effect_prechecks(DungeonState& dungeon, MonsterEntity& attacke
 
 // Based on the shared parts of DealDamage and friends, omitting the things that don't matter
 int32_t simulate_damage_calc_shared(DamageData& damage_data, DungeonState& dungeon,
-                                    MonsterEntity& attacker, MonsterEntity& defender,
-                                    eos::type_id attack_type, int32_t attack_power,
-                                    Fx32 damage_mult, eos::move_id move_id) {
+                                    const CombatContext& ctx, MonsterEntity& attacker,
+                                    MonsterEntity& defender, eos::type_id attack_type,
+                                    int32_t attack_power, Fx32 damage_mult, eos::move_id move_id) {
     int32_t crit_chance = mechanics::get_move_crit_chance(move_id);
-    calc_damage(dungeon, attacker, defender, attack_type, attack_power, crit_chance, damage_data,
-                damage_mult, move_id, true);
-    return run_mock_damage_sequence(dungeon, attacker, defender, move_id, damage_data);
+    calc_damage(dungeon, ctx, attacker, defender, attack_type, attack_power, crit_chance,
+                damage_data, damage_mult, move_id, true);
+    return run_mock_damage_sequence(dungeon, ctx, attacker, defender, move_id, damage_data);
 }
 
 // Based on pmdsky-debug: ExecuteMoveEffect ([NA] 0x232E864) + DealDamage ([NA] 0x2332B20)
 int32_t simulate_damage_calc_with_mult(DamageData& damage_data, DungeonState& dungeon,
-                                       MonsterEntity& attacker, MonsterEntity& defender, Move move,
-                                       Fx32 damage_mult) {
-    if (!execute_move_effect_prechecks(dungeon, attacker, defender, move.id)) {
+                                       const CombatContext& ctx, MonsterEntity& attacker,
+                                       MonsterEntity& defender, Move move, Fx32 damage_mult) {
+    if (!execute_move_effect_prechecks(dungeon, ctx, attacker, defender, move.id)) {
         return 0;
     }
 
     eos::type_id attack_type = attacker.get_move_type(move.id, dungeon);
     int32_t attack_power = attacker.get_move_power(move);
-    return simulate_damage_calc_shared(damage_data, dungeon, attacker, defender, attack_type,
+    return simulate_damage_calc_shared(damage_data, dungeon, ctx, attacker, defender, attack_type,
                                        attack_power, damage_mult, move.id);
 }
 
@@ -1290,13 +1531,14 @@ int32_t simulate_damage_calc_generic(DamageData& damage_data, DungeonState& dung
                                      MonsterEntity& attacker, MonsterEntity& defender,
                                      eos::type_id attack_type, int32_t attack_power,
                                      eos::move_id move_id, int32_t crit_chance, Fx32 damage_mult) {
-    if (!execute_move_effect_prechecks(dungeon, attacker, defender, move_id)) {
+    CombatContext ctx(attacker, defender, dungeon);
+    if (!execute_move_effect_prechecks(dungeon, ctx, attacker, defender, move_id)) {
         return 0;
     }
 
-    calc_damage(dungeon, attacker, defender, attack_type, attack_power, crit_chance, damage_data,
-                damage_mult, move_id, true);
-    return run_mock_damage_sequence(dungeon, attacker, defender, move_id, damage_data);
+    calc_damage(dungeon, ctx, attacker, defender, attack_type, attack_power, crit_chance,
+                damage_data, damage_mult, move_id, true);
+    return run_mock_damage_sequence(dungeon, ctx, attacker, defender, move_id, damage_data);
 }
 
 // Based on pmdsky-debug:
@@ -1304,9 +1546,9 @@ int32_t simulate_damage_calc_generic(DamageData& damage_data, DungeonState& dung
 // - DoMoveWeatherBall ([NA] 0x23266DC)
 // - DealDamageWithType ([NA] 0x2332CDC)
 int32_t simulate_damage_calc_weather_ball(DamageData& damage_data, DungeonState& dungeon,
-                                          MonsterEntity& attacker, MonsterEntity& defender,
-                                          uint8_t ginseng = 0) {
-    if (!execute_move_effect_prechecks(dungeon, attacker, defender, eos::MOVE_WEATHER_BALL)) {
+                                          const CombatContext& ctx, MonsterEntity& attacker,
+                                          MonsterEntity& defender, uint8_t ginseng = 0) {
+    if (!execute_move_effect_prechecks(dungeon, ctx, attacker, defender, eos::MOVE_WEATHER_BALL)) {
         return 0;
     }
 
@@ -1314,7 +1556,7 @@ int32_t simulate_damage_calc_weather_ball(DamageData& damage_data, DungeonState&
     eos::type_id attack_type = mechanics::WEATHER_BALL_TYPE_TABLE[weather];
     Fx32 damage_mult = mechanics::WEATHER_BALL_DAMAGE_MULT_TABLE[weather];
     int32_t attack_power = attacker.get_move_power(Move{eos::MOVE_WEATHER_BALL, ginseng});
-    return simulate_damage_calc_shared(damage_data, dungeon, attacker, defender, attack_type,
+    return simulate_damage_calc_shared(damage_data, dungeon, ctx, attacker, defender, attack_type,
                                        attack_power, damage_mult, eos::MOVE_WEATHER_BALL);
 }
 
@@ -1323,9 +1565,9 @@ int32_t simulate_damage_calc_weather_ball(DamageData& damage_data, DungeonState&
 // - DoMoveNaturalGift ([NA] 0x232D738)
 // - DealDamageWithTypeAndPowerBoost ([NA] 0x2332BB8)
 int32_t simulate_damage_calc_natural_gift(DamageData& damage_data, DungeonState& dungeon,
-                                          MonsterEntity& attacker, MonsterEntity& defender,
-                                          uint8_t ginseng = 0) {
-    if (!execute_move_effect_prechecks(dungeon, attacker, defender, eos::MOVE_NATURAL_GIFT)) {
+                                          const CombatContext& ctx, MonsterEntity& attacker,
+                                          MonsterEntity& defender, uint8_t ginseng = 0) {
+    if (!execute_move_effect_prechecks(dungeon, ctx, attacker, defender, eos::MOVE_NATURAL_GIFT)) {
         return 0;
     }
 
@@ -1339,13 +1581,14 @@ int32_t simulate_damage_calc_natural_gift(DamageData& damage_data, DungeonState&
                 // Signed integer overflow is implementation-dependent, so we can't rely on it
                 attack_power -= (1 << 16);
             }
-            return simulate_damage_calc_shared(damage_data, dungeon, attacker, defender,
+            return simulate_damage_calc_shared(damage_data, dungeon, ctx, attacker, defender,
                                                ng_info->type_id, attack_power, Fx32{1},
                                                eos::MOVE_NATURAL_GIFT);
         }
     }
 
-    return simulate_damage_calc_with_mult(damage_data, dungeon, attacker, defender, move, Fx32{1});
+    return simulate_damage_calc_with_mult(damage_data, dungeon, ctx, attacker, defender, move,
+                                          Fx32{1});
 }
 
 int get_hp_dep_mult_table_idx(const MonsterEntity& entity) {
@@ -1363,196 +1606,213 @@ int get_hp_dep_mult_table_idx(const MonsterEntity& entity) {
     return 3;
 }
 
+// Multiplier tables for MoveHandlerKind::CONDITIONAL_MULT and FIXED_MULT that aren't in mechanics
+constexpr Fx32 ZERO_DAMAGE_MULTIPLIER{0};
+constexpr Fx32 DOUBLE_DAMAGE_MULTIPLIER{2};
+constexpr Fx32 REGULAR_ATTACK_DAMAGE_MULTIPLIER = Fx32::CONST_0_5;
+
+// Custom move handlers. Each sets damage_mult (or returns false if the move fails), based on the
+// move effect handler.
+bool facade_should_boost(const MonsterEntity& attacker, const MonsterEntity&) {
+    auto& status = attacker.monster.statuses;
+    // Not 100% sure about the Identifying status...
+    return status.burn || status.poison || status.bad_poison || status.paralysis ||
+           status.identifying;
+}
+bool low_kick_damage_mult(DungeonState&, const MonsterEntity&, const MonsterEntity& defender,
+                          Move, Fx32& damage_mult) {
+    damage_mult = mechanics::get_monster_weight(defender.monster.apparent_id);
+    return true;
+}
+bool solarbeam_damage_mult(DungeonState& dungeon, const MonsterEntity& attacker,
+                           const MonsterEntity&, Move, Fx32& damage_mult) {
+    eos::weather_id weather = attacker.perceived_weather(dungeon);
+    damage_mult = mechanics::SOLARBEAM_DAMAGE_MULTIPLIER;
+    if (weather == eos::WEATHER_SANDSTORM || weather == eos::WEATHER_RAIN ||
+        weather == eos::WEATHER_HAIL) {
+        damage_mult /= 2;
+    }
+    return true;
+}
+bool triple_kick_damage_mult(DungeonState&, const MonsterEntity&, const MonsterEntity&, Move move,
+                             Fx32& damage_mult) {
+    // Can't hit more than 3 times
+    damage_mult = std::min(static_cast<int>(move.prior_successive_hits) + 1, 3);
+    return true;
+}
+bool spit_up_damage_mult(DungeonState&, const MonsterEntity& attacker, const MonsterEntity&, Move,
+                         Fx32& damage_mult) {
+    damage_mult = attacker.monster.statuses.stockpile_stage;
+    return true;
+}
+bool dream_eater_damage_mult(DungeonState& dungeon, const MonsterEntity&,
+                             const MonsterEntity& defender, Move, Fx32&) {
+    auto& status = defender.monster.statuses;
+    if (!status.sleep && !status.nightmare && !status.napping) {
+        // For program reporting purposes; not really in the game
+        dungeon.damage_calc.dream_eater_failed = true;
+        return false;
+    }
+    return true;
+}
+bool trump_card_damage_mult(DungeonState&, const MonsterEntity&, const MonsterEntity&, Move move,
+                            Fx32& damage_mult) {
+    int32_t max_pp = mechanics::get_move_max_pp(move.id);
+    if (max_pp == 0) {
+        max_pp = 1;
+    }
+    int32_t pp_frac = (static_cast<uint32_t>(move.pp) * 100) / max_pp;
+    if (pp_frac < 26) {
+        damage_mult = Fx32::CONST_1_25;
+    } else if (pp_frac < 51) {
+        damage_mult = 1;
+    } else if (pp_frac < 76) {
+        damage_mult = Fx32::CONST_0_75;
+    } else {
+        damage_mult = Fx32::CONST_0_5;
+    }
+    return true;
+}
+bool brine_should_boost(const MonsterEntity&, const MonsterEntity& defender) {
+    int32_t max_hp = defender.monster.max_hp_stat + defender.monster.max_hp_boost;
+    if (max_hp > mechanics::MAX_HP_CAP) {
+        max_hp = mechanics::MAX_HP_CAP;
+    }
+    return (static_cast<uint32_t>(defender.monster.hp) * 2) <= max_hp;
+}
+bool last_resort_damage_mult(DungeonState& dungeon, const MonsterEntity& attacker,
+                             const MonsterEntity&, Move move, Fx32& damage_mult) {
+    int32_t n_moves_out_of_pp = attacker.monster.n_moves_out_of_pp;
+    if (n_moves_out_of_pp > 0 && move.pp == 0) {
+        n_moves_out_of_pp--;
+    }
+    if (n_moves_out_of_pp < 1) {
+        dungeon.damage_calc.last_resort_failed = true;
+        return false;
+    }
+    damage_mult = mechanics::LAST_RESORT_DAMAGE_MULT_TABLE[n_moves_out_of_pp - 1];
+    return true;
+}
+
+// Builds the move handler table. Multipliers come from ExecuteMoveEffect itself or from the move
+// effect handler; moves that aren't listed just use the default multiplier of 1.
+// TODO: add support for more moves
+constexpr auto make_move_handlers() {
+    using K = MoveHandlerKind;
+    std::array<MoveHandler, std::size(mechanics::data_files::MOVES)> h{};
+    auto fixed = [](const Fx32& mult) { return MoveHandler{K::FIXED_MULT, &mult}; };
+    auto doubled_if = [](bool (*condition)(const MonsterEntity&, const MonsterEntity&)) {
+        return MoveHandler{K::CONDITIONAL_MULT, &DOUBLE_DAMAGE_MULTIPLIER, 0, condition};
+    };
+    auto custom = [](auto handler) { return MoveHandler{K::CUSTOM, nullptr, 0, nullptr, handler}; };
+
+    h[eos::MOVE_NOTHING] = fixed(ZERO_DAMAGE_MULTIPLIER);
+    // Can't hit more than 10 times
+    h[eos::MOVE_ICE_BALL] = {K::SUCCESSIVE_HITS, mechanics::ROLLOUT_DAMAGE_MULT_TABLE, 9};
+    h[eos::MOVE_ROLLOUT] = h[eos::MOVE_ICE_BALL];
+    h[eos::MOVE_DIG] = fixed(mechanics::DIG_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_WEATHER_BALL] = {K::WEATHER_BALL};
+    h[eos::MOVE_WHIRLPOOL] = doubled_if([](const MonsterEntity&, const MonsterEntity& defender) {
+        return defender.monster.statuses.diving;
+    });
+    h[eos::MOVE_SURF] = h[eos::MOVE_WHIRLPOOL];
+    h[eos::MOVE_GUST] = doubled_if([](const MonsterEntity&, const MonsterEntity& defender) {
+        return defender.monster.statuses.flying || defender.monster.statuses.bouncing;
+    });
+    h[eos::MOVE_TWISTER] = h[eos::MOVE_GUST];
+    h[eos::MOVE_RAZOR_WIND] = fixed(mechanics::RAZOR_WIND_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_FACADE] = {K::CONDITIONAL_MULT, &mechanics::FACADE_DAMAGE_MULTIPLIER, 0,
+                           facade_should_boost};
+    h[eos::MOVE_FOCUS_PUNCH] = fixed(mechanics::FOCUS_PUNCH_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_REVERSAL] = {K::ATTACKER_HP, mechanics::REVERSAL_DAMAGE_MULT_TABLE};
+    h[eos::MOVE_FLAIL] = h[eos::MOVE_REVERSAL];
+    h[eos::MOVE_SMELLINGSALT] = doubled_if([](const MonsterEntity&, const MonsterEntity& defender) {
+        return defender.monster.statuses.paralysis;
+    });
+    h[eos::MOVE_LOW_KICK] = custom(low_kick_damage_mult);
+    h[eos::MOVE_GRASS_KNOT] = h[eos::MOVE_LOW_KICK];
+    h[eos::MOVE_SKY_ATTACK] = fixed(mechanics::SKY_ATTACK_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_WATER_SPOUT] = {K::ATTACKER_HP, mechanics::WATER_SPOUT_DAMAGE_MULT_TABLE};
+    h[eos::MOVE_EARTHQUAKE] = doubled_if([](const MonsterEntity&, const MonsterEntity& defender) {
+        return defender.monster.statuses.digging;
+    });
+    h[eos::MOVE_SOLARBEAM] = custom(solarbeam_damage_mult);
+    h[eos::MOVE_FLY] = fixed(mechanics::FLY_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_DIVE] = fixed(mechanics::DIVE_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_BOUNCE] = fixed(mechanics::BOUNCE_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_HI_JUMP_KICK] = fixed(DOUBLE_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_BLAST_BURN] = fixed(DOUBLE_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_TRIPLE_KICK] = custom(triple_kick_damage_mult);
+    h[eos::MOVE_SPIT_UP] = custom(spit_up_damage_mult);
+    h[eos::MOVE_ERUPTION] = {K::ATTACKER_HP, mechanics::ERUPTION_DAMAGE_MULT_TABLE};
+    h[eos::MOVE_DREAM_EATER] = custom(dream_eater_damage_mult);
+    h[eos::MOVE_SKULL_BASH] = fixed(mechanics::SKULL_BASH_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_REGULAR_ATTACK] = fixed(REGULAR_ATTACK_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_NATURAL_GIFT] = {K::NATURAL_GIFT};
+    h[eos::MOVE_TRUMP_CARD] = custom(trump_card_damage_mult);
+    h[eos::MOVE_BRINE] = doubled_if(brine_should_boost);
+    h[eos::MOVE_WRING_OUT] = {K::DEFENDER_HP, mechanics::WRING_OUT_DAMAGE_MULT_TABLE};
+    h[eos::MOVE_CRUSH_GRIP] = h[eos::MOVE_WRING_OUT];
+    h[eos::MOVE_GYRO_BALL] = doubled_if([](const MonsterEntity& attacker, const MonsterEntity&) {
+        return attacker.monster.statuses.speed_stage == 0;
+    });
+    h[eos::MOVE_SHADOW_FORCE] = fixed(mechanics::SHADOW_FORCE_DAMAGE_MULTIPLIER);
+    h[eos::MOVE_LAST_RESORT] = custom(last_resort_damage_mult);
+    h[eos::MOVE_WAKE_UP_SLAP] = doubled_if([](const MonsterEntity&, const MonsterEntity& defender) {
+        auto& status = defender.monster.statuses;
+        return status.sleep || status.nightmare || status.napping;
+    });
+    return h;
+}
+constexpr auto MOVE_HANDLERS = make_move_handlers();
+
+const MoveHandler& get_move_handler(eos::move_id move) { return MOVE_HANDLERS[move]; }
+
 // Dispatches to the correct simulation_damage_calc* function based on the move, figuring out the
-// damage multiplier if needed (based on the move effect handler).
+// damage multiplier if needed from the move's handler.
 // The game doesn't do things this way; the logic in this function is hard-coded into the program
 // structure in the actual game.
 int32_t simulate_damage_calc(DamageData& damage_data, DungeonState& dungeon,
                              MonsterEntity& attacker, MonsterEntity& defender, Move move) {
+    CombatContext ctx(attacker, defender, dungeon);
     Fx32 damage_mult = 1; // Default, used in most cases
 
-    // Multipliers come from ExecuteMoveEffect itself or from the move effect handler
-    switch (move.id) {
-    case eos::MOVE_NOTHING:
-        damage_mult = 0;
-        break;
-    case eos::MOVE_ICE_BALL:
-    case eos::MOVE_ROLLOUT:
-        // Can't hit more than 10 times
-        damage_mult = mechanics::ROLLOUT_DAMAGE_MULT_TABLE[std::min(
-            static_cast<int>(move.prior_successive_hits), 9)];
-        break;
-    case eos::MOVE_DIG:
-        damage_mult = mechanics::DIG_DAMAGE_MULTIPLIER;
-        break;
-    case eos::MOVE_WEATHER_BALL:
-        return simulate_damage_calc_weather_ball(damage_data, dungeon, attacker, defender,
-                                                 move.ginseng);
-    case eos::MOVE_WHIRLPOOL:
-    case eos::MOVE_SURF:
-        if (defender.monster.statuses.diving) {
-            damage_mult = 2;
-        }
-        break;
-    case eos::MOVE_GUST:
-    case eos::MOVE_TWISTER:
-        if (defender.monster.statuses.flying || defender.monster.statuses.bouncing) {
-            damage_mult = 2;
-        }
-        break;
-    case eos::MOVE_RAZOR_WIND:
-        damage_mult = mechanics::RAZOR_WIND_DAMAGE_MULTIPLIER;
-        break;
-    case eos::MOVE_FACADE: {
-        auto& status = attacker.monster.statuses;
-        // Not 100% sure about the Identifying status...
-        if (status.burn || status.poison || status.bad_poison || status.paralysis ||
-            status.identifying) {
-            damage_mult = mechanics::FACADE_DAMAGE_MULTIPLIER;
-        }
-        break;
-    }
-    case eos::MOVE_FOCUS_PUNCH:
-        damage_mult = mechanics::FOCUS_PUNCH_DAMAGE_MULTIPLIER;
-        break;
-    case eos::MOVE_REVERSAL:
-    case eos::MOVE_FLAIL:
-        damage_mult = mechanics::REVERSAL_DAMAGE_MULT_TABLE[get_hp_dep_mult_table_idx(attacker)];
+    const MoveHandler& handler = get_move_handler(move.id);
+    switch (handler.kind) {
+    case MoveHandlerKind::DEFAULT:
         break;
-    case eos::MOVE_SMELLINGSALT:
-        if (defender.monster.statuses.paralysis) {
-            damage_mult = 2;
-        }
-        break;
-    case eos::MOVE_LOW_KICK:
-    case eos::MOVE_GRASS_KNOT:
-        damage_mult = mechanics::get_monster_weight(defender.monster.apparent_id);
+    case MoveHandlerKind::FIXED_MULT:
+        damage_mult = *handler.mult;
         break;
-    case eos::MOVE_SKY_ATTACK:
-        damage_mult = mechanics::SKY_ATTACK_DAMAGE_MULTIPLIER;
+    case MoveHandlerKind::SUCCESSIVE_HITS:
+        damage_mult =
+            handler.mult[std::min(static_cast<int>(move.prior_successive_hits), handler.max_index)];
         break;
-    case eos::MOVE_WATER_SPOUT:
-        damage_mult = mechanics::WATER_SPOUT_DAMAGE_MULT_TABLE[get_hp_dep_mult_table_idx(attacker)];
+    case MoveHandlerKind::ATTACKER_HP:
+        damage_mult = handler.mult[get_hp_dep_mult_table_idx(attacker)];
         break;
-    case eos::MOVE_EARTHQUAKE:
-        if (defender.monster.statuses.digging) {
-            damage_mult = 2;
-        }
+    case MoveHandlerKind::DEFENDER_HP:
+        damage_mult = handler.mult[get_hp_dep_mult_table_idx(defender)];
         break;
-    case eos::MOVE_SOLARBEAM: {
-        eos::weather_id weather = attacker.perceived_weather(dungeon);
-        damage_mult = mechanics::SOLARBEAM_DAMAGE_MULTIPLIER;
-        if (weather == eos::WEATHER_SANDSTORM || weather == eos::WEATHER_RAIN ||
-            weather == eos::WEATHER_HAIL) {
-            damage_mult /= 2;
+    case MoveHandlerKind::CONDITIONAL_MULT:
+        if (handler.condition(attacker, defender)) {
+            damage_mult = *handler.mult;
         }
         break;
-    }
-    case eos::MOVE_FLY:
-        damage_mult = mechanics::FLY_DAMAGE_MULTIPLIER;
-        break;
-    case eos::MOVE_DIVE:
-        damage_mult = mechanics::DIVE_DAMAGE_MULTIPLIER;
-        break;
-    case eos::MOVE_BOUNCE:
-        damage_mult = mechanics::BOUNCE_DAMAGE_MULTIPLIER;
-        break;
-    case eos::MOVE_HI_JUMP_KICK:
-    case eos::MOVE_BLAST_BURN:
-        damage_mult = 2;
-        break;
-    case eos::MOVE_TRIPLE_KICK:
-        // Can't hit more than 3 times
-        damage_mult = std::min(static_cast<int>(move.prior_successive_hits) + 1, 3);
-        break;
-    case eos::MOVE_SPIT_UP:
-        damage_mult = attacker.monster.statuses.stockpile_stage;
-        break;
-    case eos::MOVE_ERUPTION:
-        damage_mult = mechanics::ERUPTION_DAMAGE_MULT_TABLE[get_hp_dep_mult_table_idx(attacker)];
-        break;
-    case eos::MOVE_DREAM_EATER: {
-        auto& status = defender.monster.statuses;
-        if (!status.sleep && !status.nightmare && !status.napping) {
-            // For program reporting purposes; not really in the game
-            dungeon.damage_calc.dream_eater_failed = true;
+    case MoveHandlerKind::CUSTOM:
+        if (!handler.custom(dungeon, attacker, defender, move, damage_mult)) {
             return 0;
         }
         break;
-    }
-    case eos::MOVE_SKULL_BASH:
-        damage_mult = mechanics::SKULL_BASH_DAMAGE_MULTIPLIER;
-        break;
-    case eos::MOVE_REGULAR_ATTACK:
-        damage_mult = Fx32::CONST_0_5;
-        break;
-    case eos::MOVE_NATURAL_GIFT:
-        return simulate_damage_calc_natural_gift(damage_data, dungeon, attacker, defender,
+    case MoveHandlerKind::WEATHER_BALL:
+        return simulate_damage_calc_weather_ball(damage_data, dungeon, ctx, attacker, defender,
+                                                 move.ginseng);
+    case MoveHandlerKind::NATURAL_GIFT:
+        return simulate_damage_calc_natural_gift(damage_data, dungeon, ctx, attacker, defender,
                                                  move.ginseng);
-    case eos::MOVE_TRUMP_CARD: {
-        int32_t max_pp = mechanics::get_move_max_pp(move.id);
-        if (max_pp == 0) {
-            max_pp = 1;
-        }
-        int32_t pp_frac = (static_cast<uint32_t>(move.pp) * 100) / max_pp;
-        if (pp_frac < 26) {
-            damage_mult = Fx32::CONST_1_25;
-        } else if (pp_frac < 51) {
-            damage_mult = 1;
-        } else if (pp_frac < 76) {
-            damage_mult = Fx32::CONST_0_75;
-        } else {
-            damage_mult = Fx32::CONST_0_5;
-        }
-        break;
-    }
-    case eos::MOVE_BRINE: {
-        int32_t max_hp = defender.monster.max_hp_stat + defender.monster.max_hp_boost;
-        if (max_hp > mechanics::MAX_HP_CAP) {
-            max_hp = mechanics::MAX_HP_CAP;
-        }
-        if ((static_cast<uint32_t>(defender.monster.hp) * 2) <= max_hp) {
-            damage_mult = 2;
-        }
-        break;
-    }
-    case eos::MOVE_WRING_OUT:
-    case eos::MOVE_CRUSH_GRIP:
-        damage_mult = mechanics::WRING_OUT_DAMAGE_MULT_TABLE[get_hp_dep_mult_table_idx(defender)];
-        break;
-    case eos::MOVE_GYRO_BALL:
-        if (attacker.monster.statuses.speed_stage == 0) {
-            damage_mult = 2;
-        }
-        break;
-    case eos::MOVE_SHADOW_FORCE:
-        damage_mult = mechanics::SHADOW_FORCE_DAMAGE_MULTIPLIER;
-        break;
-    case eos::MOVE_LAST_RESORT: {
-        int32_t n_moves_out_of_pp = attacker.monster.n_moves_out_of_pp;
-        if (n_moves_out_of_pp > 0 && move.pp == 0) {
-            n_moves_out_of_pp--;
-        }
-        if (n_moves_out_of_pp < 1) {
-            dungeon.damage_calc.last_resort_failed = true;
-            return 0;
-        }
-        damage_mult = mechanics::LAST_RESORT_DAMAGE_MULT_TABLE[n_moves_out_of_pp - 1];
-        break;
-    }
-    case eos::MOVE_WAKE_UP_SLAP: {
-        auto& status = defender.monster.statuses;
-        if (status.sleep || status.nightmare || status.napping) {
-            damage_mult = 2;
-        }
-        break;
-    }
-    // TODO: add support for more moves
-    default:
-        break;
     }
 
-    return simulate_damage_calc_with_mult(damage_data, dungeon, attacker, defender, move,
+    return simulate_damage_calc_with_mult(damage_data, dungeon, ctx, attacker, defender, move,
                                           damage_mult);
 }
 
@@ -1560,7 +1820,194 @@ int32_t simulate_damage_calc(DamageData& damage_data, DungeonState& dungeon,
 int32_t simulate_damage_calc_projectile(DamageData& damage_data, DungeonState& dungeon,
                                         MonsterEntity& attacker, MonsterEntity& defender,
                                         int32_t attack_power) {
+    CombatContext ctx(attacker, defender, dungeon);
     eos::type_id attack_type = attacker.get_move_type(eos::MOVE_PROJECTILE, dungeon);
-    return simulate_damage_calc_shared(damage_data, dungeon, attacker, defender, attack_type,
+    return simulate_damage_calc_shared(damage_data, dungeon, ctx, attacker, defender, attack_type,
                                        attack_power, Fx32{1}, eos::MOVE_PROJECTILE);
 }
+
+namespace {
+// Finish a calc from its state at the rolls, with the given outcomes. dungeon and details start
+// out as they were at the end of the calc with both rolls failing. Everything after the damage
+// calc itself (the hit check and immunities in the damage sequence) doesn't depend on the rolls,
+// so it carries over as is.
+void finish_branch(DungeonState& dungeon, DamageData& details, const DamageRollState& state,
+                   const MonsterEntity& attacker, MonsterEntity& defender, bool huge_pure_power,
+                   bool critical_hit) {
+    // The roll comes before every other attack multiplier and divisor, which only multiply them
+    // further, so a success just scales the final ones
+    bool boost = huge_pure_power && state.huge_pure_power_boosts;
+    Fx64 base = stats_to_base_damage(
+        dungeon, attacker, state.atk, state.def, state.atk_mult_int * (boost ? 3 : 1),
+        state.atk_div * (boost ? 2 : 1), state.def_mult_int, state.def_div, state.power);
+    Fx64 damage_mult_dynamic = state.damage_mult_dynamic;
+    if (critical_hit) {
+        apply_critical_hit(dungeon, *state.ctx, damage_mult_dynamic, details);
+    }
+    // Projectiles are the only thing checked under regular_attack_or_projectile, and the move ID
+    // is checked too
+    finish_damage<true>(dungeon, *state.ctx, defender, base, damage_mult_dynamic,
+                        state.damage_mult, state.move_id, details);
+}
+
+// Simulate a branch on copies of the inputs, with the rolls forced to its outcomes. Reference mode
+// does this for every branch and damage roll, instead of finishing them from one calc.
+template <typename Simulate>
+void simulate_forced_branch(DamageBranch& branch, const DungeonState& dungeon,
+                            const MonsterEntity& attacker, const MonsterEntity& defender,
+                            double variance_dial, Simulate simulate) {
+    branch.dungeon = dungeon;
+    branch.dungeon.rng.huge_pure_power = branch.huge_pure_power;
+    branch.dungeon.rng.critical_hit = branch.critical_hit;
+    branch.dungeon.rng.variance_dial = variance_dial;
+    branch.details = DamageData{};
+    MonsterEntity branch_attacker = attacker;
+    MonsterEntity branch_defender_copy = defender;
+    MonsterEntity& branch_defender =
+        (&attacker == &defender) ? branch_attacker : branch_defender_copy;
+    branch.damage = simulate(branch.details, branch.dungeon, branch_attacker, branch_defender);
+}
+
+template <typename Simulate>
+DamageBranches simulate_branches(const DungeonState& dungeon, const MonsterEntity& attacker,
+                                 const MonsterEntity& defender, Simulate simulate) {
+    // Simulate on copies of the inputs, with both rolls failing. This also shows which rolls happen
+    // at all, and with what chances. Neither chance depends on how the other roll went.
+    DamageBranch neither;
+    neither.dungeon = dungeon;
+    neither.dungeon.rng.huge_pure_power = false;
+    neither.dungeon.rng.critical_hit = false;
+    DamageRollState state;
+    neither.dungeon.rng.roll_state = &state;
+    MonsterEntity scratch_attacker = attacker;
+    MonsterEntity scratch_defender_copy = defender;
+    MonsterEntity& scratch_defender =
+        (&attacker == &defender) ? scratch_attacker : scratch_defender_copy;
+    neither.damage =
+        simulate(neither.details, neither.dungeon, scratch_attacker, scratch_defender);
+    neither.dungeon.rng.roll_state = nullptr;
+
+    const auto& rng = neither.dungeon.rng;
+    int32_t huge_pure_power_chance =
+        rng.huge_pure_power_was_rolled()
+            ? MockDungeonRNG::roll_success_chance(MockDungeonRNG::HUGE_PURE_POWER_CHANCE)
+            : 0;
+    int32_t crit_chance = rng.critical_hit_was_rolled()
+                              ? MockDungeonRNG::roll_success_chance(rng.get_computed_crit_chance())
+                              : 0;
+
+    DamageBranches branches;
+    for (bool huge_pure_power : {false, true}) {
+        int32_t huge_pure_power_branch_chance =
+            huge_pure_power ? huge_pure_power_chance : 100 - huge_pure_power_chance;
+        for (bool critical_hit : {false, true}) {
+            int32_t chance = huge_pure_power_branch_chance *
+                             (critical_hit ? crit_chance : 100 - crit_chance);
+            if (chance == 0) {
+                continue;
+            }
+            DamageBranch& branch = branches.emplace_back(neither);
+            branch.huge_pure_power = huge_pure_power;
+            branch.critical_hit = critical_hit;
+            branch.chance = chance;
+            branch.dungeon.rng.huge_pure_power = huge_pure_power;
+            branch.dungeon.rng.critical_hit = critical_hit;
+            if (reference_mode_enabled) {
+                DamageBranch roll = branch;
+                simulate_forced_branch(roll, dungeon, attacker, defender, 0, simulate);
+                branch.min_roll_damage = roll.details.damage;
+                simulate_forced_branch(roll, dungeon, attacker, defender, 1, simulate);
+                branch.max_roll_damage = roll.details.damage;
+                simulate_forced_branch(branch, dungeon, attacker, defender,
+                                       dungeon.rng.variance_dial, simulate);
+                continue;
+            }
+            if (!state.ctx) {
+                // The calc never got to the rolls, so there's nothing to finish
+                branch.min_roll_damage = branch.details.damage;
+                branch.max_roll_damage = branch.details.damage;
+                continue;
+            }
+            if (huge_pure_power || critical_hit) {
+                finish_branch(branch.dungeon, branch.details, state, scratch_attacker,
+                              scratch_defender, huge_pure_power, critical_hit);
+                // Same as at the end of the damage sequence
+                branch.damage = branch.details.no_damage ? 0 : branch.details.damage;
+            }
+            auto damage_with_roll = [&](double variance_dial) {
+                DungeonState roll_dungeon = neither.dungeon;
+                roll_dungeon.rng.variance_dial = variance_dial;
+                DamageData roll_details = neither.details;
+                finish_branch(roll_dungeon, roll_details, state, scratch_attacker,
+                              scratch_defender, huge_pure_power, critical_hit);
+                return roll_details.damage;
+            };
+            branch.min_roll_damage = damage_with_roll(0);
+            branch.max_roll_damage = damage_with_roll(1);
+        }
+    }
+    return branches;
+}
+} // namespace
+
+DamageBranches simulate_damage_branches(const DungeonState& dungeon,
+                                        const MonsterEntity& attacker,
+                                        const MonsterEntity& defender, Move move) {
+    return simulate_branches(dungeon, attacker, defender,
+                             [move](DamageData& details, DungeonState& dungeon,
+                                    MonsterEntity& attacker, MonsterEntity& defender) {
+                                 return simulate_damage_calc(details, dungeon, attacker, defender,
+                                                             move);
+                             });
+}
+DamageBranches simulate_damage_branches_projectile(const DungeonState& dungeon,
+                                                   const MonsterEntity& attacker,
+                                                   const MonsterEntity& defender,
+                                                   int32_t attack_power) {
+    return simulate_branches(dungeon, attacker, defender,
+                             [attack_power](DamageData& details, DungeonState& dungeon,
+                                            MonsterEntity& attacker, MonsterEntity& defender) {
+                                 return simulate_damage_calc_projectile(details, dungeon, attacker,
+                                                                        defender, attack_power);
+                             });
+}
+
+HitChanceTable hit_chance_table(const DungeonState& dungeon, const MonsterEntity& attacker,
+                                const MonsterEntity& defender, eos::move_id move_id) {
+    HitChanceTable table{};
+
+    // Run the prechecks on copies, since they can modify their inputs. The mock hit chance rolls
+    // always succeed, so the prechecks only fail if the move can't hit at all.
+    DungeonState scratch_dungeon = dungeon;
+    MonsterEntity scratch_attacker = attacker;
+    MonsterEntity scratch_defender_copy = defender;
+    MonsterEntity& scratch_defender =
+        (&attacker == &defender) ? scratch_attacker : scratch_defender_copy;
+    CombatContext ctx(scratch_attacker, scratch_defender, scratch_dungeon);
+    if (!execute_move_effect_prechecks(scratch_dungeon, ctx, scratch_attacker, scratch_defender,
+                                       move_id)) {
+        return table;
+    }
+    int32_t forewarn_chance = scratch_dungeon.rng.forewarn_was_rolled() ? 80 : 100;
+
+    // The first hit check is in ExecuteMoveEffect, and the second in the damage sequence
+    HitCheck checks[2] = {
+        {ctx, scratch_attacker, scratch_defender, move_id, false, never_misses_self(move_id)},
+        {ctx, scratch_attacker, scratch_defender, move_id, true, true},
+    };
+    for (int32_t accuracy_stage = 0; accuracy_stage < 21; accuracy_stage++) {
+        for (int32_t evasion_stage = 0; evasion_stage < 21; evasion_stage++) {
+            int32_t chance = forewarn_chance;
+            for (const auto& check : checks) {
+                if (check.guaranteed) {
+                    chance *= *check.guaranteed ? 100 : 0;
+                } else {
+                    chance *= MockDungeonRNG::roll_success_chance(
+                        check.hit_chance(accuracy_stage, evasion_stage));
+                }
+            }
+            table[accuracy_stage][evasion_stage] = chance;
+        }
+    }
+    return table;
+}
@@ -4,9 +4,11 @@
 #define DAMAGE_HPP_
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdint>
 #include <optional>
+#include <vector>
 #include "mathutil.hpp"
 #include "mechanics.hpp"
 #include "pmdsky.hpp"
@@ -178,10 +180,14 @@ struct DamageCalcDiag {
     bool last_resort_failed = false;
 };
 
+struct DamageRollState;
+
 // Encapsulates functionality of the dungeon RNG in a more controlled manner than in-game
 class MockDungeonRNG {
   private:
     int32_t crit_chance;
+    bool critical_hit_rolled;
+    bool huge_pure_power_rolled;
     bool forewarn_active;
     std::optional<int32_t> hit_chance1;
     std::optional<int32_t> hit_chance2;
@@ -190,26 +196,36 @@ class MockDungeonRNG {
     bool huge_pure_power;
     bool critical_hit;
     double variance_dial;
+    // Not in the game. If set, calc_damage() saves its state at the Huge Power/Pure Power and
+    // critical hit rolls here, so that simulate_damage_branches() can finish the calc for the other
+    // outcomes of the rolls without running it again from the start.
+    DamageRollState* roll_state = nullptr;
 
     MockDungeonRNG(bool huge_pure_power_ = false, bool critical_hit_ = false,
                    double variance_dial_ = 0)
-        : huge_pure_power(huge_pure_power_), critical_hit(critical_hit_),
-          variance_dial(variance_dial_), crit_chance(0), forewarn_active(false),
-          hit_chance1(std::nullopt), hit_chance2(std::nullopt) {}
+        : crit_chance(0), critical_hit_rolled(false), huge_pure_power_rolled(false),
+          forewarn_active(false), hit_chance1(std::nullopt), hit_chance2(std::nullopt),
+          huge_pure_power(huge_pure_power_), critical_hit(critical_hit_),
+          variance_dial(variance_dial_) {}
 
-    bool roll_huge_pure_power() const {
+    static constexpr int32_t HUGE_PURE_POWER_CHANCE = 33;
+    bool roll_huge_pure_power() {
         // This is a mock. In-game, it would be:
-        // return DungeonRandInt(100) < 33
+        // return DungeonRandInt(100) < HUGE_PURE_POWER_CHANCE
+        huge_pure_power_rolled = true; // Store this so we know the roll happened later
         return huge_pure_power;
     }
+    bool huge_pure_power_was_rolled() const { return huge_pure_power_rolled; }
 
     bool roll_critical_hit(int32_t crit_chance) {
         // This is a mock. In-game, it would be:
         // return DungeonRandInt(100) < crit_chance
         this->crit_chance = crit_chance; // Store this so we can see what it was later
+        critical_hit_rolled = true;
         return critical_hit;
     }
     int32_t get_computed_crit_chance() const { return crit_chance; }
+    bool critical_hit_was_rolled() const { return critical_hit_rolled; }
 
     Fx64 roll_damage_variance() const {
         // This is a mock. In-game, it would be:
@@ -241,9 +257,12 @@ class MockDungeonRNG {
     }
     std::optional<int32_t> get_hit_chance1() const { return hit_chance1; }
     std::optional<int32_t> get_hit_chance2() const { return hit_chance2; }
+    // The chance out of 100 that DungeonRandInt(100) < chance
+    static int32_t roll_success_chance(int32_t chance) { return std::clamp(chance, 0, 100); }
+    // Chance (in parts per million) that both hit chance rolls and the Forewarn roll succeed
     int32_t get_combined_hit_chance_raw() const {
-        return std::min(hit_chance1.value_or(100), 100) * std::min(hit_chance2.value_or(100), 100) *
-               (forewarn_active ? 80 : 100);
+        return roll_success_chance(hit_chance1.value_or(100)) *
+               roll_success_chance(hit_chance2.value_or(100)) * (forewarn_active ? 80 : 100);
     }
     double get_combined_hit_probability() const { return get_combined_hit_chance_raw() / 1e6; }
     double get_combined_hit_percentage() const { return get_combined_hit_chance_raw() / 1e4; }
@@ -497,6 +516,102 @@ class MonsterEntity {
     bool two_turn_move_forced_miss(eos::move_id move) const;
 };
 
+// A monster's ability, item, IQ skill and exclusive item effect predicates, with the conditions
+// that gate them (Gastro Acid, Klutz, disabled IQ, etc.) resolved once up front. Each method gives
+// the same result as the MonsterEntity method of the same name, as long as the monster and dungeon
+// state it was resolved from don't change (which they don't over the course of a damage calc).
+// Refers to the monster's flag arrays, so it can't outlive the MonsterEntity.
+struct ResolvedMonster {
+    // The monster's abilities, or ABILITY_UNKNOWN if they aren't active
+    eos::ability_id abilities[2];
+    // The monster's flag arrays, or nullptr if none of the flags can be active
+    const bool* iq_skill_flags;
+    const bool* exclusive_item_effect_flags;
+    // The held item, if item_active() can be true for it (it isn't sticky and there's no Klutz)
+    std::optional<eos::item_id> active_item;
+    eos::weather_id weather;
+
+    ResolvedMonster(const MonsterEntity& entity, const DungeonState& dungeon);
+
+    bool ability_active(eos::ability_id ability) const {
+        return ability != eos::ABILITY_UNKNOWN &&
+               (abilities[0] == ability || abilities[1] == ability);
+    }
+    bool iq_skill_enabled(eos::iq_skill_id iq) const {
+        return iq_skill_flags && iq_skill_flags[iq];
+    }
+    bool exclusive_item_effect_active(eos::exclusive_item_effect_id effect) const {
+        return exclusive_item_effect_flags && exclusive_item_effect_flags[effect];
+    }
+    bool item_active(eos::item_id item) const { return active_item == item; }
+    bool aura_bow_active() const { return active_item && mechanics::is_aura_bow(*active_item); }
+    eos::weather_id perceived_weather() const { return weather; }
+};
+
+// Resolved predicates for both sides of an attack, built once per damage calc
+struct CombatContext {
+    ResolvedMonster attacker;
+    ResolvedMonster defender;
+    // Whether the attacker's Mold Breaker breaks through the defender's abilities
+    bool mold_breaker;
+
+    CombatContext(const MonsterEntity& attacker, const MonsterEntity& defender,
+                  const DungeonState& dungeon);
+
+    // Same as defender.ability_active(ability, attacker, true)
+    bool defender_ability_active(eos::ability_id ability) const {
+        return !mold_breaker && defender.ability_active(ability);
+    }
+};
+
+// The parts of a move hit check (pmdsky-debug: MoveHitCheck) that don't depend on the attacker's
+// accuracy stage or the defender's evasion stage, so that the hit chance can be worked out for any
+// pair of stages
+struct HitCheck {
+    // Set if the check is decided before any roll (Sure Shot, Whiffer, Thunder in the rain, etc.)
+    std::optional<bool> guaranteed;
+    int32_t move_accuracy = 0;
+    int32_t accuracy_boost = 0;
+    int32_t evasion_boost = 0;
+    bool exposed = false;  // The evasion stage is reset before boosts
+    bool no_guard = false; // Both stages are reset after boosts
+    const Fx32* accuracy_multipliers = nullptr;
+    const Fx32* evasion_multipliers = nullptr;
+
+    HitCheck(const CombatContext& ctx, const MonsterEntity& attacker, const MonsterEntity& defender,
+             eos::move_id move_id, bool use_second_accuracy, bool never_miss_self);
+
+    // The hit chance compared against DungeonRandInt(100), given the unmodified stages. Only
+    // meaningful if the check isn't guaranteed.
+    int32_t hit_chance(int32_t accuracy_stage, int32_t evasion_stage) const;
+};
+
+// How simulate_damage_calc() works out a move's damage multiplier (or special path) before the
+// shared damage calc. Not in the game, where this logic is hard-coded into the move effect
+// handlers; here it's data, so that requests can be grouped by kind and new moves can be added to
+// the table without touching the dispatch code.
+enum class MoveHandlerKind : uint8_t {
+    DEFAULT,          // Multiplier of 1
+    FIXED_MULT,       // *mult
+    SUCCESSIVE_HITS,  // mult[min(prior successive hits, max_index)]
+    ATTACKER_HP,      // mult[] indexed by the attacker's HP quartile
+    DEFENDER_HP,      // mult[] indexed by the defender's HP quartile
+    CONDITIONAL_MULT, // *mult if condition() holds, otherwise 1
+    CUSTOM,           // Worked out by custom(), which can also make the move fail
+    WEATHER_BALL,     // Goes through simulate_damage_calc_weather_ball()
+    NATURAL_GIFT,     // Goes through simulate_damage_calc_natural_gift()
+};
+struct MoveHandler {
+    MoveHandlerKind kind = MoveHandlerKind::DEFAULT;
+    const Fx32* mult = nullptr;
+    int max_index = 0;
+    bool (*condition)(const MonsterEntity& attacker, const MonsterEntity& defender) = nullptr;
+    // Sets the damage multiplier, or returns false if the move fails
+    bool (*custom)(DungeonState& dungeon, const MonsterEntity& attacker,
+                   const MonsterEntity& defender, Move move, Fx32& damage_mult) = nullptr;
+};
+const MoveHandler& get_move_handler(eos::move_id move);
+
 int32_t simulate_damage_calc_generic(DamageData& damage_data, DungeonState& dungeon,
                                      MonsterEntity& attacker, MonsterEntity& defender,
                                      eos::type_id attack_type, int32_t attack_power,
@@ -508,4 +623,76 @@ int32_t simulate_damage_calc_projectile(DamageData& damage_data, DungeonState& d
                                         MonsterEntity& attacker, MonsterEntity& defender,
                                         int32_t attack_power);
 
+// Exact chance (in parts per million, like MockDungeonRNG::get_combined_hit_chance_raw()) that a
+// move gets through the hit checks in ExecuteMoveEffect and the damage sequence, for every attacker
+// accuracy stage and defender evasion stage, indexed by [accuracy_stage][evasion_stage]. This
+// covers the Forewarn roll, the prechecks that always miss (Soundproof, Lightningrod, etc.) and
+// both accuracy rolls, but not move-specific failures like Dream Eater's.
+using HitChanceTable = std::array<std::array<int32_t, 21>, 21>;
+HitChanceTable hit_chance_table(const DungeonState& dungeon, const MonsterEntity& attacker,
+                                const MonsterEntity& defender, eos::move_id move_id);
+
+// Whether the game version (DungeonState::version) can change the results of a calc between these
+// monsters. The only difference between versions is JP's bug with Giratina's defensive stage
+// modifier, so this is only true when the attacker and defender would get different modifiers.
+bool version_affects_calc(const MonsterEntity& attacker, const MonsterEntity& defender);
+
+// One way a calc can go at the RNG rolls that pick between damage multipliers (Huge Power/Pure
+// Power and critical hits), with the results of the calc when the rolls go that way
+struct DamageBranch {
+    bool huge_pure_power = false;
+    bool critical_hit = false;
+    int32_t chance = 0; // In parts per 10000
+    int32_t damage = 0; // As returned by simulate_damage_calc()
+    DamageData details;
+    DungeonState dungeon; // After the simulation, for the diagnostics
+    // details.damage with the lowest and highest damage rolls, rather than the one picked by
+    // dungeon.rng.variance_dial
+    int32_t min_roll_damage = 0;
+    int32_t max_roll_damage = 0;
+};
+// Every branch a calc can take at those rolls, with the chance of each. The rng.huge_pure_power
+// and rng.critical_hit flags in the dungeon state are ignored. Rolls that don't happen (an
+// attacker without Huge Power or Pure Power, or a move that can't crit) don't split the calc, and
+// branches that can't happen (like the non-crit branch with a 100% crit chance) are left out, so
+// a calc with neither roll has a single branch with a chance of 10000. Everything else about the
+// inputs is the same as simulate_damage_calc(), and they aren't modified. The calc only runs once,
+// with both rolls failing, and the other branches are finished from its state at the rolls.
+using DamageBranches = std::vector<DamageBranch>;
+DamageBranches simulate_damage_branches(const DungeonState& dungeon,
+                                        const MonsterEntity& attacker,
+                                        const MonsterEntity& defender, Move move);
+// Same as simulate_damage_branches(), for simulate_damage_calc_projectile()
+DamageBranches simulate_damage_branches_projectile(const DungeonState& dungeon,
+                                                   const MonsterEntity& attacker,
+                                                   const MonsterEntity& defender,
+                                                   int32_t attack_power);
+
+// How often the damage calc found its base damage (the attack/defense/level part of the formula)
+// already memoized. The memo and these counts are per thread, so this only covers calcs run on the
+// calling thread since the last reset. Batches and servers add up the counts of their workers (see
+// batch::run_batch() and server::BaseDamageMemoTotals).
+struct BaseDamageMemoStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    BaseDamageMemoStats& operator+=(const BaseDamageMemoStats& other) {
+        hits += other.hits;
+        misses += other.misses;
+        return *this;
+    }
+    // Fraction of lookups that were hits, or 0 if there weren't any
+    double hit_rate() const { return hits + misses == 0 ? 0 : double(hits) / (hits + misses); }
+};
+BaseDamageMemoStats base_damage_memo_stats();
+void reset_base_damage_memo_stats();
+
+// Run the damage calc on the calling thread without its shortcuts: the base damage memo, the
+// precomputed stats after stage multipliers, the strength-reduced constant divisions, and finishing
+// the branches of simulate_damage_branches() from a single calc. Results are meant to be identical
+// either way, so this is for checking the shortcuts against the plain computations (see
+// damage_difftest.cpp). Off by default.
+void set_reference_mode(bool enabled);
+bool reference_mode();
+
 #endif
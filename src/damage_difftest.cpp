@@ -0,0 +1,671 @@
+// Differential tester for the damage calc: runs random valid configs through the reference path
+// and the optimized paths, and reports any config where they disagree, shrunk to a minimal config
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CLI/App.hpp"
+#include "CLI/Formatter.hpp"
+#include "CLI/Config.hpp"
+#include <nlohmann/json.hpp>
+using nlohmann::json;
+
+#include "batch.hpp"
+#include "calcresult.hpp"
+#include "cfgparse.hpp"
+#include "cfgtape.hpp"
+#include "damage.hpp"
+#include "idmap.hpp"
+#include "wire.hpp"
+
+// The reference path parses a JSON document and runs the calc in reference mode (see
+// set_reference_mode()), without the base damage memo, the precomputed stat tables or the
+// strength-reduced divisions. The optimized paths run the calc with every shortcut on, on the
+// config parsed the ways the CLI, the batch runner and the binary API do:
+// - "json": the same JSON document
+// - "tape": JSON text parsed into a ConfigTape
+// - "wire": the config encoded as a wire::RequestRecord and decoded again
+// Each path's full calc result (calcresult::calc_damage(), with every detail), its branch table
+// (calcresult::damage_branches()) and its result record with details (wire::encode_result()) have
+// to match the reference's exactly. A config the reference rejects has to be rejected by every
+// other path too.
+//
+// Generating, parsing and comparing JSON costs far more than the calc itself, so each generated
+// config is also checked in many variants (see Variant), which change the parsed inputs directly
+// and only compare result records. Every config and every variant counts as a case.
+namespace {
+class InvalidConfig : public std::runtime_error {
+  public:
+    explicit InvalidConfig(const std::string& what) : std::runtime_error(what) {}
+};
+
+// Names to generate configs from, listed once
+struct NameLists {
+    std::vector<std::string> species;
+    std::vector<std::string> moves;
+    std::vector<std::string> projectiles;
+    std::vector<std::string> types;
+    std::vector<std::string> abilities;
+    std::vector<std::string> items;
+    std::vector<std::string> weathers;
+    std::vector<std::string> iq_skills;
+    std::vector<std::string> exclusive_item_effects;
+    std::vector<std::string> versions;
+    // Statuses in the same group are mutually exclusive (see Statuses::is_valid())
+    std::vector<std::vector<std::string>> status_groups;
+
+    // The placeholder IDs that the web app leaves out aren't valid inputs, and some of them index
+    // past the end of the game's tables
+    NameLists()
+        : species(ids::MONSTER.all_except({eos::MONSTER_NONE, eos::MONSTER_NONE_SECONDARY})),
+          moves(ids::MOVE.all_except()), types(ids::TYPE.all_except({eos::TYPE_NEUTRAL})),
+          abilities(ids::ABILITY.all_except()), items(ids::ITEM.all_except()),
+          weathers(ids::WEATHER.all_except({eos::WEATHER_RANDOM})),
+          iq_skills(ids::IQ.all_except()),
+          exclusive_item_effects(ids::EXCLUSIVE_ITEM_EFFECT.all_except({eos::EXCLUSIVE_EFF_LAST})),
+          versions(ids::VERSION.all_except()) {
+        for (const auto& item : cfgparse::PROJECTILE_ITEMS) {
+            projectiles.emplace_back(ids::ITEM[item.id]);
+        }
+        const std::vector<std::vector<eos::status_id>> groups = {
+            {eos::STATUS_SLEEP, eos::STATUS_NIGHTMARE, eos::STATUS_NAPPING},
+            {eos::STATUS_BURN, eos::STATUS_POISONED, eos::STATUS_BADLY_POISONED,
+             eos::STATUS_PARALYSIS, eos::STATUS_IDENTIFYING},
+            {eos::STATUS_CONFUSED},
+            {eos::STATUS_SKULL_BASH, eos::STATUS_FLYING, eos::STATUS_BOUNCING, eos::STATUS_DIVING,
+             eos::STATUS_DIGGING, eos::STATUS_CHARGING, eos::STATUS_SHADOW_FORCE},
+            {eos::STATUS_REFLECT, eos::STATUS_LIGHT_SCREEN, eos::STATUS_LUCKY_CHANT},
+            {eos::STATUS_GASTRO_ACID},
+            {eos::STATUS_SURE_SHOT, eos::STATUS_WHIFFER, eos::STATUS_FOCUS_ENERGY},
+            {eos::STATUS_CROSS_EYED},
+            {eos::STATUS_MIRACLE_EYE},
+            {eos::STATUS_MAGNET_RISE},
+            {eos::STATUS_EXPOSED},
+        };
+        for (const auto& group : groups) {
+            status_groups.emplace_back();
+            for (auto status : group) {
+                status_groups.back().emplace_back(ids::STATUS[status]);
+            }
+        }
+        status_groups.push_back({"guts/marvel scale"});
+    }
+};
+const NameLists& names() {
+    static const NameLists lists;
+    return lists;
+}
+
+// Random values for one config and its variants. Each config seeds its own generator from the run's
+// seed and the config number, so any config can be rerun on its own with the same seed.
+class CaseRNG {
+    std::mt19937_64 rng;
+
+  public:
+    CaseRNG(uint64_t seed, uint64_t config_idx) {
+        // splitmix64, so neighboring configs get unrelated seeds
+        uint64_t z = seed + (config_idx + 1) * 0x9E3779B97F4A7C15;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+        rng.seed(z ^ (z >> 31));
+    }
+    // Uniform in [lo, hi]
+    int range(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); }
+    // True with a probability of pct%
+    bool chance(int pct) { return range(0, 99) < pct; }
+    const std::string& pick(const std::vector<std::string>& list) {
+        return list[range(0, static_cast<int>(list.size()) - 1)];
+    }
+    // Up to max_n random names from list, possibly with repeats (which parse the same as one)
+    json pick_some(const std::vector<std::string>& list, int max_n) {
+        json picked = json::array();
+        for (int n = range(0, max_n); n > 0; n--) {
+            picked.push_back(pick(list));
+        }
+        return picked;
+    }
+};
+
+// Mostly the neutral stage of 10, sometimes anything else, including out-of-range stages that the
+// calc clamps
+int random_stage(CaseRNG& rng) {
+    if (rng.chance(60)) {
+        return 10;
+    }
+    return rng.chance(90) ? rng.range(0, 20) : rng.range(-5, 25);
+}
+// Mostly 1, sometimes a common multiplier, and sometimes any Fx32 value up to 4
+double random_multiplier(CaseRNG& rng) {
+    if (rng.chance(70)) {
+        return 1.0;
+    }
+    if (rng.chance(50)) {
+        const double common[] = {0.25, 0.5, 1.5, 2.0};
+        return common[rng.range(0, 3)];
+    }
+    return rng.range(0, 4 << 8) / 256.0;
+}
+
+json random_monster(CaseRNG& rng) {
+    const auto& lists = names();
+    json monster;
+    monster["species"] = rng.pick(lists.species);
+    bool team_member = rng.chance(50);
+    monster["is_team_member"] = team_member;
+    monster["is_team_leader"] = team_member && rng.chance(30);
+    monster["level"] = rng.range(1, 100);
+    int max_hp = rng.range(1, 999);
+    monster["max_hp"] = max_hp;
+    monster["hp"] = rng.range(1, max_hp);
+    for (const char* stat : {"atk", "sp_atk", "def", "sp_def"}) {
+        monster[stat] = rng.range(0, 255);
+    }
+    monster["iq"] = rng.range(0, 999);
+    monster["belly"] = rng.range(0, 200);
+    if (rng.chance(10)) {
+        monster["type1"] = rng.pick(lists.types);
+        monster["type2"] = rng.pick(lists.types);
+    }
+    if (rng.chance(40)) {
+        monster["ability1"] = rng.pick(lists.abilities);
+        monster["ability2"] = rng.pick(lists.abilities);
+    }
+
+    json stages;
+    for (const char* stat : {"atk", "sp_atk", "def", "sp_def", "accuracy", "evasion"}) {
+        stages[stat] = random_stage(rng);
+    }
+    stages["speed"] = rng.range(0, 4);
+    stages["stockpile"] = rng.range(0, 3);
+    json multipliers;
+    for (const char* stat : {"atk", "sp_atk", "def", "sp_def"}) {
+        multipliers[stat] = random_multiplier(rng);
+    }
+    monster["stat_modifiers"] = {
+        {"stages", stages},
+        {"multipliers", multipliers},
+        {"flash_fire_boost", rng.range(0, 2)},
+    };
+
+    monster["iq_skills"] = rng.pick_some(lists.iq_skills, 4);
+    monster["hidden_power_type"] = rng.pick(lists.types);
+    monster["hidden_power_base_power"] = rng.range(10, 70);
+    monster["held_item"] = {
+        {"id", rng.chance(60) ? rng.pick(lists.items) : "nothing"},
+        {"sticky", rng.chance(10)},
+    };
+    json boosts;
+    for (const char* stat : {"atk", "sp_atk", "def", "sp_def"}) {
+        boosts[stat] = rng.chance(10) ? rng.range(0, 20) : 0;
+    }
+    monster["exclusive_items"] = {
+        {"effects", rng.pick_some(lists.exclusive_item_effects, 3)},
+        {"stat_boosts", boosts},
+    };
+
+    json statuses = json::array();
+    for (const auto& group : lists.status_groups) {
+        if (rng.chance(10)) {
+            statuses.push_back(rng.pick(group));
+        }
+    }
+    monster["statuses"] = statuses;
+    monster["me_first"] = rng.chance(5);
+    monster["practice_swinger"] = rng.chance(5);
+    monster["anger_point"] = rng.chance(5);
+    monster["n_moves_out_of_pp"] = rng.chance(90) ? 0 : rng.range(1, 4);
+    return monster;
+}
+
+// A random config that parse_cfg() accepts, covering every section of sample-config.json
+json random_config(CaseRNG& rng) {
+    const auto& lists = names();
+    json cfg;
+    cfg["move"] = {
+        {"id", rng.chance(95) ? rng.pick(lists.moves) : rng.pick(lists.projectiles)},
+        {"ginseng", rng.chance(80) ? 0 : rng.range(1, 99)},
+        {"pp", rng.range(0, 30)},
+        {"prior_successive_hits", rng.chance(80) ? 0 : rng.range(1, 10)},
+        {"time_darkness", rng.chance(20)},
+    };
+    cfg["attacker"] = random_monster(rng);
+    cfg["defender"] = random_monster(rng);
+    cfg["dungeon"] = {
+        {"weather", rng.pick(lists.weathers)},
+        {"mud_sport", rng.chance(10)},
+        {"water_sport", rng.chance(10)},
+        {"gravity", rng.chance(10)},
+        {"plus", {{"team", rng.chance(10)}, {"enemy", rng.chance(10)}}},
+        {"minus", {{"team", rng.chance(10)}, {"enemy", rng.chance(10)}}},
+        {"iq_disabled", rng.chance(5)},
+        {"fixed_room_id", rng.chance(95) ? 0 : static_cast<int>(eos::FIXED_SUBSTITUTE_ROOM)},
+        {"other_monsters",
+         {{"iq", rng.pick_some(lists.iq_skills, 2)},
+          {"abilities", rng.pick_some(lists.abilities, 2)}}},
+    };
+    cfg["rng"] = {
+        {"huge_pure_power", rng.chance(50)},
+        {"critical_hit", rng.chance(30)},
+    };
+    cfg["misc"] = {{"version", rng.pick(lists.versions)}};
+    return cfg;
+}
+
+// What one path made of a config
+struct Outcome {
+    json result;        // calcresult::to_json(calcresult::calc_damage())
+    json branches;      // calcresult::to_json(calcresult::damage_branches())
+    std::string record; // wire::encode_result(), with details
+};
+Outcome run_inputs(const batch::CalcInputs& inputs) {
+    Outcome out;
+    out.result = calcresult::to_json(calcresult::calc_damage(inputs));
+    out.branches = calcresult::to_json(calcresult::damage_branches(inputs));
+    wire::encode_result(out.record, batch::run_calc(inputs), 0, true);
+    return out;
+}
+
+// Turns reference mode on for the current scope
+class ReferenceScope {
+  public:
+    ReferenceScope() { set_reference_mode(true); }
+    ~ReferenceScope() { set_reference_mode(false); }
+};
+
+Outcome reference_outcome(const json& cfg) {
+    ReferenceScope reference;
+    auto inputs = parse_cfg(cfg);
+    const auto& attacker = std::get<1>(inputs);
+    const auto& defender = std::get<2>(inputs);
+    if (!attacker.monster.statuses.is_valid() || !defender.monster.statuses.is_valid()) {
+        throw InvalidConfig("generated statuses that aren't valid together");
+    }
+    return run_inputs(inputs);
+}
+
+struct OptimizedPath {
+    const char* name;
+    std::function<Outcome(const json&)> run;
+};
+const std::vector<OptimizedPath>& optimized_paths() {
+    static const std::vector<OptimizedPath> paths = {
+        {"json", [](const json& cfg) { return run_inputs(parse_cfg(cfg)); }},
+        {"tape",
+         [](const json& cfg) {
+             // One tape per thread, reused like the batch runner reuses its tape
+             thread_local cfgparse::ConfigTape tape;
+             tape.clear();
+             return run_inputs(parse_cfg(tape.parse(cfg.dump())));
+         }},
+        {"wire",
+         [](const json& cfg) {
+             return run_inputs(wire::decode_request(wire::encode_request(cfg)));
+         }},
+    };
+    return paths;
+}
+
+// Description of how the optimized paths disagree with the reference on a config, if they do.
+// rejected is set if the reference rejected the config.
+std::optional<std::string> find_mismatch(const json& cfg, bool* rejected = nullptr) {
+    std::optional<Outcome> ref;
+    std::string ref_error;
+    try {
+        ref = reference_outcome(cfg);
+    } catch (const InvalidConfig&) {
+        throw;
+    } catch (const std::exception& e) {
+        ref_error = e.what();
+    }
+    if (rejected) {
+        *rejected = !ref;
+    }
+
+    for (const auto& path : optimized_paths()) {
+        std::optional<Outcome> out;
+        std::string error;
+        try {
+            out = path.run(cfg);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        std::string name = path.name;
+        if (!ref && out) {
+            return name + ": succeeded where the reference failed with: " + ref_error;
+        }
+        if (ref && !out) {
+            return name + ": failed where the reference succeeded: " + error;
+        }
+        if (ref && out->result != ref->result) {
+            return name + ": results differ: " + json::diff(ref->result, out->result).dump();
+        }
+        if (ref && out->branches != ref->branches) {
+            return name + ": branches differ: " + json::diff(ref->branches, out->branches).dump();
+        }
+        if (ref && out->record != ref->record) {
+            return name + ": result records differ";
+        }
+    }
+    return std::nullopt;
+}
+
+// A variant of a config, with the rolls and the numbers the calc's shortcuts depend on (the
+// attacker's level and offensive stats, the defender's defensive stats, and their stages and
+// multipliers) replaced. It can be applied to parsed inputs or to the config itself, with the
+// same effect.
+struct Variant {
+    bool huge_pure_power;
+    bool critical_hit;
+    int level;
+    int offensive_stats[2];    // {atk, sp_atk}
+    int defensive_stats[2];    // {def, sp_def}
+    int offensive_stages[2];   // {atk, sp_atk}
+    int defensive_stages[2];   // {def, sp_def}
+    int offensive_mult_raw[2]; // Raw Fx32 values, {atk, sp_atk}
+    int defensive_mult_raw[2]; // Raw Fx32 values, {def, sp_def}
+
+    explicit Variant(CaseRNG& rng)
+        : huge_pure_power(rng.chance(50)), critical_hit(rng.chance(30)),
+          level(rng.range(1, 100)) {
+        for (int i = 0; i < 2; i++) {
+            offensive_stats[i] = rng.range(0, 255);
+            defensive_stats[i] = rng.range(0, 255);
+            offensive_stages[i] = random_stage(rng);
+            defensive_stages[i] = random_stage(rng);
+            offensive_mult_raw[i] = static_cast<int>(random_multiplier(rng) * 256);
+            defensive_mult_raw[i] = static_cast<int>(random_multiplier(rng) * 256);
+        }
+    }
+
+    static Fx32 fx32(int raw) {
+        return Fx32{static_cast<uint32_t>(raw >> 8), static_cast<uint8_t>(raw & 0xFF)};
+    }
+    void apply(batch::CalcInputs& inputs) const {
+        auto& dungeon = std::get<0>(inputs);
+        auto& attacker = std::get<1>(inputs).monster;
+        auto& defender = std::get<2>(inputs).monster;
+        dungeon.rng.huge_pure_power = huge_pure_power;
+        dungeon.rng.critical_hit = critical_hit;
+        attacker.level = level;
+        for (int i = 0; i < 2; i++) {
+            attacker.offensive_stats[i] = offensive_stats[i];
+            defender.defensive_stats[i] = defensive_stats[i];
+            attacker.stat_modifiers.offensive_stages[i] = offensive_stages[i];
+            defender.stat_modifiers.defensive_stages[i] = defensive_stages[i];
+            attacker.stat_modifiers.offensive_multipliers[i] = fx32(offensive_mult_raw[i]);
+            defender.stat_modifiers.defensive_multipliers[i] = fx32(defensive_mult_raw[i]);
+        }
+    }
+    void apply(json& cfg) const {
+        cfg["rng"]["huge_pure_power"] = huge_pure_power;
+        cfg["rng"]["critical_hit"] = critical_hit;
+        json& attacker = cfg["attacker"];
+        json& defender = cfg["defender"];
+        attacker["level"] = level;
+        const char* offense[2] = {"atk", "sp_atk"};
+        const char* defense[2] = {"def", "sp_def"};
+        for (int i = 0; i < 2; i++) {
+            attacker[offense[i]] = offensive_stats[i];
+            defender[defense[i]] = defensive_stats[i];
+            attacker["stat_modifiers"]["stages"][offense[i]] = offensive_stages[i];
+            defender["stat_modifiers"]["stages"][defense[i]] = defensive_stages[i];
+            attacker["stat_modifiers"]["multipliers"][offense[i]] = offensive_mult_raw[i] / 256.0;
+            defender["stat_modifiers"]["multipliers"][defense[i]] = defensive_mult_raw[i] / 256.0;
+        }
+    }
+};
+
+// Whether the calc with every shortcut disagrees with the reference on a variant's inputs. Only
+// the result records with details are compared, which is enough to catch a mismatch, and
+// find_mismatch() on the variant's config describes it in full.
+bool variant_mismatches(const batch::CalcInputs& inputs) {
+    std::string ref;
+    std::string out;
+    {
+        ReferenceScope reference;
+        wire::encode_result(ref, batch::run_calc(inputs), 0, true);
+    }
+    wire::encode_result(out, batch::run_calc(inputs), 0, true);
+    return out != ref;
+}
+
+// Pointers to every object member and array element of cfg, each one before its own members
+void collect_parts(const json& value, const json::json_pointer& ptr,
+                   std::vector<json::json_pointer>& parts) {
+    if (value.is_object()) {
+        for (const auto& item : value.items()) {
+            json::json_pointer part = ptr / item.key();
+            parts.push_back(part);
+            collect_parts(item.value(), part, parts);
+        }
+    } else if (value.is_array()) {
+        for (std::size_t i = 0; i < value.size(); i++) {
+            json::json_pointer part = ptr / i;
+            parts.push_back(part);
+            collect_parts(value[i], part, parts);
+        }
+    }
+}
+
+// Shrink a mismatching config by dropping members and array elements (falling back to the
+// defaults) for as long as the mismatch persists. The first part that can go is dropped, and the
+// search starts over, so the result is minimal: dropping any one more part fixes the mismatch.
+json shrink(json cfg) {
+    bool shrunk = true;
+    while (shrunk) {
+        shrunk = false;
+        std::vector<json::json_pointer> parts;
+        collect_parts(cfg, json::json_pointer(), parts);
+        for (const auto& part : parts) {
+            json candidate = cfg;
+            json& parent = candidate.at(part.parent_pointer());
+            if (parent.is_array()) {
+                parent.erase(std::stoul(part.back()));
+            } else {
+                parent.erase(part.back());
+            }
+            if (find_mismatch(candidate)) {
+                cfg = std::move(candidate);
+                shrunk = true;
+                break;
+            }
+        }
+    }
+    return cfg;
+}
+
+struct Options {
+    uint64_t configs = 100000;
+    uint64_t start = 0;
+    uint64_t seed = 0;
+    unsigned variants = 255;
+    unsigned jobs = 1;
+    unsigned max_mismatches = 1;
+    bool shrink = true;
+    double progress_interval = 10;
+};
+
+class Tester {
+    const Options& options;
+    std::atomic<uint64_t> next_config;
+    std::atomic<uint64_t> n_done{0};
+    std::atomic<uint64_t> n_cases{0};
+    std::atomic<uint64_t> n_rejected{0};
+    std::atomic<bool> stop{false};
+    std::mutex report_mutex;
+    std::atomic<unsigned> n_mismatches{0};
+    int status = 0;
+
+    // Configs are handed out in chunks to keep the shared counters off the hot path
+    static constexpr uint64_t CHUNK_SIZE = 16;
+
+    void report(uint64_t config_idx, const json& cfg, const std::string& mismatch) {
+        json minimal = cfg;
+        std::string minimal_mismatch;
+        if (options.shrink) {
+            minimal = shrink(cfg);
+            // The shrunk config runs on its own, so a mismatch that depends on what ran before it
+            // on the same thread (like a stale memo entry) can fail to show up again
+            auto again = find_mismatch(minimal);
+            minimal_mismatch = again ? *again : "doesn't reproduce when run on its own";
+        }
+
+        std::lock_guard<std::mutex> lock(report_mutex);
+        if (n_mismatches >= options.max_mismatches) {
+            return;
+        }
+        std::cout << "Mismatch in config " << config_idx << " (seed " << options.seed
+                  << "): " << mismatch << "\n";
+        if (options.shrink) {
+            std::cout << "Shrunk config: " << minimal_mismatch << "\n";
+        }
+        std::cout << minimal.dump(4) << std::endl;
+        status = 1;
+        if (++n_mismatches >= options.max_mismatches) {
+            stop = true;
+        }
+    }
+    void invalid(uint64_t config_idx, const json& cfg, const std::string& what) {
+        std::lock_guard<std::mutex> lock(report_mutex);
+        std::cout << "Invalid config " << config_idx << " (seed " << options.seed
+                  << "): " << what << "\n"
+                  << cfg.dump(4) << std::endl;
+        status = 2;
+        stop = true;
+    }
+
+    // Check a config and its variants. Returns the number of cases checked.
+    uint64_t check_config(uint64_t config_idx) {
+        CaseRNG rng(options.seed, config_idx);
+        json cfg = random_config(rng);
+        bool rejected = false;
+        auto mismatch = find_mismatch(cfg, &rejected);
+        if (mismatch) {
+            report(config_idx, cfg, *mismatch);
+            return 1;
+        }
+        if (rejected) {
+            n_rejected++;
+            return 1;
+        }
+
+        auto inputs = parse_cfg(cfg);
+        for (unsigned i = 0; i < options.variants; i++) {
+            Variant variant(rng);
+            variant.apply(inputs);
+            if (variant_mismatches(inputs)) {
+                json variant_cfg = cfg;
+                variant.apply(variant_cfg);
+                auto variant_mismatch = find_mismatch(variant_cfg);
+                report(config_idx, variant_cfg,
+                       "variant " + std::to_string(i) + ": " +
+                           variant_mismatch.value_or("result records differ"));
+                return i + 2;
+            }
+        }
+        return options.variants + 1;
+    }
+
+    void work() {
+        uint64_t end = options.start + options.configs;
+        while (!stop) {
+            uint64_t first = next_config.fetch_add(CHUNK_SIZE);
+            if (first >= end) {
+                break;
+            }
+            uint64_t last = std::min(first + CHUNK_SIZE, end);
+            uint64_t cases = 0;
+            for (uint64_t i = first; i < last && !stop; i++) {
+                try {
+                    cases += check_config(i);
+                } catch (const InvalidConfig& e) {
+                    CaseRNG rng(options.seed, i);
+                    invalid(i, random_config(rng), e.what());
+                }
+            }
+            n_cases += cases;
+            n_done += last - first;
+        }
+    }
+
+  public:
+    explicit Tester(const Options& options_) : options(options_), next_config(options_.start) {}
+
+    // Check every config, printing each mismatch found to stdout and progress to stderr. Returns 0
+    // if there were no mismatches, 1 if there were, and 2 if a generated config was invalid.
+    int run() {
+        using clock = std::chrono::steady_clock;
+        auto start_time = clock::now();
+        auto elapsed = [&] {
+            return std::chrono::duration<double>(clock::now() - start_time).count();
+        };
+        auto print_progress = [&] {
+            double seconds = elapsed();
+            uint64_t cases = n_cases;
+            std::cerr << n_done << " configs (" << cases << " cases) in "
+                      << static_cast<uint64_t>(seconds) << " s ("
+                      << static_cast<uint64_t>(cases / std::max(seconds, 1e-9)) << " cases/s), "
+                      << n_rejected << " configs rejected by every path, " << n_mismatches
+                      << " mismatches" << std::endl;
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned i = 0; i < options.jobs; i++) {
+            workers.emplace_back([this] { work(); });
+        }
+        double next_progress = options.progress_interval;
+        while (n_done < options.configs && !stop) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (options.progress_interval > 0 && elapsed() >= next_progress) {
+                print_progress();
+                next_progress += options.progress_interval;
+            }
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        print_progress();
+        return status;
+    }
+};
+} // namespace
+
+int main(int argc, char** argv) {
+    CLI::App app{"Differential tester for the damage calc's optimized paths against its reference "
+                 "path, on random valid configs"};
+
+    Options options;
+    options.jobs = std::max(1u, std::thread::hardware_concurrency());
+    app.add_option("-n, --configs", options.configs, "Number of configs to generate");
+    app.add_option("--variants", options.variants,
+                   "Number of variants to check of each config (see Variant)");
+    app.add_option("--start", options.start,
+                   "First config number, to split a run across machines or rerun one config");
+    app.add_option("-s, --seed", options.seed, "Seed for the random configs");
+    app.add_option("-j, --jobs", options.jobs, "Number of threads to use")
+        ->check(CLI::PositiveNumber);
+    app.add_option("-m, --max-mismatches", options.max_mismatches,
+                   "Stop after finding this many mismatches")
+        ->check(CLI::PositiveNumber);
+    bool no_shrink = false;
+    app.add_flag("--no-shrink", no_shrink, "Print mismatching configs as generated");
+    app.add_option("--progress", options.progress_interval,
+                   "Seconds between progress reports on stderr (0 for none)");
+    CLI11_PARSE(app, argc, argv);
+    options.shrink = !no_shrink;
+
+    Tester tester(options);
+    return tester.run();
+}
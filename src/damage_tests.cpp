@@ -327,6 +327,123 @@ TEST_CASE("MonsterEntity methods work", "[MonsterEntity]") {
     }
 }
 
+namespace {
+// Check every resolved predicate against the MonsterEntity method it stands in for
+void require_resolved_matches(const MonsterEntity& entity, const DungeonState& dungeon) {
+    ResolvedMonster resolved(entity, dungeon);
+    for (int i = 0; i < 124; i++) {
+        auto ability = static_cast<eos::ability_id>(i);
+        REQUIRE(resolved.ability_active(ability) == entity.ability_active(ability));
+    }
+    for (int i = 0; i < 69; i++) {
+        auto iq = static_cast<eos::iq_skill_id>(i);
+        REQUIRE(resolved.iq_skill_enabled(iq) == entity.iq_skill_enabled(iq, dungeon));
+    }
+    for (int i = 0; i < 129; i++) {
+        auto effect = static_cast<eos::exclusive_item_effect_id>(i);
+        REQUIRE(resolved.exclusive_item_effect_active(effect) ==
+                entity.exclusive_item_effect_active(effect));
+    }
+    for (auto item : {eos::ITEM_NOTHING, eos::ITEM_POWER_BAND, eos::ITEM_WEATHER_BAND,
+                      eos::ITEM_RED_BOW}) {
+        REQUIRE(resolved.item_active(item) == entity.item_active(item));
+    }
+    REQUIRE(resolved.aura_bow_active() == entity.aura_bow_active());
+    REQUIRE(resolved.perceived_weather() == entity.perceived_weather(dungeon));
+}
+} // namespace
+
+TEST_CASE("ResolvedMonster matches MonsterEntity predicates", "[MonsterEntity]") {
+    MonsterEntity entity;
+    entity.monster.abilities[0] = eos::ABILITY_CHLOROPHYLL;
+    entity.monster.abilities[1] = eos::ABILITY_KLUTZ;
+    entity.monster.iq_skill_flags[eos::IQ_AGGRESSOR] = true;
+    entity.monster.exclusive_item_effect_flags[eos::EXCLUSIVE_EFF_MIRACLE_EYE] = true;
+    entity.monster.held_item = {true, false, eos::ITEM_WEATHER_BAND};
+    DungeonState dungeon;
+    dungeon.weather = eos::WEATHER_SUNNY;
+
+    require_resolved_matches(entity, dungeon);
+    SECTION("without Klutz") {
+        entity.monster.abilities[1] = eos::ABILITY_UNKNOWN;
+        require_resolved_matches(entity, dungeon);
+        entity.monster.held_item.sticky = true;
+        require_resolved_matches(entity, dungeon);
+        entity.monster.held_item = {true, false, eos::ITEM_RED_BOW};
+        require_resolved_matches(entity, dungeon);
+    }
+    SECTION("with Gastro Acid") {
+        entity.monster.statuses.gastro_acid = true;
+        require_resolved_matches(entity, dungeon);
+    }
+    SECTION("with IQ disabled") {
+        dungeon.iq_disabled = true;
+        require_resolved_matches(entity, dungeon);
+        entity.monster.is_not_team_member = true;
+        require_resolved_matches(entity, dungeon);
+    }
+}
+
+TEST_CASE("CombatContext applies Mold Breaker to the defender", "[MonsterEntity]") {
+    MonsterEntity attacker;
+    MonsterEntity defender;
+    defender.monster.abilities[0] = eos::ABILITY_WONDER_GUARD;
+    DungeonState dungeon;
+
+    REQUIRE(CombatContext(attacker, defender, dungeon)
+                .defender_ability_active(eos::ABILITY_WONDER_GUARD));
+    attacker.monster.abilities[0] = eos::ABILITY_MOLD_BREAKER;
+    REQUIRE(!defender.ability_active(eos::ABILITY_WONDER_GUARD, attacker, true));
+    CombatContext ctx(attacker, defender, dungeon);
+    REQUIRE(!ctx.defender_ability_active(eos::ABILITY_WONDER_GUARD));
+    REQUIRE(ctx.defender.ability_active(eos::ABILITY_WONDER_GUARD));
+    // Mold Breaker doesn't apply to a monster's own abilities
+    attacker.monster.abilities[1] = eos::ABILITY_WONDER_GUARD;
+    REQUIRE(CombatContext(attacker, attacker, dungeon)
+                .defender_ability_active(eos::ABILITY_WONDER_GUARD));
+}
+
+TEST_CASE("Move handlers are looked up by move", "[helpers]") {
+    for (int i = 0; i < 559; i++) {
+        const MoveHandler& handler = get_move_handler(static_cast<eos::move_id>(i));
+        switch (handler.kind) {
+        case MoveHandlerKind::FIXED_MULT:
+        case MoveHandlerKind::SUCCESSIVE_HITS:
+        case MoveHandlerKind::ATTACKER_HP:
+        case MoveHandlerKind::DEFENDER_HP:
+            REQUIRE(handler.mult);
+            break;
+        case MoveHandlerKind::CONDITIONAL_MULT:
+            REQUIRE(handler.mult);
+            REQUIRE(handler.condition);
+            break;
+        case MoveHandlerKind::CUSTOM:
+            REQUIRE(handler.custom);
+            break;
+        default:
+            break;
+        }
+    }
+    REQUIRE(get_move_handler(eos::MOVE_TACKLE).kind == MoveHandlerKind::DEFAULT);
+    REQUIRE(get_move_handler(eos::MOVE_WEATHER_BALL).kind == MoveHandlerKind::WEATHER_BALL);
+    REQUIRE(get_move_handler(eos::MOVE_NATURAL_GIFT).kind == MoveHandlerKind::NATURAL_GIFT);
+
+    const MoveHandler& rollout = get_move_handler(eos::MOVE_ROLLOUT);
+    REQUIRE(rollout.kind == MoveHandlerKind::SUCCESSIVE_HITS);
+    REQUIRE(rollout.mult == mechanics::ROLLOUT_DAMAGE_MULT_TABLE);
+    REQUIRE(rollout.max_index == 9);
+    REQUIRE(get_move_handler(eos::MOVE_ICE_BALL).mult == rollout.mult);
+
+    const MoveHandler& surf = get_move_handler(eos::MOVE_SURF);
+    REQUIRE(surf.kind == MoveHandlerKind::CONDITIONAL_MULT);
+    MonsterEntity attacker;
+    MonsterEntity defender;
+    REQUIRE(!surf.condition(attacker, defender));
+    defender.monster.statuses.diving = true;
+    REQUIRE(surf.condition(attacker, defender));
+    REQUIRE(surf.mult->val() == 2);
+}
+
 eos::type_matchup get_type_matchup(const DungeonState&, const MonsterEntity&, const MonsterEntity&,
                                    int, eos::type_id);
 TEST_CASE("get_type_matchup() works", "[helpers]") {
@@ -940,3 +1057,443 @@ TEST_CASE("Damage calcs with empirically known scenarios (Charizard + Flygon)",
     REQUIRE(!diag.ghost_immunity_activated);
     REQUIRE(!diag.skull_bash_defense_boost_activated);
 }
+
+namespace {
+// FNV-1a hash of the results of a damage calc, for comparing large numbers of calcs at once
+void hash_calc(uint64_t& hash, const DamageData& details, const DungeonState& dungeon) {
+    const auto& diag = dungeon.damage_calc;
+    const int64_t fields[] = {
+        details.damage,
+        details.type_matchup,
+        details.type,
+        details.category,
+        details.critical_hit,
+        details.full_type_immunity,
+        details.no_damage,
+        details.healed,
+        diag.move_type,
+        diag.move_category,
+        diag.offensive_stat_stage,
+        diag.defensive_stat_stage,
+        diag.offense_calc,
+        diag.defense_calc,
+        diag.damage_calc_at,
+        diag.damage_calc_flv,
+        diag.damage_calc,
+        diag.damage_calc_base,
+        diag.static_damage_mult.get_raw(),
+        diag.item_atk_modifier,
+        diag.item_sp_atk_modifier,
+        diag.ability_offense_modifier,
+        diag.ability_defense_modifier,
+        diag.item_def_modifier,
+        diag.item_sp_def_modifier,
+        diag.stab_boost_activated,
+        diag.sunny_multiplier_activated,
+        diag.fire_move_ability_drop_activated,
+        diag.half_physical_damage_activated,
+        diag.half_special_damage_activated,
+        diag.sniper_activated,
+        dungeon.rng.get_computed_crit_chance(),
+    };
+    for (int64_t field : fields) {
+        for (int i = 0; i < 8; i++) {
+            hash = (hash ^ ((field >> (8 * i)) & 0xFF)) * 0x100000001B3;
+        }
+    }
+}
+} // namespace
+
+TEST_CASE("Damage calcs are unchanged across every move", "[damage_calc]") {
+    // A differential test against the reference implementation of calc_damage(), as a checksum of
+    // the results for every move under a set of scenarios that exercise the category-, type- and
+    // move-dependent branches. If a change to the damage calc is intentional, update the checksum.
+    Monster charizard;
+    charizard.apparent_id = eos::MONSTER_CHARIZARD;
+    charizard.is_not_team_member = false;
+    charizard.is_team_leader = true;
+    charizard.level = 50;
+    charizard.max_hp_stat = 128;
+    charizard.hp = 30;
+    charizard.offensive_stats[0] = 73;
+    charizard.offensive_stats[1] = 80;
+    charizard.defensive_stats[0] = 69;
+    charizard.defensive_stats[1] = 68;
+    charizard.types[0] = eos::TYPE_FIRE;
+    charizard.types[1] = eos::TYPE_FLYING;
+    charizard.abilities[0] = eos::ABILITY_BLAZE;
+    charizard.belly = 100;
+    charizard.n_moves_out_of_pp = 2;
+
+    Monster flygon;
+    flygon.apparent_id = eos::MONSTER_FLYGON;
+    flygon.is_not_team_member = true;
+    flygon.is_team_leader = false;
+    flygon.level = 45;
+    flygon.max_hp_stat = 150;
+    flygon.hp = 60;
+    flygon.offensive_stats[0] = 80;
+    flygon.offensive_stats[1] = 70;
+    flygon.defensive_stats[0] = 75;
+    flygon.defensive_stats[1] = 72;
+    flygon.types[0] = eos::TYPE_GROUND;
+    flygon.types[1] = eos::TYPE_DRAGON;
+    flygon.belly = 100;
+
+    // Each scenario tweaks the monsters and dungeon before the calc
+    using Scenario = void (*)(MonsterEntity&, MonsterEntity&, DungeonState&);
+    const Scenario scenarios[] = {
+        [](MonsterEntity&, MonsterEntity&, DungeonState&) {},
+        [](MonsterEntity& atk, MonsterEntity& def, DungeonState& dungeon) {
+            atk.monster.abilities[1] = eos::ABILITY_HUGE_POWER;
+            atk.monster.held_item = {true, false, eos::ITEM_POWER_BAND};
+            def.monster.held_item = {true, false, eos::ITEM_DEF_SCARF};
+            def.monster.statuses.reflect = true;
+            dungeon.rng.huge_pure_power = true;
+            dungeon.rng.critical_hit = true;
+        },
+        [](MonsterEntity& atk, MonsterEntity& def, DungeonState& dungeon) {
+            atk.monster.abilities[1] = eos::ABILITY_PLUS;
+            atk.monster.held_item = {true, false, eos::ITEM_SPECIAL_BAND};
+            def.monster.held_item = {true, false, eos::ITEM_ZINC_BAND};
+            def.monster.statuses.light_screen = true;
+            dungeon.minus_is_active[1] = true;
+            dungeon.weather = eos::WEATHER_SUNNY;
+        },
+        [](MonsterEntity& atk, MonsterEntity& def, DungeonState& dungeon) {
+            atk.monster.abilities[1] = eos::ABILITY_GUTS;
+            atk.monster.statuses.burn = true;
+            atk.monster.held_item = {true, false, eos::ITEM_RED_BOW};
+            def.monster.abilities[0] = eos::ABILITY_INTIMIDATE;
+            def.monster.abilities[1] = eos::ABILITY_MARVEL_SCALE;
+            def.monster.statuses.poison = true;
+            def.monster.held_item = {true, false, eos::ITEM_BLUE_BOW};
+            dungeon.weather = eos::WEATHER_RAIN;
+        },
+        [](MonsterEntity& atk, MonsterEntity& def, DungeonState& dungeon) {
+            atk.monster.abilities[1] = eos::ABILITY_DOWNLOAD;
+            atk.monster.iq_skill_flags[eos::IQ_AGGRESSOR] = true;
+            atk.monster.stat_modifiers.flash_fire_boost = 1;
+            def.monster.abilities[0] = eos::ABILITY_THICK_FAT;
+            def.monster.iq_skill_flags[eos::IQ_COUNTER_BASHER] = true;
+            def.monster.statuses.skull_bash = true;
+            dungeon.weather = eos::WEATHER_SANDSTORM;
+            dungeon.rng.critical_hit = true;
+        },
+        [](MonsterEntity& atk, MonsterEntity& def, DungeonState& dungeon) {
+            atk.monster.abilities[1] = eos::ABILITY_NORMALIZE;
+            atk.monster.abilities[0] = eos::ABILITY_SNIPER;
+            def.monster.abilities[0] = eos::ABILITY_WONDER_GUARD;
+            dungeon.version = versions::JP;
+            dungeon.rng.critical_hit = true;
+        },
+    };
+
+    uint64_t hash = 0xCBF29CE484222325;
+    for (Scenario scenario : scenarios) {
+        for (int i = 0; i < 559; i++) {
+            MonsterEntity attacker{charizard};
+            MonsterEntity defender{flygon};
+            DungeonState dungeon;
+            dungeon.rng.variance_dial = 0.5;
+            scenario(attacker, defender, dungeon);
+            DamageData details;
+            simulate_damage_calc(details, dungeon, attacker, defender,
+                                 Move{static_cast<eos::move_id>(i), 0, 10});
+            hash_calc(hash, details, dungeon);
+        }
+        MonsterEntity attacker{charizard};
+        MonsterEntity defender{flygon};
+        DungeonState dungeon;
+        scenario(attacker, defender, dungeon);
+        DamageData details;
+        simulate_damage_calc_projectile(details, dungeon, attacker, defender, 10);
+        hash_calc(hash, details, dungeon);
+    }
+    REQUIRE(hash == 0x93F4E77F8334CD23);
+}
+
+TEST_CASE("The base damage memo doesn't change results", "[damage_calc]") {
+    Monster attacker_monster;
+    attacker_monster.apparent_id = eos::MONSTER_CHARIZARD;
+    attacker_monster.level = 50;
+    attacker_monster.max_hp_stat = 128;
+    attacker_monster.hp = attacker_monster.max_hp_stat;
+    attacker_monster.offensive_stats[1] = 80;
+    attacker_monster.types[0] = eos::TYPE_FIRE;
+    attacker_monster.belly = 100;
+
+    Monster defender_monster;
+    defender_monster.apparent_id = eos::MONSTER_BULBASAUR;
+    defender_monster.level = 50;
+    defender_monster.max_hp_stat = 130;
+    defender_monster.hp = defender_monster.max_hp_stat;
+    defender_monster.defensive_stats[1] = 64;
+    defender_monster.types[0] = eos::TYPE_GRASS;
+    defender_monster.belly = 100;
+
+    auto calc = [&](bool is_enemy, eos::fixed_room_id fixed_room) {
+        MonsterEntity attacker{attacker_monster};
+        attacker.monster.is_not_team_member = is_enemy;
+        MonsterEntity defender{defender_monster};
+        DungeonState dungeon;
+        dungeon.rng.variance_dial = 0.5;
+        dungeon.gen_info.fixed_room_id = fixed_room;
+        DamageData details;
+        return simulate_damage_calc(details, dungeon, attacker, defender,
+                                    Move{eos::MOVE_FLAMETHROWER, 0, 10});
+    };
+
+    reset_base_damage_memo_stats();
+    int32_t ally = calc(false, eos::FIXED_NONE);
+    int32_t enemy = calc(true, eos::FIXED_NONE);
+    int32_t enemy_in_substitute_room = calc(true, eos::FIXED_SUBSTITUTE_ROOM);
+    auto stats = base_damage_memo_stats();
+    REQUIRE(stats.hits + stats.misses == 3);
+
+    // The enemy divisor is part of the key, so the same stats don't share a memo entry
+    REQUIRE(enemy < ally);
+    REQUIRE(enemy_in_substitute_room == ally);
+
+    REQUIRE(calc(false, eos::FIXED_NONE) == ally);
+    REQUIRE(calc(true, eos::FIXED_NONE) == enemy);
+    REQUIRE(calc(true, eos::FIXED_SUBSTITUTE_ROOM) == enemy_in_substitute_room);
+    auto repeat_stats = base_damage_memo_stats();
+    REQUIRE(repeat_stats.hits == stats.hits + 3);
+    REQUIRE(repeat_stats.misses == stats.misses);
+}
+
+TEST_CASE("Reference mode skips the shortcuts without changing results", "[damage_calc]") {
+    Monster attacker_monster;
+    attacker_monster.apparent_id = eos::MONSTER_CHARIZARD;
+    attacker_monster.is_not_team_member = true; // For the enemy divisor
+    attacker_monster.max_hp_stat = 128;
+    attacker_monster.hp = attacker_monster.max_hp_stat;
+    attacker_monster.offensive_stats[1] = 80;
+    attacker_monster.types[0] = eos::TYPE_FIRE;
+    attacker_monster.belly = 100;
+
+    Monster defender_monster;
+    defender_monster.apparent_id = eos::MONSTER_BULBASAUR;
+    defender_monster.level = 50;
+    defender_monster.max_hp_stat = 130;
+    defender_monster.hp = defender_monster.max_hp_stat;
+    defender_monster.defensive_stats[1] = 64;
+    defender_monster.types[0] = eos::TYPE_GRASS;
+    defender_monster.belly = 100;
+
+    auto calc = [&](uint8_t level, int16_t stage) {
+        MonsterEntity attacker{attacker_monster};
+        attacker.monster.level = level;
+        attacker.monster.stat_modifiers.offensive_stages[1] = stage;
+        MonsterEntity defender{defender_monster};
+        defender.monster.stat_modifiers.defensive_stages[1] = 20 - stage;
+        DungeonState dungeon;
+        dungeon.rng.variance_dial = 0.5;
+        DamageData details;
+        return simulate_damage_calc(details, dungeon, attacker, defender,
+                                    Move{eos::MOVE_FLAMETHROWER, 0, 10});
+    };
+
+    REQUIRE_FALSE(reference_mode());
+    for (uint8_t level : {1, 25, 50, 100}) {
+        for (int16_t stage = 0; stage <= 20; stage++) {
+            int32_t damage = calc(level, stage);
+            set_reference_mode(true);
+            reset_base_damage_memo_stats();
+            int32_t reference_damage = calc(level, stage);
+            auto stats = base_damage_memo_stats();
+            set_reference_mode(false);
+            REQUIRE(reference_damage == damage);
+            REQUIRE(stats.hits + stats.misses == 0);
+        }
+    }
+}
+
+TEST_CASE("simulate_damage_branches() splits on the rolls that happen", "[damage_calc]") {
+    Monster attacker_monster;
+    attacker_monster.apparent_id = eos::MONSTER_MARILL;
+    attacker_monster.level = 30;
+    attacker_monster.max_hp_stat = 80;
+    attacker_monster.hp = attacker_monster.max_hp_stat;
+    attacker_monster.offensive_stats[0] = 40;
+    attacker_monster.types[0] = eos::TYPE_WATER;
+    attacker_monster.belly = 100;
+
+    Monster defender_monster;
+    defender_monster.apparent_id = eos::MONSTER_GEODUDE;
+    defender_monster.level = 30;
+    defender_monster.max_hp_stat = 80;
+    defender_monster.hp = defender_monster.max_hp_stat;
+    defender_monster.defensive_stats[0] = 50;
+    defender_monster.types[0] = eos::TYPE_ROCK;
+    defender_monster.belly = 100;
+
+    DungeonState dungeon;
+    dungeon.rng.variance_dial = 0.5;
+    Move tackle{eos::MOVE_TACKLE, 0, 10};
+
+    SECTION("Crits only") {
+        MonsterEntity attacker{attacker_monster};
+        MonsterEntity defender{defender_monster};
+        auto branches = simulate_damage_branches(dungeon, attacker, defender, tackle);
+        int32_t crit_chance = branches[1].dungeon.rng.get_computed_crit_chance();
+        REQUIRE(branches.size() == 2);
+        REQUIRE(!branches[0].critical_hit);
+        REQUIRE(branches[0].chance == 100 * (100 - crit_chance));
+        REQUIRE(branches[1].details.critical_hit);
+        REQUIRE(branches[1].chance == 100 * crit_chance);
+        REQUIRE(branches[0].damage < branches[1].damage);
+    }
+    SECTION("Crits and Huge Power") {
+        attacker_monster.abilities[0] = eos::ABILITY_HUGE_POWER;
+        MonsterEntity attacker{attacker_monster};
+        MonsterEntity defender{defender_monster};
+        auto branches = simulate_damage_branches(dungeon, attacker, defender, tackle);
+        REQUIRE(branches.size() == 4);
+        int32_t total_chance = 0;
+        for (const auto& branch : branches) {
+            total_chance += branch.chance;
+            MonsterEntity forced_attacker{attacker_monster};
+            MonsterEntity forced_defender{defender_monster};
+            DungeonState forced_dungeon = dungeon;
+            forced_dungeon.rng.huge_pure_power = branch.huge_pure_power;
+            forced_dungeon.rng.critical_hit = branch.critical_hit;
+            DamageData details;
+            REQUIRE(branch.damage == simulate_damage_calc(details, forced_dungeon, forced_attacker,
+                                                          forced_defender, tackle));
+            REQUIRE(branch.details.critical_hit == details.critical_hit);
+            REQUIRE(branch.dungeon.damage_calc.offense_calc ==
+                    forced_dungeon.damage_calc.offense_calc);
+            REQUIRE(branch.dungeon.damage_calc.damage_calc ==
+                    forced_dungeon.damage_calc.damage_calc);
+            // The lowest and highest damage rolls are finished from the same calc
+            for (double variance_dial : {0.0, 1.0}) {
+                MonsterEntity roll_attacker{attacker_monster};
+                MonsterEntity roll_defender{defender_monster};
+                forced_dungeon = dungeon;
+                forced_dungeon.rng.huge_pure_power = branch.huge_pure_power;
+                forced_dungeon.rng.critical_hit = branch.critical_hit;
+                forced_dungeon.rng.variance_dial = variance_dial;
+                simulate_damage_calc(details, forced_dungeon, roll_attacker, roll_defender, tackle);
+                REQUIRE((variance_dial == 0 ? branch.min_roll_damage : branch.max_roll_damage) ==
+                        details.damage);
+            }
+        }
+        REQUIRE(total_chance == 10000);
+        REQUIRE(branches[2].huge_pure_power);
+        REQUIRE(branches[2].chance + branches[3].chance == 3300);
+    }
+    SECTION("Neither roll") {
+        // Soundproof makes sound moves miss before the damage calc
+        defender_monster.abilities[0] = eos::ABILITY_SOUNDPROOF;
+        MonsterEntity attacker{attacker_monster};
+        MonsterEntity defender{defender_monster};
+        auto branches =
+            simulate_damage_branches(dungeon, attacker, defender, Move{eos::MOVE_GROWL, 0, 10});
+        REQUIRE(branches.size() == 1);
+        REQUIRE(branches[0].chance == 10000);
+        REQUIRE(branches[0].damage == 0);
+    }
+}
+
+TEST_CASE("hit_chance_table() matches the hit checks", "[damage_calc]") {
+    Monster charizard;
+    charizard.apparent_id = eos::MONSTER_CHARIZARD;
+    charizard.is_team_leader = true;
+    charizard.level = 50;
+    charizard.max_hp_stat = 128;
+    charizard.hp = charizard.max_hp_stat;
+    charizard.offensive_stats[0] = 73;
+    charizard.offensive_stats[1] = 80;
+    charizard.types[0] = eos::TYPE_FIRE;
+    charizard.types[1] = eos::TYPE_FLYING;
+    charizard.belly = 100;
+
+    Monster bulbasaur;
+    bulbasaur.apparent_id = eos::MONSTER_BULBASAUR;
+    bulbasaur.is_not_team_member = true;
+    bulbasaur.level = 50;
+    bulbasaur.max_hp_stat = 130;
+    bulbasaur.hp = bulbasaur.max_hp_stat;
+    bulbasaur.defensive_stats[0] = 64;
+    bulbasaur.defensive_stats[1] = 64;
+    bulbasaur.types[0] = eos::TYPE_GRASS;
+    bulbasaur.types[1] = eos::TYPE_POISON;
+    bulbasaur.belly = 100;
+
+    MonsterEntity attacker{charizard};
+    MonsterEntity defender{bulbasaur};
+    DungeonState dungeon;
+
+    // Every entry should be what a simulated damage calc reports at those stages
+    auto require_table_matches = [&](eos::move_id move) {
+        auto table = hit_chance_table(dungeon, attacker, defender, move);
+        for (int16_t accuracy_stage = 0; accuracy_stage < 21; accuracy_stage += 4) {
+            for (int16_t evasion_stage = 0; evasion_stage < 21; evasion_stage += 5) {
+                MonsterEntity atk = attacker;
+                MonsterEntity def = defender;
+                DungeonState d = dungeon;
+                atk.monster.stat_modifiers.hit_chance_stages[0] = accuracy_stage;
+                def.monster.stat_modifiers.hit_chance_stages[1] = evasion_stage;
+                DamageData details;
+                simulate_damage_calc(details, d, atk, def, Move{move});
+                auto& diag = d.damage_calc;
+                bool miss = diag.two_turn_move_forced_miss || diag.soundproof_activated ||
+                            diag.first_hit_check_failed || diag.lightningrod_activated ||
+                            diag.storm_drain_activated;
+                REQUIRE(table[accuracy_stage][evasion_stage] ==
+                        (miss ? 0 : d.rng.get_combined_hit_chance_raw()));
+            }
+        }
+        return table;
+    };
+
+    SECTION("Both accuracy rolls") {
+        auto table = require_table_matches(eos::MOVE_ZAP_CANNON);
+        // trunc(95 * 1.02734375) and trunc(65 * 1.02734375)
+        REQUIRE(table[10][10] == 97 * 66 * 100);
+        REQUIRE(table[20][0] == 100 * 100 * 100);
+        REQUIRE(table[0][20] < table[10][10]);
+    }
+    SECTION("Forewarn") {
+        defender.monster.abilities[0] = eos::ABILITY_FOREWARN;
+        auto table = require_table_matches(eos::MOVE_ZAP_CANNON);
+        REQUIRE(table[10][10] == 97 * 66 * 80);
+    }
+    SECTION("Hit chances below 0 can never hit") {
+        defender.monster.held_item = {true, false, eos::ITEM_DETECT_BAND};
+        defender.monster.iq_skill_flags[eos::IQ_QUICK_DODGER] = true;
+        // Fissure's first accuracy is 20, so the drops take it below 0
+        auto table = require_table_matches(eos::MOVE_FISSURE);
+        REQUIRE(table[20][0] == 0);
+        REQUIRE(MockDungeonRNG::roll_success_chance(-5) == 0);
+        REQUIRE(MockDungeonRNG::roll_success_chance(150) == 100);
+    }
+    SECTION("No Guard") {
+        attacker.monster.abilities[0] = eos::ABILITY_NO_GUARD;
+        auto table = require_table_matches(eos::MOVE_ZAP_CANNON);
+        REQUIRE(table[0][20] == table[20][0]);
+        REQUIRE(table[0][20] == table[10][10]);
+    }
+    SECTION("Early returns") {
+        dungeon.weather = eos::WEATHER_RAIN;
+        auto table = require_table_matches(eos::MOVE_THUNDER);
+        REQUIRE(table[0][20] == 100 * 100 * 100);
+        dungeon.weather = eos::WEATHER_HAIL;
+        table = require_table_matches(eos::MOVE_BLIZZARD);
+        REQUIRE(table[0][20] == 100 * 100 * 100);
+
+        attacker.monster.statuses.whiffer = true;
+        table = require_table_matches(eos::MOVE_ZAP_CANNON);
+        REQUIRE(table[20][0] == 0);
+        attacker.monster.statuses.sure_shot = true;
+        table = require_table_matches(eos::MOVE_ZAP_CANNON);
+        REQUIRE(table[0][20] == 100 * 100 * 100);
+    }
+    SECTION("Prechecks that always miss") {
+        defender.monster.abilities[0] = eos::ABILITY_SOUNDPROOF;
+        auto table = hit_chance_table(dungeon, attacker, defender, eos::MOVE_HYPER_VOICE);
+        REQUIRE(table[20][0] == 0);
+    }
+}
@@ -2,9 +2,12 @@
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <vector>
 
 #include "CLI/App.hpp"
 #include "CLI/Formatter.hpp"
@@ -12,21 +15,164 @@
 #include <nlohmann/json.hpp>
 using nlohmann::json;
 
+#include "batch.hpp"
+#include "calcresult.hpp"
 #include "cfgparse.hpp"
 #include "damage.hpp"
 #include "idmap.hpp"
+#include "overlay.hpp"
+#include "search.hpp"
+#include "server.hpp"
+#include "sweep.hpp"
+#include "wire.hpp"
 
 std::string monster_summary(const Monster& monster);
+int search_names(const std::string& kind, const std::string& query, std::size_t limit);
+int encode_configs(std::istream& in, bool details);
+int run_sweep(const std::string& filename, const std::string& format);
+int run_server(const server::Options& options, const std::string& socket_path,
+               const std::vector<std::string>& base_specs);
 
 int main(int argc, char** argv) {
     CLI::App app{"Damage calculator for Pokémon Mystery Dungeon: Explorers of Sky"};
 
     std::string filename = "config.json";
     int verbose = 0;
-    app.add_option("-i, --input-file", filename, "Input config file");
-    app.add_flag("-v, --verbose", verbose, "Verbose output, can be specified up to 3 times");
+    bool batch_mode = false;
+    bool binary = false;
+    unsigned jobs = std::thread::hardware_concurrency();
+    CLI::Option* input_opt = app.add_option("-i, --input-file", filename, "Input config file");
+    app.add_flag("-v, --verbose", verbose,
+                 "Verbose output, can be specified up to 3 times. In batch mode, writes the base "
+                 "damage memo hit rate to stderr at the end");
+    bool show_branches = false;
+    app.add_flag("--branches", show_branches,
+                 "Also show the damage on every branch of the Huge Power/Pure Power and critical "
+                 "hit rolls, with the chance of each, whatever the config says about them");
+    bool show_versions = false;
+    app.add_flag("--versions", show_versions,
+                 "Also show how the results change in every other game version and with the other "
+                 "move power table (Sky or Time/Darkness)");
+    app.add_flag("--batch", batch_mode,
+                 "Read one JSON config per line (from stdin if there's no input file, or if it's "
+                 "\"-\"), and write one JSON result per line");
+    app.add_flag("--binary", binary,
+                 "In batch mode, read binary request records and write binary result records "
+                 "instead of JSON (see `encode`)");
+    app.add_option("-j, --jobs", jobs, "Number of threads to use in batch mode");
+    std::string format = "jsonl";
+    const std::vector<std::string> formats = {"jsonl", "csv", "arrow"};
+    app.add_option("--format", format,
+                   "In batch mode, write results as JSON lines, or as a table in CSV or Arrow IPC "
+                   "stream format")
+        ->check(CLI::IsMember(formats))
+        ->capture_default_str();
+    std::vector<std::string> base_specs;
+    app.add_option("--base", base_specs,
+                   "In batch mode, load a base config from a file, as NAME=FILE. Configs with a "
+                   "\"base\": NAME field are overlays (JSON merge patches) on the base config");
+
+    std::string search_kind;
+    std::string search_query;
+    std::size_t search_limit = 10;
+    std::string search_kinds;
+    for (auto kind : search::KINDS) {
+        search_kinds += (search_kinds.empty() ? "" : ", ") + std::string(kind);
+    }
+    CLI::App* search_cmd = app.add_subcommand("search", "Search for names by prefix");
+    search_cmd->add_option("kind", search_kind, "Kind of name: " + search_kinds)->required();
+    search_cmd->add_option("query", search_query, "Name prefix to search for");
+    search_cmd->add_option("-n, --limit", search_limit, "Maximum number of results");
+
+    bool encode_details = false;
+    CLI::App* encode_cmd = app.add_subcommand(
+        "encode", "Convert JSON configs, one per line, to binary request records for --binary. "
+                  "Integer \"id\" fields are stored as the request tag");
+    encode_cmd->add_flag("-d, --details", encode_details,
+                         "Request calculation details in the results");
+
+    std::string sweep_filename;
+    CLI::App* sweep_cmd = app.add_subcommand(
+        "sweep", "Calculate every combination of values in a sweep spec, and write one JSON row "
+                 "per combination");
+    sweep_cmd->add_option("spec", sweep_filename, "Sweep spec file")->required();
+    sweep_cmd
+        ->add_option("--format", format,
+                     "Write rows as JSON lines, or as a table in CSV or Arrow IPC stream format")
+        ->check(CLI::IsMember(formats))
+        ->capture_default_str();
+
+    std::string socket_path;
+    bool length_prefixed = false;
+    server::Options server_options;
+    CLI::App* serve_cmd = app.add_subcommand(
+        "serve", "Keep calculating configs as they arrive on stdin (or a Unix domain socket), and "
+                 "write each result as soon as it's ready, in order. A {\"command\": \"stats\"} "
+                 "request gets the queue depth and latency percentiles");
+    serve_cmd->add_option("-s, --socket", socket_path,
+                          "Listen on a Unix domain socket at this path instead of using stdin");
+    serve_cmd->add_flag("-l, --length-prefixed", length_prefixed,
+                        "Frame requests and results with a 4-byte little-endian size instead of "
+                        "newlines");
+    serve_cmd->add_option("-q, --max-queue", server_options.max_queue,
+                          "Maximum number of requests waiting for a worker, or in flight on one "
+                          "connection, before reading requests is paused");
+    serve_cmd->fallthrough();
     CLI11_PARSE(app, argc, argv);
 
+    if (*sweep_cmd) {
+        return run_sweep(sweep_filename, format);
+    }
+    if (*serve_cmd) {
+        server_options.n_threads = jobs;
+        server_options.framing =
+            length_prefixed ? server::Framing::LENGTH_PREFIXED : server::Framing::LINES;
+        return run_server(server_options, socket_path, base_specs);
+    }
+    if (*search_cmd) {
+        return search_names(search_kind, search_query, search_limit);
+    }
+    if (batch_mode || *encode_cmd) {
+        std::ios::sync_with_stdio(false);
+        std::ifstream batch_file;
+        if (input_opt->count() > 0 && filename != "-") {
+            batch_file.open(filename, std::ios::binary);
+            if (batch_file.fail()) {
+                std::cerr << "error: could not find batch file '" << filename << "'" << std::endl;
+                return 1;
+            }
+        }
+        std::istream& in = batch_file.is_open() ? batch_file : std::cin;
+        if (*encode_cmd) {
+            return encode_configs(in, encode_details);
+        }
+        try {
+            BaseDamageMemoStats memo_stats;
+            if (binary) {
+                if (format != "jsonl") {
+                    std::cerr << "error: --format can't be used with --binary" << std::endl;
+                    return 1;
+                }
+                memo_stats = batch::run_binary_batch(in, std::cout, jobs);
+            } else if (format != "jsonl") {
+                memo_stats = batch::run_batch(in, std::cout, jobs,
+                                              overlay::load_base_configs(base_specs), format);
+            } else {
+                memo_stats = batch::run_batch(in, std::cout, jobs,
+                                              overlay::load_base_configs(base_specs));
+            }
+            if (verbose >= 1) {
+                std::cerr << "base damage memo: " << memo_stats.hits << " hits, "
+                          << memo_stats.misses << " misses (" << 100 * memo_stats.hit_rate()
+                          << "% hit rate)" << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     std::ifstream cfg_file(filename);
     if (cfg_file.fail()) {
         std::cerr << "error: could not find config file '" << filename << "'" << std::endl;
@@ -37,7 +183,16 @@ int main(int argc, char** argv) {
     json cfg = json::parse(cfg_file);
 
     try {
-        auto [dungeon, attacker, defender, move, attack_power] = parse_cfg(cfg);
+        auto inputs = parse_cfg(cfg);
+        auto run = batch::run_calc(inputs);
+        const auto& dungeon = run.dungeon;
+        const auto& dungeon_max = run.dungeon_max;
+        const auto& attacker = run.attacker;
+        const auto& defender = run.defender;
+        const auto& move = run.move;
+        const auto& details = run.details;
+        const auto& details_max_var = run.details_max_var;
+
         auto move_spec = mechanics::MoveSpec(move.id);
         if (move_spec.unsupported) {
             std::cerr << "warning: move '" << ids::MOVE[move.id]
@@ -55,47 +210,39 @@ int main(int argc, char** argv) {
             std::cerr << "warning: defender status configuration is impossible" << std::endl;
         }
 
-        // Copy for a second damage calc since the inputs can be modified by the simulation
-        DungeonState dungeon_max = dungeon;
-        MonsterEntity attacker_max = attacker;
-        MonsterEntity defender_max = defender;
-        Move move_max = move;
-
-        dungeon.rng.variance_dial = 0;     // minimum damage roll
-        dungeon_max.rng.variance_dial = 1; // maximum damage roll
-
-        DamageData details = {};
-        DamageData details_max_var = {};
-        int32_t damage = 0;
-        int32_t damage_max_var = 0;
-        if (move.id == eos::MOVE_PROJECTILE) {
-            damage =
-                simulate_damage_calc_projectile(details, dungeon, attacker, defender, attack_power);
-            damage_max_var = simulate_damage_calc_projectile(
-                details_max_var, dungeon_max, attacker_max, defender_max, attack_power);
-        } else {
-            damage = simulate_damage_calc(details, dungeon, attacker, defender, move);
-            damage_max_var = simulate_damage_calc(details_max_var, dungeon_max, attacker_max,
-                                                  defender_max, move_max);
-        }
-
         std::cout << std::boolalpha;
         if (details.healed) {
             std::cout << "healed: [" << details.damage << ", " << details_max_var.damage << "]"
                       << std::endl;
         } else {
-            std::cout << "damage: [" << damage << ", " << damage_max_var << "]" << std::endl;
+            std::cout << "damage: [" << run.damage << ", " << run.damage_max_var << "]"
+                      << std::endl;
         }
-        if (dungeon.damage_calc.two_turn_move_forced_miss ||
-            dungeon.damage_calc.soundproof_activated ||
-            dungeon.damage_calc.first_hit_check_failed || dungeon.damage_calc.dream_eater_failed ||
-            dungeon.damage_calc.last_resort_failed) {
+        if (run.guaranteed_miss()) {
             std::cout << "hit chance: guaranteed miss" << std::endl;
             return 0;
         }
         std::cout << "hit chance: " << dungeon.rng.get_combined_hit_percentage() << "%"
                   << std::endl;
         std::cout << "crit chance: " << dungeon.rng.get_computed_crit_chance() << "%" << std::endl;
+        if (show_branches) {
+            std::cout << "branches:" << std::endl;
+            for (const auto& branch : calcresult::damage_branches(inputs)) {
+                std::cout << "  " << (branch.huge_pure_power ? "Huge/Pure Power, " : "")
+                          << (branch.critical_hit ? "crit" : "no crit") << " (" << branch.chance
+                          << "%): " << (branch.healed ? "healed " : "") << "["
+                          << branch.min_damage << ", " << branch.max_damage << "]" << std::endl;
+            }
+        }
+        if (show_versions) {
+            std::cout << "versions:" << std::endl;
+            for (const auto& entry : batch::diff_versions(inputs)) {
+                const auto& diff = entry.at("diff");
+                std::cout << "  " << entry.at("version").get<std::string>()
+                          << (entry.at("time_darkness").get<bool>() ? ", Time/Darkness" : ", Sky")
+                          << ": " << (diff.empty() ? "same" : diff.dump()) << std::endl;
+            }
+        }
 
         const auto& calc = dungeon.damage_calc;
         if (verbose >= 1) {
@@ -215,13 +362,92 @@ int main(int argc, char** argv) {
     }
 }
 
+int search_names(const std::string& kind, const std::string& query, std::size_t limit) {
+    try {
+        for (auto& match : search::search(kind, query, limit)) {
+            std::cout << match.name;
+            if (match.matched != match.name) {
+                std::cout << " (" << match.matched << ")";
+            }
+            std::cout << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int encode_configs(std::istream& in, bool details) {
+    cfgparse::ConfigTape tape;
+    std::size_t line_number = 0;
+    for (std::string line; std::getline(in, line);) {
+        line_number++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        try {
+            tape.clear();
+            auto cfg = tape.parse(line);
+            uint32_t tag = cfg.contains("id") ? cfg.at("id").get<uint32_t>() : 0;
+            uint32_t flags = details ? uint32_t(wire::REQUEST_DETAILS) : 0u;
+            auto req = wire::encode_request(cfg, tag, flags);
+            std::cout.write(reinterpret_cast<const char*>(&req), sizeof(req));
+        } catch (const std::exception& e) {
+            std::cerr << "error: line " << line_number << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int run_server(const server::Options& options, const std::string& socket_path,
+               const std::vector<std::string>& base_specs) {
+    try {
+        overlay::BaseConfigs bases = overlay::load_base_configs(base_specs);
+        server::Server server(options, bases);
+        if (!socket_path.empty()) {
+            server::serve_unix_socket(server, socket_path);
+        } else {
+            std::ios::sync_with_stdio(false);
+            server.serve(std::cin, std::cout);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int run_sweep(const std::string& filename, const std::string& format) {
+    std::ifstream spec_file(filename);
+    if (spec_file.fail()) {
+        std::cerr << "error: could not find sweep spec '" << filename << "'" << std::endl;
+        return 1;
+    }
+    try {
+        sweep::Sweep s(json::parse(spec_file));
+        std::ios::sync_with_stdio(false);
+        if (format != "jsonl") {
+            sweep::write_table(s, format, std::cout);
+        } else {
+            sweep::write_rows(s, std::cout);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
 std::string monster_summary(const Monster& monster) {
-    std::string summary =
-        "Lv. " + std::to_string(monster.level) + " " + ids::MONSTER[monster.apparent_id] + ", " +
-        (monster.is_not_team_member ? "enemy" : "team") + (monster.is_team_leader ? " leader" : "");
+    std::string summary = "Lv. " + std::to_string(monster.level) + " ";
+    summary += ids::MONSTER[monster.apparent_id];
+    summary += std::string(", ") + (monster.is_not_team_member ? "enemy" : "team") +
+               (monster.is_team_leader ? " leader" : "");
     if (monster.held_item.exists && monster.held_item.id != eos::ITEM_NOTHING) {
-        summary += std::string(", holding ") + (monster.held_item.sticky ? "sticky " : "") +
-                   ids::ITEM[monster.held_item.id];
+        summary += std::string(", holding ") + (monster.held_item.sticky ? "sticky " : "");
+        summary += ids::ITEM[monster.held_item.id];
     }
     return summary;
 }
@@ -0,0 +1,63 @@
+// HTTP server for EoS damage calculation (see api.hpp)
+
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CLI/App.hpp"
+#include "CLI/Formatter.hpp"
+#include "CLI/Config.hpp"
+
+#include "api.hpp"
+#include "http.hpp"
+#include "overlay.hpp"
+
+namespace {
+http::Server* running_server = nullptr;
+
+extern "C" void stop_server(int) {
+    if (running_server) {
+        running_server->stop();
+    }
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    CLI::App app{"HTTP server for the Pokémon Mystery Dungeon: Explorers of Sky damage calculator. "
+                 "Endpoints: POST /calc, /calc/batch, /distribution, /versions and /matrix, and "
+                 "GET /stats"};
+
+    http::Options options;
+    options.n_threads = std::thread::hardware_concurrency();
+    std::size_t max_matrix_size = 100000;
+    std::vector<std::string> base_specs;
+    app.add_option("--host", options.host, "Address to listen on")->capture_default_str();
+    app.add_option("-p, --port", options.port, "Port to listen on")->capture_default_str();
+    app.add_option("-j, --jobs", options.n_threads, "Number of worker threads");
+    app.add_option("--max-body", options.max_body_size, "Maximum request body size in bytes")
+        ->capture_default_str();
+    app.add_option("--max-matrix", max_matrix_size, "Maximum number of points in a /matrix sweep")
+        ->capture_default_str();
+    app.add_option("--base", base_specs,
+                   "Load a base config from a file, as NAME=FILE. Configs with a \"base\": NAME "
+                   "field are overlays (JSON merge patches) on the base config");
+    CLI11_PARSE(app, argc, argv);
+
+    try {
+        overlay::BaseConfigs bases = overlay::load_base_configs(base_specs);
+        http::Server server(options, [&] { return api::Handler(bases, max_matrix_size); });
+        running_server = &server;
+        std::signal(SIGINT, stop_server);
+        std::signal(SIGTERM, stop_server);
+        std::cerr << "listening on http://" << options.host << ":" << server.port() << std::endl;
+        server.run();
+        running_server = nullptr;
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
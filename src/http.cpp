@@ -0,0 +1,518 @@
+#include "http.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <memory>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using nlohmann::json;
+
+namespace http {
+namespace {
+const char* status_text(int status) {
+    switch (status) {
+    case 200:
+        return "OK";
+    case 400:
+        return "Bad Request";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 413:
+        return "Payload Too Large";
+    case 431:
+        return "Request Header Fields Too Large";
+    case 500:
+        return "Internal Server Error";
+    case 501:
+        return "Not Implemented";
+    case 505:
+        return "HTTP Version Not Supported";
+    default:
+        return "";
+    }
+}
+
+std::string lowercase(std::string_view str) {
+    std::string lower(str);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return lower;
+}
+
+std::string_view trim(std::string_view str) {
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+} // namespace
+
+Response error_response(int status, const std::string& message) {
+    return {status, json{{"error", message}}.dump()};
+}
+
+std::string format_response(const Response& response, bool keep_alive) {
+    std::string out = "HTTP/1.1 " + std::to_string(response.status) + " " +
+                      status_text(response.status) + "\r\n";
+    out += "Content-Type: application/json\r\n";
+    out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    out += keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    out += response.body;
+    return out;
+}
+
+void RequestParser::feed(const char* data, std::size_t size) { buffer.append(data, size); }
+
+void RequestParser::parse_header() {
+    std::size_t end = buffer.find("\r\n\r\n");
+    if ((end == std::string::npos ? buffer.size() : end + 4) > max_header_size) {
+        throw Error(431, "request header too large");
+    }
+    if (end == std::string::npos) {
+        return;
+    }
+    std::string_view header(buffer.data(), end);
+    std::size_t line_end = std::min(header.find("\r\n"), header.size());
+    std::string_view line = header.substr(0, line_end);
+    std::size_t sp1 = line.find(' ');
+    std::size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos) {
+        throw Error(400, "malformed request line");
+    }
+    Request request;
+    request.method = line.substr(0, sp1);
+    std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    request.path = target.substr(0, target.find('?'));
+    std::string_view version = line.substr(sp2 + 1);
+    if (version == "HTTP/1.0") {
+        request.keep_alive = false;
+    } else if (version != "HTTP/1.1") {
+        throw Error(505, "unsupported HTTP version '" + std::string(version) + "'");
+    }
+
+    std::size_t content_length = 0;
+    for (std::size_t pos = line_end; pos < header.size();) {
+        std::size_t next = std::min(header.find("\r\n", pos + 2), header.size());
+        std::string_view field = header.substr(pos + 2, next - pos - 2);
+        pos = next;
+        std::size_t colon = field.find(':');
+        if (colon == std::string_view::npos) {
+            throw Error(400, "malformed header field");
+        }
+        std::string name = lowercase(trim(field.substr(0, colon)));
+        std::string value = lowercase(trim(field.substr(colon + 1)));
+        if (name == "content-length") {
+            if (value.empty() || value.size() > 18 ||
+                !std::all_of(value.begin(), value.end(),
+                             [](unsigned char c) { return std::isdigit(c); })) {
+                throw Error(400, "invalid Content-Length");
+            }
+            content_length = std::stoull(value);
+            if (content_length > max_body_size) {
+                throw Error(413, "request body too large");
+            }
+        } else if (name == "transfer-encoding" && value != "identity") {
+            throw Error(501, "unsupported transfer encoding '" + value + "'");
+        } else if (name == "connection") {
+            if (value.find("close") != std::string::npos) {
+                request.keep_alive = false;
+            } else if (value.find("keep-alive") != std::string::npos) {
+                request.keep_alive = true;
+            }
+        } else if (name == "expect" && value == "100-continue") {
+            request.expect_continue = true;
+        }
+    }
+    header_size = end + 4;
+    body_size = content_length;
+    pending = std::move(request);
+}
+
+std::optional<Request> RequestParser::next() {
+    if (!pending) {
+        parse_header();
+        if (!pending) {
+            return std::nullopt;
+        }
+    }
+    if (buffer.size() < header_size + body_size) {
+        return std::nullopt;
+    }
+    std::optional<Request> request = std::move(pending);
+    pending.reset();
+    request->body = buffer.substr(header_size, body_size);
+    buffer.erase(0, header_size + body_size);
+    return request;
+}
+
+void Server::work(Handler handler) {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) {
+                return;
+            }
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        Response response;
+        try {
+            response = handler(job.request);
+        } catch (const std::exception& e) {
+            response = error_response(500, e.what());
+        }
+        base_damage_memo.collect();
+        Done result = {job.connection, format_response(response, job.request.keep_alive),
+                       job.request.keep_alive, job.received};
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.push_back(std::move(result));
+        }
+        wake();
+    }
+}
+
+json Server::stats() {
+    std::size_t queue_depth = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue_depth = queue.size();
+    }
+    return {
+        {"queue_depth", queue_depth},
+        {"workers", workers.size()},
+        {"connections", n_connections.load()},
+        {"requests", latency.count()},
+        {"latency_us",
+         {
+             {"p50", latency.percentile(0.5)},
+             {"p90", latency.percentile(0.9)},
+             {"p99", latency.percentile(0.99)},
+             {"p999", latency.percentile(0.999)},
+             {"max", latency.max()},
+         }},
+        {"base_damage_memo", base_damage_memo.to_json()},
+    };
+}
+
+#ifdef __linux__
+namespace {
+// epoll data for the listening socket and the wakeup eventfd. Connections are numbered after these.
+const uint64_t LISTEN_ID = 0;
+const uint64_t WAKE_ID = 1;
+// Connections stop reading requests while they have this much output that the client hasn't read
+const std::size_t MAX_PENDING_OUTPUT = 1 << 20;
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+} // namespace
+
+struct Server::Connection {
+    int fd;
+    RequestParser parser;
+    std::string out;
+    std::size_t out_pos = 0;
+    bool busy = false;          // A request is being handled by a worker
+    bool closing = false;       // Close once all output has been written
+    bool read_closed = false;   // The client won't send anything else
+    bool continue_sent = false; // A 100 Continue has been sent for the partial request
+    uint32_t events = 0;        // Events the connection is registered for
+
+    Connection(int fd, const Options& options)
+        : fd(fd), parser(options.max_header_size, options.max_body_size) {}
+};
+
+Server::Server(const Options& options, const std::function<Handler()>& make_handler)
+    : options(options) {
+    try {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+        addrinfo* addrs = nullptr;
+        int err = getaddrinfo(options.host.c_str(), std::to_string(options.port).c_str(), &hints,
+                              &addrs);
+        if (err != 0) {
+            throw std::runtime_error("could not resolve '" + options.host +
+                                     "': " + gai_strerror(err));
+        }
+        std::unique_ptr<addrinfo, decltype(&freeaddrinfo)> addrs_guard(addrs, freeaddrinfo);
+        listen_fd = socket(addrs->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd < 0) {
+            throw_errno("socket");
+        }
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(listen_fd, addrs->ai_addr, addrs->ai_addrlen) < 0) {
+            throw_errno("bind");
+        }
+        if (listen(listen_fd, SOMAXCONN) < 0) {
+            throw_errno("listen");
+        }
+        sockaddr_storage bound = {};
+        socklen_t bound_len = sizeof(bound);
+        getsockname(listen_fd, reinterpret_cast<sockaddr*>(&bound), &bound_len);
+        port_ = ntohs(bound.ss_family == AF_INET6
+                          ? reinterpret_cast<sockaddr_in6*>(&bound)->sin6_port
+                          : reinterpret_cast<sockaddr_in*>(&bound)->sin_port);
+
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epoll_fd < 0 || wake_fd < 0) {
+            throw_errno("epoll");
+        }
+        epoll_event listen_event = {EPOLLIN, {}};
+        listen_event.data.u64 = LISTEN_ID;
+        epoll_event wake_event = {EPOLLIN, {}};
+        wake_event.data.u64 = WAKE_ID;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &listen_event) < 0 ||
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &wake_event) < 0) {
+            throw_errno("epoll_ctl");
+        }
+
+        for (unsigned i = 0; i < std::max(options.n_threads, 1u); i++) {
+            workers.emplace_back(&Server::work, this, make_handler());
+        }
+    } catch (...) {
+        shutdown();
+        throw;
+    }
+}
+
+Server::~Server() { shutdown(); }
+
+void Server::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    not_empty.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+    workers.clear();
+    for (int* fd : {&listen_fd, &epoll_fd, &wake_fd}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void Server::wake() {
+    uint64_t one = 1;
+    ssize_t written = write(wake_fd, &one, sizeof(one));
+    (void)written; // Only fails if the counter is already huge, which wakes the loop anyway
+}
+
+void Server::stop() {
+    stop_requested = true;
+    wake();
+}
+
+void Server::run() {
+    std::unordered_map<uint64_t, Connection> connections;
+    uint64_t next_id = WAKE_ID + 1;
+
+    auto close_connection = [&](uint64_t id) {
+        auto it = connections.find(id);
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+        close(it->second.fd);
+        connections.erase(it);
+        n_connections--;
+    };
+    // Write as much pending output as possible. Returns false if the connection was closed.
+    auto flush = [&](uint64_t id, Connection& c) {
+        while (c.out_pos < c.out.size()) {
+            ssize_t n = send(c.fd, c.out.data() + c.out_pos, c.out.size() - c.out_pos,
+                             MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return true;
+                }
+                if (errno == EINTR) {
+                    continue;
+                }
+                close_connection(id);
+                return false;
+            }
+            c.out_pos += n;
+        }
+        c.out.clear();
+        c.out_pos = 0;
+        return true;
+    };
+    // Start on the connection's next request if it isn't busy, write what output it can, and
+    // close it or update what it's waiting for
+    auto advance = [&](uint64_t id, Connection& c) {
+        while (!c.busy && !c.closing && c.out.size() - c.out_pos < MAX_PENDING_OUTPUT) {
+            std::optional<Request> request;
+            try {
+                request = c.parser.next();
+            } catch (const Error& e) {
+                c.out += format_response(error_response(e.status(), e.what()), false);
+                c.closing = true;
+                break;
+            }
+            if (!request) {
+                const Request* partial = c.parser.partial();
+                if (partial && partial->expect_continue && !c.continue_sent) {
+                    c.out += "HTTP/1.1 100 Continue\r\n\r\n";
+                    c.continue_sent = true;
+                }
+                break;
+            }
+            c.continue_sent = false;
+            if (request->method == "GET" && request->path == "/stats") {
+                c.out += format_response({200, stats().dump()}, request->keep_alive);
+                c.closing = !request->keep_alive;
+                continue;
+            }
+            c.busy = true;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push_back({id, std::move(*request), std::chrono::steady_clock::now()});
+            }
+            not_empty.notify_one();
+        }
+        if (!flush(id, c)) {
+            return;
+        }
+        bool has_output = c.out_pos < c.out.size();
+        if (!has_output && !c.busy && (c.closing || c.read_closed)) {
+            close_connection(id);
+            return;
+        }
+        // Only read while a new request could be started, so pipelined requests wait in the
+        // socket rather than in memory
+        bool want_read = !c.busy && !c.closing && !c.read_closed &&
+                         c.out.size() - c.out_pos < MAX_PENDING_OUTPUT;
+        uint32_t events = (want_read ? uint32_t(EPOLLIN | EPOLLRDHUP) : 0u) |
+                          (has_output ? uint32_t(EPOLLOUT) : 0u);
+        if (events != c.events) {
+            epoll_event event = {events, {}};
+            event.data.u64 = id;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c.fd, &event);
+            c.events = events;
+        }
+    };
+
+    std::vector<epoll_event> events(64);
+    std::vector<Done> finished;
+    while (!stop_requested) {
+        int n_events = epoll_wait(epoll_fd, events.data(), events.size(), -1);
+        if (n_events < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("epoll_wait");
+        }
+        for (int e = 0; e < n_events; e++) {
+            uint64_t id = events[e].data.u64;
+            uint32_t flags = events[e].events;
+            if (id == LISTEN_ID) {
+                while (true) {
+                    int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (fd < 0) {
+                        break;
+                    }
+                    int one = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    uint64_t conn_id = next_id++;
+                    Connection& c =
+                        connections.try_emplace(conn_id, fd, options).first->second;
+                    c.events = EPOLLIN | EPOLLRDHUP;
+                    epoll_event event = {c.events, {}};
+                    event.data.u64 = conn_id;
+                    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+                    n_connections++;
+                }
+            } else if (id == WAKE_ID) {
+                uint64_t count;
+                ssize_t n_read = read(wake_fd, &count, sizeof(count));
+                (void)n_read;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished.swap(done);
+                }
+                auto now = std::chrono::steady_clock::now();
+                for (auto& result : finished) {
+                    latency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                                       now - result.received)
+                                       .count());
+                    // The connection might have been closed while its request was handled
+                    auto it = connections.find(result.connection);
+                    if (it == connections.end()) {
+                        continue;
+                    }
+                    Connection& c = it->second;
+                    c.busy = false;
+                    c.out += result.response;
+                    c.closing = c.closing || !result.keep_alive;
+                    advance(result.connection, c);
+                }
+                finished.clear();
+            } else {
+                auto it = connections.find(id);
+                if (it == connections.end()) {
+                    continue;
+                }
+                Connection& c = it->second;
+                if (flags & (EPOLLERR | EPOLLHUP)) {
+                    close_connection(id);
+                    continue;
+                }
+                if (flags & (EPOLLIN | EPOLLRDHUP)) {
+                    char buf[64 * 1024];
+                    ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+                    if (n > 0) {
+                        c.parser.feed(buf, n);
+                    } else if (n == 0) {
+                        c.read_closed = true;
+                    } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                        close_connection(id);
+                        continue;
+                    }
+                }
+                advance(id, c);
+            }
+        }
+    }
+    for (auto& [id, c] : connections) {
+        close(c.fd);
+    }
+    n_connections -= connections.size();
+}
+#else
+Server::Server(const Options& options, const std::function<Handler()>&) : options(options) {
+    throw std::runtime_error("the HTTP server is only supported on Linux");
+}
+Server::~Server() {}
+void Server::shutdown() {}
+void Server::wake() {}
+void Server::stop() { stop_requested = true; }
+void Server::run() {}
+#endif
+} // namespace http
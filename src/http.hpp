@@ -0,0 +1,153 @@
+// Minimal HTTP/1.1 server for JSON APIs, with an epoll event loop and a pool of worker threads
+
+#ifndef HTTP_HPP_
+#define HTTP_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "server.hpp"
+
+namespace http {
+struct Request {
+    std::string method;
+    std::string path; // Without any query string
+    std::string body;
+    bool keep_alive = true;
+    // Whether the client is waiting for a "100 Continue" response before sending the body
+    bool expect_continue = false;
+};
+
+// Responses always have a JSON body
+struct Response {
+    int status = 200;
+    std::string body;
+};
+// Response with {"error": message} as the body
+Response error_response(int status, const std::string& message);
+// Serialize a response, including the status line and headers
+std::string format_response(const Response& response, bool keep_alive);
+
+// A request that can't be handled, and the status to respond with before closing the connection
+class Error : public std::runtime_error {
+    int status_;
+
+  public:
+    Error(int status, const std::string& message) : std::runtime_error(message), status_(status) {}
+    int status() const { return status_; }
+};
+
+// Incrementally parses requests from the bytes read from a connection. Request bodies must have a
+// Content-Length; chunked transfer encoding isn't supported.
+class RequestParser {
+    std::size_t max_header_size;
+    std::size_t max_body_size;
+    std::string buffer;
+    // The request whose headers have been parsed, while waiting for its body
+    std::optional<Request> pending;
+    std::size_t header_size = 0;
+    std::size_t body_size = 0;
+
+    void parse_header();
+
+  public:
+    RequestParser(std::size_t max_header_size, std::size_t max_body_size)
+        : max_header_size(max_header_size), max_body_size(max_body_size) {}
+
+    void feed(const char* data, std::size_t size);
+    // Take the next complete request, if there is one. Throws http::Error if the request is
+    // malformed or too large, after which the parser can't be used.
+    std::optional<Request> next();
+    // The request whose body is still being read, if its headers have been parsed
+    const Request* partial() const { return pending ? &*pending : nullptr; }
+};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    uint16_t port = 8080; // 0 for any free port
+    unsigned n_threads = 1;
+    std::size_t max_header_size = 64 * 1024;
+    std::size_t max_body_size = 16 * 1024 * 1024;
+};
+
+// Handles requests on a worker thread. Thrown exceptions become 500 responses.
+using Handler = std::function<Response(const Request&)>;
+
+// Serves any number of keep-alive connections from a single event loop thread, which reads and
+// parses requests and writes responses without blocking. Requests are handled by a fixed pool of
+// worker threads. Each connection has at most one request being handled at a time, so pipelined
+// requests get their responses in order.
+//
+// GET /stats is answered by the server itself, with the number of open connections, requests
+// handled, requests waiting for a worker, latency percentiles and the base damage memo hit rate of
+// the handlers' calcs.
+class Server {
+    struct Job {
+        uint64_t connection;
+        Request request;
+        std::chrono::steady_clock::time_point received;
+    };
+    struct Done {
+        uint64_t connection;
+        std::string response;
+        bool keep_alive;
+        std::chrono::steady_clock::time_point received;
+    };
+    struct Connection;
+
+    Options options;
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int wake_fd = -1; // eventfd that wakes up the event loop
+    uint16_t port_ = 0;
+
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::deque<Job> queue;
+    std::vector<Done> done;
+    bool stopping = false;
+    std::atomic<bool> stop_requested{false};
+    std::vector<std::thread> workers;
+
+    server::LatencyHistogram latency;
+    server::BaseDamageMemoTotals base_damage_memo;
+    std::atomic<uint64_t> n_connections{0};
+
+    void work(Handler handler);
+    void wake();
+    // Stop the workers and close the sockets
+    void shutdown();
+
+  public:
+    // Listen on options.host and options.port, and start the workers, each of which calls
+    // make_handler once to get its handler. Throws std::system_error if the socket can't be
+    // set up, or std::runtime_error on platforms without epoll.
+    Server(const Options& options, const std::function<Handler()>& make_handler);
+    ~Server();
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // The port being listened on, which is useful if options.port was 0
+    uint16_t port() const { return port_; }
+    // Run the event loop until stop() is called. Throws std::system_error if the event loop
+    // fails.
+    void run();
+    // Make run() return as soon as possible. Safe to call from any thread, or a signal handler.
+    void stop();
+    nlohmann::json stats();
+};
+} // namespace http
+
+#endif
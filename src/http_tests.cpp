@@ -0,0 +1,253 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "batch.hpp"
+#include "http.hpp"
+#include "test_configs.hpp"
+
+#ifdef __linux__
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using nlohmann::json;
+
+TEST_CASE("RequestParser works", "[http]") {
+    http::RequestParser parser(1024, 100);
+    SECTION("Pipelined requests split across reads") {
+        std::string data = "POST /calc?x=1 HTTP/1.1\r\nHost: localhost\r\ncontent-length: 7\r\n\r\n"
+                           "{\"a\":1}"
+                           "GET /stats HTTP/1.1\r\nConnection: close\r\n\r\n"
+                           "POST /calc HTTP/1.0\r\nContent-Length: 2\r\n\r\n{}";
+        std::vector<http::Request> requests;
+        for (std::size_t i = 0; i < data.size(); i += 5) {
+            parser.feed(data.data() + i, std::min<std::size_t>(5, data.size() - i));
+            while (auto request = parser.next()) {
+                requests.push_back(*request);
+            }
+        }
+        REQUIRE(requests.size() == 3);
+        REQUIRE(requests[0].method == "POST");
+        REQUIRE(requests[0].path == "/calc");
+        REQUIRE(requests[0].body == "{\"a\":1}");
+        REQUIRE(requests[0].keep_alive);
+        REQUIRE(requests[1].method == "GET");
+        REQUIRE(requests[1].path == "/stats");
+        REQUIRE(requests[1].body.empty());
+        REQUIRE(!requests[1].keep_alive);
+        REQUIRE(requests[2].body == "{}");
+        REQUIRE(!requests[2].keep_alive);
+    }
+    SECTION("Expect: 100-continue") {
+        std::string header = "POST /calc HTTP/1.1\r\nExpect: 100-continue\r\nContent-Length: 2\r\n\r\n";
+        parser.feed(header.data(), header.size());
+        REQUIRE(!parser.next());
+        REQUIRE(parser.partial());
+        REQUIRE(parser.partial()->expect_continue);
+        parser.feed("{}", 2);
+        REQUIRE(parser.next()->body == "{}");
+        REQUIRE(!parser.partial());
+    }
+    SECTION("Errors") {
+        // Parsers can't be used after an error
+        auto status_of = [&](const std::string& data) {
+            http::RequestParser fresh(1024, 100);
+            fresh.feed(data.data(), data.size());
+            try {
+                fresh.next();
+            } catch (const http::Error& e) {
+                return e.status();
+            }
+            return 0;
+        };
+        REQUIRE(status_of("POST /calc HTTP/1.1\r\nContent-Length: 101\r\n\r\n") == 413);
+        REQUIRE(status_of("POST /calc HTTP/1.1\r\nContent-Length: -1\r\n\r\n") == 400);
+        REQUIRE(status_of("POST /calc HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n") == 501);
+        REQUIRE(status_of("POST /calc HTTP/2\r\n\r\n") == 505);
+        REQUIRE(status_of("garbage\r\n\r\n") == 400);
+        REQUIRE(status_of(std::string(1025, 'a')) == 431);
+    }
+}
+
+TEST_CASE("format_response works", "[http]") {
+    REQUIRE(http::format_response({200, "{}"}, true) ==
+            "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 2\r\n"
+            "Connection: keep-alive\r\n\r\n{}");
+    REQUIRE(http::format_response(http::error_response(404, "x"), false) ==
+            "HTTP/1.1 404 Not Found\r\nContent-Type: application/json\r\nContent-Length: 13\r\n"
+            "Connection: close\r\n\r\n{\"error\":\"x\"}");
+}
+
+#ifdef __linux__
+namespace {
+// Blocking client for a server on localhost. Throws rather than using REQUIRE, since it's used on
+// multiple threads.
+class Client {
+    int fd;
+    std::string buffer;
+
+  public:
+    explicit Client(uint16_t port) : fd(socket(AF_INET, SOCK_STREAM, 0)) {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            throw std::runtime_error("connect failed");
+        }
+    }
+    ~Client() { close(fd); }
+
+    void send_all(const std::string& data) {
+        if (send(fd, data.data(), data.size(), MSG_NOSIGNAL) != ssize_t(data.size())) {
+            throw std::runtime_error("send failed");
+        }
+    }
+    // Read one response, returning its status and body (0 if the connection closed first)
+    std::pair<int, std::string> read_response() {
+        while (true) {
+            std::size_t end = buffer.find("\r\n\r\n");
+            if (end != std::string::npos) {
+                int status = std::stoi(buffer.substr(9, 3));
+                if (status == 100) {
+                    buffer.erase(0, end + 4);
+                    return {status, ""};
+                }
+                std::size_t length_pos = buffer.find("Content-Length: ");
+                std::size_t length = std::stoul(buffer.substr(length_pos + 16));
+                if (buffer.size() >= end + 4 + length) {
+                    std::string body = buffer.substr(end + 4, length);
+                    buffer.erase(0, end + 4 + length);
+                    return {status, body};
+                }
+            }
+            char buf[4096];
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                return {0, ""};
+            }
+            buffer.append(buf, n);
+        }
+    }
+};
+
+std::string post(const std::string& path, const std::string& body) {
+    return "POST " + path + " HTTP/1.1\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\n\r\n" + body;
+}
+} // namespace
+
+TEST_CASE("Server works over TCP", "[http]") {
+    http::Options options;
+    options.port = 0;
+    options.n_threads = 3;
+    options.max_body_size = 1000;
+    // Echo the request back, slowly for some requests so that responses finish out of order
+    http::Server server(options, [] {
+        return [](const http::Request& request) -> http::Response {
+            if (request.path == "/throw") {
+                throw std::runtime_error("oops");
+            }
+            if (request.path == "/calc") {
+                auto run = batch::run_calc(json::parse(request.body));
+                return {200, json{{"damage", run.damage}}.dump()};
+            }
+            auto body = json::parse(request.body);
+            std::this_thread::sleep_for(std::chrono::milliseconds(body.value("sleep_ms", 0)));
+            return {200, json{{"path", request.path}, {"echo", body}}.dump()};
+        };
+    });
+    REQUIRE(server.port() != 0);
+    std::thread loop([&] { server.run(); });
+
+    SECTION("Pipelined requests on concurrent connections") {
+        std::vector<std::thread> clients;
+        std::vector<int> ok(4, false);
+        // Whether a connection gets all of its responses, in order
+        auto run_client = [&](int c) {
+            Client client(server.port());
+            std::string requests;
+            for (int i = 0; i < 20; i++) {
+                requests += post("/p", json{{"i", i}, {"sleep_ms", (i + c) % 3}}.dump());
+            }
+            client.send_all(requests);
+            for (int i = 0; i < 20; i++) {
+                auto [status, body] = client.read_response();
+                if (status != 200 || json::parse(body)["echo"]["i"] != i) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        for (int c = 0; c < 4; c++) {
+            clients.emplace_back([&, c] {
+                try {
+                    ok[c] = run_client(c);
+                } catch (const std::exception&) {
+                }
+            });
+        }
+        for (auto& t : clients) {
+            t.join();
+        }
+        REQUIRE(ok == std::vector<int>(4, true));
+
+        Client client(server.port());
+        client.send_all("GET /stats HTTP/1.1\r\n\r\n");
+        auto [status, body] = client.read_response();
+        REQUIRE(status == 200);
+        auto stats = json::parse(body);
+        REQUIRE(stats["requests"] == 80);
+        REQUIRE(stats["workers"] == 3);
+        REQUIRE(stats["connections"] >= 1);
+        REQUIRE(stats["latency_us"]["p50"] <= stats["latency_us"]["max"]);
+    }
+    SECTION("Errors") {
+        Client client(server.port());
+        client.send_all(post("/throw", "{}"));
+        auto [status, body] = client.read_response();
+        REQUIRE(status == 500);
+        REQUIRE(json::parse(body)["error"] == "oops");
+
+        // The connection is still usable, until a request can't be parsed
+        client.send_all("POST /p HTTP/1.1\r\nExpect: 100-continue\r\nContent-Length: 2\r\n\r\n");
+        REQUIRE(client.read_response().first == 100);
+        client.send_all("{}");
+        REQUIRE(client.read_response().first == 200);
+        client.send_all(post("/p", std::string(1001, ' ')));
+        REQUIRE(client.read_response().first == 413);
+        REQUIRE(client.read_response().first == 0);
+    }
+    SECTION("Stats include the base damage memo of the handlers' calcs") {
+        Client client(server.port());
+        for (int i = 0; i < 10; i++) {
+            client.send_all(post("/calc", test_configs::make_cfg().dump()));
+            REQUIRE(client.read_response().first == 200);
+        }
+        client.send_all("GET /stats HTTP/1.1\r\n\r\n");
+        auto [status, body] = client.read_response();
+        REQUIRE(status == 200);
+        const auto memo = json::parse(body)["base_damage_memo"];
+        double hits = memo["hits"];
+        double misses = memo["misses"];
+        // At most one miss per worker, and the rest hit
+        REQUIRE(hits + misses >= 10);
+        REQUIRE(misses <= 3);
+        REQUIRE(memo["hit_rate"] == hits / (hits + misses));
+    }
+    SECTION("Connection: close") {
+        Client client(server.port());
+        client.send_all("POST /p HTTP/1.1\r\nConnection: close\r\nContent-Length: 2\r\n\r\n{}");
+        REQUIRE(client.read_response().first == 200);
+        REQUIRE(client.read_response().first == 0);
+    }
+
+    server.stop();
+    loop.join();
+}
+#endif
@@ -2,13 +2,15 @@
 
 using namespace ids;
 
-const IDMap<versions::eos_version> ids::VERSION = {
+constexpr IDEntry<versions::eos_version, 1> VERSION_ENTRIES[] = {
     {versions::NA, "NA", {"US"}},
     {versions::EU, "EU", {}},
     {versions::JP, "JP", {}},
 };
+constexpr auto VERSION_TABLES = make_idmap_tables<VERSION_ENTRIES>();
+const IDMap<versions::eos_version> ids::VERSION{VERSION_TABLES};
 
-const IDMap<eos::move_id> ids::MOVE = {
+constexpr IDEntry<eos::move_id> MOVE_ENTRIES[] = {
     {eos::MOVE_NOTHING, "Nothing"},
     {eos::MOVE_IRON_TAIL, "Iron Tail"},
     {eos::MOVE_ICE_BALL, "Ice Ball"},
@@ -569,7 +571,9 @@ const IDMap<eos::move_id> ids::MOVE = {
     {eos::MOVE_TAG_0x22D, "(0x22D)"},
     {eos::MOVE_TAG_0x22E, "(0x22E)"},
 };
-const IDMap<eos::monster_id> ids::MONSTER = {
+constexpr auto MOVE_TABLES = make_idmap_tables<MOVE_ENTRIES>();
+const IDMap<eos::move_id> ids::MOVE{MOVE_TABLES};
+constexpr IDEntry<eos::monster_id> MONSTER_ENTRIES[] = {
     {eos::MONSTER_NONE, "??????????"},
     {eos::MONSTER_BULBASAUR, "Bulbasaur"},
     {eos::MONSTER_IVYSAUR, "Ivysaur"},
@@ -1726,7 +1730,9 @@ const IDMap<eos::monster_id> ids::MONSTER = {
     {eos::MONSTER_DECOY_SECONDARY, "Decoy (secondary)"},
     {eos::MONSTER_STATUE_SECONDARY, "Statue (secondary)"},
 };
-const IDMap<eos::type_id> ids::TYPE = {
+constexpr auto MONSTER_TABLES = make_idmap_tables<MONSTER_ENTRIES>();
+const IDMap<eos::monster_id> ids::MONSTER{MONSTER_TABLES};
+constexpr IDEntry<eos::type_id> TYPE_ENTRIES[] = {
     {eos::TYPE_NONE, "None"},       {eos::TYPE_NORMAL, "Normal"},
     {eos::TYPE_FIRE, "Fire"},       {eos::TYPE_WATER, "Water"},
     {eos::TYPE_GRASS, "Grass"},     {eos::TYPE_ELECTRIC, "Electric"},
@@ -1738,7 +1744,9 @@ const IDMap<eos::type_id> ids::TYPE = {
     {eos::TYPE_DARK, "Dark"},       {eos::TYPE_STEEL, "Steel"},
     {eos::TYPE_NEUTRAL, "Neutral"},
 };
-const IDMap<eos::ability_id> ids::ABILITY = {
+constexpr auto TYPE_TABLES = make_idmap_tables<TYPE_ENTRIES>();
+const IDMap<eos::type_id> ids::TYPE{TYPE_TABLES};
+constexpr IDEntry<eos::ability_id> ABILITY_ENTRIES[] = {
     {eos::ABILITY_UNKNOWN, "Unknown"},
     {eos::ABILITY_STENCH, "Stench"},
     {eos::ABILITY_THICK_FAT, "Thick Fat"},
@@ -1864,7 +1872,9 @@ const IDMap<eos::ability_id> ids::ABILITY = {
     {eos::ABILITY_STORM_DRAIN, "Storm Drain"},
     {eos::ABILITY_LEAF_GUARD, "Leaf Guard"},
 };
-const IDMap<eos::item_id> ids::ITEM = {
+constexpr auto ABILITY_TABLES = make_idmap_tables<ABILITY_ENTRIES>();
+const IDMap<eos::ability_id> ids::ABILITY{ABILITY_TABLES};
+constexpr IDEntry<eos::item_id> ITEM_ENTRIES[] = {
     {eos::ITEM_NOTHING, "Nothing"},
     {eos::ITEM_STICK, "Stick"},
     {eos::ITEM_IRON_THORN, "Iron Thorn"},
@@ -3266,13 +3276,17 @@ const IDMap<eos::item_id> ids::ITEM = {
     {eos::ITEM_UNNAMED_0x576, "$$$ (0x576)"},
     {eos::ITEM_UNNAMED_0x577, "$$$ (0x577)"},
 };
-const IDMap<eos::monster_gender> ids::GENDER = {
+constexpr auto ITEM_TABLES = make_idmap_tables<ITEM_ENTRIES>();
+const IDMap<eos::item_id> ids::ITEM{ITEM_TABLES};
+constexpr IDEntry<eos::monster_gender> GENDER_ENTRIES[] = {
     {eos::GENDER_INVALID, "Invalid"},
     {eos::GENDER_MALE, "Male"},
     {eos::GENDER_FEMALE, "Female"},
     {eos::GENDER_GENDERLESS, "Genderless"},
 };
-const IDMap<eos::weather_id> ids::WEATHER = {
+constexpr auto GENDER_TABLES = make_idmap_tables<GENDER_ENTRIES>();
+const IDMap<eos::monster_gender> ids::GENDER{GENDER_TABLES};
+constexpr IDEntry<eos::weather_id> WEATHER_ENTRIES[] = {
     {eos::WEATHER_CLEAR, "Clear"},
     {eos::WEATHER_SUNNY, "Sunny"},
     {eos::WEATHER_SANDSTORM, "Sandstorm"},
@@ -3283,7 +3297,9 @@ const IDMap<eos::weather_id> ids::WEATHER = {
     {eos::WEATHER_SNOW, "Snow"},
     {eos::WEATHER_RANDOM, "Random"},
 };
-const IDMap<eos::iq_skill_id> ids::IQ = {
+constexpr auto WEATHER_TABLES = make_idmap_tables<WEATHER_ENTRIES>();
+const IDMap<eos::weather_id> ids::WEATHER{WEATHER_TABLES};
+constexpr IDEntry<eos::iq_skill_id> IQ_ENTRIES[] = {
     {eos::IQ_NONE, ""},
     {eos::IQ_TYPE_ADVANTAGE_MASTER, "Type-Advantage Master"},
     {eos::IQ_ITEM_CATCHER, "Item Catcher"},
@@ -3354,7 +3370,9 @@ const IDMap<eos::iq_skill_id> ids::IQ = {
     {eos::IQ_COLLECTOR, "Collector"},
     {eos::IQ_TRUE_POWERIST, "True Powerist"},
 };
-const IDMap<eos::status_id> ids::STATUS = {
+constexpr auto IQ_TABLES = make_idmap_tables<IQ_ENTRIES>();
+const IDMap<eos::iq_skill_id> ids::IQ{IQ_TABLES};
+constexpr IDEntry<eos::status_id, 1> STATUS_ENTRIES[] = {
     {eos::STATUS_NONE, "None", {"-"}},
     {eos::STATUS_SLEEP, "Sleep", {"Asleep"}},
     {eos::STATUS_SLEEPLESS, "Sleepless", {"Won't get sleepy"}},
@@ -3458,7 +3476,9 @@ const IDMap<eos::status_id> ids::STATUS = {
     {eos::STATUS_DOUBLED_ATTACK, "Doubled Attack", {"Has sped-up attacks"}},
     {eos::STATUS_STAIR_SPOTTER, "Stair Spotter", {"Can locate stairs"}},
 };
-const IDMap<eos::exclusive_item_effect_id> ids::EXCLUSIVE_ITEM_EFFECT = {
+constexpr auto STATUS_TABLES = make_idmap_tables<STATUS_ENTRIES>();
+const IDMap<eos::status_id> ids::STATUS{STATUS_TABLES};
+constexpr IDEntry<eos::exclusive_item_effect_id, 30> EXCLUSIVE_ITEM_EFFECT_ENTRIES[] = {
     {eos::EXCLUSIVE_EFF_STAT_BOOST, "Stat boost", {}},
     {eos::EXCLUSIVE_EFF_NO_PARALYSIS,
      "No Paralysis",
@@ -3801,19 +3821,27 @@ const IDMap<eos::exclusive_item_effect_id> ids::EXCLUSIVE_ITEM_EFFECT = {
      {"Fake Torc", "Cradily Bow", "Skull Helmet", "Glacier Cape"}},
     {eos::EXCLUSIVE_EFF_LAST, "last", {}},
 };
-const IDMap<eos::move_category> ids::MOVE_CATEGORY = {
+constexpr auto EXCLUSIVE_ITEM_EFFECT_TABLES =
+    make_idmap_tables<EXCLUSIVE_ITEM_EFFECT_ENTRIES>();
+const IDMap<eos::exclusive_item_effect_id>
+    ids::EXCLUSIVE_ITEM_EFFECT{EXCLUSIVE_ITEM_EFFECT_TABLES};
+constexpr IDEntry<eos::move_category> MOVE_CATEGORY_ENTRIES[] = {
     {eos::CATEGORY_PHYSICAL, "Physical"},
     {eos::CATEGORY_SPECIAL, "Special"},
     {eos::CATEGORY_STATUS, "Status"},
     {eos::CATEGORY_NONE, "None"},
 };
-const IDMap<eos::type_matchup> ids::TYPE_MATCHUP = {
+constexpr auto MOVE_CATEGORY_TABLES = make_idmap_tables<MOVE_CATEGORY_ENTRIES>();
+const IDMap<eos::move_category> ids::MOVE_CATEGORY{MOVE_CATEGORY_TABLES};
+constexpr IDEntry<eos::type_matchup> TYPE_MATCHUP_ENTRIES[] = {
     {eos::MATCHUP_IMMUNE, "Immune"},
     {eos::MATCHUP_NOT_VERY_EFFECTIVE, "Not very effective"},
     {eos::MATCHUP_NEUTRAL, "Neutral"},
     {eos::MATCHUP_SUPER_EFFECTIVE, "Super effective"},
 };
-const IDMap<eos::damage_message> ids::DAMAGE_MESSAGE = {
+constexpr auto TYPE_MATCHUP_TABLES = make_idmap_tables<TYPE_MATCHUP_ENTRIES>();
+const IDMap<eos::type_matchup> ids::TYPE_MATCHUP{TYPE_MATCHUP_TABLES};
+constexpr IDEntry<eos::damage_message> DAMAGE_MESSAGE_ENTRIES[] = {
     {eos::DAMAGE_MESSAGE_MOVE, "Move"},
     {eos::DAMAGE_MESSAGE_BURN, "Burn"},
     {eos::DAMAGE_MESSAGE_CONSTRICTION, "Constriction"},
@@ -3841,3 +3869,5 @@ const IDMap<eos::damage_message> ids::DAMAGE_MESSAGE = {
     {eos::DAMAGE_MESSAGE_SOLAR_POWER, "Solar Power"},
     {eos::DAMAGE_MESSAGE_DRY_SKIN, "Dry Skin"},
 };
+constexpr auto DAMAGE_MESSAGE_TABLES = make_idmap_tables<DAMAGE_MESSAGE_ENTRIES>();
+const IDMap<eos::damage_message> ids::DAMAGE_MESSAGE{DAMAGE_MESSAGE_TABLES};
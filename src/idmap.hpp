@@ -4,128 +4,445 @@
 #define IDMAPS_HPP_
 
 #include <algorithm>
-#include <initializer_list>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <type_traits>
 #include <unordered_set>
 #include <vector>
 #include "pmdsky.hpp"
 #include "versions.hpp"
 
 namespace ids {
-template <typename T> class IDMap {
-    std::unordered_map<std::string, T> name_to_id;             // contains normalized names
-    std::unordered_map<T, std::string> id_to_name;             // contains raw names
-    std::unordered_map<T, std::vector<std::string>> alt_names; // contains raw names
+// A single ID with its name and up to N_ALTS alternate names, used to define an IDMap.
+// Unused alternate name slots are left empty.
+template <typename T, std::size_t N_ALTS = 0> struct IDEntry {
+    T id;
+    std::string_view name;
+    std::string_view alt_names[N_ALTS];
+};
+template <typename T> struct IDEntry<T, 0> {
+    T id;
+    std::string_view name;
+};
+
+namespace detail {
+constexpr uint16_t NO_INDEX = UINT16_MAX;
+
+constexpr char ascii_to_lower(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - ('A' - 'a');
+    }
+    return c;
+}
+// Case insensitive name hash: FNV-1a, followed by the MurmurHash3 finalizer so all the bits are
+// usable for the perfect hash
+constexpr uint64_t hash_name(std::string_view name) {
+    uint64_t h = 0xCBF29CE484222325;
+    for (char c : name) {
+        h ^= static_cast<unsigned char>(ascii_to_lower(c));
+        h *= 0x100000001B3;
+    }
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCD;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53;
+    h ^= h >> 33;
+    return h;
+}
+// Hash table slot for a name hash, given its bucket's displacement
+constexpr std::size_t hash_slot(uint64_t h, uint16_t displacement, std::size_t n_slots) {
+    uint32_t h1 = static_cast<uint32_t>(h);
+    uint32_t h2 = static_cast<uint32_t>(h >> 32) | 1;
+    return (h1 + displacement * h2) & (n_slots - 1);
+}
+constexpr std::size_t hash_bucket(uint64_t h, std::size_t n_buckets) {
+    return (h >> 40) % n_buckets;
+}
+
+template <typename T, std::size_t N_ALTS>
+constexpr std::size_t alt_name_count(const IDEntry<T, N_ALTS>& entry) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < N_ALTS; i++) {
+        if (!entry.alt_names[i].empty()) {
+            count++;
+        }
+    }
+    return count;
+}
+template <typename T> constexpr std::size_t alt_name_count(const IDEntry<T, 0>&) { return 0; }
+template <typename T, std::size_t N_ALTS>
+constexpr std::string_view alt_name(const IDEntry<T, N_ALTS>& entry, std::size_t i) {
+    for (std::size_t j = 0; j < N_ALTS; j++) {
+        if (!entry.alt_names[j].empty() && i-- == 0) {
+            return entry.alt_names[j];
+        }
+    }
+    return {};
+}
+template <typename T> constexpr std::string_view alt_name(const IDEntry<T, 0>&, std::size_t) {
+    return {};
+}
+
+template <typename Entry, std::size_t N>
+constexpr std::size_t total_alt_names(const Entry (&entries)[N]) {
+    std::size_t total = 0;
+    for (auto& entry : entries) {
+        total += alt_name_count(entry);
+    }
+    return total;
+}
+template <typename Entry, std::size_t N>
+constexpr std::size_t id_limit(const Entry (&entries)[N]) {
+    std::size_t limit = 0;
+    for (auto& entry : entries) {
+        limit = std::max(limit, static_cast<std::size_t>(entry.id) + 1);
+    }
+    return limit;
+}
+// Smallest power of 2 that keeps the load factor under 3/4
+constexpr std::size_t hash_table_size(std::size_t n_names) {
+    std::size_t size = 1;
+    while (size * 3 < n_names * 4) {
+        size *= 2;
+    }
+    return size;
+}
+} // namespace detail
 
-    static char ascii_to_lower(char c) {
-        if (c >= 'A' && c <= 'Z') {
-            return c - ('A' - 'a');
+// Case insensitive name comparison, consistent with IDMap lookups
+constexpr bool names_equal(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); i++) {
+        if (detail::ascii_to_lower(a[i]) != detail::ascii_to_lower(b[i])) {
+            return false;
         }
-        return c;
     }
-    std::vector<std::pair<T, std::string>> sorted_pairs() const {
-        std::vector<std::pair<T, std::string>> pairs(id_to_name.begin(), id_to_name.end());
-        std::sort(pairs.begin(), pairs.end());
-        return pairs;
+    return true;
+}
+// Transparent case insensitive hash and equality for names, so containers keyed by name can be
+// queried with any string type without allocating
+struct NameHash {
+    using is_transparent = void;
+    constexpr std::size_t operator()(std::string_view name) const {
+        return static_cast<std::size_t>(detail::hash_name(name));
     }
+};
+struct NameEqual {
+    using is_transparent = void;
+    constexpr bool operator()(std::string_view a, std::string_view b) const {
+        return names_equal(a, b);
+    }
+};
+
+// Primary name for an ID, along with the range of its alternate names
+template <typename T> struct IDRecord {
+    T id;
+    std::string_view name;
+    uint16_t alts_begin;
+    uint16_t alts_end;
+};
+// Alternate name, along with the index of the IDRecord it belongs to
+struct AltNameRecord {
+    std::string_view name;
+    uint16_t record;
+};
+
+// Read-only view of the alternate names of an ID, backed by the IDMap's tables
+class AltNames {
+    const AltNameRecord* begin_;
+    const AltNameRecord* end_;
 
   public:
-    IDMap(std::initializer_list<std::pair<T, std::string>> pairs) {
-        name_to_id.reserve(pairs.size());
-        id_to_name.reserve(pairs.size());
-        for (auto& [id, name] : pairs) {
-            std::string normalized = normalize(name);
-            if (name_to_id.find(normalized) != name_to_id.end()) {
-                throw std::invalid_argument("IDMap: repeated name '" + name + "' for IDs " +
-                                            std::to_string(name_to_id.at(normalized)) + ", " +
-                                            std::to_string(id));
-            }
-            if (id_to_name.find(id) != id_to_name.end()) {
-                throw std::invalid_argument("IDMap: repeated ID " + std::to_string(id) +
-                                            " for names '" + id_to_name.at(id) + "', '" + name +
-                                            "'");
-            }
-            name_to_id[normalized] = id;
-            id_to_name[id] = name;
-        }
-    }
-    IDMap(std::initializer_list<std::tuple<T, std::string, std::vector<std::string>>> entries) {
-        name_to_id.reserve(entries.size());
-        id_to_name.reserve(entries.size());
-        alt_names.reserve(entries.size());
-        for (auto& [id, name, alts] : entries) {
-            std::string normalized = normalize(name);
-            if (name_to_id.find(normalized) != name_to_id.end()) {
-                throw std::invalid_argument("IDMap: repeated name '" + name + "' for IDs " +
-                                            std::to_string(name_to_id.at(normalized)) + ", " +
-                                            std::to_string(id));
+    class iterator {
+        const AltNameRecord* ptr;
+
+      public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        constexpr explicit iterator(const AltNameRecord* p) : ptr(p) {}
+        constexpr reference operator*() const { return ptr->name; }
+        constexpr pointer operator->() const { return &ptr->name; }
+        constexpr reference operator[](difference_type n) const { return ptr[n].name; }
+        constexpr iterator& operator++() {
+            ++ptr;
+            return *this;
+        }
+        constexpr iterator operator++(int) { return iterator(ptr++); }
+        constexpr iterator& operator--() {
+            --ptr;
+            return *this;
+        }
+        constexpr iterator operator--(int) { return iterator(ptr--); }
+        constexpr iterator& operator+=(difference_type n) {
+            ptr += n;
+            return *this;
+        }
+        constexpr iterator& operator-=(difference_type n) {
+            ptr -= n;
+            return *this;
+        }
+        constexpr iterator operator+(difference_type n) const { return iterator(ptr + n); }
+        constexpr iterator operator-(difference_type n) const { return iterator(ptr - n); }
+        constexpr difference_type operator-(const iterator& other) const {
+            return ptr - other.ptr;
+        }
+        constexpr bool operator==(const iterator& other) const { return ptr == other.ptr; }
+        constexpr bool operator!=(const iterator& other) const { return ptr != other.ptr; }
+        constexpr bool operator<(const iterator& other) const { return ptr < other.ptr; }
+    };
+
+    constexpr AltNames(const AltNameRecord* begin, const AltNameRecord* end)
+        : begin_(begin), end_(end) {}
+    constexpr iterator begin() const { return iterator(begin_); }
+    constexpr iterator end() const { return iterator(end_); }
+    constexpr std::size_t size() const { return end_ - begin_; }
+    constexpr bool empty() const { return begin_ == end_; }
+    constexpr std::string_view operator[](std::size_t i) const { return begin_[i].name; }
+    std::vector<std::string> to_vector() const { return std::vector<std::string>(begin(), end()); }
+};
+
+// Lookup tables backing an IDMap, built at compile time by make_idmap_tables().
+// Names are looked up through a perfect hash with one displacement per bucket of names.
+// Slots index into the combined name list, with primary names first (in records order) and
+// alternate names after.
+template <typename T, std::size_t N_RECORDS, std::size_t N_ALT_NAMES, std::size_t N_SLOTS,
+          std::size_t N_BUCKETS, std::size_t ID_LIMIT>
+struct IDMapTables {
+    std::array<IDRecord<T>, N_RECORDS> records; // Sorted by ID
+    std::array<AltNameRecord, N_ALT_NAMES> alt_names;
+    std::array<uint16_t, ID_LIMIT> id_to_record;
+    std::array<uint16_t, N_BUCKETS> displacements;
+    std::array<uint16_t, N_SLOTS> slots;
+};
+
+// Builds the lookup tables for an array of IDEntry at compile time. Repeated names (which are
+// case insensitive) or IDs are rejected with a compile error.
+template <const auto& ENTRIES> constexpr auto make_idmap_tables() {
+    using Entries = std::remove_reference_t<decltype(ENTRIES)>;
+    using T = decltype(ENTRIES[0].id);
+    constexpr std::size_t N_RECORDS = std::extent_v<Entries>;
+    constexpr std::size_t N_ALT_NAMES = detail::total_alt_names(ENTRIES);
+    constexpr std::size_t N_NAMES = N_RECORDS + N_ALT_NAMES;
+    constexpr std::size_t N_SLOTS = detail::hash_table_size(N_NAMES);
+    constexpr std::size_t N_BUCKETS = N_NAMES / 4 + 1;
+    constexpr std::size_t ID_LIMIT = detail::id_limit(ENTRIES);
+    static_assert(N_NAMES < detail::NO_INDEX && ID_LIMIT < detail::NO_INDEX,
+                  "IDMap: too many names");
+
+    IDMapTables<T, N_RECORDS, N_ALT_NAMES, N_SLOTS, N_BUCKETS, ID_LIMIT> tables{};
+
+    // Sort entries by ID
+    std::array<uint16_t, ID_LIMIT> id_to_entry{};
+    for (auto& idx : id_to_entry) {
+        idx = detail::NO_INDEX;
+    }
+    for (std::size_t i = 0; i < N_RECORDS; i++) {
+        auto& idx = id_to_entry[static_cast<std::size_t>(ENTRIES[i].id)];
+        if (idx != detail::NO_INDEX) {
+            throw std::invalid_argument("IDMap: repeated ID");
+        }
+        idx = i;
+    }
+    std::size_t n_records = 0;
+    std::size_t n_alts = 0;
+    for (std::size_t id = 0; id < ID_LIMIT; id++) {
+        tables.id_to_record[id] = detail::NO_INDEX;
+        if (id_to_entry[id] == detail::NO_INDEX) {
+            continue;
+        }
+        auto& entry = ENTRIES[id_to_entry[id]];
+        auto& record = tables.records[n_records];
+        record.id = entry.id;
+        record.name = entry.name;
+        record.alts_begin = n_alts;
+        for (std::size_t a = 0; a < detail::alt_name_count(entry); a++) {
+            tables.alt_names[n_alts++] = {detail::alt_name(entry, a), uint16_t(n_records)};
+        }
+        record.alts_end = n_alts;
+        tables.id_to_record[id] = n_records++;
+    }
+
+    // Group names into buckets
+    std::array<uint64_t, N_NAMES> hashes{};
+    std::array<std::string_view, N_NAMES> names{};
+    std::array<uint16_t, N_BUCKETS + 1> bucket_start{};
+    for (std::size_t i = 0; i < N_NAMES; i++) {
+        names[i] = i < N_RECORDS ? tables.records[i].name : tables.alt_names[i - N_RECORDS].name;
+        hashes[i] = detail::hash_name(names[i]);
+        bucket_start[detail::hash_bucket(hashes[i], N_BUCKETS) + 1]++;
+    }
+    std::size_t max_bucket_size = 0;
+    for (std::size_t b = 0; b < N_BUCKETS; b++) {
+        max_bucket_size = std::max(max_bucket_size, std::size_t(bucket_start[b + 1]));
+        bucket_start[b + 1] += bucket_start[b];
+    }
+    std::array<uint16_t, N_NAMES> bucket_names{};
+    std::array<uint16_t, N_BUCKETS> bucket_fill{};
+    for (std::size_t i = 0; i < N_NAMES; i++) {
+        std::size_t b = detail::hash_bucket(hashes[i], N_BUCKETS);
+        bucket_names[bucket_start[b] + bucket_fill[b]++] = i;
+    }
+
+    // Place the biggest buckets first, searching for a displacement that puts every name in the
+    // bucket into a distinct empty slot
+    for (auto& slot : tables.slots) {
+        slot = detail::NO_INDEX;
+    }
+    for (std::size_t size = max_bucket_size; size > 0; size--) {
+        for (std::size_t b = 0; b < N_BUCKETS; b++) {
+            std::size_t begin = bucket_start[b];
+            std::size_t end = bucket_start[b + 1];
+            if (end - begin != size) {
+                continue;
             }
-            if (id_to_name.find(id) != id_to_name.end()) {
-                throw std::invalid_argument("IDMap: repeated ID " + std::to_string(id) +
-                                            " for names '" + id_to_name.at(id) + "', '" + name +
-                                            "'");
+            // Equal names always end up in the same bucket
+            for (std::size_t i = begin; i < end; i++) {
+                for (std::size_t j = i + 1; j < end; j++) {
+                    if (names_equal(names[bucket_names[i]], names[bucket_names[j]])) {
+                        throw std::invalid_argument("IDMap: repeated name");
+                    }
+                }
             }
-            name_to_id[normalized] = id;
-            id_to_name[id] = name;
-
-            for (auto& alt : alts) {
-                normalized = normalize(alt);
-                if (name_to_id.find(normalized) != name_to_id.end()) {
-                    throw std::invalid_argument("IDMap: repeated name '" + alt + "' for IDs " +
-                                                std::to_string(name_to_id.at(normalized)) + ", " +
-                                                std::to_string(id));
+            bool placed = false;
+            for (uint32_t d = 0; d < detail::NO_INDEX && !placed; d++) {
+                placed = true;
+                for (std::size_t i = begin; i < end && placed; i++) {
+                    std::size_t slot = detail::hash_slot(hashes[bucket_names[i]], d, N_SLOTS);
+                    placed = tables.slots[slot] == detail::NO_INDEX;
+                    for (std::size_t j = begin; j < i && placed; j++) {
+                        placed = slot != detail::hash_slot(hashes[bucket_names[j]], d, N_SLOTS);
+                    }
+                }
+                if (placed) {
+                    tables.displacements[b] = d;
+                    for (std::size_t i = begin; i < end; i++) {
+                        tables.slots[detail::hash_slot(hashes[bucket_names[i]], d, N_SLOTS)] =
+                            bucket_names[i];
+                    }
                 }
-                name_to_id[normalized] = id;
             }
-            alt_names[id] = std::move(alts);
+            if (!placed) {
+                throw std::logic_error("IDMap: could not build perfect hash");
+            }
+        }
+    }
+    return tables;
+}
+
+// Bidirectional map between IDs and names. Name lookup is case insensitive, and IDs can have
+// alternate names in addition to their primary name.
+// An IDMap is just a view into tables built by make_idmap_tables(), so it can be constructed at
+// compile time without any allocations.
+template <typename T> class IDMap {
+    const IDRecord<T>* records;
+    std::size_t n_records;
+    const AltNameRecord* alt_names;
+    const uint16_t* id_to_record;
+    std::size_t id_limit;
+    const uint16_t* displacements;
+    std::size_t n_buckets;
+    const uint16_t* slots;
+    std::size_t n_slots;
+
+    constexpr const IDRecord<T>* find_id(T id) const {
+        auto idx = static_cast<std::size_t>(id);
+        if (idx >= id_limit || id_to_record[idx] == detail::NO_INDEX) {
+            return nullptr;
+        }
+        return &records[id_to_record[idx]];
+    }
+    constexpr const IDRecord<T>* find_name(std::string_view name) const {
+        uint64_t h = detail::hash_name(name);
+        uint16_t d = displacements[detail::hash_bucket(h, n_buckets)];
+        uint16_t idx = slots[detail::hash_slot(h, d, n_slots)];
+        if (idx == detail::NO_INDEX) {
+            return nullptr;
+        }
+        if (idx < n_records) {
+            return names_equal(records[idx].name, name) ? &records[idx] : nullptr;
         }
+        auto& alt = alt_names[idx - n_records];
+        return names_equal(alt.name, name) ? &records[alt.record] : nullptr;
+    }
+    constexpr AltNames alternate_names(const IDRecord<T>& record) const {
+        return AltNames(alt_names + record.alts_begin, alt_names + record.alts_end);
     }
 
-    const std::string& operator[](const T id) const { return id_to_name.at(id); }
-    const T operator[](const std::string& name) const { return name_to_id.at(normalize(name)); }
-    const std::vector<std::string> alternate_names(const T id) const { return alt_names.at(id); }
+  public:
+    template <std::size_t N_RECORDS, std::size_t N_ALT_NAMES, std::size_t N_SLOTS,
+              std::size_t N_BUCKETS, std::size_t ID_LIMIT>
+    constexpr IDMap(
+        const IDMapTables<T, N_RECORDS, N_ALT_NAMES, N_SLOTS, N_BUCKETS, ID_LIMIT>& tables)
+        : records(tables.records.data()), n_records(N_RECORDS),
+          alt_names(tables.alt_names.data()), id_to_record(tables.id_to_record.data()),
+          id_limit(ID_LIMIT), displacements(tables.displacements.data()), n_buckets(N_BUCKETS),
+          slots(tables.slots.data()), n_slots(N_SLOTS) {}
 
-    bool contains(const std::string& name) const {
-        return name_to_id.find(normalize(name)) != name_to_id.end();
+    std::string_view operator[](const T id) const {
+        auto record = find_id(id);
+        if (!record) {
+            throw std::out_of_range("IDMap: unknown ID " + std::to_string(id));
+        }
+        return record->name;
+    }
+    T operator[](std::string_view name) const {
+        auto record = find_name(name);
+        if (!record) {
+            throw std::out_of_range("IDMap: unknown name '" + std::string(name) + "'");
+        }
+        return record->id;
+    }
+    AltNames alternate_names(const T id) const {
+        auto record = find_id(id);
+        if (!record) {
+            throw std::out_of_range("IDMap: unknown ID " + std::to_string(id));
+        }
+        return alternate_names(*record);
+    }
+
+    constexpr bool contains(std::string_view name) const { return find_name(name) != nullptr; }
+    constexpr bool contains(const T id) const { return find_id(id) != nullptr; }
+
+    // Call f(id, name, alternate_names) for every ID, in ID order
+    template <typename F> void for_each(F&& f) const {
+        for (std::size_t i = 0; i < n_records; i++) {
+            f(records[i].id, records[i].name, alternate_names(records[i]));
+        }
     }
 
     std::vector<std::string> all_except(std::unordered_set<T> exclude = {}) const {
-        auto pairs = sorted_pairs();
         std::vector<std::string> names;
-        names.reserve(pairs.size());
-        for (auto& [id, name] : pairs) {
-            if (exclude.find(id) == exclude.end()) {
-                names.push_back(name);
+        names.reserve(n_records);
+        for (std::size_t i = 0; i < n_records; i++) {
+            if (exclude.find(records[i].id) == exclude.end()) {
+                names.emplace_back(records[i].name);
             }
         }
         return names;
     }
     std::vector<std::pair<std::string, std::vector<std::string>>>
     all_with_alts_except(std::unordered_set<T> exclude = {}) const {
-        auto pairs = sorted_pairs();
         std::vector<std::pair<std::string, std::vector<std::string>>> names;
-        names.reserve(pairs.size());
-        for (auto& [id, name] : pairs) {
-            if (exclude.find(id) == exclude.end()) {
-                auto alts = alt_names.find(id);
-                if (alts != alt_names.end()) {
-                    names.push_back({name, alts->second});
-                } else {
-                    names.push_back({name, {}});
-                }
+        names.reserve(n_records);
+        for (std::size_t i = 0; i < n_records; i++) {
+            if (exclude.find(records[i].id) == exclude.end()) {
+                names.push_back(
+                    {std::string(records[i].name), alternate_names(records[i]).to_vector()});
             }
         }
         return names;
     }
-
-    std::string normalize(const std::string& name) const {
-        // For case insensitive lookup
-        std::string normalized = name;
-        std::transform(normalized.begin(), normalized.end(), normalized.begin(), ascii_to_lower);
-        return normalized;
-    }
 };
 
 extern const IDMap<versions::eos_version> VERSION;
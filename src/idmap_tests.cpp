@@ -45,13 +45,86 @@ TEST_CASE("Alternate names can be mapped to IDs") {
     REQUIRE(ids::EXCLUSIVE_ITEM_EFFECT["mobile bow"] == eos::EXCLUSIVE_EFF_NO_PARALYSIS);
 }
 TEST_CASE("IDs can be mapped to alternate names") {
-    REQUIRE(ids::STATUS.alternate_names(eos::STATUS_SLEEP) == std::vector<std::string>{"Asleep"});
-    REQUIRE(ids::EXCLUSIVE_ITEM_EFFECT.alternate_names(eos::EXCLUSIVE_EFF_NO_PARALYSIS) ==
+    REQUIRE(ids::STATUS.alternate_names(eos::STATUS_SLEEP).to_vector() ==
+            std::vector<std::string>{"Asleep"});
+    auto alts = ids::EXCLUSIVE_ITEM_EFFECT.alternate_names(eos::EXCLUSIVE_EFF_NO_PARALYSIS);
+    REQUIRE(alts.size() == 4);
+    REQUIRE(alts[1] == "Moving Scarf");
+    REQUIRE(alts.to_vector() ==
             std::vector<std::string>{"Volt Bangle", "Moving Scarf", "Magne-Torc", "Mobile Bow"});
+    REQUIRE(ids::MOVE.alternate_names(eos::MOVE_TACKLE).empty());
+}
+TEST_CASE("Names can be looked up without allocating") {
+    std::string_view buf = "xxTACKLExx";
+    REQUIRE(ids::MOVE[buf.substr(2, 6)] == eos::MOVE_TACKLE);
+    REQUIRE(ids::MOVE.contains(buf.substr(2, 6)));
+    REQUIRE(!ids::MOVE.contains(buf.substr(2, 7)));
+    static_assert(ids::names_equal("Guts/Marvel Scale", "guts/marvel scale"));
+    static_assert(!ids::names_equal("Guts", "Guts/Marvel Scale"));
+    static_assert(ids::NameHash{}("tackle") == ids::NameHash{}("TaCkLe"));
+    static_assert(ids::NameEqual{}("tackle", "TaCkLe"));
+}
+TEST_CASE("Unknown names and IDs are rejected") {
+    REQUIRE_THROWS_AS(ids::MOVE["not a move"], std::out_of_range);
+    REQUIRE_THROWS_AS(ids::MOVE[""], std::out_of_range);
+    REQUIRE_THROWS_AS(ids::VERSION[static_cast<versions::eos_version>(100)], std::out_of_range);
+    REQUIRE_THROWS_AS(ids::STATUS.alternate_names(static_cast<eos::status_id>(1000)),
+                      std::out_of_range);
+}
+TEST_CASE("Every name and alternate name can be looked up") {
+    auto check_all = [](auto& map) {
+        for (auto& [name, alts] : map.all_with_alts_except()) {
+            auto id = map[name];
+            REQUIRE(map[id] == name);
+            for (auto& alt : alts) {
+                REQUIRE(map[alt] == id);
+            }
+        }
+    };
+    check_all(ids::VERSION);
+    check_all(ids::MOVE);
+    check_all(ids::MONSTER);
+    check_all(ids::TYPE);
+    check_all(ids::ABILITY);
+    check_all(ids::ITEM);
+    check_all(ids::GENDER);
+    check_all(ids::WEATHER);
+    check_all(ids::IQ);
+    check_all(ids::STATUS);
+    check_all(ids::EXCLUSIVE_ITEM_EFFECT);
+    check_all(ids::MOVE_CATEGORY);
+    check_all(ids::TYPE_MATCHUP);
+    check_all(ids::DAMAGE_MESSAGE);
+}
+TEST_CASE("IDMap tables are built at compile time") {
+    static constexpr ids::IDEntry<versions::eos_version, 2> ENTRIES[] = {
+        {versions::JP, "Japan", {"JP"}},
+        {versions::NA, "North America", {"NA", "US"}},
+    };
+    static constexpr auto TABLES = ids::make_idmap_tables<ENTRIES>();
+    // Sorted by ID
+    static_assert(TABLES.records.size() == 2);
+    static_assert(TABLES.records[0].id == versions::NA);
+    static_assert(TABLES.records[1].id == versions::JP);
+    static_assert(TABLES.alt_names.size() == 3);
+
+    static constexpr ids::IDMap<versions::eos_version> map{TABLES};
+    REQUIRE(map["north america"] == versions::NA);
+    REQUIRE(map["us"] == versions::NA);
+    REQUIRE(map["JAPAN"] == versions::JP);
+    REQUIRE(map[versions::JP] == "Japan");
+    REQUIRE(map.alternate_names(versions::NA).to_vector() ==
+            std::vector<std::string>{"NA", "US"});
+    static_assert(map.contains("japan"));
+    REQUIRE(!map.contains("EU"));
+    REQUIRE_THROWS_AS(map[versions::EU], std::out_of_range);
+    REQUIRE(map.all_except() == std::vector<std::string>{"North America", "Japan"});
 }
 TEST_CASE("contains() works") {
     REQUIRE(ids::MOVE.contains("heat wave"));
     REQUIRE(!ids::MOVE.contains("latios"));
+    REQUIRE(ids::MOVE.contains(eos::MOVE_HEAT_WAVE));
+    REQUIRE(!ids::MOVE.contains(static_cast<eos::move_id>(0xFFFF)));
 }
 TEST_CASE("all_except() returns an ordered list of names") {
     std::vector<std::string> all_statuses = ids::STATUS.all_except();
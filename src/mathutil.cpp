@@ -83,20 +83,9 @@ bool operator<(const Fx32& lhs, const Fx32& rhs) {
     return lhs.raw < rhs.raw;
 }
 bool operator>(const Fx32& lhs, const Fx32& rhs) { return rhs < lhs; }
+bool operator==(const Fx32& lhs, const Fx32& rhs) { return lhs.raw == rhs.raw; }
+bool operator!=(const Fx32& lhs, const Fx32& rhs) { return !(lhs == rhs); }
 
-const Fx32 Fx32::CONST_NEG0_5 = Fx32{0xFFFFFF, 0x80};
-const Fx32 Fx32::CONST_0_25 = Fx32{0, 0x40};
-const Fx32 Fx32::CONST_0_5 = Fx32{0, 0x80};
-const Fx32 Fx32::CONST_153_DIV_256 = Fx32{0, 153};
-const Fx32 Fx32::CONST_1_DIV_SQRT2 = Fx32{0, 0xB5};
-const Fx32 Fx32::CONST_0_75 = Fx32{0, 0xC0};
-const Fx32 Fx32::CONST_0_8 = Fx32{0, 0xCC};
-const Fx32 Fx32::CONST_1_2 = Fx32{1, 0x33};
-const Fx32 Fx32::CONST_1_25 = Fx32{1, 0x40};
-const Fx32 Fx32::CONST_85_DIV_64 = Fx32{1, 0x54};
-const Fx32 Fx32::CONST_1_4 = Fx32{1, 0x66};
-const Fx32 Fx32::CONST_1_5 = Fx32{1, 0x80};
-const Fx32 Fx32::CONST_1_7 = Fx32{1, 0xB3};
 
 // These operations aren't really true to how the game does it, but should be equivalent. The
 // game's code is significantly more complex because it uses a 32-bit instruction set
@@ -213,9 +202,6 @@ bool operator<(const Fx64& lhs, const Fx64& rhs) {
 bool operator==(const Fx64& lhs, const Fx64& rhs) { return lhs.raw == rhs.raw; }
 bool operator!=(const Fx64& lhs, const Fx64& rhs) { return !(lhs == rhs); }
 
-const Fx64 Fx64::CONST_0_5 = Fx64{0, 0x8000};
-const Fx64 Fx64::CONST_0_75 = Fx64{0, 0xC000};
-const Fx64 Fx64::CONST_1_5 = Fx64{0, 0x18000};
 
 // pmdsky-debug: CeilFixedPoint ([NA] 0x2051064)
 int32_t DecFx16_16::ceil() const {
@@ -37,14 +37,16 @@ class Fx32 {
     static const Fx32 CONST_1_5;
     static const Fx32 CONST_1_7;
 
-    Fx32() { raw = 0; }
-    Fx32(uint32_t ipart, uint8_t fpart) { raw = (ipart << 8) | fpart; }
-    Fx32(const Fx32& fx32) { raw = fx32.raw; }
-    Fx32(uint32_t x) { raw = x << 8; }
-    Fx32(int32_t x) : Fx32(static_cast<uint32_t>(x)) {}
+    // The constructors are constexpr so that constants and data tables of Fx32s can be built at
+    // compile time, instead of by static initializers at startup
+    constexpr Fx32() : raw(0) {}
+    constexpr Fx32(uint32_t ipart, uint8_t fpart) : raw((ipart << 8) | fpart) {}
+    constexpr Fx32(const Fx32& fx32) : raw(fx32.raw) {}
+    constexpr Fx32(uint32_t x) : raw(x << 8) {}
+    constexpr Fx32(int32_t x) : Fx32(static_cast<uint32_t>(x)) {}
     bool is_negative() const;
     // Not used in the damage calc; for debug use only
-    uint32_t get_raw() const { return raw; }
+    constexpr uint32_t get_raw() const { return raw; }
     // Truncate to just the integer part.
     // In the original binary, this is just an arithmetic right-shift by 8
     int32_t trunc() const;
@@ -60,8 +62,24 @@ class Fx32 {
 
     friend bool operator<(const Fx32& lhs, const Fx32& rhs);
     friend bool operator>(const Fx32& lhs, const Fx32& rhs);
+    friend bool operator==(const Fx32& lhs, const Fx32& rhs);
+    friend bool operator!=(const Fx32& lhs, const Fx32& rhs);
 };
 
+inline constexpr Fx32 Fx32::CONST_NEG0_5{0xFFFFFF, 0x80};
+inline constexpr Fx32 Fx32::CONST_0_25{0, 0x40};
+inline constexpr Fx32 Fx32::CONST_0_5{0, 0x80};
+inline constexpr Fx32 Fx32::CONST_153_DIV_256{0, 153};
+inline constexpr Fx32 Fx32::CONST_1_DIV_SQRT2{0, 0xB5};
+inline constexpr Fx32 Fx32::CONST_0_75{0, 0xC0};
+inline constexpr Fx32 Fx32::CONST_0_8{0, 0xCC};
+inline constexpr Fx32 Fx32::CONST_1_2{1, 0x33};
+inline constexpr Fx32 Fx32::CONST_1_25{1, 0x40};
+inline constexpr Fx32 Fx32::CONST_85_DIV_64{1, 0x54};
+inline constexpr Fx32 Fx32::CONST_1_4{1, 0x66};
+inline constexpr Fx32 Fx32::CONST_1_5{1, 0x80};
+inline constexpr Fx32 Fx32::CONST_1_7{1, 0xB3};
+
 // 64-bit signed, binary fixed-point number used by the game for many math operations in the
 // damage calcalation routines specifically. The lower 16 bits are the fraction bits.
 // The actual game represents these as a pair of 32-bit integers, one for the high bits and one
@@ -73,10 +91,12 @@ class Fx64 {
     static const Fx64 CONST_0_5;
     static const Fx64 CONST_0_75;
     static const Fx64 CONST_1_5;
+    static const Fx64 CONST_8;
+    static const Fx64 CONST_85_DIV_64;
 
-    Fx64() { raw = 0; }
-    Fx64(uint32_t high, uint32_t low) { raw = (static_cast<uint64_t>(high) << 32) | low; }
-    Fx64(const Fx64& fx64) { raw = fx64.raw; }
+    constexpr Fx64() : raw(0) {}
+    constexpr Fx64(uint32_t high, uint32_t low) : raw((static_cast<uint64_t>(high) << 32) | low) {}
+    constexpr Fx64(const Fx64& fx64) : raw(fx64.raw) {}
     // pmdsky-debug: FixedPoint32To64 ([NA] 0x2001CD4)
     Fx64(Fx32 fx32) {
         raw = static_cast<uint64_t>(fx32.raw) << 8;
@@ -94,8 +114,8 @@ class Fx64 {
         }
     }
     Fx64(int32_t x) : Fx64(static_cast<uint32_t>(x)) {}
-    // Not used in the damage calc; for debug use only
-    uint64_t get_raw() const { return raw; }
+    // Not used for arithmetic in the damage calc; for memo keys and debug use only
+    constexpr uint64_t get_raw() const { return raw; }
     bool is_negative() const;
     int32_t round() const;
     double val() const; // Only for use with displaying output, NOT FULLY PRECISE
@@ -110,8 +130,48 @@ class Fx64 {
     friend bool operator<(const Fx64& lhs, const Fx64& rhs);
     friend bool operator==(const Fx64& lhs, const Fx64& rhs);
     friend bool operator!=(const Fx64& lhs, const Fx64& rhs);
+
+    template <const Fx64& DIVISOR> friend Fx64 div_by_constant(Fx64 lhs);
 };
 
+inline constexpr Fx64 Fx64::CONST_0_5{0, 0x8000};
+inline constexpr Fx64 Fx64::CONST_0_75{0, 0xC000};
+inline constexpr Fx64 Fx64::CONST_1_5{0, 0x18000};
+inline constexpr Fx64 Fx64::CONST_8{0, 0x80000};
+inline constexpr Fx64 Fx64::CONST_85_DIV_64{0, 0x15400};
+
+// Same as lhs / DIVISOR, bit for bit, but for a divisor known at compile time. operator/= needs
+// up to three 64-bit divisions by a runtime value; here the divisor is split into 2^SHIFT * ODD,
+// and the divisions by ODD are by a constant, which the compiler turns into shifts and
+// multiplications. The divisor has to be at least 1, so the quotient can't overflow.
+template <const Fx64& DIVISOR> Fx64 div_by_constant(Fx64 lhs) {
+    constexpr uint64_t RHS_RAW = DIVISOR.raw;
+    static_assert(RHS_RAW >= (static_cast<uint64_t>(1) << 16) &&
+                      RHS_RAW < (static_cast<uint64_t>(1) << 48),
+                  "divisor must be in [1, 2^32)");
+    constexpr int SHIFT = [] {
+        int shift = 0;
+        while (!((RHS_RAW >> shift) & 1)) {
+            shift++;
+        }
+        return shift;
+    }();
+    constexpr uint64_t ODD = RHS_RAW >> SHIFT;
+
+    // operator/= always comes out to floor((l << 16) / r), even in its large-lhs branches
+    uint64_t lhs_raw = lhs.is_negative() ? -lhs.raw : lhs.raw;
+    uint64_t quotient_raw;
+    if constexpr (SHIFT >= 16) {
+        quotient_raw = (lhs_raw >> (SHIFT - 16)) / ODD;
+    } else {
+        // floor((l << s) / d) == (floor(l / d) << s) + floor(((l % d) << s) / d)
+        constexpr int S = 16 - SHIFT;
+        quotient_raw = ((lhs_raw / ODD) << S) + (((lhs_raw % ODD) << S) / ODD);
+    }
+    lhs.raw = lhs.is_negative() ? -quotient_raw : quotient_raw;
+    return lhs;
+}
+
 // A 32-bit decimal fixed-point number, used by the game for belly.
 // This class matches what the game does, with a 16-bit integer for the integer part and another
 // 16-bit integer for thousandths.
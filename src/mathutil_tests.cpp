@@ -96,6 +96,9 @@ TEST_CASE("Fx32 binary operators work", "[Fx32]") {
         REQUIRE(z > m);
         REQUIRE(m < n);
         REQUIRE(n < x);
+        REQUIRE(x == Fx32(1, 0x80));
+        REQUIRE(x != y);
+        REQUIRE_FALSE(n == Fx32(2, 0x80));
     }
 }
 TEST_CASE("Fx32 predefined constants are correct", "[Fx32]") {
@@ -113,6 +116,12 @@ TEST_CASE("Fx32 predefined constants are correct", "[Fx32]") {
     REQUIRE(Fx32::CONST_1_5.val() == 1.5);
     REQUIRE(Fx32::CONST_1_7.val() == 1.69921875);
 }
+TEST_CASE("Fx32 can be constructed at compile time", "[Fx32]") {
+    constexpr Fx32 x(1, 0x80);
+    STATIC_REQUIRE(x.get_raw() == 0x180);
+    STATIC_REQUIRE(Fx32::CONST_1_5.get_raw() == 0x180);
+    STATIC_REQUIRE(Fx32(-10).get_raw() == 0xFFFFF600);
+}
 
 TEST_CASE("Fx64 default constructor sets value to 0", "[Fx64]") { REQUIRE(Fx64().get_raw() == 0); }
 TEST_CASE("Fx64 can be constructed from high and low parts", "[Fx64]") {
@@ -224,6 +233,50 @@ TEST_CASE("Fx64 predefined constants are correct", "[Fx64]") {
     REQUIRE(Fx64::CONST_0_5.get_raw() == 0x8000);
     REQUIRE(Fx64::CONST_0_75.get_raw() == 0xC000);
     REQUIRE(Fx64::CONST_1_5.get_raw() == 0x18000);
+    REQUIRE(Fx64::CONST_8 == Fx64{8});
+    REQUIRE(Fx64::CONST_85_DIV_64 == Fx64{Fx32::CONST_85_DIV_64});
+}
+TEST_CASE("div_by_constant() matches Fx64 division exactly", "[Fx64]") {
+    // Counts mismatches rather than asserting on each value, since there are millions of them
+    int mismatches = 0;
+    auto check = [&](Fx64 x) {
+        if (div_by_constant<Fx64::CONST_8>(x) != x / Fx64::CONST_8) {
+            mismatches++;
+        }
+        if (div_by_constant<Fx64::CONST_85_DIV_64>(x) != x / Fx64::CONST_85_DIV_64) {
+            mismatches++;
+        }
+    };
+
+    SECTION("every value in the damage calc's range") {
+        // The damage calc divides (offense - defense) and the base damage, both of which are far
+        // smaller than 2^15 in magnitude
+        for (int32_t x = -(1 << 20); x <= (1 << 20); x++) {
+            check(Fx64{x});
+        }
+        for (int64_t raw = -(1 << 23); raw <= (1 << 23); raw++) {
+            check(Fx64(static_cast<uint64_t>(raw) >> 32, static_cast<uint32_t>(raw)));
+        }
+    }
+    SECTION("values across the whole range") {
+        // Including the large values that go through the other branches of operator/=
+        const uint64_t edges[] = {0x7FFFFFFFFFFFFFFF, 0x8000000000000000, 0xFFFFFFFFFFFFFFFF,
+                                  0x0000FFFFFFFFFFFF, 0x0001000000000000, 0xFFFF000000000000};
+        for (uint64_t raw : edges) {
+            check(Fx64(raw >> 32, static_cast<uint32_t>(raw)));
+        }
+        uint64_t state = 0x9E3779B97F4A7C15;
+        for (int i = 0; i < 1000000; i++) {
+            // xorshift64, shifted by a varying amount so that every magnitude gets covered
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            uint64_t raw = state >> (i % 64);
+            check(Fx64(raw >> 32, static_cast<uint32_t>(raw)));
+            check(Fx64(-raw >> 32, static_cast<uint32_t>(-raw)));
+        }
+    }
+    REQUIRE(mismatches == 0);
 }
 
 TEST_CASE("DecFx16_16 can be constructed from its raw parts", "[DecFx16_16]") {
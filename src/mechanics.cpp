@@ -442,6 +442,80 @@ const Fx32 mechanics::MATCHUP_NEUTRAL_MULTIPLIER = Fx32{1};
 // pmdsky-debug: MATCHUP_SUPER_EFFECTIVE_MULTIPLIER ([NA] 0x22C4818)
 const Fx32 mechanics::MATCHUP_SUPER_EFFECTIVE_MULTIPLIER = Fx32::CONST_1_4;
 
+// Mirrors the loop over the target's types in CalcTypeBasedDamageEffects.
+// The game stops multiplying early if the multiplier ever hits 0, but none of the matchup
+// multipliers are 0, so that can't happen here.
+static mechanics::TypeMatchupCombination build_type_matchup_combination(
+    eos::type_matchup matchup0, eos::type_matchup matchup1) {
+    const Fx32* multiplier_tables[2][4] = {
+        {
+            &mechanics::MATCHUP_IMMUNE_MULTIPLIER,
+            &mechanics::MATCHUP_NOT_VERY_EFFECTIVE_MULTIPLIER,
+            &mechanics::MATCHUP_NEUTRAL_MULTIPLIER,
+            &mechanics::MATCHUP_SUPER_EFFECTIVE_MULTIPLIER,
+        },
+        {
+            &mechanics::MATCHUP_IMMUNE_MULTIPLIER_ERRATIC_PLAYER,
+            &mechanics::MATCHUP_NOT_VERY_EFFECTIVE_MULTIPLIER_ERRATIC_PLAYER,
+            &mechanics::MATCHUP_NEUTRAL_MULTIPLIER_ERRATIC_PLAYER,
+            &mechanics::MATCHUP_SUPER_EFFECTIVE_MULTIPLIER_ERRATIC_PLAYER,
+        },
+    };
+    mechanics::TypeMatchupCombination combination{};
+    combination.indiv[0] = matchup0;
+    combination.indiv[1] = matchup1;
+    combination.combined = mechanics::TYPE_MATCHUP_COMBINATOR_TABLE[matchup0][matchup1];
+    for (int erratic_player = 0; erratic_player < 2; erratic_player++) {
+        for (int apply_neutral = 0; apply_neutral < 2; apply_neutral++) {
+            Fx64 mult{1};
+            for (auto matchup : combination.indiv) {
+                if (apply_neutral || matchup != eos::MATCHUP_NEUTRAL) {
+                    mult *= Fx64{*multiplier_tables[erratic_player][matchup]};
+                }
+            }
+            combination.multipliers[erratic_player][apply_neutral] = mult;
+        }
+    }
+    return combination;
+}
+
+const mechanics::TypeMatchupCombination&
+mechanics::combine_type_matchups(eos::type_matchup matchup0, eos::type_matchup matchup1) {
+    // Built on first use, since the multipliers are defined in other translation units
+    static const auto TABLE = [] {
+        std::array<std::array<TypeMatchupCombination, 4>, 4> table;
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                table[i][j] = build_type_matchup_combination(static_cast<eos::type_matchup>(i),
+                                                             static_cast<eos::type_matchup>(j));
+            }
+        }
+        return table;
+    }();
+    return TABLE[matchup0][matchup1];
+}
+
+const mechanics::TypeMatchupCombination&
+mechanics::get_dual_type_matchup(eos::type_id attack_type, eos::type_id target_type0,
+                                 eos::type_id target_type1) {
+    // Each entry is a pair of individual matchups, packed as (matchup0 << 2) | matchup1
+    static const auto TABLE = [] {
+        std::array<std::array<std::array<uint8_t, 18>, 18>, 18> table;
+        for (int atk = 0; atk < 18; atk++) {
+            for (int t0 = 0; t0 < 18; t0++) {
+                for (int t1 = 0; t1 < 18; t1++) {
+                    table[atk][t0][t1] =
+                        (TYPE_MATCHUP_TABLE[atk][t0] << 2) | TYPE_MATCHUP_TABLE[atk][t1];
+                }
+            }
+        }
+        return table;
+    }();
+    uint8_t packed = TABLE[attack_type][target_type0][target_type1];
+    return combine_type_matchups(static_cast<eos::type_matchup>(packed >> 2),
+                                 static_cast<eos::type_matchup>(packed & 0x3));
+}
+
 // pmdsky-debug: TYPE_DAMAGE_NEGATING_EXCLUSIVE_ITEM_EFFECTS ([NA] 0x23528A4)
 const eos::damage_negating_exclusive_eff_entry
     mechanics::TYPE_DAMAGE_NEGATING_EXCLUSIVE_ITEM_EFFECTS[28] = {
@@ -645,6 +719,29 @@ const Fx32 mechanics::DEFENSIVE_STAT_STAGE_MULTIPLIERS[21] = {
     {3, 0x19}, // ~3.1
     {3, 0x4C}, // ~3.3
 };
+
+// A stat after each stage multiplier, indexed by [stage][stat]
+using StatStageTable = std::array<std::array<uint16_t, 256>, 21>;
+static StatStageTable build_stat_stage_table(const Fx32 (&multipliers)[21]) {
+    StatStageTable table;
+    for (int stage = 0; stage < 21; stage++) {
+        for (int stat = 0; stat < 256; stat++) {
+            table[stage][stat] = (Fx32{stat} * multipliers[stage]).trunc();
+        }
+    }
+    return table;
+}
+
+int32_t mechanics::offensive_stat_after_stage(int32_t stage, uint8_t stat) {
+    // Built on first use, like the type matchup tables
+    static const auto TABLE = build_stat_stage_table(OFFENSIVE_STAT_STAGE_MULTIPLIERS);
+    return TABLE[stage][stat];
+}
+int32_t mechanics::defensive_stat_after_stage(int32_t stage, uint8_t stat) {
+    static const auto TABLE = build_stat_stage_table(DEFENSIVE_STAT_STAGE_MULTIPLIERS);
+    return TABLE[stage][stat];
+}
+
 // pmdsky-debug: MALE_ACCURACY_STAGE_MULTIPLIERS ([NA] 0x22C540C)
 const Fx32 mechanics::MALE_ACCURACY_STAGE_MULTIPLIERS[21] = {
     {0, 0x54}, // ~0.33
@@ -962,7 +1059,8 @@ SpeciesSpec::SpeciesSpec(eos::monster_id monster_id) : id(monster_id) {
 
 // Data from /BALANCE/waza_p.bin
 // (The last two fields aren't actually in the game)
-const data_files::MoveData mechanics::data_files::MOVES[559] = {
+// constexpr so the notes are laid out at compile time rather than built at startup
+constexpr data_files::MoveData mechanics::data_files::MOVES[559] = {
     {eos::MOVE_NOTHING, 0, eos::TYPE_NORMAL, eos::CATEGORY_PHYSICAL, 99, 0, 0, 0, 0, false,
      "0x damage multiplier"},
     {eos::MOVE_IRON_TAIL, 40, eos::TYPE_STEEL, eos::CATEGORY_PHYSICAL, 10, 125, 78, 1, 8, false,
@@ -9,6 +9,7 @@
 #include <array>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include "mathutil.hpp"
 #include "pmdsky.hpp"
 
@@ -28,6 +29,26 @@ extern const Fx32 MATCHUP_NOT_VERY_EFFECTIVE_MULTIPLIER;
 extern const Fx32 MATCHUP_NEUTRAL_MULTIPLIER;
 extern const Fx32 MATCHUP_SUPER_EFFECTIVE_MULTIPLIER;
 
+// The result of combining the individual type matchups of an attack against both of a target's
+// types, as done in CalcTypeBasedDamageEffects. Not in the game; this is precomputed so the
+// damage calc can do a single table lookup instead of looping over the target's types.
+struct TypeMatchupCombination {
+    eos::type_matchup indiv[2];
+    eos::type_matchup combined;
+    // Combined damage multiplier, indexed by
+    // [Erratic Player multipliers used][neutral matchups applied]
+    Fx64 multipliers[2][2];
+};
+// Combine two individual type matchups
+const TypeMatchupCombination& combine_type_matchups(eos::type_matchup matchup0,
+                                                    eos::type_matchup matchup1);
+// Combined matchup of an attack type against a pair of target types, taken straight from
+// TYPE_MATCHUP_TABLE. This does NOT account for any of the special cases (Ghost immunity,
+// Miracle Eye, Gravity, etc.).
+const TypeMatchupCombination& get_dual_type_matchup(eos::type_id attack_type,
+                                                    eos::type_id target_type0,
+                                                    eos::type_id target_type1);
+
 extern const eos::damage_negating_exclusive_eff_entry
     TYPE_DAMAGE_NEGATING_EXCLUSIVE_ITEM_EFFECTS[28];
 extern const eos::exclusive_item_effect_id EXCL_ITEM_EFFECTS_EVASION_BOOST[8];
@@ -62,6 +83,11 @@ extern const eos::type_id WEATHER_BALL_TYPE_TABLE[8];
 
 extern const Fx32 OFFENSIVE_STAT_STAGE_MULTIPLIERS[21];
 extern const Fx32 DEFENSIVE_STAT_STAGE_MULTIPLIERS[21];
+// trunc(Fx32{stat} * OFFENSIVE_STAT_STAGE_MULTIPLIERS[stage]) (or the defensive equivalent). Not
+// in the game; precomputed for every stage and stat so the damage calc can skip the multiplication
+// when there's no other stat multiplier.
+int32_t offensive_stat_after_stage(int32_t stage, uint8_t stat);
+int32_t defensive_stat_after_stage(int32_t stage, uint8_t stat);
 extern const Fx32 MALE_ACCURACY_STAGE_MULTIPLIERS[21];
 extern const Fx32 MALE_EVASION_STAGE_MULTIPLIERS[21];
 extern const Fx32 FEMALE_ACCURACY_STAGE_MULTIPLIERS[21];
@@ -207,8 +233,8 @@ struct MoveData {
     uint8_t accuracy2;
     uint8_t strikes;
     uint8_t crit_chance;
-    bool unsupported;          // Not actually in the data files
-    std::string special_notes; // Not actually in the data files
+    bool unsupported;               // Not actually in the data files
+    std::string_view special_notes; // Not actually in the data files
 };
 extern const MoveData MOVES[559];
 
@@ -3,6 +3,56 @@
 
 using namespace mechanics;
 
+TEST_CASE("get_dual_type_matchup() works", "[types]") {
+    SECTION("Super effective against both types") {
+        auto& matchup = get_dual_type_matchup(eos::TYPE_FIRE, eos::TYPE_GRASS, eos::TYPE_STEEL);
+        REQUIRE(matchup.indiv[0] == eos::MATCHUP_SUPER_EFFECTIVE);
+        REQUIRE(matchup.indiv[1] == eos::MATCHUP_SUPER_EFFECTIVE);
+        REQUIRE(matchup.combined == eos::MATCHUP_SUPER_EFFECTIVE);
+        REQUIRE(matchup.multipliers[0][0] == Fx64{MATCHUP_SUPER_EFFECTIVE_MULTIPLIER} *
+                                                 Fx64{MATCHUP_SUPER_EFFECTIVE_MULTIPLIER});
+        REQUIRE(matchup.multipliers[1][0] ==
+                Fx64{MATCHUP_SUPER_EFFECTIVE_MULTIPLIER_ERRATIC_PLAYER} *
+                    Fx64{MATCHUP_SUPER_EFFECTIVE_MULTIPLIER_ERRATIC_PLAYER});
+    }
+    SECTION("Mixed matchups") {
+        auto& matchup = get_dual_type_matchup(eos::TYPE_WATER, eos::TYPE_GROUND, eos::TYPE_WATER);
+        REQUIRE(matchup.indiv[0] == eos::MATCHUP_SUPER_EFFECTIVE);
+        REQUIRE(matchup.indiv[1] == eos::MATCHUP_NOT_VERY_EFFECTIVE);
+        REQUIRE(matchup.combined == eos::MATCHUP_NEUTRAL);
+        REQUIRE(matchup.multipliers[0][1] == Fx64{MATCHUP_SUPER_EFFECTIVE_MULTIPLIER} *
+                                                 Fx64{MATCHUP_NOT_VERY_EFFECTIVE_MULTIPLIER});
+    }
+    SECTION("Neutral matchups are only applied when requested") {
+        auto& matchup = get_dual_type_matchup(eos::TYPE_NORMAL, eos::TYPE_ROCK, eos::TYPE_NONE);
+        REQUIRE(matchup.indiv[0] == eos::MATCHUP_NOT_VERY_EFFECTIVE);
+        REQUIRE(matchup.indiv[1] == eos::MATCHUP_NEUTRAL);
+        REQUIRE(matchup.combined == eos::MATCHUP_NOT_VERY_EFFECTIVE);
+        REQUIRE(matchup.multipliers[1][0] ==
+                Fx64{MATCHUP_NOT_VERY_EFFECTIVE_MULTIPLIER_ERRATIC_PLAYER});
+        REQUIRE(matchup.multipliers[1][1] ==
+                Fx64{MATCHUP_NOT_VERY_EFFECTIVE_MULTIPLIER_ERRATIC_PLAYER} *
+                    Fx64{MATCHUP_NEUTRAL_MULTIPLIER_ERRATIC_PLAYER});
+    }
+    SECTION("Matches the type matchup tables for all types") {
+        for (int atk = 0; atk < 18; atk++) {
+            for (int t0 = 0; t0 < 18; t0++) {
+                for (int t1 = 0; t1 < 18; t1++) {
+                    auto m0 = TYPE_MATCHUP_TABLE[atk][t0];
+                    auto m1 = TYPE_MATCHUP_TABLE[atk][t1];
+                    auto& matchup = get_dual_type_matchup(static_cast<eos::type_id>(atk),
+                                                          static_cast<eos::type_id>(t0),
+                                                          static_cast<eos::type_id>(t1));
+                    REQUIRE(&matchup == &combine_type_matchups(m0, m1));
+                    REQUIRE(matchup.indiv[0] == m0);
+                    REQUIRE(matchup.indiv[1] == m1);
+                    REQUIRE(matchup.combined == TYPE_MATCHUP_COMBINATOR_TABLE[m0][m1]);
+                }
+            }
+        }
+    }
+}
+
 TEST_CASE("get_move_type() works", "[moves]") {
     REQUIRE(get_move_type(eos::MOVE_HEAT_WAVE) == eos::TYPE_FIRE);
     REQUIRE(get_move_type(eos::MOVE_SPACIAL_REND) == eos::TYPE_DRAGON);
@@ -62,6 +112,18 @@ TEST_CASE("MoveSpec can be constructed from move ID", "[moves]") {
     REQUIRE(move.pp == 4);
 }
 
+TEST_CASE("Stats after stage multipliers match the multipliers exactly", "[stats]") {
+    for (int32_t stage = 0; stage < 21; stage++) {
+        for (int32_t stat = 0; stat < 256; stat++) {
+            // The damage calc only uses the tables when the extra multiplier is exactly 1
+            Fx32 off = Fx32{stat} * OFFENSIVE_STAT_STAGE_MULTIPLIERS[stage] * Fx32{1};
+            Fx32 def = Fx32{stat} * DEFENSIVE_STAT_STAGE_MULTIPLIERS[stage] * Fx32{1};
+            REQUIRE(offensive_stat_after_stage(stage, stat) == off.trunc());
+            REQUIRE(defensive_stat_after_stage(stage, stat) == def.trunc());
+        }
+    }
+}
+
 TEST_CASE("is_aura_bow() works", "[items]") {
     REQUIRE(!is_aura_bow(eos::ITEM_POWER_BAND));
     REQUIRE(is_aura_bow(eos::ITEM_SILVER_BOW));
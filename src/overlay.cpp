@@ -0,0 +1,101 @@
+#include "overlay.hpp"
+
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+using nlohmann::json;
+using cfgparse::ConfigTape;
+
+namespace overlay {
+BaseConfig::BaseConfig(const json& cfg) : root(tape.add(cfg)) { parse_sections(); }
+BaseConfig::BaseConfig(const std::string& text) : root(tape.parse(text)) { parse_sections(); }
+
+void BaseConfig::parse_sections() {
+    if (!root.is_object()) {
+        throw std::invalid_argument("base config must be an object");
+    }
+    for (int section = 0; section < cfgparse::N_SECTIONS; section++) {
+        try {
+            cfgparse::parse_cfg_section(root, static_cast<cfgparse::Section>(section), inputs);
+        } catch (const std::exception&) {
+            errors[section] = std::current_exception();
+        }
+    }
+}
+
+CalcInputs BaseConfig::apply(const ConfigTape::Node& overlay, ConfigTape& scratch) const {
+    if (!overlay.is_object()) {
+        throw std::invalid_argument("config overlay must be an object");
+    }
+    std::array<bool, cfgparse::N_SECTIONS + 1> touched = {};
+    for (auto value : overlay) {
+        touched[cfgparse::section_of(value.key())] = true;
+    }
+
+    CalcInputs result = inputs;
+    // Only build the merged config if it's needed, and then only parse the sections that changed
+    std::optional<ConfigTape::Node> merged;
+    for (int section = 0; section < cfgparse::N_SECTIONS; section++) {
+        if (touched[section]) {
+            if (!merged) {
+                merged = scratch.merge_patch(root, overlay);
+            }
+            cfgparse::parse_cfg_section(*merged, static_cast<cfgparse::Section>(section), result);
+        } else if (errors[section]) {
+            std::rethrow_exception(errors[section]);
+        }
+    }
+    return result;
+}
+CalcInputs BaseConfig::apply(const json& overlay) const {
+    ConfigTape scratch;
+    return apply(scratch.add(overlay), scratch);
+}
+
+void BaseConfigs::add(const std::string& name, std::unique_ptr<const BaseConfig> base) {
+    bases.insert_or_assign(name, std::move(base));
+}
+bool BaseConfigs::remove(std::string_view name) {
+    auto it = bases.find(name);
+    if (it == bases.end()) {
+        return false;
+    }
+    bases.erase(it);
+    return true;
+}
+const BaseConfig* BaseConfigs::find(std::string_view name) const {
+    auto it = bases.find(name);
+    return it == bases.end() ? nullptr : it->second.get();
+}
+
+CalcInputs BaseConfigs::parse(const ConfigTape::Node& cfg, ConfigTape& tape) const {
+    if (!cfg.contains("base")) {
+        return parse_cfg(cfg);
+    }
+    std::string_view name = cfg.at("base").get_string();
+    const BaseConfig* base = find(name);
+    if (!base) {
+        throw std::invalid_argument("unknown base config '" + std::string(name) + "'");
+    }
+    return base->apply(cfg, tape);
+}
+
+BaseConfigs load_base_configs(const std::vector<std::string>& specs) {
+    BaseConfigs bases;
+    for (const auto& spec : specs) {
+        std::size_t eq = spec.find('=');
+        if (eq == std::string::npos) {
+            throw std::invalid_argument("base config '" + spec + "' must be given as NAME=FILE");
+        }
+        std::string filename = spec.substr(eq + 1);
+        std::ifstream file(filename);
+        if (file.fail()) {
+            throw std::invalid_argument("could not find base config file '" + filename + "'");
+        }
+        bases.add(spec.substr(0, eq), std::make_unique<const BaseConfig>(json::parse(file)));
+    }
+    return bases;
+}
+} // namespace overlay
@@ -0,0 +1,83 @@
+// Base configs that are parsed once, and overlays that calcs can apply on top of them
+
+#ifndef OVERLAY_HPP_
+#define OVERLAY_HPP_
+
+#include <array>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "cfgparse.hpp"
+#include "cfgtape.hpp"
+#include "damage.hpp"
+
+namespace overlay {
+// Calc inputs, as returned by parse_cfg() (same as batch::CalcInputs)
+using CalcInputs = std::tuple<DungeonState, MonsterEntity, MonsterEntity, Move, int32_t>;
+
+// A config that's parsed ahead of time, so that configs which only differ from it slightly don't
+// have to be parsed in full.
+//
+// Overlays are JSON merge patches (RFC 7386) on the base config. Each section of the config (see
+// cfgparse::Section) that an overlay doesn't touch is copied from the already-parsed base, and
+// only the touched sections are parsed again, from the merged config. The base doesn't have to
+// be a complete config: sections of the base that fail to parse (e.g., because the defender is
+// missing) are only an error for overlays that don't replace them.
+class BaseConfig {
+    cfgparse::ConfigTape tape;
+    cfgparse::ConfigTape::Node root;
+    CalcInputs inputs;
+    // The exception from parsing each section, if any
+    std::array<std::exception_ptr, cfgparse::N_SECTIONS> errors;
+
+    void parse_sections();
+
+  public:
+    // Throws std::invalid_argument if the config isn't an object
+    explicit BaseConfig(const nlohmann::json& cfg);
+    // Same as above, but for JSON text. Also throws the same exceptions as nlohmann::json::parse().
+    explicit BaseConfig(const std::string& text);
+    // Nodes hold references into the tape
+    BaseConfig(const BaseConfig&) = delete;
+    BaseConfig& operator=(const BaseConfig&) = delete;
+
+    // Calc inputs for the base config with an overlay applied, throwing the same exceptions
+    // parse_cfg() would for the merged config. Top-level overlay keys that aren't part of any
+    // section (like "id") are ignored. The merged sections are built in tape, which the caller
+    // owns so that it can be reused.
+    CalcInputs apply(const cfgparse::ConfigTape::Node& overlay, cfgparse::ConfigTape& tape) const;
+    CalcInputs apply(const nlohmann::json& overlay) const;
+};
+
+// Base configs, by name. Looking up base configs is thread-safe as long as the set isn't being
+// modified at the same time.
+class BaseConfigs {
+    std::map<std::string, std::unique_ptr<const BaseConfig>, std::less<>> bases;
+
+  public:
+    // Add a base config, replacing any existing one with the same name
+    void add(const std::string& name, std::unique_ptr<const BaseConfig> base);
+    // Returns false if there was no base config with the name
+    bool remove(std::string_view name);
+    // Returns nullptr if there's no base config with the name
+    const BaseConfig* find(std::string_view name) const;
+    std::size_t size() const { return bases.size(); }
+
+    // Parse a config, which is either a full config, or an overlay if it has a "base" field with
+    // the name of a base config. Throws std::invalid_argument if the named base config doesn't
+    // exist, and otherwise the same exceptions as parse_cfg().
+    CalcInputs parse(const cfgparse::ConfigTape::Node& cfg, cfgparse::ConfigTape& tape) const;
+};
+
+// Load base configs from files, each given as NAME=FILE. Throws std::invalid_argument if a spec is
+// malformed or a file can't be opened, and otherwise the same exceptions as BaseConfig.
+BaseConfigs load_base_configs(const std::vector<std::string>& specs);
+} // namespace overlay
+
+#endif
@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "batch.hpp"
+#include "overlay.hpp"
+
+using nlohmann::json;
+using cfgparse::ConfigTape;
+
+namespace {
+json make_base() {
+    return {
+        {"attacker",
+         {{"species", "charmander"},
+          {"level", 30},
+          {"sp_atk", 40},
+          {"iq_skills", {"type-advantage master"}},
+          {"stat_modifiers", {{"stages", {{"sp_atk", 12}}}}}}},
+        {"dungeon", {{"weather", "sunny"}}},
+        {"move", {{"id", "ember"}}},
+    };
+}
+
+// Results of calculating inputs, for comparing
+json summarize(const overlay::CalcInputs& inputs) {
+    return batch::summarize(batch::run_calc(inputs));
+}
+} // namespace
+
+TEST_CASE("Overlays give the same results as merged configs", "[overlay]") {
+    overlay::BaseConfig base(make_base());
+    std::vector<json> overlays = {
+        {{"defender", {{"species", "bulbasaur"}, {"level", 20}}}},
+        {{"defender", {{"species", "squirtle"}, {"sp_def", 50}}}, {"dungeon", {{"weather", "rain"}}}},
+        {{"defender", {{"species", "bulbasaur"}}},
+         {"attacker", {{"level", 50}, {"iq_skills", json::array()}}}},
+        {{"defender", {{"species", "bulbasaur"}}},
+         {"attacker", {{"stat_modifiers", {{"stages", {{"sp_atk", nullptr}}}}}}}},
+        {{"defender", {{"species", "bulbasaur"}}}, {"dungeon", nullptr}, {"id", 5}},
+        {{"defender", {{"species", "bulbasaur"}}}, {"move", {{"id", "gold fang"}}}},
+        {{"defender", {{"species", "bulbasaur"}}}, {"misc", {{"version", "EU"}}}},
+    };
+    ConfigTape tape;
+    for (const auto& patch : overlays) {
+        CAPTURE(patch.dump());
+        json merged = make_base();
+        merged.merge_patch(patch);
+        auto expected = summarize(parse_cfg(merged));
+        REQUIRE(summarize(base.apply(patch)) == expected);
+        tape.clear();
+        REQUIRE(summarize(base.apply(tape.add(patch), tape)) == expected);
+    }
+    // Text and json bases are the same
+    overlay::BaseConfig text_base(make_base().dump());
+    json patch = overlays[1];
+    REQUIRE(summarize(text_base.apply(patch)) == summarize(base.apply(patch)));
+}
+
+TEST_CASE("Overlay errors match parse_cfg()", "[overlay]") {
+    overlay::BaseConfig base(make_base());
+    // The base has no defender, so overlays have to add one
+    REQUIRE_THROWS_AS(base.apply(json::object()), json::out_of_range);
+    REQUIRE_THROWS_AS(base.apply({{"attacker", {{"level", 5}}}}), json::out_of_range);
+    // Errors in the order parse_cfg() hits them
+    json patch = {{"defender", {{"species", "missingno"}}}, {"move", {{"id", "not a move"}}}};
+    std::string expected;
+    try {
+        json merged = make_base();
+        merged.merge_patch(patch);
+        parse_cfg(merged);
+    } catch (const std::exception& e) {
+        expected = e.what();
+    }
+    REQUIRE(!expected.empty());
+    try {
+        base.apply(patch);
+        FAIL("expected an error");
+    } catch (const std::exception& e) {
+        REQUIRE(std::string(e.what()) == expected);
+    }
+    // Broken sections of the base can be replaced
+    json broken = make_base();
+    broken["attacker"]["species"] = "missingno";
+    overlay::BaseConfig broken_base(broken);
+    REQUIRE_THROWS(broken_base.apply({{"defender", {{"species", "bulbasaur"}}}}));
+    REQUIRE_NOTHROW(broken_base.apply(
+        {{"defender", {{"species", "bulbasaur"}}}, {"attacker", {{"species", "charmander"}}}}));
+
+    REQUIRE_THROWS_AS(overlay::BaseConfig(json::array()), std::invalid_argument);
+    REQUIRE_THROWS_AS(base.apply(json::array()), std::invalid_argument);
+}
+
+TEST_CASE("BaseConfigs work", "[overlay]") {
+    overlay::BaseConfigs bases;
+    bases.add("base", std::make_unique<const overlay::BaseConfig>(make_base()));
+    REQUIRE(bases.find("base") != nullptr);
+    REQUIRE(bases.find("other") == nullptr);
+
+    json full = make_base();
+    full["defender"] = {{"species", "bulbasaur"}};
+    json patch = {{"base", "base"}, {"defender", {{"species", "bulbasaur"}}}};
+    ConfigTape tape;
+    REQUIRE(summarize(bases.parse(tape.add(patch), tape)) == summarize(parse_cfg(full)));
+    REQUIRE(summarize(bases.parse(tape.add(full), tape)) == summarize(parse_cfg(full)));
+    patch["base"] = "other";
+    REQUIRE_THROWS_AS(bases.parse(tape.add(patch), tape), std::invalid_argument);
+
+    SECTION("Batches can use base configs") {
+        std::ostringstream input;
+        for (int level = 1; level <= 100; level++) {
+            json line = {{"id", level},
+                         {"base", "base"},
+                         {"defender", {{"species", "bulbasaur"}, {"level", level}}}};
+            input << line.dump() << '\n';
+        }
+        input << patch.dump() << '\n';
+        std::istringstream in(input.str());
+        std::ostringstream out;
+        batch::run_batch(in, out, 4, bases);
+
+        std::istringstream lines(out.str());
+        std::string line;
+        for (int level = 1; level <= 100; level++) {
+            REQUIRE(std::getline(lines, line));
+            full["defender"]["level"] = level;
+            auto expected = summarize(parse_cfg(full));
+            expected["id"] = level;
+            REQUIRE(json::parse(line) == expected);
+        }
+        REQUIRE(std::getline(lines, line));
+        REQUIRE(json::parse(line)["error"] == "unknown base config 'other'");
+    }
+    SECTION("Base configs can be replaced and removed") {
+        json other = make_base();
+        other["attacker"]["level"] = 1;
+        bases.add("base", std::make_unique<const overlay::BaseConfig>(other));
+        patch["base"] = "base";
+        full["attacker"]["level"] = 1;
+        REQUIRE(summarize(bases.parse(tape.add(patch), tape)) == summarize(parse_cfg(full)));
+        REQUIRE(bases.remove("base"));
+        REQUIRE(!bases.remove("base"));
+        REQUIRE(bases.size() == 0);
+    }
+}
@@ -0,0 +1,376 @@
+#include "search.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include "idmap.hpp"
+
+namespace search {
+namespace {
+char to_lower(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - ('A' - 'a');
+    }
+    return c;
+}
+bool is_word_separator(char c) { return c == ' ' || c == '-' || c == '/' || c == '('; }
+bool is_word_start(std::string_view name, std::size_t i) {
+    return !is_word_separator(name[i]) && (i == 0 || is_word_separator(name[i - 1]));
+}
+uint32_t pack_trigram(char a, char b, char c) {
+    return (uint32_t(uint8_t(a)) << 16) | (uint32_t(uint8_t(b)) << 8) | uint32_t(uint8_t(c));
+}
+// Trigrams of a lowercased string, with "$" marking the start. If padded, "$" also marks the end.
+std::vector<uint32_t> get_trigrams(std::string_view str, bool pad_end) {
+    std::string padded = "$" + std::string(str) + (pad_end ? "$" : "");
+    std::vector<uint32_t> trigrams;
+    for (std::size_t i = 0; i + 2 < padded.size(); i++) {
+        trigrams.push_back(pack_trigram(padded[i], padded[i + 1], padded[i + 2]));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+// Fuzzy matches must share at least this fraction of the query's trigrams
+const std::size_t FUZZY_THRESHOLD_NUM = 2;
+const std::size_t FUZZY_THRESHOLD_DENOM = 5;
+const std::size_t FUZZY_MIN_SHARED = 2;
+} // namespace
+
+SearchIndex::SearchIndex(const std::vector<Names>& entries) {
+    primary.reserve(entries.size());
+    for (std::size_t e = 0; e < entries.size(); e++) {
+        primary.push_back(entries[e].empty() ? std::string_view() : entries[e][0]);
+        for (std::size_t i = 0; i < entries[e].size(); i++) {
+            std::string_view name = entries[e][i];
+            if (name.empty()) {
+                continue;
+            }
+            names.push_back({uint16_t(e), i > 0, name, uint32_t(lower.size()), 0});
+            for (char c : name) {
+                lower.push_back(to_lower(c));
+            }
+        }
+    }
+
+    for (std::size_t n = 0; n < names.size(); n++) {
+        std::string_view name = names[n].name;
+        for (std::size_t i = 0; i < name.size(); i++) {
+            if (is_word_start(name, i)) {
+                keys.push_back({uint16_t(n), uint32_t(names[n].lower_begin + i),
+                                uint16_t(name.size() - i), 0});
+            }
+        }
+    }
+
+    // Rank all keys up front, so the trie only needs to compare ranks
+    std::vector<uint32_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto rank_tuple = [&](uint32_t k) {
+        const Key& key = keys[k];
+        const Name& name = names[key.name];
+        bool later_word = key.text_begin != name.lower_begin;
+        return std::make_tuple(later_word, name.alternate, name.name.size(), name.entry, key.name);
+    };
+    std::sort(order.begin(), order.end(),
+              [&](uint32_t a, uint32_t b) { return rank_tuple(a) < rank_tuple(b); });
+    for (std::size_t r = 0; r < order.size(); r++) {
+        Key& key = keys[order[r]];
+        key.rank = r;
+        if (key.text_begin == names[key.name].lower_begin) {
+            names[key.name].rank = r;
+        }
+    }
+    std::sort(keys.begin(), keys.end(), [&](const Key& a, const Key& b) {
+        return std::make_pair(key_text(a), a.rank) < std::make_pair(key_text(b), b.rank);
+    });
+
+    nodes.push_back({0, uint32_t(keys.size()), 0, 0, 0, 0, 0, 0, 0, true});
+    build_node(0, 0);
+
+    for (std::size_t n = 0; n < names.size(); n++) {
+        std::string_view name = std::string_view(lower).substr(names[n].lower_begin,
+                                                               names[n].name.size());
+        for (uint32_t trigram : get_trigrams(name, true)) {
+            trigrams.push_back({trigram, uint16_t(n)});
+        }
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+}
+
+void SearchIndex::build_node(uint32_t node, std::size_t depth) {
+    uint32_t begin = nodes[node].key_begin;
+    uint32_t end = nodes[node].key_end;
+
+    // Keys are sorted, so the common prefix of the first and last keys is common to all of them
+    std::size_t label_end = depth;
+    if (begin < end) {
+        std::string_view first = key_text(keys[begin]);
+        std::string_view last = key_text(keys[end - 1]);
+        while (label_end < first.size() && label_end < last.size() &&
+               first[label_end] == last[label_end]) {
+            label_end++;
+        }
+        nodes[node].label_begin = keys[begin].text_begin + depth;
+    }
+    nodes[node].label_len = label_end - depth;
+
+    // Keys ending at this node sort before longer keys
+    uint32_t i = begin;
+    while (i < end && keys[i].text_len == label_end) {
+        i++;
+    }
+    nodes[node].n_terminal = i - begin;
+
+    // Group the remaining keys by their next character
+    uint32_t child_begin = nodes.size();
+    while (i < end) {
+        char c = key_text(keys[i])[label_end];
+        uint32_t j = i + 1;
+        while (j < end && key_text(keys[j])[label_end] == c) {
+            j++;
+        }
+        nodes.push_back({i, j, 0, 0, 0, 0, 0, 0, 0, true});
+        i = j;
+    }
+    uint32_t child_end = nodes.size();
+    nodes[node].child_begin = child_begin;
+    nodes[node].child_end = child_end;
+    for (uint32_t child = child_begin; child < child_end; child++) {
+        build_node(child, label_end);
+    }
+    find_top(node);
+}
+
+void SearchIndex::find_top(uint32_t node) {
+    std::vector<uint32_t> subtree(nodes[node].key_end - nodes[node].key_begin);
+    std::iota(subtree.begin(), subtree.end(), nodes[node].key_begin);
+    std::sort(subtree.begin(), subtree.end(),
+              [&](uint32_t a, uint32_t b) { return keys[a].rank < keys[b].rank; });
+
+    uint32_t top_begin = top.size();
+    bool complete = true;
+    for (uint32_t k : subtree) {
+        uint16_t entry = names[keys[k].name].entry;
+        bool seen = std::any_of(top.begin() + top_begin, top.end(),
+                                [&](uint32_t t) { return names[keys[t].name].entry == entry; });
+        if (seen) {
+            continue;
+        }
+        if (top.size() - top_begin == TOP_K) {
+            complete = false;
+            break;
+        }
+        top.push_back(k);
+    }
+    nodes[node].top_begin = top_begin;
+    nodes[node].top_end = top.size();
+    nodes[node].top_complete = complete;
+}
+
+std::vector<Match> SearchIndex::search(std::string_view query, std::size_t limit) const {
+    std::vector<Match> matches;
+    std::vector<uint16_t> matched_entries;
+    if (limit == 0) {
+        return matches;
+    }
+    // Returns whether there's room for more matches
+    auto add = [&](uint16_t name_idx) {
+        const Name& name = names[name_idx];
+        if (std::find(matched_entries.begin(), matched_entries.end(), name.entry) ==
+            matched_entries.end()) {
+            matched_entries.push_back(name.entry);
+            matches.push_back({primary[name.entry], name.name});
+        }
+        return matches.size() < limit;
+    };
+
+    std::string q(query);
+    std::transform(q.begin(), q.end(), q.begin(), to_lower);
+
+    // Walk down the trie as far as the query goes
+    uint32_t node = 0;
+    std::size_t pos = 0;
+    bool found = true;
+    bool at_label_end = true;
+    while (true) {
+        std::string_view label =
+            std::string_view(lower).substr(nodes[node].label_begin, nodes[node].label_len);
+        std::size_t n = std::min(label.size(), q.size() - pos);
+        if (label.substr(0, n) != std::string_view(q).substr(pos, n)) {
+            found = false;
+            break;
+        }
+        pos += n;
+        if (pos == q.size()) {
+            at_label_end = n == label.size();
+            break;
+        }
+        uint32_t next = nodes[node].child_end;
+        for (uint32_t child = nodes[node].child_begin; child < nodes[node].child_end; child++) {
+            if (lower[nodes[child].label_begin] == q[pos]) {
+                next = child;
+                break;
+            }
+        }
+        if (next == nodes[node].child_end) {
+            found = false;
+            break;
+        }
+        node = next;
+    }
+
+    if (found) {
+        const Node& nd = nodes[node];
+        bool more = true;
+        if (at_label_end) {
+            // Terminal keys are exact matches, and are already in rank order
+            for (uint32_t k = nd.key_begin; more && k < nd.key_begin + nd.n_terminal; k++) {
+                // Exact matches on a later word aren't really exact matches
+                if (keys[k].text_begin == names[keys[k].name].lower_begin) {
+                    more = add(keys[k].name);
+                }
+            }
+        }
+        for (uint32_t t = nd.top_begin; more && t < nd.top_end; t++) {
+            more = add(keys[top[t]].name);
+        }
+        if (more && !nd.top_complete) {
+            std::vector<uint32_t> subtree(nd.key_end - nd.key_begin);
+            std::iota(subtree.begin(), subtree.end(), nd.key_begin);
+            std::sort(subtree.begin(), subtree.end(),
+                      [&](uint32_t a, uint32_t b) { return keys[a].rank < keys[b].rank; });
+            for (std::size_t i = 0; more && i < subtree.size(); i++) {
+                more = add(keys[subtree[i]].name);
+            }
+        }
+    }
+    if (matches.size() < limit) {
+        search_fuzzy(q, limit, matches, matched_entries);
+    }
+    return matches;
+}
+
+void SearchIndex::search_fuzzy(const std::string& query, std::size_t limit,
+                               std::vector<Match>& matches,
+                               std::vector<uint16_t>& matched_entries) const {
+    // The query is a prefix, so don't pad the end
+    std::vector<uint32_t> query_trigrams = get_trigrams(query, false);
+    std::size_t min_shared = std::max(
+        FUZZY_MIN_SHARED,
+        (query_trigrams.size() * FUZZY_THRESHOLD_NUM + FUZZY_THRESHOLD_DENOM - 1) /
+            FUZZY_THRESHOLD_DENOM);
+    if (query_trigrams.size() < min_shared) {
+        return;
+    }
+
+    // Queries and names can be long enough to share more than 255 trigrams
+    std::vector<uint32_t> shared(names.size());
+    for (uint32_t trigram : query_trigrams) {
+        auto range = std::equal_range(
+            trigrams.begin(), trigrams.end(), std::make_pair(trigram, uint16_t(0)),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (auto it = range.first; it != range.second; it++) {
+            shared[it->second]++;
+        }
+    }
+    std::vector<uint16_t> candidates;
+    for (std::size_t n = 0; n < names.size(); n++) {
+        if (shared[n] >= min_shared) {
+            candidates.push_back(n);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [&](uint16_t a, uint16_t b) {
+        return std::make_pair(-int(shared[a]), names[a].rank) <
+               std::make_pair(-int(shared[b]), names[b].rank);
+    });
+    for (uint16_t n : candidates) {
+        if (matches.size() >= limit) {
+            break;
+        }
+        uint16_t entry = names[n].entry;
+        if (std::find(matched_entries.begin(), matched_entries.end(), entry) ==
+            matched_entries.end()) {
+            matched_entries.push_back(entry);
+            matches.push_back({primary[entry], names[n].name});
+        }
+    }
+}
+
+namespace {
+template <typename T>
+SearchIndex make_index(const ids::IDMap<T>& map, std::initializer_list<T> exclude = {}) {
+    std::vector<SearchIndex::Names> entries;
+    map.for_each([&](T id, std::string_view name, ids::AltNames alternate_names) {
+        if (std::find(exclude.begin(), exclude.end(), id) != exclude.end()) {
+            return;
+        }
+        SearchIndex::Names names = {name};
+        names.insert(names.end(), alternate_names.begin(), alternate_names.end());
+        entries.push_back(std::move(names));
+    });
+    return SearchIndex(entries);
+}
+
+// Each index is built the first time it's needed
+const SearchIndex& get_index(std::string_view kind) {
+    if (kind == "version") {
+        static const SearchIndex index = make_index(ids::VERSION);
+        return index;
+    }
+    if (kind == "move") {
+        static const SearchIndex index = make_index(ids::MOVE);
+        return index;
+    }
+    if (kind == "species") {
+        static const SearchIndex index =
+            make_index(ids::MONSTER, {eos::MONSTER_NONE, eos::MONSTER_NONE_SECONDARY});
+        return index;
+    }
+    if (kind == "type") {
+        static const SearchIndex index = make_index(ids::TYPE, {eos::TYPE_NEUTRAL});
+        return index;
+    }
+    if (kind == "ability") {
+        static const SearchIndex index = make_index(ids::ABILITY);
+        return index;
+    }
+    if (kind == "item") {
+        static const SearchIndex index = make_index(ids::ITEM);
+        return index;
+    }
+    if (kind == "gender") {
+        static const SearchIndex index = make_index(ids::GENDER);
+        return index;
+    }
+    if (kind == "weather") {
+        static const SearchIndex index = make_index(ids::WEATHER, {eos::WEATHER_RANDOM});
+        return index;
+    }
+    if (kind == "iq") {
+        static const SearchIndex index = make_index(ids::IQ);
+        return index;
+    }
+    if (kind == "status") {
+        static const SearchIndex index = make_index(ids::STATUS);
+        return index;
+    }
+    if (kind == "exclusive_item_effect") {
+        static const SearchIndex index = make_index(ids::EXCLUSIVE_ITEM_EFFECT);
+        return index;
+    }
+    std::string known;
+    for (auto k : KINDS) {
+        known += (known.empty() ? "" : ", ") + std::string(k);
+    }
+    throw std::invalid_argument("unknown search kind '" + std::string(kind) + "' (expected one of " +
+                                known + ")");
+}
+} // namespace
+
+std::vector<Match> search(std::string_view kind, std::string_view query, std::size_t limit) {
+    return get_index(kind).search(query, limit);
+}
+} // namespace search
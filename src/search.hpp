@@ -0,0 +1,101 @@
+// Name search for autocompletion, over the names (and alternate names) in the IDMaps
+
+#ifndef SEARCH_HPP_
+#define SEARCH_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace search {
+struct Match {
+    std::string_view name;    // Primary name of the matching ID
+    std::string_view matched; // The name that matched the query (primary or alternate)
+};
+
+// Search index over a list of IDs, each with a primary name and any number of alternate names.
+// Matches are ranked as follows:
+//   1. Exact matches
+//   2. Names starting with the query
+//   3. Names with a later word starting with the query (e.g., "beam" matches "Solar Beam")
+//   4. Typo-tolerant matches that share most of the query's trigrams
+// Within a tier, primary names rank above alternate names, then shorter names above longer ones,
+// then earlier IDs above later ones. Each ID is returned at most once. Matching is case
+// insensitive.
+//
+// Prefix lookup uses a compressed trie over every word suffix of every name, with the top few
+// matches precomputed for each node, so typical queries don't need to visit more than a handful of
+// names.
+class SearchIndex {
+  public:
+    // Names for a single ID; the primary name comes first. The strings are not copied, so they
+    // must outlive the index.
+    using Names = std::vector<std::string_view>;
+
+    explicit SearchIndex(const std::vector<Names>& entries);
+
+    std::vector<Match> search(std::string_view query, std::size_t limit) const;
+
+  private:
+    // Number of matches cached per trie node
+    static const std::size_t TOP_K = 16;
+
+    struct Name {
+        uint16_t entry;
+        bool alternate;
+        std::string_view name;
+        uint32_t lower_begin; // Lowercased name, in lower_
+        uint32_t rank;        // Rank of the name's whole-name key
+    };
+    // A suffix of a name starting at a word boundary
+    struct Key {
+        uint16_t name;
+        uint32_t text_begin; // Lowercased suffix, in lower_
+        uint16_t text_len;
+        uint32_t rank; // Position among all keys in rank order
+    };
+    struct Node {
+        uint32_t key_begin; // Keys in the subtree, as a range of keys
+        uint32_t key_end;
+        uint32_t n_terminal; // Number of keys ending at this node, at the start of the range
+        uint32_t label_begin; // Edge label leading into this node, in lower_
+        uint16_t label_len;
+        uint32_t child_begin; // Children, as a range of nodes
+        uint32_t child_end;
+        uint32_t top_begin; // Best keys in the subtree with distinct IDs, as a range of top
+        uint32_t top_end;
+        bool top_complete; // Whether every ID in the subtree is in top
+    };
+
+    std::vector<std::string_view> primary;
+    std::vector<Name> names;
+    std::string lower;
+    std::vector<Key> keys; // Sorted by text
+    std::vector<Node> nodes;
+    std::vector<uint32_t> top;
+    std::vector<std::pair<uint32_t, uint16_t>> trigrams; // (trigram, name), sorted
+
+    std::string_view key_text(const Key& key) const {
+        return std::string_view(lower).substr(key.text_begin, key.text_len);
+    }
+    void build_node(uint32_t node, std::size_t depth);
+    void find_top(uint32_t node);
+    void search_fuzzy(const std::string& query, std::size_t limit, std::vector<Match>& matches,
+                      std::vector<uint16_t>& matched_entries) const;
+};
+
+// Kinds of IDs that can be searched, named like the corresponding config fields
+constexpr std::array<std::string_view, 11> KINDS = {
+    "version", "move",    "species", "type",   "ability", "item",
+    "gender",  "weather", "iq",      "status", "exclusive_item_effect",
+};
+
+// Search the names of a given kind of ID, returning up to limit matches. Throws
+// std::invalid_argument if the kind is unknown.
+std::vector<Match> search(std::string_view kind, std::string_view query, std::size_t limit);
+} // namespace search
+
+#endif
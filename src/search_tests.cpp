@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include "search.hpp"
+
+namespace {
+std::vector<std::string> primary_names(const std::vector<search::Match>& matches) {
+    std::vector<std::string> names;
+    for (auto& m : matches) {
+        names.emplace_back(m.name);
+    }
+    return names;
+}
+} // namespace
+
+TEST_CASE("SearchIndex::search() works", "[search]") {
+    search::SearchIndex index({
+        {"Thunder"},
+        {"Thunderbolt"},
+        {"Thunder Wave"},
+        {"Thunder Fang"},
+        {"ThunderShock"},
+        {"Solar Beam"},
+        {"Hyper Beam"},
+        {"Beam Blade", "Sword Beam"},
+        {"Volt Bangle", "Moving Scarf", "Magne-Torc"},
+    });
+
+    SECTION("Prefix matches are ranked by length, then ID") {
+        REQUIRE(primary_names(index.search("thunder", 10)) ==
+                std::vector<std::string>{"Thunder", "Thunderbolt", "Thunder Wave", "Thunder Fang",
+                                         "ThunderShock"});
+        REQUIRE(primary_names(index.search("THUNDER", 2)) ==
+                std::vector<std::string>{"Thunder", "Thunderbolt"});
+    }
+    SECTION("Exact matches come first") {
+        auto matches = index.search("beam blade", 10);
+        REQUIRE(matches.size() == 1);
+        REQUIRE(matches[0].name == "Beam Blade");
+        REQUIRE(matches[0].matched == "Beam Blade");
+    }
+    SECTION("Later words in a name are matched after whole names") {
+        REQUIRE(primary_names(index.search("beam", 10)) ==
+                std::vector<std::string>{"Beam Blade", "Solar Beam", "Hyper Beam"});
+        REQUIRE(primary_names(index.search("torc", 10)) ==
+                std::vector<std::string>{"Volt Bangle"});
+    }
+    SECTION("Alternate names are searched") {
+        auto matches = index.search("moving", 10);
+        REQUIRE(matches.size() == 1);
+        REQUIRE(matches[0].name == "Volt Bangle");
+        REQUIRE(matches[0].matched == "Moving Scarf");
+    }
+    SECTION("Each ID is only returned once") {
+        // "Beam Blade" matches through both its primary and alternate names
+        auto matches = index.search("b", 10);
+        REQUIRE(primary_names(matches) ==
+                std::vector<std::string>{"Beam Blade", "Solar Beam", "Hyper Beam", "Volt Bangle"});
+    }
+    SECTION("Typos are tolerated") {
+        REQUIRE(primary_names(index.search("thundrbolt", 1)) ==
+                std::vector<std::string>{"Thunderbolt"});
+        REQUIRE(index.search("soler bea", 10)[0].name == "Solar Beam");
+        REQUIRE(index.search("xyzzy", 10).empty());
+    }
+    SECTION("Limits are respected") {
+        REQUIRE(index.search("", 3).size() == 3);
+        REQUIRE(index.search("", 100).size() == 9);
+        REQUIRE(index.search("thunder", 0).empty());
+    }
+}
+
+TEST_CASE("Fuzzy search works with long queries", "[search]") {
+    // Pseudorandom letters, so that nearly every trigram is different
+    std::string name;
+    uint32_t state = 1;
+    for (int i = 0; i < 400; i++) {
+        state = state * 1103515245 + 12345;
+        name += char('a' + (state >> 16) % 26);
+    }
+    search::SearchIndex index({{"Thunder"}, {name}});
+    // A typo at the start rules out prefix matches, but the query still shares far more than 255
+    // trigrams with the name
+    std::string query = name;
+    query[0] = query[0] == 'z' ? 'y' : 'z';
+    auto matches = index.search(query, 10);
+    REQUIRE(matches.size() == 1);
+    REQUIRE(matches[0].name == name);
+}
+
+TEST_CASE("search() works", "[search]") {
+    SECTION("Every kind can be searched") {
+        for (auto kind : search::KINDS) {
+            REQUIRE(!search::search(kind, "", 5).empty());
+        }
+    }
+    SECTION("Names from the IDMaps are found") {
+        REQUIRE(search::search("move", "Heat Wave", 1)[0].name == "Heat Wave");
+        REQUIRE(search::search("species", "latio", 1)[0].name == "Latios");
+        REQUIRE(search::search("item", "x-ray", 1)[0].name == "X-Ray Specs");
+        auto asleep = search::search("status", "asleep", 1);
+        REQUIRE(asleep[0].name == "Sleep");
+        REQUIRE(asleep[0].matched == "Asleep");
+    }
+    SECTION("Large indexes are searched past the cached matches") {
+        auto matches = search::search("species", "", 5000);
+        REQUIRE(matches.size() > 1000);
+    }
+    SECTION("Unknown kinds are rejected") {
+        REQUIRE_THROWS_AS(search::search("pokemon", "pikachu", 1), std::invalid_argument);
+    }
+}
@@ -0,0 +1,457 @@
+#include "server.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include "batch.hpp"
+#include "cfgtape.hpp"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace server {
+std::size_t LatencyHistogram::bucket_of(uint64_t us) {
+    if (us < (2 << SUB_BUCKET_BITS)) {
+        return us;
+    }
+    int exponent = 63;
+    while (!(us >> exponent)) {
+        exponent--;
+    }
+    // Keep the top SUB_BUCKET_BITS bits after the leading 1
+    int shift = exponent - SUB_BUCKET_BITS;
+    return ((shift + 1) << SUB_BUCKET_BITS) + ((us >> shift) & ((1 << SUB_BUCKET_BITS) - 1));
+}
+uint64_t LatencyHistogram::bucket_min(std::size_t bucket) {
+    if (bucket < (2 << SUB_BUCKET_BITS)) {
+        return bucket;
+    }
+    int shift = (bucket >> SUB_BUCKET_BITS) - 1;
+    uint64_t mantissa = (1 << SUB_BUCKET_BITS) | (bucket & ((1 << SUB_BUCKET_BITS) - 1));
+    return mantissa << shift;
+}
+
+void LatencyHistogram::record(uint64_t us) {
+    counts[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t prev = max_.load(std::memory_order_relaxed);
+    while (prev < us && !max_.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+    }
+}
+uint64_t LatencyHistogram::count() const {
+    uint64_t total = 0;
+    for (const auto& c : counts) {
+        total += c.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+uint64_t LatencyHistogram::percentile(double q) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    // Rank of the percentile, counting from 1
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * total + 0.5));
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < N_BUCKETS; i++) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return bucket_min(i);
+        }
+    }
+    return max();
+}
+
+void BaseDamageMemoTotals::collect() {
+    BaseDamageMemoStats stats = base_damage_memo_stats();
+    reset_base_damage_memo_stats();
+    hits.fetch_add(stats.hits, std::memory_order_relaxed);
+    misses.fetch_add(stats.misses, std::memory_order_relaxed);
+}
+BaseDamageMemoStats BaseDamageMemoTotals::total() const {
+    return {hits.load(std::memory_order_relaxed), misses.load(std::memory_order_relaxed)};
+}
+json BaseDamageMemoTotals::to_json() const {
+    BaseDamageMemoStats stats = total();
+    return {{"hits", stats.hits}, {"misses", stats.misses}, {"hit_rate", stats.hit_rate()}};
+}
+
+namespace {
+// Requests bigger than this with length prefixes are assumed to be garbage
+const uint32_t MAX_REQUEST_SIZE = 1 << 24;
+
+bool read_request(std::istream& in, Framing framing, std::string& buf) {
+    if (framing == Framing::LINES) {
+        auto is_space = [](unsigned char c) { return std::isspace(c); };
+        while (std::getline(in, buf)) {
+            if (!std::all_of(buf.begin(), buf.end(), is_space)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    unsigned char prefix[4];
+    if (!in.read(reinterpret_cast<char*>(prefix), sizeof(prefix))) {
+        if (in.gcount() == 0) {
+            return false;
+        }
+        throw std::invalid_argument("truncated request length");
+    }
+    uint32_t size = prefix[0] | (prefix[1] << 8) | (prefix[2] << 16) |
+                    (static_cast<uint32_t>(prefix[3]) << 24);
+    if (size > MAX_REQUEST_SIZE) {
+        throw std::invalid_argument("request of " + std::to_string(size) + " bytes is too big");
+    }
+    buf.resize(size);
+    if (!in.read(buf.data(), size)) {
+        throw std::invalid_argument("truncated request");
+    }
+    return true;
+}
+
+void write_response(std::ostream& out, Framing framing, const std::string& response) {
+    if (framing == Framing::LENGTH_PREFIXED) {
+        uint32_t size = response.size();
+        char prefix[4] = {static_cast<char>(size), static_cast<char>(size >> 8),
+                          static_cast<char>(size >> 16), static_cast<char>(size >> 24)};
+        out.write(prefix, sizeof(prefix));
+        out << response;
+    } else {
+        out << response << '\n';
+    }
+}
+} // namespace
+
+// Collects responses from the workers as they finish, and writes them in request order on the
+// connection's own writer thread. Workers never touch the stream, so a client that's slow to read
+// only holds up its own connection.
+struct Server::Connection {
+    std::ostream& out;
+    Framing framing;
+    std::mutex mutex;
+    std::condition_variable finished_cv;
+    std::condition_variable written_cv;
+    // Finished responses that haven't been written yet
+    std::map<uint64_t, std::string> finished;
+    uint64_t n_written = 0;
+    // Total number of responses, once the connection stops taking requests
+    uint64_t n_responses = UINT64_MAX;
+
+    Connection(std::ostream& out_, Framing framing_) : out(out_), framing(framing_) {}
+
+    void finish(uint64_t seq, std::string&& response) {
+        // Notify with the lock held, since the connection can go away as soon as it's released
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.emplace(seq, std::move(response));
+        finished_cv.notify_one();
+    }
+    // Wait until fewer than limit of the first n_requests responses are still to be written
+    void wait_for_room(uint64_t n_requests, std::size_t limit) {
+        std::unique_lock<std::mutex> lock(mutex);
+        written_cv.wait(lock, [&] { return n_requests - n_written < limit; });
+    }
+    void close(uint64_t n_responses_) {
+        std::lock_guard<std::mutex> lock(mutex);
+        n_responses = n_responses_;
+        finished_cv.notify_one();
+    }
+    // Runs on the writer thread until all the responses have been written
+    void write_all() {
+        std::vector<std::string> ready;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            finished_cv.wait(lock, [&] {
+                return n_written == n_responses ||
+                       (!finished.empty() && finished.begin()->first == n_written);
+            });
+            if (n_written == n_responses) {
+                return;
+            }
+            for (auto it = finished.begin();
+                 it != finished.end() && it->first == n_written + ready.size();
+                 it = finished.erase(it)) {
+                ready.push_back(std::move(it->second));
+            }
+            lock.unlock();
+            for (const auto& response : ready) {
+                write_response(out, framing, response);
+            }
+            out.flush();
+            lock.lock();
+            n_written += ready.size();
+            ready.clear();
+            written_cv.notify_one();
+        }
+    }
+};
+
+Server::Server(const Options& options_, const overlay::BaseConfigs& bases_)
+    : bases(bases_), options(options_) {
+    options.n_threads = std::max(options.n_threads, 1u);
+    options.max_queue = std::max<std::size_t>(options.max_queue, 1);
+    for (unsigned i = 0; i < options.n_threads; i++) {
+        workers.emplace_back(&Server::work, this);
+    }
+}
+Server::~Server() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    not_empty.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+
+void Server::work() {
+    // Per-worker scratch state, reused across requests
+    cfgparse::ConfigTape tape;
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [&] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        not_full.notify_one();
+
+        json result;
+        tape.clear();
+        try {
+            auto cfg = tape.parse(job.request);
+            if (cfg.is_object() && cfg.contains("command")) {
+                if (cfg.at("command").get_string() != "stats") {
+                    throw std::invalid_argument("unknown command '" +
+                                                cfg.at("command").get<std::string>() + "'");
+                }
+                result = stats();
+                if (cfg.contains("id")) {
+                    result["id"] = cfg.at("id").to_json();
+                }
+            } else {
+                result = batch::calc_result(cfg, tape, bases);
+            }
+        } catch (const std::exception& e) {
+            result = {{"error", e.what()}};
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                                             job.received);
+        latency.record(elapsed.count());
+        base_damage_memo.collect();
+        job.connection->finish(job.seq, result.dump());
+    }
+}
+
+void Server::submit(Job&& job) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [&] { return queue.size() < options.max_queue; });
+        queue.push_back(std::move(job));
+    }
+    not_empty.notify_one();
+}
+
+void Server::serve(std::istream& in, std::ostream& out) {
+    n_connections++;
+    Connection connection(out, options.framing);
+    std::thread writer(&Connection::write_all, &connection);
+    uint64_t n_requests = 0;
+    std::exception_ptr error;
+    try {
+        std::string buf;
+        while (read_request(in, options.framing, buf)) {
+            // Stop reading from a client that isn't reading its responses
+            connection.wait_for_room(n_requests, options.max_queue);
+            submit({&connection, n_requests++, std::move(buf), Clock::now()});
+        }
+    } catch (const std::exception& e) {
+        // Tell the client why the rest of its requests were ignored
+        error = std::current_exception();
+        connection.finish(n_requests++, json{{"error", e.what()}}.dump());
+    }
+    // The workers hold references to the connection until everything's been written
+    connection.close(n_requests);
+    writer.join();
+    n_connections--;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+json Server::stats() {
+    std::size_t queue_depth;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue_depth = queue.size();
+    }
+    return {
+        {"queue_depth", queue_depth},
+        {"max_queue", options.max_queue},
+        {"workers", options.n_threads},
+        {"connections", n_connections.load()},
+        {"requests", latency.count()},
+        {"latency_us",
+         {
+             {"p50", latency.percentile(0.5)},
+             {"p90", latency.percentile(0.9)},
+             {"p99", latency.percentile(0.99)},
+             {"p999", latency.percentile(0.999)},
+             {"max", latency.max()},
+         }},
+        {"base_damage_memo", base_damage_memo.to_json()},
+    };
+}
+
+#ifndef _WIN32
+namespace {
+// Stream buffer for a file descriptor, like a socket
+class FdBuf : public std::streambuf {
+    int fd;
+    char in_buf[1 << 14];
+    char out_buf[1 << 14];
+
+  protected:
+    int_type underflow() override {
+        ssize_t n;
+        do {
+            n = ::read(fd, in_buf, sizeof(in_buf));
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) {
+            return traits_type::eof();
+        }
+        setg(in_buf, in_buf, in_buf + n);
+        return traits_type::to_int_type(in_buf[0]);
+    }
+    int_type overflow(int_type c) override {
+        if (sync() != 0) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+    int sync() override {
+        const char* p = pbase();
+        while (p < pptr()) {
+            ssize_t n = ::write(fd, p, pptr() - p);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return -1;
+            }
+            p += n;
+        }
+        setp(out_buf, out_buf + sizeof(out_buf));
+        return 0;
+    }
+
+  public:
+    explicit FdBuf(int fd_) : fd(fd_) { setp(out_buf, out_buf + sizeof(out_buf)); }
+};
+
+// Closes a file descriptor when it goes out of scope
+struct FdCloser {
+    int fd;
+    ~FdCloser() { ::close(fd); }
+};
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+} // namespace
+
+void serve_unix_socket(Server& server, const std::string& path) {
+    // Write errors from clients hanging up are handled per connection
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::invalid_argument("socket path '" + path + "' is too long");
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw_errno("socket");
+    }
+    FdCloser listen_closer{listen_fd};
+    // Replace a stale socket from an earlier server, but nothing else
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        ::unlink(path.c_str());
+    }
+    if (::bind(listen_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+        throw_errno("bind " + path);
+    }
+    if (::listen(listen_fd, SOMAXCONN) < 0) {
+        throw_errno("listen " + path);
+    }
+
+    // Connection threads are detached, so wait for them to finish using the server on the way out
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    std::size_t n_active = 0;
+    std::exception_ptr error;
+    while (true) {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            error = std::make_exception_ptr(
+                std::system_error(errno, std::generic_category(), "accept " + path));
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            n_active++;
+        }
+        std::thread([&, fd] {
+            {
+                FdCloser closer{fd};
+                FdBuf in_buf(fd);
+                FdBuf out_buf(fd);
+                std::istream in(&in_buf);
+                std::ostream out(&out_buf);
+                try {
+                    server.serve(in, out);
+                } catch (const std::exception&) {
+                    // The client has already been sent the error, so just hang up
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            n_active--;
+            done_cv.notify_all();
+        }).detach();
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [&] { return n_active == 0; });
+    std::rethrow_exception(error);
+}
+#else
+void serve_unix_socket(Server&, const std::string&) {
+    throw std::runtime_error("Unix domain sockets aren't supported on this platform");
+}
+#endif
+} // namespace server
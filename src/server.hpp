@@ -0,0 +1,130 @@
+// Long-running server that calculates configs sent over stdin or a Unix domain socket
+
+#ifndef SERVER_HPP_
+#define SERVER_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "damage.hpp"
+#include "overlay.hpp"
+
+namespace server {
+// How requests and responses are delimited on a connection
+enum class Framing {
+    // One JSON config per line, and one compact JSON result per line. Blank lines are skipped.
+    LINES,
+    // Each JSON config or result is preceded by its size in bytes, as a 4-byte little-endian
+    // integer
+    LENGTH_PREFIXED,
+};
+
+struct Options {
+    unsigned n_threads = 1;
+    // Maximum number of requests waiting for a worker, and that a single connection can have in
+    // flight (waiting, being calculated, or waiting to be written). Connections stop reading
+    // requests while the queue or their own share of it is full, so clients that send requests
+    // faster than they can be calculated, or that don't read their responses, are slowed down
+    // rather than using unbounded memory.
+    std::size_t max_queue = 4096;
+    Framing framing = Framing::LINES;
+};
+
+// Distribution of request latencies in microseconds, with a relative precision of about 6%.
+// Recording is lock-free.
+class LatencyHistogram {
+    // 16 buckets per power of 2 (exact below 32)
+    static const int SUB_BUCKET_BITS = 4;
+    static const std::size_t N_BUCKETS = (64 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+    std::array<std::atomic<uint64_t>, N_BUCKETS> counts{};
+    std::atomic<uint64_t> max_{0};
+
+    static std::size_t bucket_of(uint64_t us);
+    static uint64_t bucket_min(std::size_t bucket);
+
+  public:
+    void record(uint64_t us);
+    uint64_t count() const;
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    // Smallest latency that the fraction q (in [0, 1]) of requests took at most, rounded down to
+    // the bucket it falls in. 0 if nothing's been recorded.
+    uint64_t percentile(double q) const;
+};
+
+// Base damage memo counts (see base_damage_memo_stats()) added up over worker threads. Adding is
+// lock-free.
+class BaseDamageMemoTotals {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+
+  public:
+    // Add the calling thread's counts since it last called this
+    void collect();
+    BaseDamageMemoStats total() const;
+    // {"hits": ..., "misses": ..., "hit_rate": ...}
+    nlohmann::json to_json() const;
+};
+
+// Requests are calculated by a fixed pool of worker threads, each with its own scratch state. Any
+// number of connections can be served at once, each with its own threads for reading requests and
+// writing responses, with responses written in the same order as the requests on that connection.
+//
+// Requests are configs like in batch mode (see batch::run_batch()), including overlays on the base
+// configs. A request of {"command": "stats"} instead gets the server's current queue depth, request
+// count, latency percentiles and base damage memo hit rate.
+class Server {
+    struct Connection;
+    struct Job {
+        Connection* connection;
+        uint64_t seq;
+        std::string request;
+        std::chrono::steady_clock::time_point received;
+    };
+
+    const overlay::BaseConfigs& bases;
+    Options options;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<Job> queue;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+    LatencyHistogram latency;
+    BaseDamageMemoTotals base_damage_memo;
+    std::atomic<uint64_t> n_connections{0};
+
+    void work();
+    void submit(Job&& job);
+
+  public:
+    // bases must not be modified while the server is running
+    Server(const Options& options, const overlay::BaseConfigs& bases);
+    ~Server();
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // Serve one connection until in ends, and all of its responses have been written. Throws
+    // std::invalid_argument if a request can't be read (only possible with length prefixes), after
+    // writing the responses to the requests before it, followed by an "error" response.
+    void serve(std::istream& in, std::ostream& out);
+    nlohmann::json stats();
+};
+
+// Serve every connection to a Unix domain socket at path, each on its own thread. Any existing
+// socket file at path is replaced. Only returns if accepting connections fails, which throws
+// std::system_error. Throws std::runtime_error on platforms without Unix domain sockets.
+void serve_unix_socket(Server& server, const std::string& path);
+} // namespace server
+
+#endif
@@ -0,0 +1,318 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "batch.hpp"
+#include "server.hpp"
+#include "test_configs.hpp"
+
+using nlohmann::json;
+
+namespace {
+json make_cfg(int id) {
+    json cfg = test_configs::make_cfg(1 + (id - 1) % 100);
+    cfg["id"] = id;
+    return cfg;
+}
+json expected_result(int id) {
+    auto result = batch::summarize(batch::run_calc(make_cfg(id)));
+    result["id"] = id;
+    return result;
+}
+
+std::string length_prefixed(const std::string& str) {
+    uint32_t size = str.size();
+    std::string framed = {static_cast<char>(size), static_cast<char>(size >> 8),
+                          static_cast<char>(size >> 16), static_cast<char>(size >> 24)};
+    return framed + str;
+}
+std::vector<json> read_length_prefixed(const std::string& data) {
+    std::vector<json> results;
+    for (std::size_t i = 0; i + 4 <= data.size();) {
+        auto byte = [&](std::size_t j) { return static_cast<uint32_t>(uint8_t(data[i + j])); };
+        uint32_t size = byte(0) | (byte(1) << 8) | (byte(2) << 16) | (byte(3) << 24);
+        results.push_back(json::parse(data.substr(i + 4, size)));
+        i += 4 + size;
+    }
+    return results;
+}
+std::vector<json> read_lines(const std::string& data) {
+    std::vector<json> results;
+    std::istringstream lines(data);
+    for (std::string line; std::getline(lines, line);) {
+        results.push_back(json::parse(line));
+    }
+    return results;
+}
+
+// Output that blocks until it's released, like a client that's stopped reading
+class BlockedBuf : public std::stringbuf {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool blocked = false;
+    bool released = false;
+
+    void block() {
+        std::unique_lock<std::mutex> lock(mutex);
+        blocked = true;
+        cv.notify_all();
+        cv.wait(lock, [&] { return released; });
+    }
+
+  protected:
+    int_type overflow(int_type c) override {
+        block();
+        return std::stringbuf::overflow(c);
+    }
+    int sync() override {
+        block();
+        return std::stringbuf::sync();
+    }
+
+  public:
+    void wait_until_blocked() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return blocked; });
+    }
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+        cv.notify_all();
+    }
+};
+
+// Input that hands out one line at a time, counting how many have been read
+class LineBuf : public std::streambuf {
+    std::vector<std::string> lines;
+    std::atomic<std::size_t> n_read_{0};
+
+  protected:
+    int_type underflow() override {
+        std::size_t i = n_read_;
+        if (i == lines.size()) {
+            return traits_type::eof();
+        }
+        n_read_ = i + 1;
+        char* line = lines[i].data();
+        setg(line, line, line + lines[i].size());
+        return traits_type::to_int_type(line[0]);
+    }
+
+  public:
+    explicit LineBuf(std::vector<std::string> lines_) : lines(std::move(lines_)) {}
+    std::size_t n_read() const { return n_read_; }
+};
+} // namespace
+
+TEST_CASE("LatencyHistogram works", "[server]") {
+    server::LatencyHistogram hist;
+    REQUIRE(hist.percentile(0.5) == 0);
+    for (uint64_t us = 1; us <= 1000; us++) {
+        hist.record(us);
+    }
+    REQUIRE(hist.count() == 1000);
+    REQUIRE(hist.max() == 1000);
+    // Within the bucket precision
+    auto near = [](uint64_t actual, uint64_t expected) {
+        return actual <= expected && actual * 17 >= expected * 16;
+    };
+    REQUIRE(near(hist.percentile(0.5), 500));
+    REQUIRE(near(hist.percentile(0.9), 900));
+    REQUIRE(near(hist.percentile(0.99), 990));
+    REQUIRE(hist.percentile(0) == 1);
+    REQUIRE(near(hist.percentile(1), 1000));
+    // Small values are exact, and huge ones don't overflow
+    hist.record(0);
+    hist.record(UINT64_MAX);
+    REQUIRE(hist.percentile(0) == 0);
+    REQUIRE(hist.max() == UINT64_MAX);
+    REQUIRE(hist.percentile(1) > (UINT64_MAX / 17) * 16);
+}
+
+TEST_CASE("Server responses are in request order", "[server]") {
+    overlay::BaseConfigs bases;
+    const int n_requests = 500;
+    SECTION("Newline-delimited") {
+        // A small queue makes the connection wait on the workers
+        server::Server server({4, 8, server::Framing::LINES}, bases);
+        std::string input;
+        for (int id = 1; id <= n_requests; id++) {
+            input += make_cfg(id).dump() + "\n\n";
+        }
+        input += "not json\n";
+        std::istringstream in(input);
+        std::ostringstream out;
+        server.serve(in, out);
+
+        auto results = read_lines(out.str());
+        REQUIRE(results.size() == n_requests + 1);
+        for (int id = 1; id <= n_requests; id++) {
+            REQUIRE(results[id - 1] == expected_result(id));
+        }
+        REQUIRE(results.back().contains("error"));
+    }
+    SECTION("Length-prefixed") {
+        server::Server server({2, 4096, server::Framing::LENGTH_PREFIXED}, bases);
+        std::string input;
+        for (int id = 1; id <= n_requests; id++) {
+            // Newlines inside requests are fine
+            input += length_prefixed(make_cfg(id).dump(1));
+        }
+        std::istringstream in(input);
+        std::ostringstream out;
+        server.serve(in, out);
+
+        auto results = read_length_prefixed(out.str());
+        REQUIRE(results.size() == n_requests);
+        for (int id = 1; id <= n_requests; id++) {
+            REQUIRE(results[id - 1] == expected_result(id));
+        }
+
+        SECTION("Truncated requests end the connection") {
+            std::istringstream truncated(length_prefixed(make_cfg(1).dump()) +
+                                         length_prefixed("{}").substr(0, 5));
+            std::ostringstream truncated_out;
+            REQUIRE_THROWS_AS(server.serve(truncated, truncated_out), std::invalid_argument);
+            auto truncated_results = read_length_prefixed(truncated_out.str());
+            REQUIRE(truncated_results.size() == 2);
+            REQUIRE(truncated_results[0] == expected_result(1));
+            REQUIRE(truncated_results[1]["error"] == "truncated request");
+        }
+    }
+    SECTION("Concurrent connections") {
+        server::Server server({3, 16, server::Framing::LINES}, bases);
+        std::vector<std::string> outputs(4);
+        std::vector<std::thread> connections;
+        for (std::size_t c = 0; c < outputs.size(); c++) {
+            connections.emplace_back([&, c] {
+                std::string input;
+                for (int i = 0; i < 100; i++) {
+                    input += make_cfg(1 + i + c * 100).dump() + "\n";
+                }
+                std::istringstream in(input);
+                std::ostringstream out;
+                server.serve(in, out);
+                outputs[c] = out.str();
+            });
+        }
+        for (auto& t : connections) {
+            t.join();
+        }
+        for (std::size_t c = 0; c < outputs.size(); c++) {
+            auto results = read_lines(outputs[c]);
+            REQUIRE(results.size() == 100);
+            for (int i = 0; i < 100; i++) {
+                REQUIRE(results[i] == expected_result(1 + i + c * 100));
+            }
+        }
+    }
+}
+
+TEST_CASE("Slow clients don't hold up other connections", "[server]") {
+    overlay::BaseConfigs bases;
+    // With a single worker, every other connection would stall if the worker wrote responses itself
+    server::Server server({1, 16, server::Framing::LINES}, bases);
+    BlockedBuf blocked_buf;
+    std::thread slow([&] {
+        std::istringstream in(make_cfg(1).dump() + "\n" + make_cfg(2).dump() + "\n");
+        std::ostream out(&blocked_buf);
+        server.serve(in, out);
+    });
+    blocked_buf.wait_until_blocked();
+
+    std::istringstream in(make_cfg(3).dump() + "\n" + make_cfg(4).dump() + "\n");
+    std::ostringstream out;
+    server.serve(in, out);
+    auto results = read_lines(out.str());
+    REQUIRE(results.size() == 2);
+    REQUIRE(results[0] == expected_result(3));
+    REQUIRE(results[1] == expected_result(4));
+
+    blocked_buf.release();
+    slow.join();
+    auto slow_results = read_lines(blocked_buf.str());
+    REQUIRE(slow_results.size() == 2);
+    REQUIRE(slow_results[0] == expected_result(1));
+    REQUIRE(slow_results[1] == expected_result(2));
+}
+
+TEST_CASE("Clients that don't read their responses stop being read", "[server]") {
+    overlay::BaseConfigs bases;
+    const std::size_t max_queue = 4;
+    const int n_requests = 100;
+    server::Server server({2, max_queue, server::Framing::LINES}, bases);
+    std::vector<std::string> lines;
+    for (int i = 1; i <= n_requests; i++) {
+        lines.push_back(make_cfg(i).dump() + "\n");
+    }
+    LineBuf in_buf(std::move(lines));
+    BlockedBuf blocked_buf;
+    std::thread client([&] {
+        std::istream in(&in_buf);
+        std::ostream out(&blocked_buf);
+        server.serve(in, out);
+    });
+    blocked_buf.wait_until_blocked();
+    // Give the reader time to run ahead, if it's going to
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // Up to max_queue requests in flight, plus one read and waiting for room
+    REQUIRE(in_buf.n_read() <= max_queue + 1);
+
+    blocked_buf.release();
+    client.join();
+    REQUIRE(in_buf.n_read() == n_requests);
+    auto results = read_lines(blocked_buf.str());
+    REQUIRE(results.size() == n_requests);
+    for (int i = 1; i <= n_requests; i++) {
+        REQUIRE(results[i - 1] == expected_result(i));
+    }
+}
+
+TEST_CASE("Server stats work", "[server]") {
+    overlay::BaseConfigs bases;
+    bases.add("base", std::make_unique<const overlay::BaseConfig>(make_cfg(10)));
+    server::Server server({2, 100, server::Framing::LINES}, bases);
+    json overlay = {{"base", "base"}, {"id", "overlay"}};
+    std::string input = make_cfg(1).dump() + "\n" + overlay.dump() + "\n";
+    input += R"({"command": "stats", "id": 7})" "\n";
+    input += R"({"command": "restart"})" "\n";
+    std::istringstream in(input);
+    std::ostringstream out;
+    server.serve(in, out);
+
+    auto results = read_lines(out.str());
+    REQUIRE(results.size() == 4);
+    REQUIRE(results[0] == expected_result(1));
+    auto base_result = expected_result(10);
+    base_result["id"] = "overlay";
+    REQUIRE(results[1] == base_result);
+    const auto& stats = results[2];
+    REQUIRE(stats["id"] == 7);
+    REQUIRE(stats["workers"] == 2);
+    REQUIRE(stats["max_queue"] == 100);
+    REQUIRE(stats["connections"] == 1);
+    REQUIRE(stats["queue_depth"] <= 2);
+    REQUIRE(stats["requests"] <= 2);
+    REQUIRE(stats["latency_us"]["p50"] <= stats["latency_us"]["max"]);
+    REQUIRE(stats["base_damage_memo"].contains("hit_rate"));
+    REQUIRE(results[3]["error"] == "unknown command 'restart'");
+
+    auto after = server.stats();
+    REQUIRE(after["requests"] == 4);
+    REQUIRE(after["connections"] == 0);
+    REQUIRE(after["queue_depth"] == 0);
+    // Both calcs look up their base damage at least once
+    const auto& memo = after["base_damage_memo"];
+    double hits = memo["hits"];
+    double misses = memo["misses"];
+    REQUIRE(hits + misses >= 2);
+    REQUIRE(memo["hit_rate"] == hits / (hits + misses));
+}
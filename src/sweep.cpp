@@ -0,0 +1,422 @@
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include "cfgparse.hpp"
+#include "idmap.hpp"
+
+using nlohmann::json;
+using cfgparse::ConfigTape;
+using cfgparse::Section;
+
+namespace sweep {
+namespace {
+// Fields that are lists themselves, as {parent key, key}. An empty parent matches any parent.
+const std::array<std::pair<std::string_view, std::string_view>, 5> LIST_FIELDS = {{
+    {"", "iq_skills"},
+    {"", "statuses"},
+    {"exclusive_items", "effects"},
+    {"other_monsters", "iq"},
+    {"other_monsters", "abilities"},
+}};
+
+bool is_list_field(const std::string& parent, const std::string& key) {
+    for (const auto& [p, k] : LIST_FIELDS) {
+        if (key == k && (p.empty() || parent == p)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// All the names a name-valued field can take, for "*"
+std::vector<std::string> all_names(const std::string& parent, const std::string& key) {
+    if (key == "species") {
+        return ids::MONSTER.all_except();
+    } else if (key == "type1" || key == "type2" || key == "hidden_power_type") {
+        return ids::TYPE.all_except();
+    } else if (key == "ability1" || key == "ability2") {
+        return ids::ABILITY.all_except();
+    } else if (key == "weather") {
+        return ids::WEATHER.all_except();
+    } else if (key == "version") {
+        return ids::VERSION.all_except();
+    } else if (parent == "move" && key == "id") {
+        return ids::MOVE.all_except();
+    } else if (parent == "held_item" && key == "id") {
+        return ids::ITEM.all_except();
+    }
+    throw std::invalid_argument("\"*\" is not supported for " + key);
+}
+
+// Ranges with more values than this are assumed to be mistakes, and rejected before they're
+// expanded
+const uint64_t MAX_RANGE_SIZE = 1 << 20;
+
+std::vector<json> range_values(const json& range) {
+    if (!range.is_array() || range.size() < 2 || range.size() > 3) {
+        throw std::invalid_argument("range must be [start, stop] or [start, stop, step]");
+    }
+    for (const auto& x : range) {
+        if (!x.is_number()) {
+            throw std::invalid_argument("range bounds and step must be numbers");
+        }
+    }
+    bool integral = std::all_of(range.begin(), range.end(),
+                                [](const json& x) { return x.is_number_integer(); });
+    auto too_large = [] {
+        return std::invalid_argument("range has more than the maximum of " +
+                                     std::to_string(MAX_RANGE_SIZE) + " values");
+    };
+    std::vector<json> values;
+    if (integral) {
+        int64_t start = range[0].get<int64_t>();
+        int64_t stop = range[1].get<int64_t>();
+        int64_t step = range.size() > 2 ? range[2].get<int64_t>() : 1;
+        if (step <= 0) {
+            throw std::invalid_argument("range step must be positive");
+        }
+        if (stop < start) {
+            return values;
+        }
+        // Unsigned, so that neither the span nor the values can overflow
+        uint64_t n_steps = (static_cast<uint64_t>(stop) - static_cast<uint64_t>(start)) /
+                           static_cast<uint64_t>(step);
+        if (n_steps >= MAX_RANGE_SIZE) {
+            throw too_large();
+        }
+        values.reserve(n_steps + 1);
+        for (uint64_t i = 0; i <= n_steps; i++) {
+            values.push_back(static_cast<int64_t>(static_cast<uint64_t>(start) +
+                                                  i * static_cast<uint64_t>(step)));
+        }
+    } else {
+        double start = range[0].get<double>();
+        double stop = range[1].get<double>();
+        double step = range.size() > 2 ? range[2].get<double>() : 1;
+        if (!(step > 0)) {
+            throw std::invalid_argument("range step must be positive");
+        }
+        // Allow a bit of leeway so that, e.g., [0, 1, 0.1] includes 1
+        double n_steps = std::floor((stop - start) / step + 1e-9);
+        if (n_steps < 0) {
+            return values;
+        }
+        if (!(n_steps < MAX_RANGE_SIZE)) {
+            throw too_large();
+        }
+        auto n = static_cast<uint64_t>(n_steps);
+        values.reserve(n + 1);
+        for (uint64_t i = 0; i <= n; i++) {
+            values.push_back(start + i * step);
+        }
+    }
+    return values;
+}
+
+Section swept_section(const std::string& root_key) {
+    Section section = cfgparse::section_of(root_key);
+    if (section == cfgparse::N_SECTIONS) {
+        throw std::invalid_argument("cannot sweep over unknown field '" + root_key + "'");
+    }
+    return section;
+}
+
+// Spec with the sweep values split out
+struct Expanded {
+    // Config with each swept field set to its first value
+    json base;
+    // Path and values of each swept field
+    std::vector<std::pair<std::vector<std::string>, std::vector<json>>> axes;
+
+    void collect(json& obj, std::vector<std::string>& path) {
+        for (auto& [key, val] : obj.items()) {
+            const std::string& parent = path.empty() ? "" : path.back();
+            std::vector<json> values;
+            if (val.is_object() && val.size() == 1 && val.contains("range")) {
+                values = range_values(val["range"]);
+            } else if (val.is_object() && val.size() == 1 && val.contains("values")) {
+                if (!val["values"].is_array()) {
+                    throw std::invalid_argument("values must be a list");
+                }
+                values = val["values"].get<std::vector<json>>();
+            } else if (val.is_array() && !is_list_field(parent, key)) {
+                values = val.get<std::vector<json>>();
+            } else if (val.is_string() && val.get_ref<const std::string&>() == "*") {
+                for (auto& name : all_names(parent, key)) {
+                    values.push_back(name);
+                }
+            } else if (val.is_object()) {
+                path.push_back(key);
+                collect(val, path);
+                path.pop_back();
+                continue;
+            } else {
+                continue;
+            }
+
+            path.push_back(key);
+            if (values.empty()) {
+                throw std::invalid_argument("no values to sweep over for " + path.back());
+            }
+            for (const auto& v : values) {
+                if (v.is_structured()) {
+                    throw std::invalid_argument("sweep values for " + path.back() +
+                                                " must be single values");
+                }
+            }
+            val = values[0];
+            axes.emplace_back(path, std::move(values));
+            path.pop_back();
+        }
+    }
+
+    explicit Expanded(const json& spec) : base(spec) {
+        if (!base.is_object()) {
+            throw std::invalid_argument("sweep spec must be an object");
+        }
+        // Move dotted top-level keys into place
+        std::vector<std::string> dotted_keys;
+        for (auto& [key, val] : base.items()) {
+            if (key.find('.') != std::string::npos) {
+                dotted_keys.push_back(key);
+            }
+        }
+        for (const auto& key : dotted_keys) {
+            std::string pointer = "/" + key;
+            std::replace(pointer.begin(), pointer.end(), '.', '/');
+            json val = std::move(base[key]);
+            base.erase(key);
+            base[json::json_pointer(pointer)] = std::move(val);
+        }
+        std::vector<std::string> path;
+        collect(base, path);
+    }
+};
+} // namespace
+
+Sweep::Sweep(const json& spec) : root(tape.empty_object()) {
+    Expanded expanded(spec);
+    root = tape.add(expanded.base);
+    for (auto& [path, values] : expanded.axes) {
+        Axis axis = {"", swept_section(path.front()), root, {}};
+        for (const auto& key : path) {
+            axis.path += (axis.path.empty() ? "" : ".") + key;
+            axis.field = axis.field.at(key);
+        }
+        for (const auto& v : values) {
+            axis.values.push_back(tape.add(v));
+        }
+        axes_.push_back(std::move(axis));
+    }
+}
+
+std::size_t Sweep::size() const {
+    std::size_t n = 1;
+    for (const auto& axis : axes_) {
+        if (n > std::numeric_limits<std::size_t>::max() / axis.values.size()) {
+            return std::numeric_limits<std::size_t>::max();
+        }
+        n *= axis.values.size();
+    }
+    return n;
+}
+
+void Sweep::run(const std::function<void(const Point&)>& f) { run(f, 0, size()); }
+
+void Sweep::run(const std::function<void(const Point&)>& f, std::size_t first,
+                std::size_t count) {
+    // Parsed sections, and the error from parsing each section if there was one
+    std::optional<DungeonState> dungeon;
+    std::optional<MonsterEntity> attacker;
+    std::optional<MonsterEntity> defender;
+    std::optional<std::pair<Move, int32_t>> move;
+    std::array<std::string, cfgparse::N_SECTIONS> section_errors;
+    std::array<bool, cfgparse::N_SECTIONS> dirty;
+    dirty.fill(true);
+
+    // Parse a section if it changed, and record any error
+    auto reparse = [&](Section section, auto& parsed, auto parse) {
+        if (!dirty[section]) {
+            return;
+        }
+        dirty[section] = false;
+        section_errors[section].clear();
+        parsed.reset();
+        try {
+            parsed = parse();
+        } catch (const std::exception& e) {
+            section_errors[section] = e.what();
+        }
+    };
+
+    // Start at the first point, with the last axis changing fastest
+    std::vector<std::size_t> indexes(axes_.size(), 0);
+    for (std::size_t i = axes_.size(); i-- > 0;) {
+        Axis& axis = axes_[i];
+        indexes[i] = first % axis.values.size();
+        first /= axis.values.size();
+        tape.set(axis.field, axis.values[indexes[i]]);
+    }
+    if (first > 0 || count == 0) {
+        return; // Past the end
+    }
+
+    std::string error;
+    while (true) {
+        reparse(cfgparse::SECTION_DUNGEON, dungeon, [&] {
+            return parse_dungeon_cfg(root.value("dungeon", tape.empty_object()),
+                                     root.value("rng", tape.empty_object()),
+                                     root.value("misc", tape.empty_object()));
+        });
+        reparse(cfgparse::SECTION_ATTACKER, attacker,
+                [&] { return parse_monster_cfg(root.at("attacker")); });
+        reparse(cfgparse::SECTION_DEFENDER, defender,
+                [&] { return parse_monster_cfg(root.at("defender")); });
+        reparse(cfgparse::SECTION_MOVE, move, [&] { return parse_move_cfg(root.at("move")); });
+
+        // Report the first error in the same order parse_cfg() would hit it
+        error.clear();
+        for (const auto& section_error : section_errors) {
+            if (!section_error.empty()) {
+                error = section_error;
+                break;
+            }
+        }
+        std::optional<batch::CalcRun> run;
+        if (error.empty()) {
+            try {
+                run = batch::run_calc(
+                    batch::CalcInputs{*dungeon, *attacker, *defender, move->first, move->second});
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+        }
+        f(Point{indexes, run ? &*run : nullptr, error});
+        if (--count == 0) {
+            return;
+        }
+
+        // Advance to the next point, with the last axis changing fastest
+        std::size_t i = axes_.size();
+        while (true) {
+            if (i == 0) {
+                return;
+            }
+            i--;
+            Axis& axis = axes_[i];
+            indexes[i] = (indexes[i] + 1) % axis.values.size();
+            tape.set(axis.field, axis.values[indexes[i]]);
+            dirty[axis.section] = true;
+            if (indexes[i] != 0) {
+                break;
+            }
+        }
+    }
+}
+
+void write_rows(Sweep& sweep, std::ostream& out) {
+    const auto& axes = sweep.axes();
+    sweep.run([&](const Point& point) {
+        json row = json::object();
+        for (std::size_t i = 0; i < axes.size(); i++) {
+            row[axes[i].path] = axes[i].values[point.indexes[i]].to_json();
+        }
+        if (point.run) {
+            row.update(batch::summarize(*point.run));
+        } else {
+            row["error"] = point.error;
+        }
+        out << row.dump() << '\n';
+    });
+    out.flush();
+}
+
+namespace {
+// Column type that fits every value of an axis
+columns::Type axis_type(const Axis& axis) {
+    bool all_ints = true;
+    bool all_numbers = true;
+    bool all_bools = true;
+    for (const auto& value : axis.values) {
+        auto type = value.type();
+        bool is_int = type == json::value_t::number_integer ||
+                      type == json::value_t::number_unsigned;
+        if (is_int) {
+            json v = value.to_json();
+            is_int = v >= std::numeric_limits<int32_t>::min() &&
+                     v <= std::numeric_limits<int32_t>::max();
+        }
+        all_ints = all_ints && is_int;
+        all_numbers = all_numbers && value.to_json().is_number();
+        all_bools = all_bools && type == json::value_t::boolean;
+    }
+    if (all_ints) {
+        return columns::Type::INT32;
+    } else if (all_numbers) {
+        return columns::Type::FLOAT64;
+    } else if (all_bools) {
+        return columns::Type::BOOL;
+    }
+    return columns::Type::STRING;
+}
+} // namespace
+
+void write_table(Sweep& sweep, std::string_view format, std::ostream& out) {
+    // Minimum number of rows written at a time
+    const std::size_t TABLE_ROWS = 65536;
+
+    const auto& axes = sweep.axes();
+    std::vector<columns::Column> schema;
+    // Text of each value of string axes: strings as they are, and anything else as JSON
+    std::vector<std::vector<std::string>> strings(axes.size());
+    for (std::size_t i = 0; i < axes.size(); i++) {
+        schema.push_back({axes[i].path, axis_type(axes[i])});
+        if (schema.back().type == columns::Type::STRING) {
+            for (const auto& value : axes[i].values) {
+                strings[i].push_back(value.is_string() ? std::string(value.get_string())
+                                                       : value.to_json().dump());
+            }
+        }
+    }
+    const auto& results = batch::result_columns();
+    schema.insert(schema.end(), results.begin(), results.end());
+
+    auto writer = columns::make_writer(format, out, schema);
+    columns::Table table(schema);
+    sweep.run([&](const Point& point) {
+        for (std::size_t i = 0; i < axes.size(); i++) {
+            const auto& value = axes[i].values[point.indexes[i]];
+            switch (schema[i].type) {
+            case columns::Type::INT32:
+                table.push_int(i, value.get<int32_t>());
+                break;
+            case columns::Type::FLOAT64:
+                table.push_double(i, value.get<double>());
+                break;
+            case columns::Type::BOOL:
+                table.push_bool(i, value.get<bool>());
+                break;
+            case columns::Type::STRING:
+                table.push_string(i, strings[i][point.indexes[i]]);
+                break;
+            }
+        }
+        batch::push_result(table, axes.size(), point.run, point.error);
+        table.end_row();
+        if (table.n_rows() >= TABLE_ROWS) {
+            writer->write(table);
+            table.clear();
+        }
+    });
+    if (table.n_rows() > 0) {
+        writer->write(table);
+    }
+    writer->finish();
+}
+} // namespace sweep
@@ -0,0 +1,76 @@
+// Sweeps: running damage calcs over every combination of values for some config fields
+
+#ifndef SWEEP_HPP_
+#define SWEEP_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "batch.hpp"
+#include "cfgparse.hpp"
+#include "cfgtape.hpp"
+#include "columns.hpp"
+
+// A sweep spec is a config (see sample-config.json) where any primitive field can be replaced by a
+// set of values to sweep over:
+// - a list, e.g. "weather": ["sunny", "rain"], or equivalently {"values": [...]}. Fields that are
+//   already lists (like "iq_skills") can't be swept over.
+// - an inclusive range, e.g. "level": {"range": [1, 100]}, with an optional step as a third
+//   element. Ranges with any non-integer bound or step give floating-point values. Ranges can have
+//   up to 2^20 values.
+// - "*" for every name of a name-valued field, e.g. "species": "*"
+// Top-level keys can also be dotted paths to fields, e.g. "defender.species": "*".
+namespace sweep {
+struct Axis {
+    std::string path;          // Dotted path to the field, e.g. "attacker.level"
+    cfgparse::Section section; // Only this section is reparsed when the field changes
+    cfgparse::ConfigTape::Node field;               // The field in the config
+    std::vector<cfgparse::ConfigTape::Node> values; // Values the field takes
+};
+
+// One combination of axis values, and its calc result or error
+struct Point {
+    const std::vector<std::size_t>& indexes; // Index into the values of each axis
+    const batch::CalcRun* run;               // Null if there was an error
+    const std::string& error;
+};
+
+class Sweep {
+    cfgparse::ConfigTape tape;
+    cfgparse::ConfigTape::Node root;
+    std::vector<Axis> axes_;
+
+  public:
+    // Throws std::invalid_argument if the spec is malformed
+    explicit Sweep(const nlohmann::json& spec);
+    // Axes hold references into the sweep
+    Sweep(const Sweep&) = delete;
+    Sweep& operator=(const Sweep&) = delete;
+
+    // Sorted by path, which is also the order they're iterated in, from outermost to innermost
+    const std::vector<Axis>& axes() const { return axes_; }
+    // Number of points (saturates at the maximum size_t)
+    std::size_t size() const;
+    // Calculate every point in order, lazily, calling f on each. Errors in a point are reported in
+    // the point rather than thrown.
+    void run(const std::function<void(const Point&)>& f);
+    // Same as above, but only count points in order, starting from the first-th (counting from 0).
+    // Sweeps over separate copies of a spec can run separate ranges of it in parallel.
+    void run(const std::function<void(const Point&)>& f, std::size_t first, std::size_t count);
+};
+
+// Run a sweep and write one compact JSON row per point to out, with the value of each axis keyed
+// by its path, and either the calc summary (see batch::summarize()) or an "error" field.
+void write_rows(Sweep& sweep, std::ostream& out);
+// Run a sweep and write it to out as a table in a columnar format (see columns::make_writer()),
+// with a column for each axis followed by batch::result_columns(). Axis columns are integers,
+// floats or booleans if all their values are, and strings otherwise, with non-string values
+// written as JSON.
+void write_table(Sweep& sweep, std::string_view format, std::ostream& out);
+} // namespace sweep
+
+#endif
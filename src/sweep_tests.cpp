@@ -0,0 +1,204 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "idmap.hpp"
+#include "sweep.hpp"
+#include "test_configs.hpp"
+
+using nlohmann::json;
+using test_configs::make_cfg;
+
+namespace {
+std::vector<json> run_rows(const json& spec) {
+    sweep::Sweep s(spec);
+    std::ostringstream out;
+    sweep::write_rows(s, out);
+    std::vector<json> rows;
+    std::istringstream lines(out.str());
+    for (std::string line; std::getline(lines, line);) {
+        rows.push_back(json::parse(line));
+    }
+    return rows;
+}
+} // namespace
+
+TEST_CASE("Sweep specs are expanded", "[sweep]") {
+    json spec = make_cfg();
+    spec["attacker"]["level"] = {{"range", {10, 50, 20}}};
+    spec["dungeon"] = {{"weather", {"sunny", "rain"}}};
+    spec["attacker"]["iq_skills"] = {"type-advantage master"};
+    spec["defender.species"] = {{"values", {"bulbasaur", "squirtle"}}};
+    spec["attacker"]["stat_modifiers"] = {{"multipliers", {{"sp_atk", {{"range", {1, 2, 0.5}}}}}}};
+    sweep::Sweep s(spec);
+
+    const auto& axes = s.axes();
+    REQUIRE(axes.size() == 4);
+    REQUIRE(axes[0].path == "attacker.level");
+    REQUIRE(axes[0].section == cfgparse::SECTION_ATTACKER);
+    REQUIRE(axes[0].values.size() == 3);
+    REQUIRE(axes[0].values[2].get<int>() == 50);
+    REQUIRE(axes[1].path == "attacker.stat_modifiers.multipliers.sp_atk");
+    REQUIRE(axes[1].values.size() == 3);
+    REQUIRE(axes[1].values[1].get<double>() == 1.5);
+    REQUIRE(axes[2].path == "defender.species");
+    REQUIRE(axes[2].section == cfgparse::SECTION_DEFENDER);
+    REQUIRE(axes[3].path == "dungeon.weather");
+    REQUIRE(axes[3].section == cfgparse::SECTION_DUNGEON);
+    REQUIRE(s.size() == 3 * 3 * 2 * 2);
+
+    SECTION("\"*\" expands to every name") {
+        json all_species = make_cfg();
+        all_species["defender"]["species"] = "*";
+        REQUIRE(sweep::Sweep(all_species).size() == ids::MONSTER.all_except().size());
+    }
+    SECTION("Malformed specs are rejected") {
+        json bad = make_cfg();
+        bad["attacker"]["level"] = {{"range", {1, 10, 0}}};
+        REQUIRE_THROWS_AS(sweep::Sweep(bad), std::invalid_argument);
+        bad["attacker"]["level"] = json::array();
+        REQUIRE_THROWS_AS(sweep::Sweep(bad), std::invalid_argument);
+        bad["attacker"]["level"] = "*";
+        REQUIRE_THROWS_AS(sweep::Sweep(bad), std::invalid_argument);
+        bad["attacker"]["level"] = {{"values", {{1, 2}}}};
+        REQUIRE_THROWS_AS(sweep::Sweep(bad), std::invalid_argument);
+        // Too many values, even if counting them would overflow
+        bad["attacker"]["level"] = {{"range", {0, 1 << 20}}};
+        REQUIRE_THROWS_AS(sweep::Sweep(bad), std::invalid_argument);
+        bad["attacker"]["level"] = {{"range", {INT64_MIN, INT64_MAX}}};
+        REQUIRE_THROWS_AS(sweep::Sweep(bad), std::invalid_argument);
+        bad["attacker"]["level"] = {{"range", {0, 1e300, 1e-300}}};
+        REQUIRE_THROWS_AS(sweep::Sweep(bad), std::invalid_argument);
+    }
+    SECTION("Ranges can end near the integer limits") {
+        json near_max = make_cfg();
+        near_max["attacker"]["level"] = {{"range", {INT64_MAX - 5, INT64_MAX, 2}}};
+        sweep::Sweep s(near_max);
+        REQUIRE(s.size() == 3);
+        REQUIRE(s.axes()[0].values.back().to_json() == INT64_MAX - 1);
+        near_max["attacker"]["level"] = {{"range", {INT64_MIN, INT64_MIN + 1}}};
+        REQUIRE(sweep::Sweep(near_max).size() == 2);
+    }
+}
+
+TEST_CASE("Sweeps give the same results as individual configs", "[sweep]") {
+    json spec = make_cfg();
+    spec["attacker.level"] = {{"range", {1, 100, 33}}};
+    spec["dungeon.weather"] = {"clear", "sunny", "rain"};
+    spec["defender"]["species"] = {"bulbasaur", "missingno", "squirtle"};
+    spec["move.id"] = {"ember", "gold fang"};
+    auto rows = run_rows(spec);
+    REQUIRE(rows.size() == 4 * 3 * 3 * 2);
+
+    std::size_t i = 0;
+    for (int level = 1; level <= 100; level += 33) {
+        for (std::string species : {"bulbasaur", "missingno", "squirtle"}) {
+            for (std::string weather : {"clear", "sunny", "rain"}) {
+                for (std::string move : {"ember", "gold fang"}) {
+                    const json& row = rows[i++];
+                    CAPTURE(row.dump());
+                    REQUIRE(row["attacker.level"] == level);
+                    REQUIRE(row["defender.species"] == species);
+                    REQUIRE(row["dungeon.weather"] == weather);
+                    REQUIRE(row["move.id"] == move);
+
+                    json cfg = make_cfg();
+                    cfg["attacker"]["level"] = level;
+                    cfg["defender"]["species"] = species;
+                    cfg["dungeon"] = {{"weather", weather}};
+                    cfg["move"]["id"] = move;
+                    if (species == "missingno") {
+                        REQUIRE(row.contains("error"));
+                        continue;
+                    }
+                    auto expected = batch::summarize(batch::run_calc(cfg));
+                    expected.update({{"attacker.level", level},
+                                     {"defender.species", species},
+                                     {"dungeon.weather", weather},
+                                     {"move.id", move}});
+                    REQUIRE(row == expected);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Sweeps without any axes have one point", "[sweep]") {
+    auto rows = run_rows(make_cfg());
+    REQUIRE(rows.size() == 1);
+    REQUIRE(rows[0] == batch::summarize(batch::run_calc(make_cfg())));
+}
+
+TEST_CASE("Sweeps can run a range of points", "[sweep]") {
+    json spec = make_cfg();
+    spec["attacker.level"] = {{"range", {1, 100, 10}}};
+    spec["defender.species"] = {"bulbasaur", "missingno", "squirtle"};
+    spec["move.id"] = {"ember", "gold fang"};
+
+    // Every point of a run, as {indexes, damage or error}
+    auto collect = [](sweep::Sweep& s, std::size_t first, std::size_t count) {
+        std::vector<std::pair<std::vector<std::size_t>, std::string>> points;
+        s.run(
+            [&](const sweep::Point& point) {
+                points.push_back({point.indexes, point.run ? std::to_string(point.run->damage)
+                                                            : point.error});
+            },
+            first, count);
+        return points;
+    };
+    sweep::Sweep full(spec);
+    auto expected = collect(full, 0, full.size());
+    REQUIRE(expected.size() == 10 * 3 * 2);
+
+    // Split into uneven ranges, reusing one sweep after a partial run
+    sweep::Sweep s(spec);
+    std::vector<std::pair<std::vector<std::size_t>, std::string>> points;
+    const std::size_t bounds[] = {0, 7, 8, 31, 60};
+    for (std::size_t i = 0; i + 1 < std::size(bounds); i++) {
+        auto range = collect(s, bounds[i], bounds[i + 1] - bounds[i]);
+        REQUIRE(range.size() == bounds[i + 1] - bounds[i]);
+        points.insert(points.end(), range.begin(), range.end());
+    }
+    REQUIRE(points == expected);
+    REQUIRE(collect(s, 0, s.size()) == expected);
+
+    REQUIRE(collect(s, 59, 100).size() == 1);
+    REQUIRE(collect(s, 60, 1).empty());
+    REQUIRE(collect(s, 5, 0).empty());
+}
+
+TEST_CASE("Sweeps can be written as tables", "[sweep]") {
+    json spec = make_cfg();
+    spec["attacker.level"] = {10, 20};
+    spec["attacker.stat_modifiers.multipliers.sp_atk"] = {1, 1.5};
+    spec["defender.species"] = {"bulbasaur", "missingno"};
+    spec["dungeon.gravity"] = {true, false};
+    sweep::Sweep s(spec);
+    std::ostringstream out;
+    sweep::write_table(s, "csv", out);
+
+    std::istringstream lines(out.str());
+    std::vector<std::string> rows;
+    for (std::string line; std::getline(lines, line);) {
+        rows.push_back(line);
+    }
+    REQUIRE(rows.size() == 1 + 16);
+    REQUIRE(rows[0].rfind("attacker.level,attacker.stat_modifiers.multipliers.sp_atk,"
+                          "defender.species,dungeon.gravity,attacker,attacker_level,",
+                          0) == 0);
+    json cfg = make_cfg();
+    cfg["attacker"]["level"] = 10;
+    cfg["attacker"]["stat_modifiers"] = {{"multipliers", {{"sp_atk", 1}}}};
+    cfg["dungeon"] = {{"gravity", true}};
+    auto run = batch::run_calc(cfg);
+    REQUIRE(rows[1].rfind("10,1,bulbasaur,true,Charmander,10,Bulbasaur,1,Ember," +
+                              std::to_string(run.damage) + "," +
+                              std::to_string(run.damage_max_var) + ",",
+                          0) == 0);
+    REQUIRE(rows[2].rfind("10,1,bulbasaur,false,", 0) == 0);
+    REQUIRE(rows[3].rfind("10,1,missingno,true,,,,,,", 0) == 0);
+    REQUIRE(rows[5].rfind("10,1.5,bulbasaur,true,", 0) == 0);
+}
@@ -0,0 +1,61 @@
+// Configs shared by the tests that take JSON configs
+
+#ifndef TEST_CONFIGS_HPP_
+#define TEST_CONFIGS_HPP_
+
+#include <nlohmann/json.hpp>
+
+namespace test_configs {
+// A plain Ember from a Charmander onto a Bulbasaur, with the attacker's level and Sp. Atk. both
+// set to the given level
+inline nlohmann::json make_cfg(int level = 30) {
+    return {
+        {"attacker", {{"species", "charmander"}, {"level", level}, {"sp_atk", level}}},
+        {"defender", {{"species", "bulbasaur"}}},
+        {"move", {{"id", "ember"}}},
+    };
+}
+
+// The same Ember, but with a value set for most of the optional fields
+inline nlohmann::json make_full_cfg() {
+    return {
+        {"move", {{"id", "ember"}, {"ginseng", 2}, {"pp", 5}, {"time_darkness", true}}},
+        {"attacker",
+         {
+             {"species", "charmander"},
+             {"is_team_member", true},
+             {"level", 30},
+             {"sp_atk", 40},
+             {"iq", 150},
+             {"iq_skills", {"type-advantage master", "aggressor"}},
+             {"stat_modifiers",
+              {{"stages", {{"sp_atk", 12}, {"speed", 2}}},
+               {"multipliers", {{"sp_atk", 1.5}}},
+               {"flash_fire_boost", 1}}},
+             {"held_item", {{"id", "power band"}, {"sticky", true}}},
+             {"statuses", {"burn", "guts/marvel scale"}},
+         }},
+        {"defender",
+         {
+             {"species", "bulbasaur"},
+             {"type2", "fire"},
+             {"ability1", "blaze"},
+             {"level", 25},
+             {"sp_def", 30},
+             {"hp", 40},
+             {"max_hp", 60},
+             {"exclusive_items",
+              {{"effects", {"exp. from damage"}}, {"stat_boosts", {{"sp_def", 3}}}}},
+         }},
+        {"dungeon",
+         {{"weather", "sunny"},
+          {"mud_sport", true},
+          {"plus", {{"team", true}}},
+          {"other_monsters", {{"abilities", {"cloud nine"}}}}}},
+        {"rng", {{"critical_hit", true}}},
+        {"misc", {{"version", "EU"}}},
+    };
+}
+} // namespace test_configs
+
+#endif
@@ -1,11 +1,22 @@
 #include <algorithm>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <emscripten/bind.h>
+#include "calcresult.hpp"
 #include "cfgparse.hpp"
 #include "damage.hpp"
 #include "idmap.hpp"
 #include "mechanics.hpp"
+#include "overlay.hpp"
 #include "pmdsky.hpp"
+#include "search.hpp"
+#include "sweep.hpp"
+#include "wire.hpp"
 
 namespace emscripten {
 namespace internal {
@@ -41,6 +52,17 @@ using namespace emscripten;
 namespace js {
 using nlohmann::json;
 
+// Look up the names for a list of IDs
+template <typename T, std::size_t N>
+std::vector<std::string> names_of(const ids::IDMap<T>& map, const std::array<T, N>& id_list) {
+    std::vector<std::string> names;
+    names.reserve(N);
+    for (auto id : id_list) {
+        names.emplace_back(map[id]);
+    }
+    return names;
+}
+
 std::vector<std::string> get_versions() { return ids::VERSION.all_except(); }
 
 std::vector<std::string> get_moves() {
@@ -50,16 +72,16 @@ std::vector<std::string> get_moves() {
     auto projectile =
         std::find(all_moves.begin(), all_moves.end(), ids::MOVE[eos::MOVE_PROJECTILE]);
     for (auto& item : cfgparse::PROJECTILE_ITEMS) {
-        all_moves.insert(++projectile, ids::ITEM[item.id]);
+        all_moves.emplace(++projectile, ids::ITEM[item.id]);
     }
     return all_moves;
 }
 std::vector<std::string> get_projectile_moves() {
     std::vector<std::string> projectiles;
     projectiles.reserve(1 + cfgparse::PROJECTILE_ITEMS.size());
-    projectiles.push_back(ids::MOVE[eos::MOVE_PROJECTILE]);
+    projectiles.emplace_back(ids::MOVE[eos::MOVE_PROJECTILE]);
     for (auto& proj : cfgparse::PROJECTILE_ITEMS) {
-        projectiles.push_back(ids::ITEM[proj.id]);
+        projectiles.emplace_back(ids::ITEM[proj.id]);
     }
     return projectiles;
 }
@@ -69,92 +91,95 @@ std::vector<std::string> get_species() {
 std::vector<std::string> get_types() { return ids::TYPE.all_except({eos::TYPE_NEUTRAL}); }
 std::vector<std::string> get_abilities() {
     // Only a couple abilities are actually used anywhere; only return these
-    return {
-        ids::ABILITY[eos::ABILITY_UNKNOWN],      ids::ABILITY[eos::ABILITY_THICK_FAT],
-        ids::ABILITY[eos::ABILITY_INTIMIDATE],   ids::ABILITY[eos::ABILITY_BATTLE_ARMOR],
-        ids::ABILITY[eos::ABILITY_TORRENT],      ids::ABILITY[eos::ABILITY_GUTS],
-        ids::ABILITY[eos::ABILITY_SHELL_ARMOR],  ids::ABILITY[eos::ABILITY_OVERGROW],
-        ids::ABILITY[eos::ABILITY_SAND_VEIL],    ids::ABILITY[eos::ABILITY_HUGE_POWER],
-        ids::ABILITY[eos::ABILITY_VOLT_ABSORB],  ids::ABILITY[eos::ABILITY_WATER_ABSORB],
-        ids::ABILITY[eos::ABILITY_HUSTLE],       ids::ABILITY[eos::ABILITY_LIGHTNINGROD],
-        ids::ABILITY[eos::ABILITY_COMPOUNDEYES], ids::ABILITY[eos::ABILITY_MARVEL_SCALE],
-        ids::ABILITY[eos::ABILITY_WONDER_GUARD], ids::ABILITY[eos::ABILITY_LEVITATE],
-        ids::ABILITY[eos::ABILITY_PLUS],         ids::ABILITY[eos::ABILITY_SOUNDPROOF],
-        ids::ABILITY[eos::ABILITY_MINUS],        ids::ABILITY[eos::ABILITY_SWARM],
-        ids::ABILITY[eos::ABILITY_BLAZE],        ids::ABILITY[eos::ABILITY_FLASH_FIRE],
-        ids::ABILITY[eos::ABILITY_PURE_POWER],   ids::ABILITY[eos::ABILITY_ANGER_POINT],
-        ids::ABILITY[eos::ABILITY_TINTED_LENS],  ids::ABILITY[eos::ABILITY_MOLD_BREAKER],
-        ids::ABILITY[eos::ABILITY_DRY_SKIN],     ids::ABILITY[eos::ABILITY_SCRAPPY],
-        ids::ABILITY[eos::ABILITY_SUPER_LUCK],   ids::ABILITY[eos::ABILITY_SOLAR_POWER],
-        ids::ABILITY[eos::ABILITY_RECKLESS],     ids::ABILITY[eos::ABILITY_SNIPER],
-        ids::ABILITY[eos::ABILITY_HEATPROOF],    ids::ABILITY[eos::ABILITY_DOWNLOAD],
-        ids::ABILITY[eos::ABILITY_TANGLED_FEET], ids::ABILITY[eos::ABILITY_ADAPTABILITY],
-        ids::ABILITY[eos::ABILITY_TECHNICIAN],   ids::ABILITY[eos::ABILITY_IRON_FIST],
-        ids::ABILITY[eos::ABILITY_MOTOR_DRIVE],  ids::ABILITY[eos::ABILITY_UNAWARE],
-        ids::ABILITY[eos::ABILITY_RIVALRY],      ids::ABILITY[eos::ABILITY_NO_GUARD],
-        ids::ABILITY[eos::ABILITY_NORMALIZE],    ids::ABILITY[eos::ABILITY_SOLID_ROCK],
-        ids::ABILITY[eos::ABILITY_FILTER],       ids::ABILITY[eos::ABILITY_KLUTZ],
-        ids::ABILITY[eos::ABILITY_FLOWER_GIFT],  ids::ABILITY[eos::ABILITY_SNOW_CLOAK],
-        ids::ABILITY[eos::ABILITY_FOREWARN],     ids::ABILITY[eos::ABILITY_STORM_DRAIN],
+    constexpr std::array<eos::ability_id, 52> used = {
+        eos::ABILITY_UNKNOWN,      eos::ABILITY_THICK_FAT,
+        eos::ABILITY_INTIMIDATE,   eos::ABILITY_BATTLE_ARMOR,
+        eos::ABILITY_TORRENT,      eos::ABILITY_GUTS,
+        eos::ABILITY_SHELL_ARMOR,  eos::ABILITY_OVERGROW,
+        eos::ABILITY_SAND_VEIL,    eos::ABILITY_HUGE_POWER,
+        eos::ABILITY_VOLT_ABSORB,  eos::ABILITY_WATER_ABSORB,
+        eos::ABILITY_HUSTLE,       eos::ABILITY_LIGHTNINGROD,
+        eos::ABILITY_COMPOUNDEYES, eos::ABILITY_MARVEL_SCALE,
+        eos::ABILITY_WONDER_GUARD, eos::ABILITY_LEVITATE,
+        eos::ABILITY_PLUS,         eos::ABILITY_SOUNDPROOF,
+        eos::ABILITY_MINUS,        eos::ABILITY_SWARM,
+        eos::ABILITY_BLAZE,        eos::ABILITY_FLASH_FIRE,
+        eos::ABILITY_PURE_POWER,   eos::ABILITY_ANGER_POINT,
+        eos::ABILITY_TINTED_LENS,  eos::ABILITY_MOLD_BREAKER,
+        eos::ABILITY_DRY_SKIN,     eos::ABILITY_SCRAPPY,
+        eos::ABILITY_SUPER_LUCK,   eos::ABILITY_SOLAR_POWER,
+        eos::ABILITY_RECKLESS,     eos::ABILITY_SNIPER,
+        eos::ABILITY_HEATPROOF,    eos::ABILITY_DOWNLOAD,
+        eos::ABILITY_TANGLED_FEET, eos::ABILITY_ADAPTABILITY,
+        eos::ABILITY_TECHNICIAN,   eos::ABILITY_IRON_FIST,
+        eos::ABILITY_MOTOR_DRIVE,  eos::ABILITY_UNAWARE,
+        eos::ABILITY_RIVALRY,      eos::ABILITY_NO_GUARD,
+        eos::ABILITY_NORMALIZE,    eos::ABILITY_SOLID_ROCK,
+        eos::ABILITY_FILTER,       eos::ABILITY_KLUTZ,
+        eos::ABILITY_FLOWER_GIFT,  eos::ABILITY_SNOW_CLOAK,
+        eos::ABILITY_FOREWARN,     eos::ABILITY_STORM_DRAIN,
     };
+    return names_of(ids::ABILITY, used);
 }
 std::vector<std::string> get_held_items() {
     // Only a couple held items are actually used anywhere; only return these
-    return {
-        ids::ITEM[eos::ITEM_NOTHING],      ids::ITEM[eos::ITEM_Y_RAY_SPECS],
-        ids::ITEM[eos::ITEM_SCOPE_LENS],   ids::ITEM[eos::ITEM_PATSY_BAND],
-        ids::ITEM[eos::ITEM_POWER_BAND],   ids::ITEM[eos::ITEM_DEF_SCARF],
-        ids::ITEM[eos::ITEM_SPECIAL_BAND], ids::ITEM[eos::ITEM_ZINC_BAND],
-        ids::ITEM[eos::ITEM_DETECT_BAND],  ids::ITEM[eos::ITEM_SPACE_GLOBE],
-        ids::ITEM[eos::ITEM_MUNCH_BELT],   ids::ITEM[eos::ITEM_WEATHER_BAND],
-        ids::ITEM[eos::ITEM_HEAL_SEED],    ids::ITEM[eos::ITEM_ORAN_BERRY],
-        ids::ITEM[eos::ITEM_SITRUS_BERRY], ids::ITEM[eos::ITEM_EYEDROP_SEED],
-        ids::ITEM[eos::ITEM_REVIVER_SEED], ids::ITEM[eos::ITEM_BLINKER_SEED],
-        ids::ITEM[eos::ITEM_DOOM_SEED],    ids::ITEM[eos::ITEM_X_EYE_SEED],
-        ids::ITEM[eos::ITEM_LIFE_SEED],    ids::ITEM[eos::ITEM_RAWST_BERRY],
-        ids::ITEM[eos::ITEM_HUNGER_SEED],  ids::ITEM[eos::ITEM_QUICK_SEED],
-        ids::ITEM[eos::ITEM_PECHA_BERRY],  ids::ITEM[eos::ITEM_CHERI_BERRY],
-        ids::ITEM[eos::ITEM_TOTTER_SEED],  ids::ITEM[eos::ITEM_SLEEP_SEED],
-        ids::ITEM[eos::ITEM_PLAIN_SEED],   ids::ITEM[eos::ITEM_WARP_SEED],
-        ids::ITEM[eos::ITEM_BLAST_SEED],   ids::ITEM[eos::ITEM_JOY_SEED],
-        ids::ITEM[eos::ITEM_CHESTO_BERRY], ids::ITEM[eos::ITEM_STUN_SEED],
-        ids::ITEM[eos::ITEM_GOLDEN_SEED],  ids::ITEM[eos::ITEM_VILE_SEED],
-        ids::ITEM[eos::ITEM_PURE_SEED],    ids::ITEM[eos::ITEM_VIOLENT_SEED],
-        ids::ITEM[eos::ITEM_VANISH_SEED],  ids::ITEM[eos::ITEM_DROPEYE_SEED],
-        ids::ITEM[eos::ITEM_REVISER_SEED], ids::ITEM[eos::ITEM_SLIP_SEED],
-        ids::ITEM[eos::ITEM_VIA_SEED],     ids::ITEM[eos::ITEM_OREN_BERRY],
-        ids::ITEM[eos::ITEM_DOUGH_SEED],   ids::ITEM[eos::ITEM_SILVER_BOW],
-        ids::ITEM[eos::ITEM_BROWN_BOW],    ids::ITEM[eos::ITEM_RED_BOW],
-        ids::ITEM[eos::ITEM_PINK_BOW],     ids::ITEM[eos::ITEM_ORANGE_BOW],
-        ids::ITEM[eos::ITEM_YELLOW_BOW],   ids::ITEM[eos::ITEM_LIME_BOW],
-        ids::ITEM[eos::ITEM_GREEN_BOW],    ids::ITEM[eos::ITEM_VIRIDIAN_BOW],
-        ids::ITEM[eos::ITEM_MINTY_BOW],    ids::ITEM[eos::ITEM_SKY_BLUE_BOW],
-        ids::ITEM[eos::ITEM_BLUE_BOW],     ids::ITEM[eos::ITEM_COBALT_BOW],
-        ids::ITEM[eos::ITEM_PURPLE_BOW],   ids::ITEM[eos::ITEM_VIOLET_BOW],
-        ids::ITEM[eos::ITEM_FUCHSIA_BOW],
+    constexpr std::array<eos::item_id, 61> used = {
+        eos::ITEM_NOTHING,      eos::ITEM_Y_RAY_SPECS,
+        eos::ITEM_SCOPE_LENS,   eos::ITEM_PATSY_BAND,
+        eos::ITEM_POWER_BAND,   eos::ITEM_DEF_SCARF,
+        eos::ITEM_SPECIAL_BAND, eos::ITEM_ZINC_BAND,
+        eos::ITEM_DETECT_BAND,  eos::ITEM_SPACE_GLOBE,
+        eos::ITEM_MUNCH_BELT,   eos::ITEM_WEATHER_BAND,
+        eos::ITEM_HEAL_SEED,    eos::ITEM_ORAN_BERRY,
+        eos::ITEM_SITRUS_BERRY, eos::ITEM_EYEDROP_SEED,
+        eos::ITEM_REVIVER_SEED, eos::ITEM_BLINKER_SEED,
+        eos::ITEM_DOOM_SEED,    eos::ITEM_X_EYE_SEED,
+        eos::ITEM_LIFE_SEED,    eos::ITEM_RAWST_BERRY,
+        eos::ITEM_HUNGER_SEED,  eos::ITEM_QUICK_SEED,
+        eos::ITEM_PECHA_BERRY,  eos::ITEM_CHERI_BERRY,
+        eos::ITEM_TOTTER_SEED,  eos::ITEM_SLEEP_SEED,
+        eos::ITEM_PLAIN_SEED,   eos::ITEM_WARP_SEED,
+        eos::ITEM_BLAST_SEED,   eos::ITEM_JOY_SEED,
+        eos::ITEM_CHESTO_BERRY, eos::ITEM_STUN_SEED,
+        eos::ITEM_GOLDEN_SEED,  eos::ITEM_VILE_SEED,
+        eos::ITEM_PURE_SEED,    eos::ITEM_VIOLENT_SEED,
+        eos::ITEM_VANISH_SEED,  eos::ITEM_DROPEYE_SEED,
+        eos::ITEM_REVISER_SEED, eos::ITEM_SLIP_SEED,
+        eos::ITEM_VIA_SEED,     eos::ITEM_OREN_BERRY,
+        eos::ITEM_DOUGH_SEED,   eos::ITEM_SILVER_BOW,
+        eos::ITEM_BROWN_BOW,    eos::ITEM_RED_BOW,
+        eos::ITEM_PINK_BOW,     eos::ITEM_ORANGE_BOW,
+        eos::ITEM_YELLOW_BOW,   eos::ITEM_LIME_BOW,
+        eos::ITEM_GREEN_BOW,    eos::ITEM_VIRIDIAN_BOW,
+        eos::ITEM_MINTY_BOW,    eos::ITEM_SKY_BLUE_BOW,
+        eos::ITEM_BLUE_BOW,     eos::ITEM_COBALT_BOW,
+        eos::ITEM_PURPLE_BOW,   eos::ITEM_VIOLET_BOW,
+        eos::ITEM_FUCHSIA_BOW,
     };
+    return names_of(ids::ITEM, used);
 }
 std::vector<std::string> get_weather_types() {
     return ids::WEATHER.all_except({eos::WEATHER_RANDOM});
 }
 std::vector<std::string> get_iq_skills() {
     // Only a couple IQ skills are actually used anywhere; only return these
-    return {
-        ids::IQ[eos::IQ_TYPE_ADVANTAGE_MASTER],
-        ids::IQ[eos::IQ_SURE_HIT_ATTACKER],
-        ids::IQ[eos::IQ_QUICK_DODGER],
-        ids::IQ[eos::IQ_SHARPSHOOTER],
-        ids::IQ[eos::IQ_AGGRESSOR],
-        ids::IQ[eos::IQ_DEFENDER],
-        ids::IQ[eos::IQ_POWER_PITCHER],
-        ids::IQ[eos::IQ_CONCENTRATOR],
-        ids::IQ[eos::IQ_COUNTER_BASHER],
-        ids::IQ[eos::IQ_CHEERLEADER],
-        ids::IQ[eos::IQ_ERRATIC_PLAYER],
-        ids::IQ[eos::IQ_PRACTICE_SWINGER],
-        ids::IQ[eos::IQ_CLUTCH_PERFORMER],
-        ids::IQ[eos::IQ_CRITICAL_DODGER],
+    constexpr std::array<eos::iq_skill_id, 14> used = {
+        eos::IQ_TYPE_ADVANTAGE_MASTER,
+        eos::IQ_SURE_HIT_ATTACKER,
+        eos::IQ_QUICK_DODGER,
+        eos::IQ_SHARPSHOOTER,
+        eos::IQ_AGGRESSOR,
+        eos::IQ_DEFENDER,
+        eos::IQ_POWER_PITCHER,
+        eos::IQ_CONCENTRATOR,
+        eos::IQ_COUNTER_BASHER,
+        eos::IQ_CHEERLEADER,
+        eos::IQ_ERRATIC_PLAYER,
+        eos::IQ_PRACTICE_SWINGER,
+        eos::IQ_CLUTCH_PERFORMER,
+        eos::IQ_CRITICAL_DODGER,
     };
+    return names_of(ids::IQ, used);
 }
 
 struct NameWithAlternates {
@@ -178,7 +203,8 @@ std::vector<NameWithAlternates> get_statuses() {
     std::vector<NameWithAlternates> statuses;
     statuses.reserve(supported.size());
     for (auto s : supported) {
-        statuses.push_back({ids::STATUS[s], ids::STATUS.alternate_names(s)});
+        statuses.push_back(
+            {std::string(ids::STATUS[s]), ids::STATUS.alternate_names(s).to_vector()});
     }
     // Special catch-all status; see cfgparse.cpp
     statuses.push_back({"Guts/Marvel Scale",
@@ -235,12 +261,32 @@ std::vector<NameWithAlternates> get_exclusive_item_effects() {
     std::vector<NameWithAlternates> effects;
     effects.reserve(used.size());
     for (auto u : used) {
-        effects.push_back(
-            {ids::EXCLUSIVE_ITEM_EFFECT[u], ids::EXCLUSIVE_ITEM_EFFECT.alternate_names(u)});
+        effects.push_back({std::string(ids::EXCLUSIVE_ITEM_EFFECT[u]),
+                           ids::EXCLUSIVE_ITEM_EFFECT.alternate_names(u).to_vector()});
     }
     return effects;
 }
 
+struct SearchMatch {
+    std::string name;
+    std::string matched_name;
+};
+// Search names for autocompletion, so the full name lists don't need to be filtered in JS
+std::vector<SearchMatch> search(std::string kind, std::string query, int limit) {
+    try {
+        auto matches = search::search(kind, query, std::max(limit, 0));
+        std::vector<SearchMatch> results;
+        results.reserve(matches.size());
+        for (auto& m : matches) {
+            results.push_back({std::string(m.name), std::string(m.matched)});
+        }
+        return results;
+    } catch (const std::exception& e) {
+        std::cerr << "[search(" << kind << ", " << query << ")] " << e.what() << std::endl;
+        return {};
+    }
+}
+
 struct MoveDetails {
     int base_power = 0;
     std::string type = "";
@@ -271,9 +317,15 @@ MoveDetails get_move_details(std::string name, bool time_darkness = false) {
         }
 
         return {
-            base_power,    ids::TYPE[data.type], ids::MOVE_CATEGORY[data.category],
-            data.pp,       data.accuracy1,       data.accuracy2,
-            data.strikes,  data.crit_chance,     data.unsupported,
+            base_power,
+            std::string(ids::TYPE[data.type]),
+            std::string(ids::MOVE_CATEGORY[data.category]),
+            data.pp,
+            data.accuracy1,
+            data.accuracy2,
+            data.strikes,
+            data.crit_chance,
+            data.unsupported,
             special_notes,
         };
     } catch (const std::exception& e) {
@@ -295,11 +347,11 @@ SpeciesDetails get_species_details(std::string name) {
     try {
         auto data = mechanics::data_files::MONSTERS[ids::MONSTER[name]];
         return {
-            ids::GENDER[data.gender],
-            ids::TYPE[data.type1],
-            ids::TYPE[data.type2],
-            ids::ABILITY[data.ability1],
-            ids::ABILITY[data.ability2],
+            std::string(ids::GENDER[data.gender]),
+            std::string(ids::TYPE[data.type1]),
+            std::string(ids::TYPE[data.type2]),
+            std::string(ids::ABILITY[data.ability1]),
+            std::string(ids::ABILITY[data.ability2]),
             data.weight,
             data.size,
         };
@@ -309,223 +361,233 @@ SpeciesDetails get_species_details(std::string name) {
     }
 }
 
-struct ModifierDetails {
-    int item_atk = 0;
-    int item_spatk = 0;
-    int item_def = 0;
-    int item_spdef = 0;
-    int ability_offense = 0;
-    int ability_defense = 0;
-    int iq_skill_offense = 0;
-    int iq_skill_defense = 0;
-    bool scope_lens_or_sharpshooter = false;
-    bool patsy_band = false;
-    bool half_physical_damage = false;
-    bool half_special_damage = false;
-    bool focus_energy = false;
-    bool type_advantage_master = false;
-    bool cloudy_drop = false;
-    bool rain_multiplier = false;
-    bool sunny_multiplier = false;
-    bool thick_fat_heatproof = false;
-    bool flash_fire = false;
-    bool levitate = false;
-    bool overgrow = false;
-    bool swarm = false;
-    bool blaze_dry_skin = false;
-    bool scrappy = false;
-    bool super_luck = false;
-    bool sniper = false;
-    bool stab = false;
-    bool mud_sport_fog = false;
-    bool water_sport = false;
-    bool charge = false;
-    bool ghost_immunity = false;
-    bool skull_bash = false;
-};
-struct CalcDetails {
-    int offensive_stat_stage = 0;
-    int defensive_stat_stage = 0;
-    int offensive_stat = 0;
-    int defensive_stat = 0;
-    int offense_calc = 0;
-    int defense_calc = 0;
-    int damage_calc_at = 0;
-    int damage_calc_def = 0;
-    int damage_calc_flv = 0;
-    int damage_calc_base = 0;
-    double static_damage_mult = 0;
-    int damage_calc = 0;
-    int avg_random_damage_mult_pct = 0;
-    int min_random_damage_mult_pct = 0;
-    int max_random_damage_mult_pct = 0;
-    ModifierDetails modifiers = {};
-};
-struct ResultDetails {
-    std::string damage_message = "";
-    std::string type_matchup = "";
-    std::string indiv_type_matchup1 = "";
-    std::string indiv_type_matchup2 = "";
-    std::string move_type = "";
-    std::string move_category = "";
-    bool critical_hit = false;
-    bool full_type_immunity = false;
-    bool no_damage = false;
-    CalcDetails calc = {};
-};
-struct CalcDamageResult {
-    int avg_damage = 0;
-    int min_damage = 0;
-    int max_damage = 0;
-    bool healed = false;
-    double hit_chance = 0;
-    bool guaranteed_miss = false;
-    int crit_chance = 0;
-    ResultDetails details = {};
-};
-CalcDamageResult calc_damage(std::string config_str) {
+// The lean build (see build-wasm.sh --lean) leaves out everything that takes JSON configs, so that
+// the JSON parser can be dropped from the binary. Callers use the binary APIs instead.
+#ifndef DAMAGECALC_WASM_LEAN
+// Base configs that configs passed to calcDamage() can be overlays on (see overlay.hpp)
+overlay::BaseConfigs base_configs;
+bool add_base_config(std::string name, std::string config_str) {
     try {
-        json cfg = json::parse(config_str);
-        auto [dungeon, attacker, defender, move, attack_power] = parse_cfg(cfg);
-        auto move_spec = mechanics::MoveSpec(move.id);
-
-        // Copy for other damage calcs since the inputs can be modified by the simulation
-        DungeonState dungeon_min = dungeon;
-        DungeonState dungeon_max = dungeon;
-        MonsterEntity attacker_min = attacker;
-        MonsterEntity defender_min = defender;
-        MonsterEntity attacker_max = attacker;
-        MonsterEntity defender_max = defender;
-        Move move_min = move;
-        Move move_max = move;
-        dungeon.rng.variance_dial = 0.5;   // average damage roll
-        dungeon_min.rng.variance_dial = 0; // minimum damage roll
-        dungeon_max.rng.variance_dial = 1; // maximum damage roll
-
-        DamageData details = {};
-        DamageData details_min_var = {};
-        DamageData details_max_var = {};
-        int32_t damage = 0;
-        int32_t damage_min_var = 0;
-        int32_t damage_max_var = 0;
-
-        if (move.id == eos::MOVE_PROJECTILE) {
-            damage =
-                simulate_damage_calc_projectile(details, dungeon, attacker, defender, attack_power);
-            damage_min_var = simulate_damage_calc_projectile(
-                details_min_var, dungeon_min, attacker_min, defender_min, attack_power);
-            damage_max_var = simulate_damage_calc_projectile(
-                details_max_var, dungeon_max, attacker_max, defender_max, attack_power);
-        } else {
-            damage = simulate_damage_calc(details, dungeon, attacker, defender, move);
-            damage_min_var = simulate_damage_calc(details_min_var, dungeon_min, attacker_min,
-                                                  defender_min, move_min);
-            damage_max_var = simulate_damage_calc(details_max_var, dungeon_max, attacker_max,
-                                                  defender_max, move_max);
+        base_configs.add(name, std::make_unique<const overlay::BaseConfig>(config_str));
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "[add_base_config] " << e.what() << std::endl;
+        return false;
+    }
+}
+bool remove_base_config(std::string name) { return base_configs.remove(name); }
+
+calcresult::CalcDamageResult calc_damage(std::string config_str) {
+    try {
+        cfgparse::ConfigTape tape;
+        return calcresult::calc_damage(base_configs.parse(tape.parse(config_str), tape));
+    } catch (const std::exception& e) {
+        std::cerr << "[calc_damage] " << e.what() << std::endl;
+        std::cerr << "(config) " << config_str << std::endl;
+        return {};
+    }
+}
+// Damage on every branch of a config at the Huge Power/Pure Power and critical hit rolls, with
+// the chance of each (see calcresult::damage_branches())
+std::vector<calcresult::DamageBranchResult> calc_damage_branches(std::string config_str) {
+    try {
+        cfgparse::ConfigTape tape;
+        return calcresult::damage_branches(base_configs.parse(tape.parse(config_str), tape));
+    } catch (const std::exception& e) {
+        std::cerr << "[calc_damage_branches] " << e.what() << std::endl;
+        std::cerr << "(config) " << config_str << std::endl;
+        return {};
+    }
+}
+#endif
+
+// Binary calcs (see wire.hpp). Callers write concatenated request records into the view returned
+// by getRequestBuffer(), then calcBinary() returns a view of the concatenated result records. Both
+// views point straight into wasm memory, so nothing is copied between JS and wasm. They're only
+// valid until the next call to either function, or until wasm memory grows.
+std::vector<uint8_t> request_buffer;
+std::string result_buffer;
+val get_request_buffer(std::size_t size) {
+    request_buffer.resize(size);
+    return val(typed_memory_view(request_buffer.size(), request_buffer.data()));
+}
+val calc_binary(std::size_t size) {
+    result_buffer.clear();
+    wire::RecordReader reader(request_buffer.data(), std::min(size, request_buffer.size()));
+    try {
+        while (!reader.done()) {
+            wire::calc_request(reader.next(), result_buffer);
         }
+    } catch (const std::exception& e) {
+        // The rest of the buffer can't be read
+        wire::encode_error(result_buffer, e.what(), 0);
+    }
+    return val(typed_memory_view(result_buffer.size(),
+                                 reinterpret_cast<const uint8_t*>(result_buffer.data())));
+}
 
-        CalcDamageResult result = {};
-        if (details.healed) {
-            result.avg_damage = details.damage;
-            result.min_damage = details_min_var.damage;
-            result.max_damage = details_max_var.damage;
-        } else {
-            result.avg_damage = damage;
-            result.min_damage = damage_min_var;
-            result.max_damage = damage_max_var;
+// Batches with fixed-size results, so JS can index into them directly. Callers write request
+// records back to back into getRequestBuffer(count * REQUEST_SIZE) (outside the lean build,
+// encodeRequest() can fill in a record from a JSON config), then calcRequests(count) returns an
+// Int32Array view with RESULT_STRIDE values per request, laid out like wire::ResultRecord:
+// [header, header, tag, flags, min damage, max damage, hit chance (0.0001%), crit chance (%)].
+// Failed requests have the RESULT_ERROR flag, and getBatchError() gives their error messages.
+// Like calcBinary(), the view is only valid until the next batch, or until wasm memory grows.
+const int REQUEST_SIZE = sizeof(wire::RequestRecord);
+const int RESULT_STRIDE = sizeof(wire::ResultRecord) / sizeof(int32_t);
+std::vector<wire::ResultRecord> batch_results;
+std::vector<std::string> batch_errors;
+val batch_view() {
+    return val(typed_memory_view(batch_results.size() * RESULT_STRIDE,
+                                 reinterpret_cast<const int32_t*>(batch_results.data())));
+}
+
+// Number of threads that batches are split across
+std::size_t n_workers() {
+#ifdef __EMSCRIPTEN_PTHREADS__
+    return std::max(1u, std::thread::hardware_concurrency());
+#else
+    return 1;
+#endif
+}
+
+// Split n items into contiguous ranges, one per thread, and call f(first, count, thread) on each
+// range in parallel. In the multithreaded build (see build-wasm.sh), threads come from a pool of
+// Web Workers started with the module. Otherwise, it's all one range on the calling thread.
+void parallel_ranges(std::size_t n,
+                     const std::function<void(std::size_t, std::size_t, std::size_t)>& f) {
+#ifdef __EMSCRIPTEN_PTHREADS__
+    std::size_t n_threads = std::min<std::size_t>(n_workers(), n);
+    if (n_threads > 1) {
+        std::vector<std::thread> threads;
+        std::size_t first = 0;
+        for (std::size_t t = 0; t < n_threads; t++) {
+            std::size_t count = n / n_threads + (t < n % n_threads);
+            threads.emplace_back(f, first, count, t);
+            first += count;
         }
-        result.healed = details.healed;
-        if (dungeon.damage_calc.two_turn_move_forced_miss ||
-            dungeon.damage_calc.soundproof_activated ||
-            dungeon.damage_calc.first_hit_check_failed || dungeon.damage_calc.dream_eater_failed ||
-            dungeon.damage_calc.last_resort_failed) {
-            result.guaranteed_miss = true;
-            return result;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        return;
+    }
+#endif
+    f(0, n, 0);
+}
+
+val calc_requests(std::size_t count) {
+    count = std::min(count, request_buffer.size() / sizeof(wire::RequestRecord));
+    batch_results.resize(count);
+    batch_errors.assign(count, std::string());
+    parallel_ranges(count, [](std::size_t first, std::size_t n, std::size_t) {
+        std::vector<std::string> errors;
+        wire::calc_requests(request_buffer.data() + first * sizeof(wire::RequestRecord), n,
+                            batch_results.data() + first, errors);
+        std::move(errors.begin(), errors.end(), batch_errors.begin() + first);
+    });
+    return batch_view();
+}
+std::string get_batch_error(std::size_t index) {
+    return index < batch_errors.size() ? batch_errors[index] : "";
+}
+
+#ifndef DAMAGECALC_WASM_LEAN
+// Encode a JSON config as the index-th request record in the request buffer, with the given tag
+bool encode_request(std::string config_str, std::size_t index, uint32_t tag) {
+    try {
+        if ((index + 1) * sizeof(wire::RequestRecord) > request_buffer.size()) {
+            throw std::out_of_range("request index is past the end of the request buffer");
         }
-        result.hit_chance = dungeon.rng.get_combined_hit_percentage();
-        result.crit_chance = dungeon.rng.get_computed_crit_chance();
-
-        const auto& calc = dungeon.damage_calc;
-        auto& res_details = result.details;
-        res_details.damage_message = ids::DAMAGE_MESSAGE[details.damage_message];
-        res_details.type_matchup = ids::TYPE_MATCHUP[details.type_matchup];
-        res_details.indiv_type_matchup1 = ids::TYPE_MATCHUP[calc.move_indiv_type_matchups[0]];
-        res_details.indiv_type_matchup2 = ids::TYPE_MATCHUP[calc.move_indiv_type_matchups[1]];
-        res_details.move_type = ids::TYPE[details.type];
-        res_details.move_category = ids::MOVE_CATEGORY[details.category];
-        res_details.critical_hit = details.critical_hit;
-        res_details.full_type_immunity = details.full_type_immunity;
-        res_details.no_damage = details.no_damage;
-
-        auto& calc_details = res_details.calc;
-        calc_details.offensive_stat_stage = calc.offensive_stat_stage;
-        calc_details.defensive_stat_stage = calc.defensive_stat_stage;
-        calc_details.offensive_stat = calc.offensive_stat;
-        calc_details.defensive_stat = calc.defensive_stat;
-        calc_details.offense_calc = calc.offense_calc;
-        calc_details.defense_calc = calc.defense_calc;
-        calc_details.damage_calc_at = calc.damage_calc_at;
-        calc_details.damage_calc_def = calc.damage_calc_def;
-        calc_details.damage_calc_flv = calc.damage_calc_flv;
-        calc_details.damage_calc_base = calc.damage_calc_base;
-        calc_details.static_damage_mult = calc.static_damage_mult.val();
-        calc_details.damage_calc = calc.damage_calc;
-        calc_details.avg_random_damage_mult_pct = calc.damage_calc_random_mult_pct;
-        calc_details.min_random_damage_mult_pct =
-            dungeon_min.damage_calc.damage_calc_random_mult_pct;
-        calc_details.max_random_damage_mult_pct =
-            dungeon_max.damage_calc.damage_calc_random_mult_pct;
-
-        auto& mod_details = calc_details.modifiers;
-        mod_details.item_atk = calc.item_atk_modifier;
-        mod_details.item_spatk = calc.item_sp_atk_modifier;
-        mod_details.item_def = calc.item_def_modifier;
-        mod_details.item_spdef = calc.item_sp_def_modifier;
-        mod_details.ability_offense = calc.ability_offense_modifier;
-        mod_details.ability_defense = calc.ability_defense_modifier;
-        mod_details.iq_skill_offense = calc.iq_skill_offense_modifier;
-        mod_details.iq_skill_defense = calc.iq_skill_defense_modifier;
-        mod_details.scope_lens_or_sharpshooter = calc.scope_lens_or_sharpshooter_activated;
-        mod_details.patsy_band = calc.patsy_band_activated;
-        mod_details.half_physical_damage = calc.half_physical_damage_activated;
-        mod_details.half_special_damage = calc.half_special_damage_activated;
-        mod_details.focus_energy = calc.focus_energy_activated;
-        mod_details.type_advantage_master = calc.type_advantage_master_activated;
-        mod_details.cloudy_drop = calc.cloudy_drop_activated;
-        mod_details.rain_multiplier = calc.rain_multiplier_activated;
-        mod_details.sunny_multiplier = calc.sunny_multiplier_activated;
-        mod_details.thick_fat_heatproof = calc.fire_move_ability_drop_activated;
-        mod_details.flash_fire = calc.flash_fire_activated;
-        mod_details.levitate = calc.levitate_activated;
-        mod_details.overgrow = calc.overgrow_boost_activated;
-        mod_details.swarm = calc.swarm_boost_activated;
-        mod_details.blaze_dry_skin = calc.fire_move_ability_boost_activated;
-        mod_details.scrappy = calc.scrappy_activated;
-        mod_details.super_luck = calc.super_luck_activated;
-        mod_details.sniper = calc.sniper_activated;
-        mod_details.stab = calc.stab_boost_activated;
-        mod_details.mud_sport_fog = calc.electric_move_dampened;
-        mod_details.water_sport = calc.water_sport_drop_activated;
-        mod_details.charge = calc.charge_boost_activated;
-        mod_details.ghost_immunity = calc.ghost_immunity_activated;
-        mod_details.skull_bash = calc.skull_bash_defense_boost_activated;
+        cfgparse::ConfigTape tape;
+        auto req = wire::encode_request(tape.parse(config_str), tag);
+        std::memcpy(request_buffer.data() + index * sizeof(req), &req, sizeof(req));
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "[encode_request] " << e.what() << std::endl;
+        return false;
+    }
+}
 
+// Sweeps (see sweep.hpp) with fixed-size results, for comparison tables like every move of a
+// species. The results are laid out like calcRequests(), in sweep order with the point index as
+// the tag, and the axes give the values (as strings) that each point's indexes refer to.
+const std::size_t MAX_SWEEP_POINTS = 100000;
+struct SweepAxis {
+    std::string path;
+    std::vector<std::string> values;
+};
+struct SweepResult {
+    std::vector<SweepAxis> axes;
+    val results = val::null();
+};
+SweepResult calc_sweep(std::string spec_str) {
+    try {
+        json spec = json::parse(spec_str);
+        // Sweeps keep their state in their config tape, so each thread gets its own copy
+        std::vector<std::unique_ptr<sweep::Sweep>> sweeps;
+        sweeps.push_back(std::make_unique<sweep::Sweep>(spec));
+        const sweep::Sweep& s = *sweeps[0];
+        if (s.size() > MAX_SWEEP_POINTS) {
+            throw std::invalid_argument("sweep has more than the maximum of " +
+                                        std::to_string(MAX_SWEEP_POINTS) + " points");
+        }
+        SweepResult result;
+        for (const auto& axis : s.axes()) {
+            SweepAxis res_axis{axis.path, {}};
+            for (const auto& value : axis.values) {
+                res_axis.values.push_back(value.is_string() ? std::string(value.get_string())
+                                                            : value.to_json().dump());
+            }
+            result.axes.push_back(std::move(res_axis));
+        }
+        std::size_t n_points = s.size();
+        batch_results.resize(n_points);
+        batch_errors.assign(n_points, std::string());
+        while (sweeps.size() < std::min(n_workers(), n_points)) {
+            sweeps.push_back(std::make_unique<sweep::Sweep>(spec));
+        }
+        parallel_ranges(n_points, [&](std::size_t first, std::size_t n, std::size_t thread) {
+            uint32_t tag = first;
+            sweeps[thread]->run(
+                [&](const sweep::Point& point) {
+                    if (point.run) {
+                        batch_results[tag] = wire::make_result(*point.run, tag);
+                    } else {
+                        batch_results[tag] = wire::make_error_result(tag);
+                        batch_errors[tag] = point.error;
+                    }
+                    tag++;
+                },
+                first, n);
+        });
+        result.results = batch_view();
         return result;
     } catch (const std::exception& e) {
-        std::cerr << "[calc_damage] " << e.what() << std::endl;
-        std::cerr << "(config) " << config_str << std::endl;
+        std::cerr << "[calc_sweep] " << e.what() << std::endl;
+        std::cerr << "(spec) " << spec_str << std::endl;
         return {};
     }
 }
+#endif
 }; // namespace js
 
 EMSCRIPTEN_BINDINGS(damagecalc) {
     constant("FIXED_SUBSTITUTE_ROOM", static_cast<int>(eos::FIXED_SUBSTITUTE_ROOM));
 
+    constant("REQUEST_SIZE", js::REQUEST_SIZE);
+    constant("RESULT_STRIDE", js::RESULT_STRIDE);
+    constant("RESULT_ERROR", static_cast<int>(wire::RESULT_ERROR));
+    constant("RESULT_HEALED", static_cast<int>(wire::RESULT_HEALED));
+    constant("RESULT_GUARANTEED_MISS", static_cast<int>(wire::RESULT_GUARANTEED_MISS));
+
     value_object<js::NameWithAlternates>("NameWithAlternates")
         .field("name", &js::NameWithAlternates::name)
         .field("alternateNames", &js::NameWithAlternates::alternate_names);
 
+    value_object<js::SearchMatch>("SearchMatch")
+        .field("name", &js::SearchMatch::name)
+        .field("matchedName", &js::SearchMatch::matched_name);
+
     value_object<js::MoveDetails>("MoveDetails")
         .field("basePower", &js::MoveDetails::base_power)
         .field("type", &js::MoveDetails::type)
@@ -547,76 +609,94 @@ EMSCRIPTEN_BINDINGS(damagecalc) {
         .field("weight", &js::SpeciesDetails::weight)
         .field("size", &js::SpeciesDetails::size);
 
-    value_object<js::ModifierDetails>("ModifierDetails")
-        .field("itemAtk", &js::ModifierDetails::item_atk)
-        .field("itemSpAtk", &js::ModifierDetails::item_spatk)
-        .field("itemDef", &js::ModifierDetails::item_def)
-        .field("itemSpDef", &js::ModifierDetails::item_spdef)
-        .field("abilityOffense", &js::ModifierDetails::ability_offense)
-        .field("abilityDefense", &js::ModifierDetails::ability_defense)
-        .field("iqSkillOffense", &js::ModifierDetails::iq_skill_offense)
-        .field("iqSkillDefense", &js::ModifierDetails::iq_skill_defense)
-        .field("scopeLensOrSharpshooter", &js::ModifierDetails::scope_lens_or_sharpshooter)
-        .field("patsyBand", &js::ModifierDetails::patsy_band)
-        .field("halfPhysicalDamage", &js::ModifierDetails::half_physical_damage)
-        .field("halfSpecialDamage", &js::ModifierDetails::half_special_damage)
-        .field("focusEnergy", &js::ModifierDetails::focus_energy)
-        .field("typeAdvantageMaster", &js::ModifierDetails::type_advantage_master)
-        .field("cloudyDrop", &js::ModifierDetails::cloudy_drop)
-        .field("rainMultiplier", &js::ModifierDetails::rain_multiplier)
-        .field("sunnyMultiplier", &js::ModifierDetails::sunny_multiplier)
-        .field("thickFatHeatproof", &js::ModifierDetails::thick_fat_heatproof)
-        .field("flashFire", &js::ModifierDetails::flash_fire)
-        .field("levitate", &js::ModifierDetails::levitate)
-        .field("overgrow", &js::ModifierDetails::overgrow)
-        .field("swarm", &js::ModifierDetails::swarm)
-        .field("blazeDrySkin", &js::ModifierDetails::blaze_dry_skin)
-        .field("scrappy", &js::ModifierDetails::scrappy)
-        .field("superLuck", &js::ModifierDetails::super_luck)
-        .field("sniper", &js::ModifierDetails::sniper)
-        .field("stab", &js::ModifierDetails::stab)
-        .field("mudSportFog", &js::ModifierDetails::mud_sport_fog)
-        .field("waterSport", &js::ModifierDetails::water_sport)
-        .field("charge", &js::ModifierDetails::charge)
-        .field("ghostImmunity", &js::ModifierDetails::ghost_immunity)
-        .field("skullBash", &js::ModifierDetails::skull_bash);
-    value_object<js::CalcDetails>("CalcDetails")
-        .field("offensiveStatStage", &js::CalcDetails::offensive_stat_stage)
-        .field("defensiveStatStage", &js::CalcDetails::defensive_stat_stage)
-        .field("offensiveStat", &js::CalcDetails::offensive_stat)
-        .field("defensiveStat", &js::CalcDetails::defensive_stat)
-        .field("offenseCalc", &js::CalcDetails::offense_calc)
-        .field("defenseCalc", &js::CalcDetails::defense_calc)
-        .field("damageCalcAt", &js::CalcDetails::damage_calc_at)
-        .field("damageCalcDef", &js::CalcDetails::damage_calc_def)
-        .field("damageCalcFlv", &js::CalcDetails::damage_calc_flv)
-        .field("damageCalcBase", &js::CalcDetails::damage_calc_base)
-        .field("staticDamageMult", &js::CalcDetails::static_damage_mult)
-        .field("damageCalc", &js::CalcDetails::damage_calc)
-        .field("avgRandomDamageMultPct", &js::CalcDetails::avg_random_damage_mult_pct)
-        .field("minRandomDamageMultPct", &js::CalcDetails::min_random_damage_mult_pct)
-        .field("maxRandomDamageMultPct", &js::CalcDetails::max_random_damage_mult_pct)
-        .field("modifiers", &js::CalcDetails::modifiers);
-    value_object<js::ResultDetails>("ResultDetails")
-        .field("damageMessage", &js::ResultDetails::damage_message)
-        .field("typeMatchup", &js::ResultDetails::type_matchup)
-        .field("indivTypeMatchup1", &js::ResultDetails::indiv_type_matchup1)
-        .field("indivTypeMatchup2", &js::ResultDetails::indiv_type_matchup2)
-        .field("moveType", &js::ResultDetails::move_type)
-        .field("moveCategory", &js::ResultDetails::move_category)
-        .field("criticalHit", &js::ResultDetails::critical_hit)
-        .field("fullTypeImmunity", &js::ResultDetails::full_type_immunity)
-        .field("noDamage", &js::ResultDetails::no_damage)
-        .field("calc", &js::ResultDetails::calc);
-    value_object<js::CalcDamageResult>("CalcDamageResult")
-        .field("avgDamage", &js::CalcDamageResult::avg_damage)
-        .field("minDamage", &js::CalcDamageResult::min_damage)
-        .field("maxDamage", &js::CalcDamageResult::max_damage)
-        .field("healed", &js::CalcDamageResult::healed)
-        .field("hitChance", &js::CalcDamageResult::hit_chance)
-        .field("guaranteedMiss", &js::CalcDamageResult::guaranteed_miss)
-        .field("critChance", &js::CalcDamageResult::crit_chance)
-        .field("details", &js::CalcDamageResult::details);
+#ifndef DAMAGECALC_WASM_LEAN
+    value_object<js::SweepAxis>("SweepAxis")
+        .field("path", &js::SweepAxis::path)
+        .field("values", &js::SweepAxis::values);
+
+    value_object<js::SweepResult>("SweepResult")
+        .field("axes", &js::SweepResult::axes)
+        .field("results", &js::SweepResult::results);
+
+    value_object<calcresult::ModifierDetails>("ModifierDetails")
+        .field("itemAtk", &calcresult::ModifierDetails::item_atk)
+        .field("itemSpAtk", &calcresult::ModifierDetails::item_spatk)
+        .field("itemDef", &calcresult::ModifierDetails::item_def)
+        .field("itemSpDef", &calcresult::ModifierDetails::item_spdef)
+        .field("abilityOffense", &calcresult::ModifierDetails::ability_offense)
+        .field("abilityDefense", &calcresult::ModifierDetails::ability_defense)
+        .field("iqSkillOffense", &calcresult::ModifierDetails::iq_skill_offense)
+        .field("iqSkillDefense", &calcresult::ModifierDetails::iq_skill_defense)
+        .field("scopeLensOrSharpshooter", &calcresult::ModifierDetails::scope_lens_or_sharpshooter)
+        .field("patsyBand", &calcresult::ModifierDetails::patsy_band)
+        .field("halfPhysicalDamage", &calcresult::ModifierDetails::half_physical_damage)
+        .field("halfSpecialDamage", &calcresult::ModifierDetails::half_special_damage)
+        .field("focusEnergy", &calcresult::ModifierDetails::focus_energy)
+        .field("typeAdvantageMaster", &calcresult::ModifierDetails::type_advantage_master)
+        .field("cloudyDrop", &calcresult::ModifierDetails::cloudy_drop)
+        .field("rainMultiplier", &calcresult::ModifierDetails::rain_multiplier)
+        .field("sunnyMultiplier", &calcresult::ModifierDetails::sunny_multiplier)
+        .field("thickFatHeatproof", &calcresult::ModifierDetails::thick_fat_heatproof)
+        .field("flashFire", &calcresult::ModifierDetails::flash_fire)
+        .field("levitate", &calcresult::ModifierDetails::levitate)
+        .field("overgrow", &calcresult::ModifierDetails::overgrow)
+        .field("swarm", &calcresult::ModifierDetails::swarm)
+        .field("blazeDrySkin", &calcresult::ModifierDetails::blaze_dry_skin)
+        .field("scrappy", &calcresult::ModifierDetails::scrappy)
+        .field("superLuck", &calcresult::ModifierDetails::super_luck)
+        .field("sniper", &calcresult::ModifierDetails::sniper)
+        .field("stab", &calcresult::ModifierDetails::stab)
+        .field("mudSportFog", &calcresult::ModifierDetails::mud_sport_fog)
+        .field("waterSport", &calcresult::ModifierDetails::water_sport)
+        .field("charge", &calcresult::ModifierDetails::charge)
+        .field("ghostImmunity", &calcresult::ModifierDetails::ghost_immunity)
+        .field("skullBash", &calcresult::ModifierDetails::skull_bash);
+    value_object<calcresult::CalcDetails>("CalcDetails")
+        .field("offensiveStatStage", &calcresult::CalcDetails::offensive_stat_stage)
+        .field("defensiveStatStage", &calcresult::CalcDetails::defensive_stat_stage)
+        .field("offensiveStat", &calcresult::CalcDetails::offensive_stat)
+        .field("defensiveStat", &calcresult::CalcDetails::defensive_stat)
+        .field("offenseCalc", &calcresult::CalcDetails::offense_calc)
+        .field("defenseCalc", &calcresult::CalcDetails::defense_calc)
+        .field("damageCalcAt", &calcresult::CalcDetails::damage_calc_at)
+        .field("damageCalcDef", &calcresult::CalcDetails::damage_calc_def)
+        .field("damageCalcFlv", &calcresult::CalcDetails::damage_calc_flv)
+        .field("damageCalcBase", &calcresult::CalcDetails::damage_calc_base)
+        .field("staticDamageMult", &calcresult::CalcDetails::static_damage_mult)
+        .field("damageCalc", &calcresult::CalcDetails::damage_calc)
+        .field("avgRandomDamageMultPct", &calcresult::CalcDetails::avg_random_damage_mult_pct)
+        .field("minRandomDamageMultPct", &calcresult::CalcDetails::min_random_damage_mult_pct)
+        .field("maxRandomDamageMultPct", &calcresult::CalcDetails::max_random_damage_mult_pct)
+        .field("modifiers", &calcresult::CalcDetails::modifiers);
+    value_object<calcresult::ResultDetails>("ResultDetails")
+        .field("damageMessage", &calcresult::ResultDetails::damage_message)
+        .field("typeMatchup", &calcresult::ResultDetails::type_matchup)
+        .field("indivTypeMatchup1", &calcresult::ResultDetails::indiv_type_matchup1)
+        .field("indivTypeMatchup2", &calcresult::ResultDetails::indiv_type_matchup2)
+        .field("moveType", &calcresult::ResultDetails::move_type)
+        .field("moveCategory", &calcresult::ResultDetails::move_category)
+        .field("criticalHit", &calcresult::ResultDetails::critical_hit)
+        .field("fullTypeImmunity", &calcresult::ResultDetails::full_type_immunity)
+        .field("noDamage", &calcresult::ResultDetails::no_damage)
+        .field("calc", &calcresult::ResultDetails::calc);
+    value_object<calcresult::CalcDamageResult>("CalcDamageResult")
+        .field("avgDamage", &calcresult::CalcDamageResult::avg_damage)
+        .field("minDamage", &calcresult::CalcDamageResult::min_damage)
+        .field("maxDamage", &calcresult::CalcDamageResult::max_damage)
+        .field("healed", &calcresult::CalcDamageResult::healed)
+        .field("hitChance", &calcresult::CalcDamageResult::hit_chance)
+        .field("guaranteedMiss", &calcresult::CalcDamageResult::guaranteed_miss)
+        .field("critChance", &calcresult::CalcDamageResult::crit_chance)
+        .field("details", &calcresult::CalcDamageResult::details);
+    value_object<calcresult::DamageBranchResult>("DamageBranchResult")
+        .field("hugePurePower", &calcresult::DamageBranchResult::huge_pure_power)
+        .field("criticalHit", &calcresult::DamageBranchResult::critical_hit)
+        .field("chance", &calcresult::DamageBranchResult::chance)
+        .field("avgDamage", &calcresult::DamageBranchResult::avg_damage)
+        .field("minDamage", &calcresult::DamageBranchResult::min_damage)
+        .field("maxDamage", &calcresult::DamageBranchResult::max_damage)
+        .field("healed", &calcresult::DamageBranchResult::healed);
+#endif
 
     function("getVersions", &js::get_versions);
     function("getMoves", &js::get_moves);
@@ -629,7 +709,19 @@ EMSCRIPTEN_BINDINGS(damagecalc) {
     function("getIqSkills", &js::get_iq_skills);
     function("getStatuses", &js::get_statuses);
     function("getExclusiveItemEffects", &js::get_exclusive_item_effects);
+    function("search", &js::search);
     function("getMoveDetails", &js::get_move_details);
     function("getSpeciesDetails", &js::get_species_details);
+    function("getRequestBuffer", &js::get_request_buffer);
+    function("calcBinary", &js::calc_binary);
+    function("calcRequests", &js::calc_requests);
+    function("getBatchError", &js::get_batch_error);
+#ifndef DAMAGECALC_WASM_LEAN
+    function("addBaseConfig", &js::add_base_config);
+    function("removeBaseConfig", &js::remove_base_config);
     function("calcDamage", &js::calc_damage);
+    function("calcDamageBranches", &js::calc_damage_branches);
+    function("encodeRequest", &js::encode_request);
+    function("calcSweep", &js::calc_sweep);
+#endif
 }
@@ -0,0 +1,448 @@
+#include "wire.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "cfgparse.hpp"
+#include "idmap.hpp"
+
+using nlohmann::json;
+using cfgparse::ConfigTape;
+
+namespace wire {
+namespace {
+// Statuses fields, in StatusBit order
+const std::array<bool Statuses::*, 28> STATUS_FIELDS = {
+    &Statuses::sleep,        &Statuses::nightmare,     &Statuses::napping,
+    &Statuses::burn,         &Statuses::poison,        &Statuses::bad_poison,
+    &Statuses::paralysis,    &Statuses::identifying,   &Statuses::confusion,
+    &Statuses::skull_bash,   &Statuses::flying,        &Statuses::bouncing,
+    &Statuses::diving,       &Statuses::digging,       &Statuses::charge,
+    &Statuses::shadow_force, &Statuses::reflect,       &Statuses::light_screen,
+    &Statuses::lucky_chant,  &Statuses::gastro_acid,   &Statuses::sure_shot,
+    &Statuses::whiffer,      &Statuses::focus_energy,  &Statuses::cross_eyed,
+    &Statuses::miracle_eye,  &Statuses::magnet_rise,   &Statuses::exposed,
+    &Statuses::other_negative_status,
+};
+
+template <std::size_t N_FLAGS, std::size_t N_BYTES>
+void pack_bits(const bool (&flags)[N_FLAGS], uint8_t (&bits)[N_BYTES]) {
+    static_assert(N_BYTES == (N_FLAGS + 7) / 8);
+    for (std::size_t i = 0; i < N_FLAGS; i++) {
+        if (flags[i]) {
+            bits[i / 8] |= 1 << (i % 8);
+        }
+    }
+}
+template <std::size_t N_FLAGS, std::size_t N_BYTES>
+void unpack_bits(const uint8_t (&bits)[N_BYTES], bool (&flags)[N_FLAGS]) {
+    static_assert(N_BYTES == (N_FLAGS + 7) / 8);
+    for (std::size_t i = 0; i < N_FLAGS; i++) {
+        flags[i] = bits[i / 8] & (1 << (i % 8));
+    }
+}
+
+// Convert to a narrower field type, or throw if the value doesn't fit
+template <typename T, typename V> T narrow(V v, const char* name) {
+    auto wide = static_cast<int64_t>(v);
+    if (wide < std::numeric_limits<T>::min() || wide > std::numeric_limits<T>::max()) {
+        throw std::out_of_range(std::string(name) + ": " + std::to_string(wide) +
+                                " does not fit in a binary request");
+    }
+    return static_cast<T>(v);
+}
+
+// Check that an ID from a request is valid, since IDs are used as table indexes
+template <typename T> T checked_id(const ids::IDMap<T>& map, unsigned id, const char* name) {
+    auto t = static_cast<T>(id);
+    if (!map.contains(t)) {
+        throw std::invalid_argument(std::string("unknown ") + name + " ID " + std::to_string(id));
+    }
+    return t;
+}
+
+Fx32 fx32_from_raw(uint32_t raw) { return Fx32{raw >> 8, static_cast<uint8_t>(raw & 0xFF)}; }
+
+// Throws std::invalid_argument if a record can't start with this header
+void check_header(const Header& header) {
+    if (header.magic != REQUEST_MAGIC && header.magic != RESULT_MAGIC) {
+        throw std::invalid_argument("not a damage calc record");
+    }
+    if (header.version != VERSION) {
+        throw std::invalid_argument("unsupported record version " +
+                                    std::to_string(header.version));
+    }
+    if (header.size < sizeof(Header) || header.size % 8 != 0) {
+        throw std::invalid_argument("invalid record size " + std::to_string(header.size));
+    }
+}
+
+void append(std::string& out, const void* data, std::size_t size) {
+    out.append(static_cast<const char*>(data), size);
+}
+
+MonsterRecord encode_monster(const Monster& monster) {
+    MonsterRecord rec = {};
+    rec.species = monster.apparent_id;
+    rec.held_item = monster.held_item.exists ? monster.held_item.id : eos::ITEM_NOTHING;
+    rec.max_hp = monster.max_hp_stat;
+    rec.hp = monster.hp;
+    rec.iq = monster.iq;
+    rec.belly = monster.belly.get_ipart();
+    rec.hidden_power_base_power = monster.hidden_power_base_power;
+    rec.level = monster.level;
+    rec.flags = (monster.is_not_team_member ? 0 : MONSTER_TEAM_MEMBER) |
+                (monster.is_team_leader ? MONSTER_TEAM_LEADER : 0) |
+                (monster.held_item.sticky ? MONSTER_HELD_ITEM_STICKY : 0) |
+                (monster.me_first_flag ? MONSTER_ME_FIRST : 0) |
+                (monster.practice_swinger_flag ? MONSTER_PRACTICE_SWINGER : 0) |
+                (monster.anger_point_flag ? MONSTER_ANGER_POINT : 0);
+
+    const auto& mods = monster.stat_modifiers;
+    for (int i = 0; i < 2; i++) {
+        rec.multipliers[i] = mods.offensive_multipliers[i].get_raw();
+        rec.multipliers[2 + i] = mods.defensive_multipliers[i].get_raw();
+        rec.types[i] = monster.types[i];
+        rec.abilities[i] = monster.abilities[i];
+        rec.stats[i] = monster.offensive_stats[i];
+        rec.stats[2 + i] = monster.defensive_stats[i];
+        rec.stages[i] = narrow<int8_t>(mods.offensive_stages[i], "offensive stage");
+        rec.stages[2 + i] = narrow<int8_t>(mods.defensive_stages[i], "defensive stage");
+        rec.stages[4 + i] = narrow<int8_t>(mods.hit_chance_stages[i], "hit chance stage");
+        rec.exclusive_item_boosts[i] = monster.exclusive_item_offense_boosts[i];
+        rec.exclusive_item_boosts[2 + i] = monster.exclusive_item_defense_boosts[i];
+    }
+    rec.stages[6] = narrow<int8_t>(monster.statuses.speed_stage, "speed");
+    rec.stages[7] = narrow<int8_t>(monster.statuses.stockpile_stage, "stockpile");
+    rec.flash_fire_boost = narrow<int8_t>(mods.flash_fire_boost, "flash_fire_boost");
+    rec.hidden_power_type = monster.hidden_power_type;
+    rec.n_moves_out_of_pp = monster.n_moves_out_of_pp;
+
+    for (std::size_t i = 0; i < STATUS_FIELDS.size(); i++) {
+        if (monster.statuses.*STATUS_FIELDS[i]) {
+            rec.statuses |= 1u << i;
+        }
+    }
+    pack_bits(monster.iq_skill_flags, rec.iq_skills);
+    pack_bits(monster.exclusive_item_effect_flags, rec.exclusive_item_effects);
+    return rec;
+}
+
+MonsterEntity decode_monster(const MonsterRecord& rec) {
+    Monster monster = {};
+    monster.apparent_id = checked_id(ids::MONSTER, rec.species, "species");
+    if (rec.held_item != eos::ITEM_NOTHING) {
+        monster.held_item.id = checked_id(ids::ITEM, rec.held_item, "item");
+        monster.held_item.exists = true;
+    }
+    monster.held_item.sticky = rec.flags & MONSTER_HELD_ITEM_STICKY;
+    monster.max_hp_stat = rec.max_hp;
+    monster.hp = rec.hp;
+    monster.iq = rec.iq;
+    monster.belly = DecFx16_16(rec.belly);
+    monster.hidden_power_base_power = rec.hidden_power_base_power;
+    monster.level = rec.level;
+    monster.is_not_team_member = !(rec.flags & MONSTER_TEAM_MEMBER);
+    monster.is_team_leader = rec.flags & MONSTER_TEAM_LEADER;
+    monster.me_first_flag = rec.flags & MONSTER_ME_FIRST;
+    monster.practice_swinger_flag = rec.flags & MONSTER_PRACTICE_SWINGER;
+    monster.anger_point_flag = rec.flags & MONSTER_ANGER_POINT;
+
+    auto& mods = monster.stat_modifiers;
+    for (int i = 0; i < 2; i++) {
+        mods.offensive_multipliers[i] = fx32_from_raw(rec.multipliers[i]);
+        mods.defensive_multipliers[i] = fx32_from_raw(rec.multipliers[2 + i]);
+        monster.types[i] = checked_id(ids::TYPE, rec.types[i], "type");
+        monster.abilities[i] = checked_id(ids::ABILITY, rec.abilities[i], "ability");
+        monster.offensive_stats[i] = rec.stats[i];
+        monster.defensive_stats[i] = rec.stats[2 + i];
+        mods.offensive_stages[i] = rec.stages[i];
+        mods.defensive_stages[i] = rec.stages[2 + i];
+        mods.hit_chance_stages[i] = rec.stages[4 + i];
+        monster.exclusive_item_offense_boosts[i] = rec.exclusive_item_boosts[i];
+        monster.exclusive_item_defense_boosts[i] = rec.exclusive_item_boosts[2 + i];
+    }
+    monster.statuses.speed_stage = rec.stages[6];
+    monster.statuses.stockpile_stage = rec.stages[7];
+    mods.flash_fire_boost = rec.flash_fire_boost;
+    monster.hidden_power_type = checked_id(ids::TYPE, rec.hidden_power_type, "type");
+    monster.n_moves_out_of_pp = rec.n_moves_out_of_pp;
+
+    for (std::size_t i = 0; i < STATUS_FIELDS.size(); i++) {
+        monster.statuses.*STATUS_FIELDS[i] = rec.statuses & (1u << i);
+    }
+    unpack_bits(rec.iq_skills, monster.iq_skill_flags);
+    unpack_bits(rec.exclusive_item_effects, monster.exclusive_item_effect_flags);
+    return MonsterEntity{monster};
+}
+
+} // namespace
+
+RequestRecord encode_request(const json& cfg, uint32_t tag, uint32_t flags) {
+    ConfigTape tape;
+    return encode_request(tape.add(cfg), tag, flags);
+}
+RequestRecord encode_request(const ConfigTape::Node& cfg, uint32_t tag, uint32_t flags) {
+    auto [dungeon, attacker, defender, move, power] = parse_cfg(cfg);
+
+    RequestRecord req = {};
+    req.header = {REQUEST_MAGIC, VERSION, sizeof(RequestRecord)};
+    req.tag = tag;
+    req.flags = flags;
+
+    req.dungeon.weather = dungeon.weather;
+    req.dungeon.fixed_room_id = narrow<uint8_t>(dungeon.gen_info.fixed_room_id, "fixed_room_id");
+    req.dungeon.version = dungeon.version;
+    req.dungeon.flags = (dungeon.mud_sport_turns > 0 ? DUNGEON_MUD_SPORT : 0) |
+                        (dungeon.water_sport_turns > 0 ? DUNGEON_WATER_SPORT : 0) |
+                        (dungeon.gravity ? DUNGEON_GRAVITY : 0) |
+                        (dungeon.iq_disabled ? DUNGEON_IQ_DISABLED : 0) |
+                        (dungeon.plus_is_active[0] ? DUNGEON_PLUS_ENEMY : 0) |
+                        (dungeon.plus_is_active[1] ? DUNGEON_PLUS_TEAM : 0) |
+                        (dungeon.minus_is_active[0] ? DUNGEON_MINUS_ENEMY : 0) |
+                        (dungeon.minus_is_active[1] ? DUNGEON_MINUS_TEAM : 0);
+    req.dungeon.rng_flags = (dungeon.rng.huge_pure_power ? RNG_HUGE_PURE_POWER : 0) |
+                            (dungeon.rng.critical_hit ? RNG_CRITICAL_HIT : 0);
+    pack_bits(dungeon.other_monsters.iq_skill_flags, req.dungeon.other_monsters_iq_skills);
+    pack_bits(dungeon.other_monsters.abilities, req.dungeon.other_monsters_abilities);
+
+    req.attacker = encode_monster(attacker.monster);
+    req.defender = encode_monster(defender.monster);
+
+    req.move.id = move.id;
+    if (move.id == eos::MOVE_PROJECTILE) {
+        // Thrown items are all parsed as the projectile move, so look up which item it was
+        auto name = cfg.at("move").at("id").get<std::string>();
+        if (auto item = cfgparse::find_projectile_item(name)) {
+            req.move.projectile_item = item->id;
+        }
+    }
+    req.move.ginseng = move.ginseng;
+    req.move.pp = move.pp;
+    req.move.prior_successive_hits = move.prior_successive_hits;
+    req.move.flags = move.time_darkness ? MOVE_TIME_DARKNESS : 0;
+    return req;
+}
+
+batch::CalcInputs decode_request(const RequestRecord& req) {
+    DungeonState dungeon = {};
+    dungeon.weather = checked_id(ids::WEATHER, req.dungeon.weather, "weather");
+    dungeon.gen_info.fixed_room_id = eos::fixed_room_id(req.dungeon.fixed_room_id);
+    dungeon.version = checked_id(ids::VERSION, req.dungeon.version, "version");
+    dungeon.mud_sport_turns = req.dungeon.flags & DUNGEON_MUD_SPORT ? 1 : 0;
+    dungeon.water_sport_turns = req.dungeon.flags & DUNGEON_WATER_SPORT ? 1 : 0;
+    dungeon.gravity = req.dungeon.flags & DUNGEON_GRAVITY;
+    dungeon.iq_disabled = req.dungeon.flags & DUNGEON_IQ_DISABLED;
+    dungeon.plus_is_active[0] = req.dungeon.flags & DUNGEON_PLUS_ENEMY;
+    dungeon.plus_is_active[1] = req.dungeon.flags & DUNGEON_PLUS_TEAM;
+    dungeon.minus_is_active[0] = req.dungeon.flags & DUNGEON_MINUS_ENEMY;
+    dungeon.minus_is_active[1] = req.dungeon.flags & DUNGEON_MINUS_TEAM;
+    dungeon.rng.huge_pure_power = req.dungeon.rng_flags & RNG_HUGE_PURE_POWER;
+    dungeon.rng.critical_hit = req.dungeon.rng_flags & RNG_CRITICAL_HIT;
+    unpack_bits(req.dungeon.other_monsters_iq_skills, dungeon.other_monsters.iq_skill_flags);
+    unpack_bits(req.dungeon.other_monsters_abilities, dungeon.other_monsters.abilities);
+
+    MonsterEntity attacker = decode_monster(req.attacker);
+    MonsterEntity defender = decode_monster(req.defender);
+
+    Move move = {checked_id(ids::MOVE, req.move.id, "move"), req.move.ginseng, req.move.pp,
+                 req.move.prior_successive_hits,
+                 static_cast<bool>(req.move.flags & MOVE_TIME_DARKNESS)};
+    int32_t power = 0;
+    if (req.move.projectile_item != 0) {
+        auto item = std::find_if(
+            cfgparse::PROJECTILE_ITEMS.begin(), cfgparse::PROJECTILE_ITEMS.end(),
+            [&](const auto& item) { return item.id == req.move.projectile_item; });
+        if (move.id != eos::MOVE_PROJECTILE || item == cfgparse::PROJECTILE_ITEMS.end()) {
+            throw std::invalid_argument("invalid projectile item ID " +
+                                        std::to_string(req.move.projectile_item));
+        }
+        power = item->base_power;
+    } else {
+        power = mechanics::get_move_base_power(move.id, move.time_darkness);
+    }
+
+    return {dungeon, attacker, defender, move, power};
+}
+
+ResultRecord make_result(const batch::CalcRun& run, uint32_t tag) {
+    ResultRecord res = {};
+    res.header = {RESULT_MAGIC, VERSION, static_cast<uint16_t>(sizeof(ResultRecord))};
+    res.tag = tag;
+    if (run.details.healed) {
+        res.flags |= RESULT_HEALED;
+        res.damage[0] = run.details.damage;
+        res.damage[1] = run.details_max_var.damage;
+    } else {
+        res.damage[0] = run.damage;
+        res.damage[1] = run.damage_max_var;
+    }
+    if (run.guaranteed_miss()) {
+        res.flags |= RESULT_GUARANTEED_MISS;
+    } else {
+        res.hit_chance = run.dungeon.rng.get_combined_hit_chance_raw();
+        res.crit_chance = run.dungeon.rng.get_computed_crit_chance();
+    }
+    return res;
+}
+ResultRecord make_error_result(uint32_t tag) {
+    ResultRecord res = {};
+    res.header = {RESULT_MAGIC, VERSION, static_cast<uint16_t>(sizeof(ResultRecord))};
+    res.tag = tag;
+    res.flags = RESULT_ERROR;
+    return res;
+}
+
+void encode_result(std::string& out, const batch::CalcRun& run, uint32_t tag, bool details) {
+    ResultRecord res = make_result(run, tag);
+    if (details) {
+        res.header.size += sizeof(DetailsRecord);
+        res.flags |= RESULT_DETAILS;
+    }
+    append(out, &res, sizeof(res));
+    if (!details) {
+        return;
+    }
+
+    const auto& calc = run.dungeon.damage_calc;
+    DetailsRecord diag = {};
+    diag.damage_calc = calc.damage_calc;
+    diag.damage_calc_base = calc.damage_calc_base;
+    diag.damage_calc_random_mult_pct[0] = calc.damage_calc_random_mult_pct;
+    diag.damage_calc_random_mult_pct[1] = run.dungeon_max.damage_calc.damage_calc_random_mult_pct;
+    diag.static_damage_mult = calc.static_damage_mult.get_raw();
+    diag.offensive_stat = calc.offensive_stat;
+    diag.defensive_stat = calc.defensive_stat;
+    diag.offense_calc = calc.offense_calc;
+    diag.defense_calc = calc.defense_calc;
+    diag.damage_calc_at = calc.damage_calc_at;
+    diag.damage_calc_def = calc.damage_calc_def;
+    diag.damage_calc_flv = calc.damage_calc_flv;
+    diag.damage_message = run.details.damage_message;
+    diag.type_matchup = run.details.type_matchup;
+    diag.indiv_type_matchups[0] = calc.move_indiv_type_matchups[0];
+    diag.indiv_type_matchups[1] = calc.move_indiv_type_matchups[1];
+    diag.type = run.details.type;
+    diag.category = run.details.category;
+    diag.offensive_stat_stage = calc.offensive_stat_stage;
+    diag.defensive_stat_stage = calc.defensive_stat_stage;
+    diag.flags = (run.details.critical_hit ? DETAILS_CRITICAL_HIT : 0) |
+                 (run.details.full_type_immunity ? DETAILS_FULL_TYPE_IMMUNITY : 0) |
+                 (run.details.no_damage ? DETAILS_NO_DAMAGE : 0);
+    append(out, &diag, sizeof(diag));
+}
+
+void encode_error(std::string& out, const std::string& message, uint32_t tag) {
+    std::size_t len = std::min(message.size(), MAX_ERROR_LENGTH);
+    std::size_t padded_len = (len + 7) / 8 * 8;
+    ResultRecord res = make_error_result(tag);
+    res.header.size += padded_len;
+    append(out, &res, sizeof(res));
+    out.append(message, 0, len);
+    out.append(padded_len - len, '\0');
+}
+
+void calc_request(const RecordView& record, std::string& out) {
+    uint32_t tag = 0;
+    try {
+        RequestRecord req = record.request();
+        tag = req.tag;
+        auto run = batch::run_calc(decode_request(req));
+        encode_result(out, run, tag, req.flags & REQUEST_DETAILS);
+    } catch (const std::exception& e) {
+        encode_error(out, e.what(), tag);
+    }
+}
+
+void calc_requests(const uint8_t* data, std::size_t n, ResultRecord* results,
+                   std::vector<std::string>& errors) {
+    errors.assign(n, std::string());
+    for (std::size_t i = 0; i < n; i++) {
+        uint32_t tag = 0;
+        try {
+            RecordView record(data + i * sizeof(RequestRecord), sizeof(RequestRecord));
+            RequestRecord req = record.request();
+            tag = req.tag;
+            results[i] = make_result(batch::run_calc(decode_request(req)), tag);
+        } catch (const std::exception& e) {
+            results[i] = make_error_result(tag);
+            errors[i] = e.what();
+        }
+    }
+}
+
+RecordView::RecordView(const uint8_t* data, std::size_t size) : data_(data) {
+    if (size < sizeof(Header)) {
+        throw std::invalid_argument("truncated record header");
+    }
+    std::memcpy(&header_, data, sizeof(Header));
+    check_header(header_);
+    if (header_.size > size) {
+        throw std::invalid_argument("truncated record");
+    }
+}
+RequestRecord RecordView::request() const {
+    if (!is_request() || size() != sizeof(RequestRecord)) {
+        throw std::invalid_argument("not a request record");
+    }
+    RequestRecord req;
+    std::memcpy(&req, data_, sizeof(req));
+    return req;
+}
+ResultRecord RecordView::result() const {
+    if (!is_result() || size() < sizeof(ResultRecord)) {
+        throw std::invalid_argument("not a result record");
+    }
+    ResultRecord res;
+    std::memcpy(&res, data_, sizeof(res));
+    return res;
+}
+bool RecordView::has_details() const {
+    return (result().flags & RESULT_DETAILS) &&
+           size() >= sizeof(ResultRecord) + sizeof(DetailsRecord);
+}
+DetailsRecord RecordView::details() const {
+    if (!has_details()) {
+        throw std::invalid_argument("result has no details");
+    }
+    DetailsRecord diag;
+    std::memcpy(&diag, data_ + sizeof(ResultRecord), sizeof(diag));
+    return diag;
+}
+std::string RecordView::error() const {
+    if (!(result().flags & RESULT_ERROR)) {
+        return "";
+    }
+    auto message = reinterpret_cast<const char*>(data_ + sizeof(ResultRecord));
+    std::size_t max_len = size() - sizeof(ResultRecord);
+    return std::string(message, std::find(message, message + max_len, '\0'));
+}
+
+RecordView RecordReader::next() {
+    RecordView record(pos, end - pos);
+    pos += record.size();
+    return record;
+}
+
+bool read_record(std::istream& in, std::string& buf) {
+    buf.resize(sizeof(Header));
+    in.read(buf.data(), sizeof(Header));
+    if (in.gcount() == 0) {
+        return false;
+    }
+    if (in.gcount() != sizeof(Header)) {
+        throw std::invalid_argument("truncated record header");
+    }
+    Header header;
+    std::memcpy(&header, buf.data(), sizeof(Header));
+    check_header(header);
+    buf.resize(header.size);
+    in.read(buf.data() + sizeof(Header), header.size - sizeof(Header));
+    if (static_cast<std::size_t>(in.gcount()) != header.size - sizeof(Header)) {
+        throw std::invalid_argument("truncated record");
+    }
+    return true;
+}
+} // namespace wire
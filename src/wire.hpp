@@ -0,0 +1,285 @@
+// Compact binary encoding of damage calc requests and results, for callers that need more
+// throughput than JSON allows
+
+#ifndef WIRE_HPP_
+#define WIRE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "batch.hpp"
+#include "cfgtape.hpp"
+#include "damage.hpp"
+
+// Records are plain structs with fixed-width fields and explicit padding, stored little-endian
+// (the byte order of every platform this builds for). Each record starts with a header giving its
+// kind, format version, and total size, so a stream of concatenated records can be walked without
+// understanding every record in it. Record sizes are multiples of 8 bytes.
+//
+// IDs are stored as their integer values, sets of flags as bitsets (bit i of byte i / 8 is flag i),
+// and stages as signed bytes.
+namespace wire {
+const uint32_t REQUEST_MAGIC = 0x51524344; // "DCRQ"
+const uint32_t RESULT_MAGIC = 0x53524344;  // "DCRS"
+const uint16_t VERSION = 1;
+
+struct Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size; // Total size of the record in bytes, including the header
+};
+static_assert(sizeof(Header) == 8);
+
+// DungeonRecord::flags
+enum DungeonFlag : uint8_t {
+    DUNGEON_MUD_SPORT = 1 << 0,
+    DUNGEON_WATER_SPORT = 1 << 1,
+    DUNGEON_GRAVITY = 1 << 2,
+    DUNGEON_IQ_DISABLED = 1 << 3,
+    DUNGEON_PLUS_ENEMY = 1 << 4,
+    DUNGEON_PLUS_TEAM = 1 << 5,
+    DUNGEON_MINUS_ENEMY = 1 << 6,
+    DUNGEON_MINUS_TEAM = 1 << 7,
+};
+// DungeonRecord::rng_flags
+enum RNGFlag : uint8_t {
+    RNG_HUGE_PURE_POWER = 1 << 0,
+    RNG_CRITICAL_HIT = 1 << 1,
+};
+struct DungeonRecord {
+    uint8_t weather;
+    uint8_t fixed_room_id;
+    uint8_t version;
+    uint8_t flags;
+    uint8_t rng_flags;
+    uint8_t other_monsters_iq_skills[9];  // One bit for each IQ skill
+    uint8_t other_monsters_abilities[16]; // One bit for each ability
+    uint8_t reserved[2];
+};
+static_assert(sizeof(DungeonRecord) == 32);
+
+// MonsterRecord::flags
+enum MonsterFlag : uint8_t {
+    MONSTER_TEAM_MEMBER = 1 << 0,
+    MONSTER_TEAM_LEADER = 1 << 1,
+    MONSTER_HELD_ITEM_STICKY = 1 << 2,
+    MONSTER_ME_FIRST = 1 << 3,
+    MONSTER_PRACTICE_SWINGER = 1 << 4,
+    MONSTER_ANGER_POINT = 1 << 5,
+};
+// MonsterRecord::statuses, in the same order as the fields of Statuses
+enum StatusBit : uint32_t {
+    STATUS_SLEEP = 1u << 0,
+    STATUS_NIGHTMARE = 1u << 1,
+    STATUS_NAPPING = 1u << 2,
+    STATUS_BURN = 1u << 3,
+    STATUS_POISON = 1u << 4,
+    STATUS_BAD_POISON = 1u << 5,
+    STATUS_PARALYSIS = 1u << 6,
+    STATUS_IDENTIFYING = 1u << 7,
+    STATUS_CONFUSION = 1u << 8,
+    STATUS_SKULL_BASH = 1u << 9,
+    STATUS_FLYING = 1u << 10,
+    STATUS_BOUNCING = 1u << 11,
+    STATUS_DIVING = 1u << 12,
+    STATUS_DIGGING = 1u << 13,
+    STATUS_CHARGE = 1u << 14,
+    STATUS_SHADOW_FORCE = 1u << 15,
+    STATUS_REFLECT = 1u << 16,
+    STATUS_LIGHT_SCREEN = 1u << 17,
+    STATUS_LUCKY_CHANT = 1u << 18,
+    STATUS_GASTRO_ACID = 1u << 19,
+    STATUS_SURE_SHOT = 1u << 20,
+    STATUS_WHIFFER = 1u << 21,
+    STATUS_FOCUS_ENERGY = 1u << 22,
+    STATUS_CROSS_EYED = 1u << 23,
+    STATUS_MIRACLE_EYE = 1u << 24,
+    STATUS_MAGNET_RISE = 1u << 25,
+    STATUS_EXPOSED = 1u << 26,
+    STATUS_OTHER_NEGATIVE = 1u << 27, // Guts/Marvel Scale
+};
+// Stat arrays are ordered {atk, sp_atk, def, sp_def}
+struct MonsterRecord {
+    uint16_t species;
+    uint16_t held_item; // 0 (Nothing) for no held item
+    int16_t max_hp;
+    int16_t hp;
+    int16_t iq;
+    int16_t belly;
+    int16_t hidden_power_base_power;
+    uint8_t level;
+    uint8_t flags;
+    uint32_t multipliers[4]; // Raw Fx32 values
+    uint32_t statuses;
+    uint8_t types[2];
+    uint8_t abilities[2];
+    uint8_t hidden_power_type;
+    uint8_t stats[4];
+    // {atk, sp_atk, def, sp_def, accuracy, evasion, speed, stockpile}
+    int8_t stages[8];
+    int8_t flash_fire_boost;
+    uint8_t n_moves_out_of_pp;
+    uint8_t exclusive_item_boosts[4];
+    uint8_t iq_skills[9];               // One bit for each IQ skill
+    uint8_t exclusive_item_effects[17]; // One bit for each exclusive item effect
+    uint8_t reserved[3];
+};
+static_assert(sizeof(MonsterRecord) == 88);
+
+// MoveRecord::flags
+enum MoveFlag : uint8_t {
+    MOVE_TIME_DARKNESS = 1 << 0,
+};
+struct MoveRecord {
+    uint16_t id;
+    uint16_t projectile_item; // Thrown item if id is the projectile move, otherwise 0
+    uint8_t ginseng;
+    uint8_t pp;
+    uint8_t prior_successive_hits;
+    uint8_t flags;
+};
+static_assert(sizeof(MoveRecord) == 8);
+
+// RequestRecord::flags
+enum RequestFlag : uint32_t {
+    REQUEST_DETAILS = 1u << 0, // Include a DetailsRecord in the result
+};
+struct RequestRecord {
+    Header header;
+    uint32_t tag; // Copied into the result, for matching results to requests
+    uint32_t flags;
+    DungeonRecord dungeon;
+    MonsterRecord attacker;
+    MonsterRecord defender;
+    MoveRecord move;
+};
+static_assert(sizeof(RequestRecord) == 232);
+
+// ResultRecord::flags
+enum ResultFlag : uint32_t {
+    RESULT_ERROR = 1u << 0,  // Followed by the error message (NUL-padded) instead of details
+    RESULT_HEALED = 1u << 1, // damage is the amount healed
+    RESULT_GUARANTEED_MISS = 1u << 2,
+    RESULT_DETAILS = 1u << 3, // Followed by a DetailsRecord
+};
+struct ResultRecord {
+    Header header;
+    uint32_t tag;
+    uint32_t flags;
+    int32_t damage[2];   // {min roll, max roll}
+    int32_t hit_chance;  // In units of 0.0001%
+    int32_t crit_chance; // Percentage
+};
+static_assert(sizeof(ResultRecord) == 32);
+
+// DetailsRecord::flags
+enum DetailsFlag : uint8_t {
+    DETAILS_CRITICAL_HIT = 1 << 0,
+    DETAILS_FULL_TYPE_IMMUNITY = 1 << 1,
+    DETAILS_NO_DAMAGE = 1 << 2,
+};
+// Selected fields of DamageData and DamageCalcDiag from the minimum-roll calc
+struct DetailsRecord {
+    int32_t damage_calc;
+    int32_t damage_calc_base;
+    int32_t damage_calc_random_mult_pct[2]; // {min roll, max roll}
+    uint32_t static_damage_mult;            // Raw Fx32 value
+    uint16_t offensive_stat;
+    uint16_t defensive_stat;
+    uint16_t offense_calc;
+    uint16_t defense_calc;
+    uint16_t damage_calc_at;
+    uint16_t damage_calc_def;
+    uint16_t damage_calc_flv;
+    uint8_t damage_message;
+    uint8_t type_matchup;
+    uint8_t indiv_type_matchups[2];
+    uint8_t type;
+    uint8_t category;
+    uint8_t offensive_stat_stage;
+    uint8_t defensive_stat_stage;
+    uint8_t flags;
+    uint8_t reserved[5];
+};
+static_assert(sizeof(DetailsRecord) == 48);
+
+// Largest possible result record, including the longest error message
+const std::size_t MAX_ERROR_LENGTH = 256;
+const std::size_t MAX_RESULT_SIZE = sizeof(ResultRecord) + MAX_ERROR_LENGTH;
+
+// Encode a JSON config (see sample-config.json) as a request. Throws the same exceptions as
+// parse_cfg(), or std::out_of_range if a value doesn't fit in its field.
+RequestRecord encode_request(const nlohmann::json& cfg, uint32_t tag = 0, uint32_t flags = 0);
+RequestRecord encode_request(const cfgparse::ConfigTape::Node& cfg, uint32_t tag = 0,
+                             uint32_t flags = 0);
+// Decode a request into the same calc inputs parse_cfg() returns. Throws std::invalid_argument if
+// the request has unknown IDs.
+batch::CalcInputs decode_request(const RequestRecord& req);
+
+// Result record for a calc, without details
+ResultRecord make_result(const batch::CalcRun& run, uint32_t tag);
+// Result record for a failed calc, without the error message
+ResultRecord make_error_result(uint32_t tag);
+// Append a result record to out
+void encode_result(std::string& out, const batch::CalcRun& run, uint32_t tag, bool details);
+void encode_error(std::string& out, const std::string& message, uint32_t tag);
+
+class RecordView;
+// Run a request record and append its result to out. Errors, including the record not being a
+// valid request, are reported in the result.
+void calc_request(const RecordView& record, std::string& out);
+
+// Run n request records packed back to back in data, writing a fixed-size result record (without
+// details) for each one to results, so result i is always at the same place. Malformed requests
+// only fail their own result. errors is resized to n, with the error message of each failed
+// request (empty for the rest).
+void calc_requests(const uint8_t* data, std::size_t n, ResultRecord* results,
+                   std::vector<std::string>& errors);
+
+// Read-only view of a record within a buffer. The record is validated when the view is created,
+// and accessors copy out only the parts asked for, so the buffer can have any alignment.
+class RecordView {
+    const uint8_t* data_;
+    Header header_;
+
+  public:
+    // Throws std::invalid_argument if the buffer doesn't start with a complete record
+    RecordView(const uint8_t* data, std::size_t size);
+
+    const uint8_t* data() const { return data_; }
+    uint32_t magic() const { return header_.magic; }
+    std::size_t size() const { return header_.size; }
+    bool is_request() const { return header_.magic == REQUEST_MAGIC; }
+    bool is_result() const { return header_.magic == RESULT_MAGIC; }
+
+    RequestRecord request() const;
+    ResultRecord result() const;
+    // Whether a result has a DetailsRecord, and the record itself
+    bool has_details() const;
+    DetailsRecord details() const;
+    // Error message of a result
+    std::string error() const;
+};
+
+// Walks a buffer of concatenated records, without copying it
+class RecordReader {
+    const uint8_t* pos;
+    const uint8_t* end;
+
+  public:
+    RecordReader(const uint8_t* data, std::size_t size) : pos(data), end(data + size) {}
+    bool done() const { return pos == end; }
+    // Throws std::invalid_argument if the remaining data doesn't start with a complete record
+    RecordView next();
+};
+
+// Read the next record from a stream into buf (replacing its contents). Returns false at the end
+// of the stream, and throws std::invalid_argument if the stream ends mid-record or the record is
+// malformed.
+bool read_record(std::istream& in, std::string& buf);
+} // namespace wire
+
+#endif
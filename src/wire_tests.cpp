@@ -0,0 +1,172 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "test_configs.hpp"
+#include "wire.hpp"
+
+using nlohmann::json;
+using test_configs::make_full_cfg;
+
+namespace {
+std::vector<uint8_t> bytes_of(const std::string& str) {
+    return std::vector<uint8_t>(str.begin(), str.end());
+}
+} // namespace
+
+TEST_CASE("Requests round-trip through the binary format", "[wire]") {
+    SECTION("Configs give the same results as JSON") {
+        std::vector<json> cfgs = {make_full_cfg()};
+        json projectile = make_full_cfg();
+        projectile["move"] = {{"id", "gold fang"}};
+        cfgs.push_back(projectile);
+        json immune = make_full_cfg();
+        immune["defender"]["ability1"] = "flash fire";
+        cfgs.push_back(immune);
+
+        for (const auto& cfg : cfgs) {
+            CAPTURE(cfg.dump());
+            auto req = wire::encode_request(cfg, 7, wire::REQUEST_DETAILS);
+            REQUIRE(req.tag == 7);
+            auto expected = batch::run_calc(cfg);
+            auto run = batch::run_calc(wire::decode_request(req));
+            REQUIRE(batch::summarize(run) == batch::summarize(expected));
+            REQUIRE(run.move.id == expected.move.id);
+            REQUIRE(run.attacker.monster.held_item.id == expected.attacker.monster.held_item.id);
+            REQUIRE(run.dungeon.damage_calc.damage_calc ==
+                    expected.dungeon.damage_calc.damage_calc);
+        }
+    }
+    SECTION("Values that don't fit are rejected") {
+        json cfg = make_full_cfg();
+        cfg["attacker"]["stat_modifiers"]["stages"]["atk"] = 1000;
+        REQUIRE_THROWS_AS(wire::encode_request(cfg), std::out_of_range);
+    }
+    SECTION("Unknown IDs are rejected") {
+        auto req = wire::encode_request(make_full_cfg());
+        req.attacker.species = 0xFFFF;
+        REQUIRE_THROWS_AS(wire::decode_request(req), std::invalid_argument);
+        req = wire::encode_request(make_full_cfg());
+        req.move.projectile_item = eos::ITEM_POWER_BAND;
+        REQUIRE_THROWS_AS(wire::decode_request(req), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Result records work", "[wire]") {
+    auto req = wire::encode_request(make_full_cfg(), 3, wire::REQUEST_DETAILS);
+    std::string buf(reinterpret_cast<const char*>(&req), sizeof(req));
+    std::string results;
+    wire::calc_request(wire::RecordView(reinterpret_cast<const uint8_t*>(buf.data()), buf.size()),
+                       results);
+    req.flags = 0;
+    req.defender.species = 0xFFFF;
+    buf.assign(reinterpret_cast<const char*>(&req), sizeof(req));
+    wire::calc_request(wire::RecordView(reinterpret_cast<const uint8_t*>(buf.data()), buf.size()),
+                       results);
+
+    auto data = bytes_of(results);
+    wire::RecordReader reader(data.data(), data.size());
+    auto expected = batch::run_calc(make_full_cfg());
+
+    auto first = reader.next();
+    REQUIRE(first.is_result());
+    auto res = first.result();
+    REQUIRE(res.tag == 3);
+    REQUIRE(res.damage[0] == expected.damage);
+    REQUIRE(res.damage[1] == expected.damage_max_var);
+    REQUIRE(res.hit_chance == expected.dungeon.rng.get_combined_hit_chance_raw());
+    REQUIRE(res.crit_chance == expected.dungeon.rng.get_computed_crit_chance());
+    REQUIRE(first.has_details());
+    auto details = first.details();
+    REQUIRE(details.damage_calc == expected.dungeon.damage_calc.damage_calc);
+    REQUIRE(details.type == expected.details.type);
+    REQUIRE(static_cast<bool>(details.flags & wire::DETAILS_CRITICAL_HIT) ==
+            expected.details.critical_hit);
+
+    auto second = reader.next();
+    REQUIRE(second.result().flags == wire::RESULT_ERROR);
+    REQUIRE(second.result().tag == 3);
+    REQUIRE(second.error() == "unknown species ID 65535");
+    REQUIRE(!second.has_details());
+    REQUIRE(reader.done());
+}
+
+TEST_CASE("calc_requests() gives fixed-size results", "[wire]") {
+    std::vector<wire::RequestRecord> reqs = {
+        wire::encode_request(make_full_cfg(), 1, wire::REQUEST_DETAILS),
+        wire::encode_request(make_full_cfg(), 2),
+        wire::encode_request(make_full_cfg(), 3),
+    };
+    reqs[1].attacker.species = 0xFFFF;
+    reqs[2].header.magic = wire::RESULT_MAGIC;
+    std::vector<wire::ResultRecord> results(reqs.size());
+    std::vector<std::string> errors;
+    wire::calc_requests(reinterpret_cast<const uint8_t*>(reqs.data()), reqs.size(),
+                        results.data(), errors);
+    REQUIRE(errors.size() == 3);
+
+    auto expected = batch::run_calc(make_full_cfg());
+    REQUIRE(results[0].header.size == sizeof(wire::ResultRecord));
+    REQUIRE(results[0].tag == 1);
+    REQUIRE(results[0].flags == 0);
+    REQUIRE(results[0].damage[0] == expected.damage);
+    REQUIRE(results[0].damage[1] == expected.damage_max_var);
+    REQUIRE(results[0].hit_chance == expected.dungeon.rng.get_combined_hit_chance_raw());
+    REQUIRE(errors[0].empty());
+    // The same as a variable-size result without details
+    std::string encoded;
+    wire::encode_result(encoded, expected, 1, false);
+    REQUIRE(std::memcmp(encoded.data(), &results[0], sizeof(wire::ResultRecord)) == 0);
+
+    REQUIRE(results[1].flags == wire::RESULT_ERROR);
+    REQUIRE(results[1].tag == 2);
+    REQUIRE(errors[1] == "unknown species ID 65535");
+    REQUIRE(results[2].flags == wire::RESULT_ERROR);
+    REQUIRE(errors[2] == "not a request record");
+}
+
+TEST_CASE("Malformed records are rejected", "[wire]") {
+    auto req = wire::encode_request(make_full_cfg());
+    std::vector<uint8_t> data(sizeof(req));
+    std::memcpy(data.data(), &req, sizeof(req));
+
+    REQUIRE_THROWS_AS(wire::RecordView(data.data(), data.size() - 1), std::invalid_argument);
+    REQUIRE_THROWS_AS(wire::RecordView(data.data(), 4), std::invalid_argument);
+    REQUIRE_THROWS_AS(wire::RecordView(data.data(), data.size()).result(),
+                      std::invalid_argument);
+    data[0] ^= 0xFF;
+    REQUIRE_THROWS_AS(wire::RecordView(data.data(), data.size()), std::invalid_argument);
+}
+
+TEST_CASE("run_binary_batch() works", "[wire]") {
+    std::string input;
+    const uint32_t n_requests = 1500;
+    for (uint32_t i = 0; i < n_requests; i++) {
+        json cfg = make_full_cfg();
+        cfg["attacker"]["level"] = 1 + i % 100;
+        auto req = wire::encode_request(cfg, i);
+        input.append(reinterpret_cast<const char*>(&req), sizeof(req));
+    }
+    std::istringstream in(input);
+    std::ostringstream out;
+    batch::run_binary_batch(in, out, 4);
+
+    auto data = bytes_of(out.str());
+    wire::RecordReader reader(data.data(), data.size());
+    for (uint32_t i = 0; i < n_requests; i++) {
+        auto res = reader.next().result();
+        REQUIRE(res.tag == i);
+        json cfg = make_full_cfg();
+        cfg["attacker"]["level"] = 1 + i % 100;
+        REQUIRE(res.damage[0] == batch::run_calc(cfg).damage);
+    }
+    REQUIRE(reader.done());
+
+    SECTION("Truncated input is an error") {
+        std::istringstream truncated(input.substr(0, input.size() - 1));
+        std::ostringstream truncated_out;
+        REQUIRE_THROWS_AS(batch::run_binary_batch(truncated, truncated_out, 2),
+                          std::invalid_argument);
+    }
+}